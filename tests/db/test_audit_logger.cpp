@@ -0,0 +1,130 @@
+#include "test_framework.h"
+#include "../../tissdb/audit/audit_logger.h"
+#include "../../tissdb/common/ring_buffer.h"
+#include <filesystem>
+#include <set>
+#include <thread>
+
+namespace {
+TissDB::Audit::AuditLogEntry make_audit_entry(std::chrono::system_clock::time_point when, const std::string& resource,
+                                              TissDB::Audit::EventType type = TissDB::Audit::EventType::DocWrite) {
+    return {when, "token", "127.0.0.1", type, resource, true, "test"};
+}
+} // anonymous namespace
+
+TEST_CASE(MpscRingBufferKeepsEveryProducersOrder) {
+    TissDB::Common::MpscRingBuffer<int> ring(5);
+    ASSERT_EQ(8, ring.capacity());
+    for (int i = 0; i < 8; ++i) {
+        ASSERT_TRUE(ring.try_push(int(i)));
+    }
+    ASSERT_FALSE(ring.try_push(8)); // Full
+    int value = -1;
+    ASSERT_TRUE(ring.try_pop(value));
+    ASSERT_EQ(0, value);
+    ASSERT_TRUE(ring.try_push(8));
+    for (int i = 1; i <= 8; ++i) {
+        ASSERT_TRUE(ring.try_pop(value));
+        ASSERT_EQ(i, value);
+    }
+    ASSERT_FALSE(ring.try_pop(value));
+
+    // Several producers against one consumer: nothing lost or duplicated,
+    // and each producer's values come out in the order it pushed them.
+    TissDB::Common::MpscRingBuffer<int> shared(64);
+    const int producers = 4;
+    const int per_producer = 20000;
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&shared, p] {
+            for (int i = 0; i < per_producer; ++i) {
+                while (!shared.try_push(p * per_producer + i)) std::this_thread::yield();
+            }
+        });
+    }
+    std::vector<int> last(producers, -1);
+    int received = 0;
+    bool ordered = true;
+    while (received < producers * per_producer) {
+        if (!shared.try_pop(value)) continue;
+        const int producer = value / per_producer;
+        ordered = ordered && value % per_producer == last[producer] + 1;
+        last[producer] = value % per_producer;
+        ++received;
+    }
+    for (auto& thread : threads) thread.join();
+    ASSERT_TRUE(ordered);
+    ASSERT_FALSE(shared.try_pop(value));
+}
+
+TEST_CASE(AuditLoggerServesTimeRanges) {
+    const std::string log_dir = "audit_test_log";
+    std::filesystem::remove_all(log_dir);
+    const auto base = std::chrono::system_clock::time_point(std::chrono::seconds(1700000000));
+    {
+        TissDB::Audit::AuditLoggerOptions options;
+        options.segment_bytes = 16 * 1024; // Several segments and index blocks
+        TissDB::Audit::AuditLogger logger(log_dir, options);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t) {
+            threads.emplace_back([&logger, base, t] {
+                for (int i = t; i < 2000; i += 4) {
+                    logger.log(make_audit_entry(base + std::chrono::seconds(i), "db/res" + std::to_string(i)));
+                }
+            });
+        }
+        for (auto& thread : threads) thread.join();
+
+        auto window = logger.get_logs(base + std::chrono::seconds(100), base + std::chrono::seconds(199));
+        ASSERT_EQ(100, window.size());
+        ASSERT_TRUE(window.front().timestamp == base + std::chrono::seconds(100));
+        ASSERT_TRUE(window.back().timestamp == base + std::chrono::seconds(199));
+        ASSERT_EQ("db/res150", window[50].resource_accessed);
+        ASSERT_TRUE(window[50].event_type == TissDB::Audit::EventType::DocWrite);
+        ASSERT_EQ("127.0.0.1", window[50].source_ip);
+
+        ASSERT_EQ(10, logger.get_logs(base, base + std::chrono::hours(1), 10).size());
+        auto stats = logger.stats();
+        ASSERT_EQ(2000, stats.logged);
+        ASSERT_EQ(2000, stats.written);
+        ASSERT_EQ(0, stats.dropped);
+    }
+    {
+        // A restarted logger writes a new segment; reads span both.
+        TissDB::Audit::AuditLogger logger(log_dir);
+        logger.log(make_audit_entry(base + std::chrono::seconds(5000), "db/after_restart"));
+        auto all = logger.get_logs(base, base + std::chrono::hours(2));
+        ASSERT_EQ(2001, all.size());
+        ASSERT_EQ("db/after_restart", all.back().resource_accessed);
+    }
+    // The reader does not need a logger.
+    ASSERT_EQ(2001, TissDB::Audit::read_audit_log(log_dir, base, base + std::chrono::hours(2)).size());
+    std::filesystem::remove_all(log_dir);
+}
+
+TEST_CASE(AuditLoggerOverflowPolicy) {
+    const std::string log_dir = "audit_overflow_log";
+    std::filesystem::remove_all(log_dir);
+    const auto now = std::chrono::system_clock::now();
+    {
+        TissDB::Audit::AuditLoggerOptions options;
+        options.queue_capacity = 2;
+        options.overflow_policy = TissDB::Audit::OverflowPolicy::DropRoutine;
+        TissDB::Audit::AuditLogger logger(log_dir, options);
+        for (int i = 0; i < 5000; ++i) {
+            logger.log(make_audit_entry(now, "r", TissDB::Audit::EventType::RequestBegin));
+            logger.log(make_audit_entry(now, "f", TissDB::Audit::EventType::AuthFailure));
+        }
+        auto stats = logger.stats();
+        ASSERT_EQ(10000, stats.logged + stats.dropped);
+        // Only routine events may be dropped; security events wait for room.
+        auto logs = logger.get_logs(now - std::chrono::seconds(1), now + std::chrono::seconds(1));
+        size_t failures = 0;
+        for (const auto& entry : logs) {
+            if (entry.event_type == TissDB::Audit::EventType::AuthFailure) ++failures;
+        }
+        ASSERT_EQ(5000, failures);
+        ASSERT_EQ(logger.stats().logged, logs.size());
+    }
+    std::filesystem::remove_all(log_dir);
+}
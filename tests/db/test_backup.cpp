@@ -0,0 +1,109 @@
+#include "test_framework.h"
+#include "../../tissdb/storage/lsm_tree.h"
+#include "../../tissdb/storage/backup.h"
+#include "../../tissdb/common/document.h"
+#include <filesystem>
+
+namespace {
+void put_backup_doc(TissDB::Storage::LSMTree& db, const std::string& key, double value) {
+    TissDB::Document doc;
+    TissDB::Element elem; elem.key = "v"; elem.value = value;
+    doc.elements.push_back(elem);
+    db.put("docs", key, doc);
+}
+} // anonymous namespace
+
+TEST_CASE(BackupIncrementalAndRestore) {
+    const std::string db_path = "backup_test_db";
+    const std::string backup_root = "backup_test_root";
+    const std::string restore_path = "backup_test_restored";
+    std::filesystem::remove_all(db_path);
+    std::filesystem::remove_all(backup_root);
+    std::filesystem::remove_all(restore_path);
+
+    TissDB::Storage::BackupResult first;
+    TissDB::Storage::BackupResult second;
+    {
+        TissDB::Storage::LSMTree db(db_path);
+        db.create_collection("docs", TissDB::Schema());
+        put_backup_doc(db, "a", 1.0);
+        put_backup_doc(db, "b", 2.0);
+        db.checkpoint();
+        put_backup_doc(db, "c", 3.0); // Only in the WAL tail
+
+        first = db.create_backup(backup_root);
+        ASSERT_TRUE(first.parent_backup_id.empty());
+        ASSERT_EQ(1, first.files_linked);
+        ASSERT_TRUE(std::filesystem::exists(first.backup_path + "/docs/sstable_000001.db"));
+        ASSERT_TRUE(std::filesystem::exists(first.backup_path + "/wal.log"));
+
+        put_backup_doc(db, "d", 4.0);
+        second = db.create_backup(backup_root, true);
+        ASSERT_EQ(first.backup_id, second.parent_backup_id);
+        ASSERT_EQ(1, second.files_reused); // sstable_000001.db is unchanged
+        ASSERT_EQ(1, second.files_linked); // the new flush
+    }
+
+    // Restoring the first backup brings back the WAL tail but not later writes.
+    TissDB::Storage::restore_backup(first.backup_path, restore_path);
+    {
+        TissDB::Storage::LSMTree db(restore_path);
+        ASSERT_EQ(3, db.scan("docs").size());
+        auto c = db.get("docs", "c");
+        ASSERT_TRUE(c.has_value() && *c);
+        ASSERT_FALSE(db.get("docs", "d").has_value());
+        put_backup_doc(db, "e", 5.0);
+    }
+
+    // Writes to the restored database must not leak into the backup.
+    TissDB::Storage::restore_backup(first.backup_path, restore_path);
+    {
+        TissDB::Storage::LSMTree db(restore_path);
+        ASSERT_EQ(3, db.scan("docs").size());
+    }
+
+    for (const auto& entry : std::filesystem::directory_iterator(".")) {
+        if (entry.path().filename().string().rfind(restore_path, 0) == 0) {
+            std::filesystem::remove_all(entry.path());
+        }
+    }
+    std::filesystem::remove_all(db_path);
+    std::filesystem::remove_all(backup_root);
+}
+
+TEST_CASE(BackupKeepsSequenceNumbers) {
+    const std::string db_path = "backup_sequence_test_db";
+    const std::string backup_root = "backup_sequence_test_root";
+    const std::string restore_path = "backup_sequence_test_restored";
+    std::filesystem::remove_all(db_path);
+    std::filesystem::remove_all(backup_root);
+    std::filesystem::remove_all(restore_path);
+
+    uint64_t last_before_backup = 0;
+    TissDB::Storage::BackupResult backup;
+    {
+        TissDB::Storage::LSMTree db(db_path);
+        db.create_collection("docs", TissDB::Schema());
+        for (int i = 0; i < 5; ++i) put_backup_doc(db, "k" + std::to_string(i), i);
+        last_before_backup = db.last_sequence();
+        // Flushed writes leave the WAL, so only the saved counter remembers them.
+        backup = db.create_backup(backup_root, true);
+    }
+
+    TissDB::Storage::restore_backup(backup.backup_path, restore_path);
+    {
+        TissDB::Storage::LSMTree db(restore_path);
+        ASSERT_EQ(5, db.scan("docs").size());
+        ASSERT_EQ(last_before_backup, db.last_sequence());
+        put_backup_doc(db, "after", 1.0);
+        ASSERT_TRUE(db.last_sequence() > last_before_backup);
+    }
+
+    for (const auto& entry : std::filesystem::directory_iterator(".")) {
+        if (entry.path().filename().string().rfind(restore_path, 0) == 0) {
+            std::filesystem::remove_all(entry.path());
+        }
+    }
+    std::filesystem::remove_all(db_path);
+    std::filesystem::remove_all(backup_root);
+}
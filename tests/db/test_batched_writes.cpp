@@ -0,0 +1,125 @@
+#include "test_framework.h"
+#include "../../tissdb/query/executor.h"
+#include "../../tissdb/query/parser.h"
+#include "../../tissdb/query/statement_cache.h"
+#include "../../tissdb/storage/lsm_tree.h"
+#include "../../tissdb/storage/wal.h"
+#include <filesystem>
+#include <map>
+#include <string>
+
+namespace {
+
+double count_of(const TissDB::Query::QueryResult& result, const std::string& field) {
+    ASSERT_EQ(field, result.at(0).elements.at(0).key);
+    return std::get<double>(result.at(0).elements.at(0).value);
+}
+
+double field_of(TissDB::Storage::LSMTree& db, const std::string& collection, const std::string& key, const std::string& field) {
+    const auto doc = db.get(collection, key);
+    for (const auto& element : (*doc)->elements) {
+        if (element.key == field) return std::get<double>(element.value);
+    }
+    return -1;
+}
+
+} // anonymous namespace
+
+TEST_CASE(WalAppendBatchKeepsEachRecord) {
+    const std::string wal_path = "batched_wal_test.log";
+    std::filesystem::remove(wal_path);
+    {
+        TissDB::Storage::WriteAheadLog wal(wal_path);
+        std::vector<TissDB::Storage::LogEntry> entries(3);
+        for (size_t i = 0; i < entries.size(); ++i) {
+            entries[i].type = i == 2 ? TissDB::Storage::LogEntryType::DELETE : TissDB::Storage::LogEntryType::PUT;
+            entries[i].collection_name = "c";
+            entries[i].document_id = "d" + std::to_string(i);
+            entries[i].doc.id = entries[i].document_id;
+            entries[i].lsn = 10 + i;
+        }
+        wal.append_batch(entries);
+        ASSERT_EQ(10, wal.first_lsn());
+        ASSERT_EQ(12, wal.last_lsn());
+    }
+    {
+        TissDB::Storage::WriteAheadLog wal(wal_path);
+        const auto recovered = wal.recover();
+        ASSERT_EQ(3, recovered.size());
+        ASSERT_EQ(std::string("d1"), recovered[1].document_id);
+        ASSERT_EQ(11, recovered[1].lsn);
+        ASSERT_TRUE(recovered[2].type == TissDB::Storage::LogEntryType::DELETE);
+    }
+    std::filesystem::remove(wal_path);
+}
+
+TEST_CASE(UpdateAndDeleteFindRowsThroughIndexes) {
+    const std::string db_path = "batched_writes_test_db";
+    std::filesystem::remove_all(db_path);
+    {
+        TissDB::Storage::LSMTree db(db_path);
+        db.create_collection("people", TissDB::Schema());
+        for (int i = 0; i < 3000; ++i) {
+            const std::string id = "p" + std::to_string(i);
+            db.put("people", id, TissDB::Document{id, {{"city", "c" + std::to_string(i % 10)}, {"n", static_cast<double>(i)}}});
+        }
+        db.create_index("people", {"city"});
+        TissDB::Query::Parser parser;
+        TissDB::Query::Executor executor(db);
+
+        // By document id: a point lookup, not a scan.
+        ASSERT_EQ(1.0, count_of(executor.execute(parser.parse("UPDATE people SET n = 7 WHERE id = 'p5'"), {}), "updated_count"));
+        ASSERT_EQ(7.0, field_of(db, "people", "p5", "n"));
+        ASSERT_EQ(0.0, count_of(executor.execute(parser.parse("UPDATE people SET n = 7 WHERE id = 'p5' AND n > 100"), {}), "updated_count"));
+
+        // Through the index, which a prepared statement keeps.
+        TissDB::Query::StatementCache cache;
+        auto update = cache.find("db", cache.prepare("db", "UPDATE people SET n = n + 1 WHERE city = ? AND n < 1000"));
+        ASSERT_EQ(100.0, count_of(executor.execute(*update, {std::string("c3")}), "updated_count"));
+        ASSERT_EQ(4.0, field_of(db, "people", "p3", "n"));
+        ASSERT_EQ(1003.0, field_of(db, "people", "p1003", "n"));
+        TissDB::Query::AccessPath access;
+        ASSERT_TRUE(update->access_path.get(db.catalog_version(), {{"city", "c3"}}, access));
+        ASSERT_TRUE(access.uses_index());
+        ASSERT_EQ(300, db.find_by_index("people", "city", "c3").size());
+
+        // Changing an indexed field moves the document in the index.
+        executor.execute(parser.parse("UPDATE people SET city = 'moved' WHERE id = 'p13'"), {});
+        ASSERT_EQ(299, db.find_by_index("people", "city", "c3").size());
+        ASSERT_EQ(1, db.find_by_index("people", "city", "moved").size());
+
+        ASSERT_EQ(300.0, count_of(executor.execute(parser.parse("DELETE FROM people WHERE city = 'c1'"), {}), "deleted_count"));
+        ASSERT_EQ(0, db.find_by_index("people", "city", "c1").size());
+        ASSERT_EQ(2700, db.scan("people").size());
+    }
+    std::filesystem::remove_all(db_path);
+}
+
+TEST_CASE(BatchedWritesSpanShardsAndSurviveRestart) {
+    const std::string db_path = "batched_shard_writes_test_db";
+    std::filesystem::remove_all(db_path);
+    {
+        TissDB::Storage::LSMTree db(db_path);
+        db.create_sharded_collection("events", TissDB::Schema(), 4);
+        for (int i = 0; i < 3000; ++i) {
+            const std::string id = "e" + std::to_string(i);
+            db.put("events", id, TissDB::Document{id, {{"city", "c" + std::to_string(i % 10)}, {"n", static_cast<double>(i)}}});
+        }
+        TissDB::Query::Parser parser;
+        TissDB::Query::Executor executor(db);
+
+        // More rows than one batch: every write still gets its own sequence number.
+        const uint64_t before = db.last_sequence();
+        ASSERT_EQ(3000.0, count_of(executor.execute(parser.parse("UPDATE events SET n = 0"), {}), "updated_count"));
+        ASSERT_EQ(before + 3000, db.last_sequence());
+        ASSERT_EQ(0.0, field_of(db, "events", "e2999", "n"));
+        ASSERT_EQ(1500.0, count_of(executor.execute(parser.parse("DELETE FROM events WHERE city > 'c4'"), {}), "deleted_count"));
+        ASSERT_EQ(1500, db.scan("events").size());
+    }
+    {
+        TissDB::Storage::LSMTree db(db_path);
+        ASSERT_EQ(1500, db.scan("events").size());
+        ASSERT_EQ(0.0, field_of(db, "events", "e2990", "n"));
+    }
+    std::filesystem::remove_all(db_path);
+}
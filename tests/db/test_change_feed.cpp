@@ -0,0 +1,114 @@
+#include "test_framework.h"
+#include "../../tissdb/storage/lsm_tree.h"
+#include "../../tissdb/common/document.h"
+#include <chrono>
+#include <filesystem>
+#include <thread>
+
+namespace {
+void put_change_doc(TissDB::Storage::LSMTree& db, const std::string& collection, const std::string& key, double value) {
+    TissDB::Document doc;
+    TissDB::Element elem; elem.key = "v"; elem.value = value;
+    doc.elements.push_back(elem);
+    db.put(collection, key, doc);
+}
+
+TissDB::Storage::CompactionOptions no_background_compaction() {
+    TissDB::Storage::CompactionOptions options;
+    options.background = false;
+    return options;
+}
+} // anonymous namespace
+
+TEST_CASE(ChangeFeedReadsAcrossCheckpoints) {
+    const std::string db_path = "change_feed_test_db";
+    std::filesystem::remove_all(db_path);
+    {
+        TissDB::Storage::LSMTree db(db_path, nullptr, no_background_compaction());
+        db.create_collection("orders", TissDB::Schema());
+        db.create_collection("users", TissDB::Schema());
+        put_change_doc(db, "orders", "o1", 1.0);
+        put_change_doc(db, "users", "u1", 2.0);
+        db.checkpoint();
+        put_change_doc(db, "orders", "o2", 3.0);
+        ASSERT_TRUE(db.del("orders", "o1"));
+        ASSERT_EQ(4, db.last_sequence());
+        ASSERT_EQ(1, db.earliest_change());
+
+        auto all = db.read_changes(0, 100);
+        ASSERT_EQ(4, all.events.size());
+        for (size_t i = 0; i < all.events.size(); ++i) {
+            ASSERT_EQ(i + 1, all.events[i].lsn);
+        }
+        ASSERT_EQ("u1", all.events[1].document_id);
+        ASSERT_EQ(3.0, std::get<double>(all.events[2].doc.elements[0].value));
+        ASSERT_TRUE(all.events[3].type == TissDB::Storage::LogEntryType::DELETE);
+        ASSERT_EQ(4, all.next_since);
+        ASSERT_EQ(4, all.last_lsn);
+
+        // Resuming from a cursor, a page at a time.
+        auto page = db.read_changes(1, 2);
+        ASSERT_EQ(2, page.events.size());
+        ASSERT_EQ(2, page.events[0].lsn);
+        ASSERT_EQ(3, page.next_since);
+        ASSERT_EQ(1, db.read_changes(page.next_since, 2).events.size());
+        ASSERT_EQ(0, db.read_changes(4, 2).events.size());
+
+        // Filtered reads still advance the cursor past other collections.
+        auto orders = db.read_changes(0, 100, "orders");
+        ASSERT_EQ(3, orders.events.size());
+        ASSERT_EQ(4, orders.next_since);
+    }
+    {
+        // The active log is replayed under its recorded sequence numbers.
+        TissDB::Storage::LSMTree db(db_path, nullptr, no_background_compaction());
+        ASSERT_EQ(4, db.last_sequence());
+        ASSERT_EQ(4, db.read_changes(0, 100).events.size());
+        put_change_doc(db, "orders", "o3", 4.0);
+        ASSERT_EQ(5, db.read_changes(4, 100).events[0].lsn);
+    }
+    std::filesystem::remove_all(db_path);
+}
+
+TEST_CASE(ChangeFeedDropsSegmentsPastRetention) {
+    const std::string db_path = "change_feed_retention_db";
+    std::filesystem::remove_all(db_path);
+    {
+        TissDB::Storage::ChangeFeedOptions feed_options;
+        feed_options.retained_segments = 1;
+        TissDB::Storage::LSMTree db(db_path, nullptr, no_background_compaction(), feed_options);
+        db.create_collection("events", TissDB::Schema());
+        for (int round = 0; round < 3; ++round) {
+            put_change_doc(db, "events", "k" + std::to_string(round), round);
+            put_change_doc(db, "events", "j" + std::to_string(round), round);
+            db.checkpoint();
+        }
+        ASSERT_EQ(6, db.last_sequence());
+        // Only the last sealed segment (changes 5 and 6) is kept.
+        ASSERT_EQ(5, db.earliest_change());
+        ASSERT_EQ(2, db.read_changes(4, 100).events.size());
+        ASSERT_TRUE(std::filesystem::exists(std::filesystem::path(db_path) / "wal_archive"));
+        // The archive is not mistaken for a collection.
+        ASSERT_EQ(1, db.list_collections().size());
+    }
+    std::filesystem::remove_all(db_path);
+}
+
+TEST_CASE(ChangeFeedWaitWakesOnWrite) {
+    const std::string db_path = "change_feed_wait_db";
+    std::filesystem::remove_all(db_path);
+    {
+        TissDB::Storage::LSMTree db(db_path, nullptr, no_background_compaction());
+        db.create_collection("events", TissDB::Schema());
+        ASSERT_FALSE(db.wait_for_changes(0, std::chrono::milliseconds(10)));
+
+        std::thread writer([&db] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            put_change_doc(db, "events", "a", 1.0);
+        });
+        ASSERT_TRUE(db.wait_for_changes(0, std::chrono::milliseconds(5000)));
+        writer.join();
+        ASSERT_EQ(1, db.read_changes(0, 10).events.size());
+    }
+    std::filesystem::remove_all(db_path);
+}
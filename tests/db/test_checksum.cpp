@@ -0,0 +1,169 @@
+#include "test_framework.h"
+#include "../../tissdb/common/checksum.h"
+#include "../../tissdb/storage/wal.h"
+#include "../../tissdb/storage/sstable.h"
+#include "../../tissdb/storage/memtable.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+namespace {
+std::vector<uint8_t> checksum_test_buffer(size_t size) {
+    std::vector<uint8_t> buf(size);
+    uint32_t seed = 42;
+    for (auto& b : buf) {
+        seed = seed * 1103515245 + 12345;
+        b = static_cast<uint8_t>(seed >> 16);
+    }
+    return buf;
+}
+
+std::vector<char> read_file(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::vector<char>(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+void write_file(const std::string& path, const std::vector<char>& data) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(data.data(), data.size());
+}
+} // anonymous namespace
+
+TEST_CASE(ChecksumKnownVectors) {
+    const char* check = "123456789";
+    ASSERT_EQ(0xCBF43926u, TissDB::Common::crc32(check, 9));
+    ASSERT_EQ(0xE3069283u, TissDB::Common::crc32c(check, 9));
+    ASSERT_EQ(0xE3069283u, TissDB::Common::Crc32cImpl::extend_portable(0, check, 9));
+    ASSERT_EQ(0xE3069283u, TissDB::Common::Crc32cImpl::extend_hardware(0, check, 9));
+    ASSERT_EQ(0u, TissDB::Common::crc32c(check, 0));
+}
+
+TEST_CASE(ChecksumHardwareMatchesPortable) {
+    // Sizes straddle the interleaved block thresholds (3 x 256 and 3 x 8192 bytes).
+    auto buf = checksum_test_buffer(3 * 8192 * 2 + 100);
+    for (size_t offset : {0, 1, 5}) {
+        for (size_t size : {0, 1, 7, 8, 9, 767, 768, 769, 5000, 24575, 24576, 24577, 49252}) {
+            if (offset + size > buf.size()) continue;
+            uint32_t portable = TissDB::Common::Crc32cImpl::extend_portable(0, buf.data() + offset, size);
+            uint32_t hardware = TissDB::Common::Crc32cImpl::extend_hardware(0, buf.data() + offset, size);
+            ASSERT_EQ(portable, hardware);
+        }
+    }
+}
+
+TEST_CASE(ChecksumStreamingUpdate) {
+    auto buf = checksum_test_buffer(10000);
+    uint32_t whole = TissDB::Common::crc32c(buf.data(), buf.size());
+
+    TissDB::Common::Crc32c crc;
+    size_t pos = 0;
+    for (size_t chunk : {1, 13, 0, 800, 3000, 6186}) {
+        crc.update(buf.data() + pos, chunk);
+        pos += chunk;
+    }
+    ASSERT_EQ(buf.size(), pos);
+    ASSERT_EQ(whole, crc.value());
+
+    crc.reset();
+    ASSERT_EQ(0u, crc.value());
+}
+
+TEST_CASE(WALReadsLegacyCrc32Format) {
+    std::string wal_path = "test_wal_legacy.log";
+    std::filesystem::remove(wal_path);
+
+    {
+        TissDB::Storage::WriteAheadLog wal(wal_path);
+        TissDB::Document doc;
+        doc.id = "doc1";
+        TissDB::Element elem; elem.key = "k"; elem.value = std::string("v");
+        doc.elements.push_back(elem);
+        TissDB::Storage::LogEntry put;
+        put.type = TissDB::Storage::LogEntryType::PUT;
+        put.collection_name = "c";
+        put.document_id = doc.id;
+        put.doc = doc;
+        wal.append(put);
+        TissDB::Storage::LogEntry del;
+        del.type = TissDB::Storage::LogEntryType::DELETE;
+        del.collection_name = "c";
+        del.document_id = "doc2";
+        wal.append(del);
+    }
+
+    // Rewrite the log in the pre-header layout: drop the header and re-checksum
+    // every entry with the legacy CRC32.
+    auto bytes = read_file(wal_path);
+    uint32_t magic;
+    std::memcpy(&magic, bytes.data(), sizeof(magic));
+    ASSERT_EQ(TissDB::Storage::WAL_MAGIC, magic);
+
+    std::vector<char> legacy;
+    size_t pos = 2 * sizeof(uint32_t);
+    while (pos < bytes.size()) {
+        uint32_t size;
+        std::memcpy(&size, bytes.data() + pos, sizeof(size));
+        uint32_t crc = TissDB::Common::crc32(bytes.data() + pos + sizeof(size), size);
+        legacy.insert(legacy.end(), bytes.begin() + pos, bytes.begin() + pos + sizeof(size) + size);
+        const char* crc_bytes = reinterpret_cast<const char*>(&crc);
+        legacy.insert(legacy.end(), crc_bytes, crc_bytes + sizeof(crc));
+        pos += sizeof(size) + size + sizeof(crc);
+    }
+    write_file(wal_path, legacy);
+
+    {
+        TissDB::Storage::WriteAheadLog wal(wal_path);
+        auto entries = wal.recover();
+        ASSERT_EQ(2, entries.size());
+        ASSERT_EQ("doc1", entries[0].document_id);
+        ASSERT_TRUE(entries[1].type == TissDB::Storage::LogEntryType::DELETE);
+
+        // Appending to a legacy log keeps the legacy format.
+        TissDB::Storage::LogEntry del;
+        del.type = TissDB::Storage::LogEntryType::DELETE;
+        del.collection_name = "c";
+        del.document_id = "doc3";
+        wal.append(del);
+        ASSERT_EQ(3, wal.recover().size());
+    }
+
+    std::filesystem::remove(wal_path);
+}
+
+TEST_CASE(SSTableReadsLegacyCrc32Footer) {
+    std::string data_dir = "sstable_legacy_test_data";
+    std::filesystem::create_directories(data_dir);
+
+    TissDB::Storage::Memtable memtable;
+    TissDB::Document doc;
+    doc.id = "doc1";
+    TissDB::Element elem; elem.key = "name"; elem.value = std::string("Alice");
+    doc.elements.push_back(elem);
+    memtable.put("doc1", doc);
+
+    // Tables from before per-collection keys were all written with this DEK.
+    std::string path = TissDB::Storage::SSTable::write_from_memtable(data_dir, "default_collection", memtable);
+
+    // Convert the footer into the legacy one: drop version and magic and
+    // replace the CRC32C with a CRC32 over data and index.
+    auto bytes = read_file(path);
+    bytes.resize(bytes.size() - 2 * sizeof(uint32_t));
+    size_t body_size = bytes.size() - sizeof(uint32_t) - sizeof(uint64_t);
+    uint32_t crc = TissDB::Common::crc32(bytes.data(), body_size);
+    std::memcpy(bytes.data() + body_size, &crc, sizeof(crc));
+    write_file(path, bytes);
+
+    TissDB::Storage::SSTable sstable(path, "test_collection");
+    auto found = sstable.find("doc1");
+    ASSERT_TRUE(found.has_value());
+    ASSERT_EQ("doc1", TissDB::deserialize(*found).id);
+
+    // A corrupted legacy file is rejected.
+    bytes[0] ^= 0xFF;
+    write_file(path, bytes);
+    TissDB::Storage::SSTable corrupted(path, "test_collection");
+    ASSERT_FALSE(corrupted.find("doc1").has_value());
+
+    std::filesystem::remove_all(data_dir);
+}
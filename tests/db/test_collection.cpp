@@ -1,7 +1,10 @@
 #include "test_framework.h"
 #include "../../tissdb/storage/lsm_tree.h"
 #include "../../tissdb/storage/collection.h"
+#include "../../tissdb/storage/sstable.h"
+#include "../../tissdb/common/serialization.h"
 #include "../../tissdb/common/document.h"
+#include <filesystem>
 
 TEST_CASE(CollectionPutGet) {
     TissDB::Storage::LSMTree lsm_tree;
@@ -107,4 +110,35 @@ TEST_CASE(CollectionScan) {
     }
     ASSERT_TRUE(found_doc1);
     ASSERT_TRUE(found_doc2);
-}
\ No newline at end of file
+}
+
+TEST_CASE(CollectionNameKeysItsSSTables) {
+    const std::string db_path = "collection_name_test_db";
+    std::filesystem::remove_all(db_path);
+    std::string sstable_path;
+    {
+        TissDB::Storage::LSMTree db(db_path);
+        db.create_collection("orders", TissDB::Schema());
+        db.create_sharded_collection("events", TissDB::Schema(), 2);
+        ASSERT_EQ(std::string("orders"), db.get_collection("orders").get_name());
+        ASSERT_EQ(std::string("events/shard_1"), db.get_collection("events/shard_1").get_name());
+        db.put("orders", "o1", TissDB::Document{"o1", {{"total", 5.0}}});
+        db.get_collection("orders").flush();
+        sstable_path = db.get_collection("orders").get_sstables().at(0)->get_path();
+    }
+    {
+        TissDB::Storage::LSMTree db(db_path);
+        ASSERT_EQ(std::string("orders"), db.get_collection("orders").get_name());
+        ASSERT_TRUE(db.get("orders", "o1").has_value());
+    }
+
+    // The table only decrypts with the DEK of the collection that wrote it.
+    TissDB::Storage::SSTable own(sstable_path, "orders");
+    TissDB::Storage::SSTable other(sstable_path, "events/shard_1");
+    auto own_value = own.find("o1");
+    auto other_value = other.find("o1");
+    ASSERT_TRUE(own_value.has_value() && other_value.has_value());
+    ASSERT_EQ(std::string("o1"), TissDB::deserialize(*own_value).id);
+    ASSERT_FALSE(*own_value == *other_value);
+    std::filesystem::remove_all(db_path);
+}
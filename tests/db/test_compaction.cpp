@@ -0,0 +1,198 @@
+#include "test_framework.h"
+#include "../../tissdb/storage/lsm_tree.h"
+#include "../../tissdb/common/document.h"
+#include <filesystem>
+
+namespace {
+void put_compaction_doc(TissDB::Storage::LSMTree& db, const std::string& key, double value) {
+    TissDB::Document doc;
+    TissDB::Element elem; elem.key = "v"; elem.value = value;
+    doc.elements.push_back(elem);
+    db.put("events", key, doc);
+}
+
+TissDB::Storage::CompactionOptions manual_compaction() {
+    TissDB::Storage::CompactionOptions options;
+    options.background = false;
+    options.max_bytes_per_second = 0;
+    return options;
+}
+} // anonymous namespace
+
+TEST_CASE(CompactionPurgesTombstones) {
+    const std::string db_path = "compaction_test_db";
+    std::filesystem::remove_all(db_path);
+    {
+        TissDB::Storage::LSMTree db(db_path, nullptr, manual_compaction());
+        db.create_collection("events", TissDB::Schema());
+        put_compaction_doc(db, "a", 1.0);
+        put_compaction_doc(db, "b", 2.0);
+        put_compaction_doc(db, "c", 3.0);
+        db.checkpoint();
+        ASSERT_TRUE(db.del("events", "a"));
+        ASSERT_TRUE(db.del("events", "b"));
+        db.checkpoint();
+        ASSERT_EQ(5, db.last_sequence());
+        ASSERT_EQ(2, db.get_collection("events").get_sstables().size());
+
+        ASSERT_TRUE(db.compact("events"));
+        auto stats = db.get_compaction_stats();
+        ASSERT_EQ(1, stats.runs);
+        ASSERT_EQ(2, stats.tombstones_purged);
+        ASSERT_EQ(0, stats.tombstones_retained);
+        ASSERT_EQ(2, stats.sstables_removed);
+
+        const auto& sstables = db.get_collection("events").get_sstables();
+        ASSERT_EQ(1, sstables.size());
+        ASSERT_EQ(1, sstables[0]->scan_entries().size()); // Only "c" is left on disk
+        ASSERT_FALSE(db.get("events", "a").has_value());
+        ASSERT_EQ(1, db.scan("events").size());
+    }
+    {
+        // The merged table and the sequence number survive a restart.
+        TissDB::Storage::LSMTree db(db_path, nullptr, manual_compaction());
+        ASSERT_EQ(5, db.last_sequence());
+        ASSERT_EQ(1, db.scan("events").size());
+        ASSERT_EQ(1, db.get_collection("events").get_sstable_files().size());
+    }
+    std::filesystem::remove_all(db_path);
+}
+
+TEST_CASE(CompactionRespectsRetentionHold) {
+    const std::string db_path = "compaction_hold_test_db";
+    std::filesystem::remove_all(db_path);
+    {
+        TissDB::Storage::LSMTree db(db_path, nullptr, manual_compaction());
+        db.create_collection("events", TissDB::Schema());
+        put_compaction_doc(db, "a", 1.0);
+        put_compaction_doc(db, "b", 2.0);
+        db.checkpoint();
+        ASSERT_TRUE(db.del("events", "a")); // Sequence 3
+
+        // A consumer that has seen everything up to sequence 3 does not need the tombstone...
+        uint64_t caught_up = db.add_retention_hold(3);
+        ASSERT_TRUE(db.del("events", "b")); // Sequence 4
+        // ...but one that stopped at 2 still needs both.
+        uint64_t lagging = db.add_retention_hold(2);
+        db.checkpoint();
+
+        ASSERT_TRUE(db.compact("events"));
+        ASSERT_EQ(0, db.get_compaction_stats().tombstones_purged);
+        ASSERT_EQ(2, db.get_compaction_stats().tombstones_retained);
+
+        auto entries = db.get_collection("events").get_sstables()[0]->scan_entries();
+        ASSERT_EQ(2, entries.size());
+        ASSERT_TRUE(entries[0].doc == nullptr);
+        ASSERT_EQ(3, entries[0].tombstone_seq);
+        ASSERT_EQ(4, entries[1].tombstone_seq);
+
+        db.release_retention_hold(lagging);
+        ASSERT_TRUE(db.compact("events"));
+        ASSERT_EQ(1, db.get_compaction_stats().tombstones_purged); // "a" only
+
+        db.release_retention_hold(caught_up);
+        ASSERT_TRUE(db.compact("events"));
+        ASSERT_EQ(2, db.get_compaction_stats().tombstones_purged);
+        // Nothing was left to write, so the collection has no SSTables at all.
+        ASSERT_TRUE(db.get_collection("events").get_sstables().empty());
+        ASSERT_FALSE(db.compact("events"));
+        ASSERT_TRUE(db.scan("events").empty());
+    }
+    std::filesystem::remove_all(db_path);
+}
+
+TEST_CASE(CompactionRunsInBackground) {
+    const std::string db_path = "compaction_background_test_db";
+    std::filesystem::remove_all(db_path);
+    {
+        TissDB::Storage::CompactionOptions options;
+        options.min_sstables = 2;
+        options.interval = std::chrono::milliseconds(10);
+        TissDB::Storage::LSMTree db(db_path, nullptr, options);
+        db.create_collection("events", TissDB::Schema());
+        put_compaction_doc(db, "a", 1.0);
+        db.checkpoint();
+        ASSERT_TRUE(db.del("events", "a"));
+        db.checkpoint();
+
+        for (int i = 0; i < 200 && db.get_compaction_stats().runs == 0; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        ASSERT_EQ(1, db.get_compaction_stats().runs);
+        ASSERT_TRUE(db.scan("events").empty());
+    }
+    std::filesystem::remove_all(db_path);
+}
+
+TEST_CASE(CompactionDropsExpiredDocuments) {
+    const std::string db_path = "compaction_ttl_test_db";
+    std::filesystem::remove_all(db_path);
+    {
+        TissDB::Storage::LSMTree db(db_path, nullptr, manual_compaction());
+        db.create_collection("events", TissDB::Schema());
+        db.create_index("events", {"v"});
+        TissDB::Storage::TtlPolicy policy;
+        policy.expiry_field = "expires";
+        db.set_ttl_policy("events", policy);
+
+        auto put_expiring = [&db](const std::string& key, double expires) {
+            TissDB::Document doc;
+            TissDB::Element v; v.key = "v"; v.value = std::string("x");
+            TissDB::Element e; e.key = "expires"; e.value = expires;
+            doc.elements.push_back(v);
+            doc.elements.push_back(e);
+            db.put("events", key, doc);
+        };
+        put_expiring("old", 1.0);        // Expired in 1970
+        put_expiring("new", 4102444800.0); // 2100-01-01
+        put_compaction_doc(db, "plain", 1.0); // No expiry field: never expires
+
+        // Hidden at read time, before any compaction.
+        ASSERT_FALSE(db.get("events", "old").has_value());
+        ASSERT_TRUE(db.get("events", "new").has_value());
+        ASSERT_EQ(2, db.scan("events").size());
+
+        db.checkpoint();
+        ASSERT_FALSE(db.get("events", "old").has_value());
+        ASSERT_TRUE(db.compact("events"));
+        ASSERT_EQ(1, db.get_compaction_stats().documents_expired);
+        ASSERT_EQ(0, db.get_compaction_stats().tombstones_purged);
+        ASSERT_EQ(2, db.get_collection("events").get_sstables()[0]->scan_entries().size());
+        ASSERT_EQ(1, db.find_by_index("events", "v", "x").size()); // "new" only
+    }
+    {
+        // The policy is persisted with the collection.
+        TissDB::Storage::LSMTree db(db_path, nullptr, manual_compaction());
+        ASSERT_EQ(std::string("expires"), db.get_ttl_policy("events").expiry_field);
+        ASSERT_EQ(2, db.scan("events").size());
+    }
+    std::filesystem::remove_all(db_path);
+}
+
+TEST_CASE(DefaultTtlStampsExpiry) {
+    const std::string db_path = "compaction_default_ttl_test_db";
+    std::filesystem::remove_all(db_path);
+    {
+        TissDB::Storage::LSMTree db(db_path, nullptr, manual_compaction());
+        db.create_collection("events", TissDB::Schema());
+        TissDB::Storage::TtlPolicy policy;
+        policy.default_ttl_seconds = 3600;
+        db.set_ttl_policy("events", policy);
+        put_compaction_doc(db, "a", 1.0);
+
+        auto doc = db.get("events", "a");
+        ASSERT_TRUE(doc.has_value() && *doc);
+        auto expires_at = policy.expires_at_us(**doc);
+        ASSERT_TRUE(expires_at.has_value());
+        const int64_t remaining = *expires_at - TissDB::Storage::now_us();
+        ASSERT_TRUE(remaining > 3500LL * 1000000 && remaining <= 3600LL * 1000000);
+    }
+    {
+        // Replaying the WAL keeps the stamped expiry.
+        TissDB::Storage::LSMTree db(db_path, nullptr, manual_compaction());
+        auto doc = db.get("events", "a");
+        ASSERT_TRUE(doc.has_value() && *doc);
+        ASSERT_EQ(2, (*doc)->elements.size());
+    }
+    std::filesystem::remove_all(db_path);
+}
@@ -0,0 +1,85 @@
+#include "test_framework.h"
+#include "../../tissdb/query/compiled_expression.h"
+#include "../../tissdb/query/parser.h"
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+TissDB::Query::Expression parse_where(const std::string& condition) {
+    TissDB::Query::Parser parser;
+    auto ast = parser.parse("SELECT * FROM t WHERE " + condition);
+    return std::get<TissDB::Query::SelectStatement>(ast).where_clause.value();
+}
+
+bool compiled_matches(const std::string& condition, const TissDB::Document& doc,
+                      const std::vector<TissDB::Query::Literal>& params = {}) {
+    return TissDB::Query::CompiledExpression::predicate(parse_where(condition), params).matches(doc);
+}
+
+} // anonymous namespace
+
+TEST_CASE(CompiledExpressionComparisons) {
+    TissDB::Document doc{"order7", {{"amount", 42.0}, {"code", std::string("17")}, {"name", std::string("widget")},
+                                    {"active", true}, {"ts", TissDB::Timestamp{5000000}}}};
+
+    ASSERT_TRUE(compiled_matches("amount > 40 AND amount < 50", doc));
+    ASSERT_FALSE(compiled_matches("amount > 40 AND amount < 41", doc));
+    ASSERT_TRUE(compiled_matches("amount = 1 OR name = 'widget'", doc));
+    ASSERT_TRUE(compiled_matches("amount BETWEEN 40 AND 45", doc));
+    ASSERT_FALSE(compiled_matches("amount NOT BETWEEN 40 AND 45", doc));
+    // Strings that read as numbers compare as numbers, and as text otherwise.
+    ASSERT_TRUE(compiled_matches("code > 9", doc));
+    ASSERT_TRUE(compiled_matches("code > '9'", doc));
+    ASSERT_TRUE(compiled_matches("code < 'a'", doc));
+    ASSERT_TRUE(compiled_matches("name LIKE 'wid%'", doc));
+    ASSERT_FALSE(compiled_matches("name LIKE 'gad%'", doc));
+    ASSERT_TRUE(compiled_matches("name LIKE name", doc));
+    ASSERT_TRUE(compiled_matches("_id = 'order7'", doc));
+    ASSERT_TRUE(compiled_matches("active = TRUE", doc));
+    ASSERT_TRUE(compiled_matches("amount * 2 - 4 = 80", doc));
+    // A missing field reads as null.
+    ASSERT_FALSE(compiled_matches("missing = 3", doc));
+    ASSERT_TRUE(compiled_matches("missing = 'null'", doc));
+    ASSERT_TRUE(compiled_matches("amount < ? AND name = ?", doc, {50.0, std::string("widget")}));
+}
+
+TEST_CASE(CompiledExpressionFoldsConstants) {
+    using TissDB::Query::CompiledExpression;
+    const std::vector<TissDB::Query::Literal> params = {3.0};
+
+    const auto condition = parse_where("x = 1 + ? * 2");
+    const auto& right = std::get<std::shared_ptr<TissDB::Query::BinaryExpression>>(condition)->right;
+    auto sum = CompiledExpression::value(right, params);
+    ASSERT_TRUE(sum.is_constant());
+    ASSERT_EQ(7.0, std::get<double>(sum.evaluate(TissDB::Document{})));
+
+    auto folded = CompiledExpression::predicate(parse_where("1 + 2 = 3"), {});
+    ASSERT_TRUE(folded.is_constant());
+    ASSERT_TRUE(folded.matches(TissDB::Document{}));
+
+    auto short_circuit = CompiledExpression::predicate(parse_where("1 = 2 AND amount > 3"), {});
+    ASSERT_TRUE(short_circuit.is_constant());
+    ASSERT_FALSE(short_circuit.matches(TissDB::Document{"1", {{"amount", 5.0}}}));
+
+    auto field_dependent = CompiledExpression::predicate(parse_where("amount > 1 + 2"), {});
+    ASSERT_FALSE(field_dependent.is_constant());
+    ASSERT_TRUE(field_dependent.matches(TissDB::Document{"1", {{"amount", 5.0}}}));
+}
+
+TEST_CASE(CompiledExpressionRaisesErrorsWhenReached) {
+    using TissDB::Query::CompiledExpression;
+    TissDB::Document doc{"1", {{"amount", 5.0}, {"zero", 0.0}}};
+
+    // A division by zero is raised for the documents that reach it, not
+    // when the expression is compiled.
+    auto divide = CompiledExpression::predicate(parse_where("amount / zero > 1"), {});
+    ASSERT_THROW(divide.matches(doc), std::runtime_error);
+    ASSERT_THROW(CompiledExpression::predicate(parse_where("amount > 1 / 0"), {}).matches(doc), std::runtime_error);
+
+    // An unbound parameter only matters if it is evaluated.
+    auto unbound = CompiledExpression::predicate(parse_where("amount = 5 OR amount = ?"), {});
+    ASSERT_TRUE(unbound.matches(doc));
+    ASSERT_THROW(unbound.matches(TissDB::Document{"2", {{"amount", 6.0}}}), std::runtime_error);
+}
@@ -32,6 +32,20 @@ public:
         return std::nullopt;
     }
 
+    void put_many(const std::string& collection_name, std::vector<TissDB::Document> docs) override {
+        for (auto& doc : docs) {
+            mock_data_[collection_name][doc.id] = std::move(doc);
+        }
+    }
+
+    size_t del_many(const std::string& collection_name, const std::vector<std::string>& keys) override {
+        size_t deleted = 0;
+        for (const auto& key : keys) {
+            deleted += mock_data_[collection_name].erase(key);
+        }
+        return deleted;
+    }
+
     std::vector<TissDB::Document> scan(const std::string& collection_name) override {
         std::vector<TissDB::Document> docs;
         if (mock_data_.count(collection_name)) {
@@ -42,6 +56,14 @@ public:
         return docs;
     }
 
+    std::vector<std::shared_ptr<const TissDB::Document>> scan_shared(const std::string& collection_name) override {
+        std::vector<std::shared_ptr<const TissDB::Document>> docs;
+        for (auto& doc : scan(collection_name)) {
+            docs.push_back(std::make_shared<const TissDB::Document>(std::move(doc)));
+        }
+        return docs;
+    }
+
     // Override create_index to just record that an index was created
     void create_index(const std::string& collection_name, const std::vector<std::string>& field_names, bool is_unique = false) override {
         (void)is_unique; // Unused in mock
@@ -0,0 +1,145 @@
+#include "test_framework.h"
+#include "../../tissdb/query/executor.h"
+#include "../../tissdb/query/executor_vectorized.h"
+#include "../../tissdb/query/parser.h"
+#include "../../tissdb/storage/lsm_tree.h"
+#include <filesystem>
+#include <memory>
+#include <string>
+
+namespace {
+
+const TissDB::Object& plan_field(const TissDB::Object& node, const std::string& key) {
+    return *std::get<std::shared_ptr<TissDB::Object>>(node.values.at(key));
+}
+
+const TissDB::Object& plan_input(const TissDB::Object& node, size_t i) {
+    const auto& inputs = *std::get<std::shared_ptr<TissDB::Array>>(node.values.at("inputs"));
+    return *std::get<std::shared_ptr<TissDB::Object>>(inputs.values.at(i));
+}
+
+std::string plan_text(const TissDB::Object& node, const std::string& key) {
+    return std::get<std::string>(node.values.at(key));
+}
+
+double plan_number(const TissDB::Object& node, const std::string& key) {
+    return std::get<double>(node.values.at(key));
+}
+
+TissDB::Document explain(TissDB::Storage::LSMTree& db, const std::string& query) {
+    TissDB::Query::Parser parser;
+    TissDB::Query::Executor executor(db);
+    auto result = executor.execute(parser.parse(query), {});
+    ASSERT_EQ(1, result.size());
+    return result[0];
+}
+
+const TissDB::Object& plan_of(const TissDB::Document& doc) {
+    return *std::get<std::shared_ptr<TissDB::Object>>(doc.elements.at(0).value);
+}
+
+void fill_explain_db(TissDB::Storage::LSMTree& db) {
+    db.create_collection("users", TissDB::Schema());
+    db.create_collection("orders", TissDB::Schema());
+    for (int i = 0; i < 100; ++i) {
+        const std::string id = "u" + std::to_string(i);
+        db.put("users", id, TissDB::Document{id, {{"email", id + "@example.com"}, {"city", "c" + std::to_string(i % 4)},
+                                                 {"age", static_cast<double>(i)}}});
+    }
+    for (int i = 0; i < 300; ++i) {
+        const std::string id = "o" + std::to_string(i);
+        db.put("orders", id, TissDB::Document{id, {{"user", "u" + std::to_string(i % 100)}}});
+    }
+    db.create_index("users", {"email"});
+}
+
+} // anonymous namespace
+
+TEST_CASE(ExplainShowsChosenPlan) {
+    const std::string db_path = "explain_test_db";
+    std::filesystem::remove_all(db_path);
+    {
+        TissDB::Storage::LSMTree db(db_path);
+        fill_explain_db(db);
+
+        // Planned but not run: no row counts.
+        const auto lookup = explain(db, "EXPLAIN SELECT * FROM users WHERE email = 'u3@example.com'");
+        ASSERT_EQ(1, lookup.elements.size());
+        const auto& filter = plan_of(lookup);
+        ASSERT_EQ(std::string("Filter"), plan_text(filter, "operator"));
+        ASSERT_FALSE(filter.values.count("actual_rows"));
+        const auto& index_scan = plan_input(filter, 0);
+        ASSERT_EQ(std::string("IndexScan"), plan_text(index_scan, "operator"));
+        ASSERT_EQ(std::string("email"), plan_text(index_scan, "index"));
+        ASSERT_TRUE(index_scan.values.count("estimated_rows"));
+
+        const auto join = explain(db, "EXPLAIN SELECT * FROM orders JOIN users ON orders.user = users._id");
+        const auto& join_node = plan_of(join);
+        ASSERT_EQ(std::string("Join"), plan_text(join_node, "operator"));
+        ASSERT_EQ(std::string("inner"), plan_text(join_node, "type"));
+        ASSERT_TRUE(join_node.values.count("algorithm"));
+        ASSERT_EQ(std::string("orders"), plan_text(plan_input(join_node, 0), "collection"));
+        ASSERT_EQ(std::string("users"), plan_text(plan_input(join_node, 1), "collection"));
+
+        const auto grouped = explain(db, "EXPLAIN SELECT city, COUNT(*) FROM users GROUP BY city ORDER BY city LIMIT 2");
+        const auto& vectorized = plan_of(grouped);
+        ASSERT_EQ(std::string("Vectorized"), plan_text(vectorized, "operator"));
+        ASSERT_EQ(std::string("city"), plan_text(plan_field(vectorized, "aggregate"), "group_by"));
+        ASSERT_EQ(std::string("TopN"), plan_text(plan_field(vectorized, "sort"), "operator"));
+        ASSERT_THROW(TissDB::Query::Parser().parse("EXPLAIN DELETE FROM users"), std::runtime_error);
+    }
+    std::filesystem::remove_all(db_path);
+}
+
+TEST_CASE(ExplainAnalyzeCountsRows) {
+    const std::string db_path = "explain_analyze_test_db";
+    std::filesystem::remove_all(db_path);
+    {
+        TissDB::Storage::LSMTree db(db_path);
+        fill_explain_db(db);
+
+        // The scan stops once the LIMIT is met.
+        const auto limited = explain(db, "EXPLAIN ANALYZE SELECT email FROM users WHERE age >= 10 LIMIT 5");
+        ASSERT_EQ(5.0, std::get<double>(limited.elements.at(1).value));
+        const auto& project = plan_of(limited);
+        ASSERT_EQ(std::string("Project"), plan_text(project, "operator"));
+        ASSERT_EQ(5.0, plan_number(project, "actual_rows"));
+        ASSERT_TRUE(plan_number(project, "bytes") > 0);
+        const auto& limit = plan_input(project, 0);
+        ASSERT_EQ(std::string("Limit"), plan_text(limit, "operator"));
+        const auto& filter = plan_input(limit, 0);
+        ASSERT_EQ(5.0, plan_number(filter, "actual_rows"));
+        const auto& scan = plan_input(filter, 0);
+        ASSERT_EQ(std::string("Scan"), plan_text(scan, "operator"));
+        ASSERT_TRUE(plan_number(scan, "actual_rows") >= 5.0);
+        ASSERT_TRUE(plan_number(scan, "actual_rows") < 100.0);
+        ASSERT_EQ(100.0, plan_number(scan, "estimated_rows"));
+        ASSERT_TRUE(plan_number(scan, "time_ms") <= plan_number(project, "time_ms"));
+
+        // Row at a time: each materialized operator reports its own output.
+        TissDB::Query::set_vectorized_execution(false);
+        const auto grouped = explain(db,
+            "EXPLAIN ANALYZE SELECT city, COUNT(*) FROM users WHERE age < 50 GROUP BY city ORDER BY city DESC LIMIT 3");
+        const auto joined = explain(db,
+            "EXPLAIN ANALYZE SELECT COUNT(*) FROM orders JOIN users ON orders.user = users._id WHERE users.age < 50");
+        TissDB::Query::set_vectorized_execution(true);
+        ASSERT_EQ(3.0, std::get<double>(grouped.elements.at(1).value));
+        const auto& top = plan_input(plan_of(grouped), 0);
+        ASSERT_EQ(std::string("TopN"), plan_text(top, "operator"));
+        ASSERT_EQ(3.0, plan_number(top, "actual_rows"));
+        const auto& aggregate = plan_input(top, 0);
+        ASSERT_EQ(std::string("HashAggregate"), plan_text(aggregate, "operator"));
+        ASSERT_EQ(4.0, plan_number(aggregate, "actual_rows"));
+        ASSERT_EQ(50.0, plan_number(plan_input(aggregate, 0), "actual_rows"));
+
+        const auto& count = plan_input(plan_of(joined), 0);
+        ASSERT_EQ(1.0, plan_number(count, "actual_rows"));
+        const auto& join_filter = plan_input(count, 0);
+        ASSERT_EQ(150.0, plan_number(join_filter, "actual_rows"));
+        const auto& join = plan_input(join_filter, 0);
+        ASSERT_EQ(300.0, plan_number(join, "actual_rows"));
+        ASSERT_EQ(300.0, plan_number(plan_input(join, 0), "actual_rows"));
+        ASSERT_TRUE(plan_number(join, "memory_bytes") > 0);
+    }
+    std::filesystem::remove_all(db_path);
+}
@@ -0,0 +1,99 @@
+#include "test_framework.h"
+#include "../../tissdb/query/hash_aggregate.h"
+#include "../../tissdb/query/parser.h"
+#include <cmath>
+#include <string>
+#include <vector>
+
+namespace {
+
+TissDB::Query::SelectStatement parse_select(const std::string& query) {
+    return std::get<TissDB::Query::SelectStatement>(TissDB::Query::Parser().parse(query));
+}
+
+const TissDB::Value* aggregate_field(const TissDB::Document& doc, const std::string& key) {
+    for (const auto& elem : doc.elements) {
+        if (elem.key == key) return &elem.value;
+    }
+    return nullptr;
+}
+
+} // anonymous namespace
+
+TEST_CASE(GroupKeysAreTyped) {
+    const auto select = parse_select("SELECT k, COUNT(*) FROM t GROUP BY k");
+    TissDB::Query::HashAggregator aggregator(select);
+    const std::vector<TissDB::Value> keys = {
+        1.0, std::string("1"), 0.30000000000000004, 0.3, 0.0, -0.0, true, TissDB::Timestamp{1},
+    };
+    for (const auto& key : keys) aggregator.add(TissDB::Document{"d", {{"k", key}}});
+    aggregator.add(TissDB::Document{"d", {}});
+    aggregator.add(TissDB::Document{"d", {}});
+
+    // Only -0 and 0, and the two rows without the field, share a group.
+    ASSERT_EQ(8, aggregator.group_count());
+    for (const auto& doc : aggregator.finish()) {
+        const double count = std::get<double>(*aggregate_field(doc, "COUNT(*)"));
+        if (doc.id == "NULL") {
+            ASSERT_EQ(1, doc.elements.size());
+            ASSERT_EQ(2.0, count);
+        } else {
+            ASSERT_EQ(doc.id == "0" ? 2.0 : 1.0, count);
+        }
+    }
+}
+
+TEST_CASE(PartialAggregatesMerge) {
+    const auto select = parse_select(
+        "SELECT region, COUNT(*), SUM(amount), AVG(amount), MIN(amount), MAX(name), STDDEV(amount) "
+        "FROM sales GROUP BY region");
+    std::vector<TissDB::Document> docs;
+    for (int i = 0; i < 1000; ++i) {
+        TissDB::Document doc{std::to_string(i), {{"region", std::string(i % 3 ? "east" : "west")}}};
+        if (i % 7 != 0) doc.elements.push_back({"amount", static_cast<double>(i % 101)});
+        doc.elements.push_back({"name", "n" + std::to_string(i % 37)});
+        docs.push_back(std::move(doc));
+    }
+
+    TissDB::Query::HashAggregator whole(select);
+    for (const auto& doc : docs) whole.add(doc);
+    // Partial aggregates over three slices; only the first sees "west" rows.
+    std::vector<TissDB::Query::HashAggregator> parts(3, TissDB::Query::HashAggregator(select));
+    for (size_t i = 0; i < docs.size(); ++i) parts[i % 3].add(docs[i]);
+    for (size_t p = 1; p < parts.size(); ++p) parts[0].merge(std::move(parts[p]));
+
+    const auto expected = whole.finish();
+    const auto merged = parts[0].finish();
+    ASSERT_EQ(2, merged.size());
+    for (size_t g = 0; g < expected.size(); ++g) {
+        ASSERT_EQ(expected[g].id, merged[g].id);
+        ASSERT_EQ(expected[g].elements.size(), merged[g].elements.size());
+        for (size_t e = 0; e < expected[g].elements.size(); ++e) {
+            const auto& want = expected[g].elements[e];
+            const auto& got = merged[g].elements[e];
+            ASSERT_EQ(want.key, got.key);
+            if (want.key == "STDDEV(amount)" || want.key == "AVG(amount)") {
+                ASSERT_TRUE(std::abs(std::get<double>(want.value) - std::get<double>(got.value)) < 1e-9);
+            } else {
+                ASSERT_TRUE(want.value == got.value);
+            }
+        }
+    }
+}
+
+TEST_CASE(AggregateStdDevOfPopulation) {
+    const auto select = parse_select("SELECT STDDEV(value), COUNT(*), COUNT(*) FROM data");
+    TissDB::Query::HashAggregator aggregator(select);
+    ASSERT_EQ(0.0, std::get<double>(*aggregate_field(aggregator.finish()[0], "STDDEV(value)")));
+
+    for (double value : {10.0, 20.0, 30.0}) {
+        aggregator.add(TissDB::Document{"d", {{"value", value}}});
+    }
+    aggregator.add(TissDB::Document{"d", {{"value", std::string("n/a")}}});
+    const auto result = aggregator.finish();
+    ASSERT_EQ(1, result.size());
+    ASSERT_TRUE(std::abs(std::sqrt(200.0 / 3.0) - std::get<double>(*aggregate_field(result[0], "STDDEV(value)"))) < 1e-12);
+    // A repeated aggregate is computed once for each time it is listed.
+    ASSERT_EQ(4.0, std::get<double>(result[0].elements[1].value));
+    ASSERT_EQ(4.0, std::get<double>(result[0].elements[2].value));
+}
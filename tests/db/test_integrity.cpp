@@ -78,10 +78,10 @@ TEST_CASE(SSTableChecksumValid) {
     doc1.id = "doc1";
     memtable.put("doc1", std::make_shared<TissDB::Document>(doc1));
 
-    std::string sstable_path = TissDB::Storage::SSTable::write_from_memtable(data_dir, memtable);
+    std::string sstable_path = TissDB::Storage::SSTable::write_from_memtable(data_dir, "test_collection", memtable);
 
     // This should load successfully
-    TissDB::Storage::SSTable sstable(sstable_path);
+    TissDB::Storage::SSTable sstable(sstable_path, "test_collection");
     auto result = sstable.find("doc1");
     ASSERT_TRUE(result.has_value());
 
@@ -99,13 +99,13 @@ TEST_CASE(SSTableChecksumInvalid) {
     doc1.id = "doc1";
     memtable.put("doc1", std::make_shared<TissDB::Document>(doc1));
 
-    std::string sstable_path = TissDB::Storage::SSTable::write_from_memtable(data_dir, memtable);
+    std::string sstable_path = TissDB::Storage::SSTable::write_from_memtable(data_dir, "test_collection", memtable);
 
     // Corrupt the SSTable file
     corrupt_file(sstable_path, 10, 0xAB);
 
     // This should fail to load
-    TissDB::Storage::SSTable sstable(sstable_path);
+    TissDB::Storage::SSTable sstable(sstable_path, "test_collection");
     auto result = sstable.find("doc1");
     ASSERT_FALSE(result.has_value()); // The SSTable should be invalid and thus empty
 
@@ -0,0 +1,169 @@
+#include "test_framework.h"
+#include "../../tissdb/query/cost_model.h"
+#include "../../tissdb/query/executor.h"
+#include "../../tissdb/query/join_algorithms.h"
+#include "../../tissdb/query/parser.h"
+#include "../../tissdb/storage/lsm_tree.h"
+#include <algorithm>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace {
+
+TissDB::Query::SharedDocuments make_join_side(const std::vector<std::pair<std::string, TissDB::Value>>& rows,
+                                              const std::string& field) {
+    TissDB::Query::SharedDocuments docs;
+    for (const auto& [id, value] : rows) {
+        TissDB::Document doc{id, {}};
+        if (!std::holds_alternative<std::nullptr_t>(value)) doc.elements.push_back({field, value});
+        docs.push_back(std::make_shared<const TissDB::Document>(doc));
+    }
+    return docs;
+}
+
+std::vector<std::string> sorted_ids(const std::vector<TissDB::Document>& docs) {
+    std::vector<std::string> ids;
+    for (const auto& doc : docs) ids.push_back(doc.id);
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+
+TissDB::Query::QueryResult run_join_query(TissDB::Storage::LSMTree& db, const std::string& query) {
+    TissDB::Query::Parser parser;
+    TissDB::Query::Executor executor(db);
+    return executor.execute(parser.parse(query), {});
+}
+
+} // anonymous namespace
+
+TEST_CASE(JoinKeysFollowEquality) {
+    using TissDB::Query::join_key;
+    auto key = [](const TissDB::Value& value) {
+        return join_key(TissDB::Document{"1", {{"k", value}}}, "k");
+    };
+    // Strings that read as numbers equal the number.
+    ASSERT_TRUE(key(std::string("7")) == key(7.0));
+    ASSERT_TRUE(key(std::string("7.0")) == key(7.0));
+    ASSERT_TRUE(key(-0.0) == key(0.0));
+    ASSERT_FALSE(key(std::string("abc")) == key(std::string("abd")));
+    ASSERT_TRUE(key(std::string("true")) == key(true));
+    // A missing field reads as null.
+    ASSERT_TRUE(join_key(TissDB::Document{"1", {}}, "k") == key(nullptr));
+    ASSERT_TRUE(join_key(TissDB::Document{"42", {}}, "_id") == key(42.0));
+    ASSERT_FALSE(key(TissDB::BinaryData{1, 2}).has_value());
+}
+
+TEST_CASE(JoinAlgorithmsAgree) {
+    using namespace TissDB::Query;
+    auto left = make_join_side({{"o1", std::string("c1")}, {"o2", std::string("c2")}, {"o3", std::string("c1")},
+                                {"o4", std::string("c9")}, {"o5", 3.0}, {"o6", TissDB::BinaryData{1}}},
+                               "cust");
+    auto right = make_join_side({{"c1", std::string("c1")}, {"c2", std::string("c2")}, {"c3", std::string("3")},
+                                 {"c4", std::string("c4")}},
+                                "cid");
+    auto ast = Parser().parse("SELECT * FROM o JOIN c ON o.cust = c.cid");
+    const auto on = CompiledExpression::predicate(std::get<SelectStatement>(ast).join_clause->on_condition, {});
+
+    const std::vector<std::pair<JoinType, size_t>> expected = {
+        {JoinType::INNER, 4}, {JoinType::LEFT, 6}, {JoinType::RIGHT, 5}, {JoinType::FULL, 7}};
+    const std::string spill_dir = "join_spill_test_dir";
+    std::filesystem::remove_all(spill_dir);
+    std::filesystem::create_directories(spill_dir);
+    set_join_spill_directory(spill_dir);
+    for (const auto& [type, rows] : expected) {
+        JoinSpec spec;
+        spec.type = type;
+        spec.left_alias = "o";
+        spec.right_alias = "c";
+        spec.left_key = "cust";
+        spec.right_key = "cid";
+        spec.on_condition = &on;
+
+        const auto nested = sorted_ids(JoinAlgorithms::nestedLoopJoin(left, right, spec));
+        ASSERT_EQ(rows, nested.size());
+        ASSERT_TRUE(nested == sorted_ids(JoinAlgorithms::hashJoin(left, right, spec, 0)));
+        ASSERT_TRUE(nested == sorted_ids(JoinAlgorithms::sortMergeJoin(left, right, spec)));
+        // A limit of one byte partitions both sides to disk.
+        ASSERT_TRUE(nested == sorted_ids(JoinAlgorithms::hashJoin(left, right, spec, 1)));
+    }
+    set_join_spill_directory("");
+    ASSERT_TRUE(std::filesystem::is_empty(spill_dir));
+    std::filesystem::remove_all(spill_dir);
+
+    // Unmatched rows keep their own side's fields, qualified.
+    JoinSpec spec{JoinType::LEFT, "o", "c", "cust", "cid", &on};
+    for (const auto& doc : JoinAlgorithms::hashJoin(left, right, spec, 0)) {
+        if (doc.id == "o4") {
+            ASSERT_EQ(2, doc.elements.size());
+            ASSERT_EQ("o.cust", doc.elements[1].key);
+        }
+    }
+}
+
+TEST_CASE(PlannerChoosesJoinAlgorithm) {
+    using namespace TissDB::Query;
+    std::vector<TissDB::Document> docs;
+    for (int i = 0; i < 1000; ++i) {
+        docs.push_back(TissDB::Document{std::to_string(i), {{"k", static_cast<double>(i)}}});
+    }
+    const auto stats = TissDB::Storage::CollectionStatistics::analyze(docs);
+
+    JoinInputs inputs;
+    inputs.left_rows = 1000;
+    inputs.left_stats = &stats;
+    inputs.right_stats = &stats;
+    inputs.left_key = "k";
+    inputs.right_key = "k";
+    inputs.left_is_full_scan = true;
+    ASSERT_TRUE(JoinStrategy::Hash == choose_join_strategy(inputs));
+
+    // Both sides already in key order: merging them is cheapest.
+    inputs.left_sorted = inputs.right_sorted = true;
+    ASSERT_TRUE(JoinStrategy::SortMerge == choose_join_strategy(inputs));
+
+    // Neither side fits in memory: sort-merge is out, and the hash join spills.
+    inputs.memory_rows = 100;
+    ASSERT_TRUE(JoinStrategy::Hash == choose_join_strategy(inputs));
+    // Unless an index avoids holding either side.
+    inputs.right_indexed = true;
+    ASSERT_TRUE(JoinStrategy::LookupRight == choose_join_strategy(inputs));
+
+    // Without statistics a hash join is the default.
+    TissDB::Storage::CollectionStatistics none;
+    inputs.right_stats = &none;
+    inputs.right_indexed = false;
+    ASSERT_TRUE(JoinStrategy::Hash == choose_join_strategy(inputs));
+}
+
+TEST_CASE(OuterJoinsThroughExecutor) {
+    const std::string db_path = "join_test_db";
+    std::filesystem::remove_all(db_path);
+    {
+        TissDB::Storage::LSMTree db(db_path);
+        db.create_collection("orders", TissDB::Schema());
+        db.create_collection("customers", TissDB::Schema());
+        for (int i = 0; i < 30; ++i) {
+            const std::string id = "o" + std::to_string(i);
+            db.put("orders", id, TissDB::Document{id, {{"cust", "c" + std::to_string(i % 12)}, {"qty", static_cast<double>(i)}}});
+        }
+        for (int i = 0; i < 10; ++i) {
+            const std::string id = "c" + std::to_string(i);
+            db.put("customers", id, TissDB::Document{id, {{"name", "name" + std::to_string(i)}}});
+        }
+
+        for (size_t limit : {size_t{64} * 1024 * 1024, size_t{1}}) {
+            TissDB::Query::set_join_memory_limit(limit);
+            // Orders of c10 and c11 have no customer; every customer has orders.
+            ASSERT_EQ(26, run_join_query(db, "SELECT * FROM orders JOIN customers ON orders.cust = customers._id").size());
+            ASSERT_EQ(30, run_join_query(db, "SELECT * FROM orders o LEFT JOIN customers c ON c._id = o.cust").size());
+            ASSERT_EQ(26, run_join_query(db, "SELECT * FROM orders RIGHT JOIN customers ON orders.cust = customers._id").size());
+            auto full = run_join_query(db, "SELECT * FROM customers FULL JOIN orders ON customers._id = orders.cust");
+            ASSERT_EQ(30, full.size());
+            auto filtered = run_join_query(db, "SELECT * FROM orders LEFT JOIN customers ON orders.cust = customers._id WHERE orders.qty >= 22");
+            ASSERT_EQ(8, filtered.size());
+        }
+        TissDB::Query::set_join_memory_limit(64 * 1024 * 1024);
+    }
+    std::filesystem::remove_all(db_path);
+}
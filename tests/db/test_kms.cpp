@@ -0,0 +1,76 @@
+#include "test_framework.h"
+#include "../../tissdb/crypto/kms.h"
+
+namespace {
+TissDB::Crypto::Key test_master_key() {
+    return {0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08,
+            0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0x10};
+}
+
+TissDB::Crypto::Buffer make_buffer(size_t size) {
+    TissDB::Crypto::Buffer buf(size);
+    for (size_t i = 0; i < size; ++i) {
+        buf[i] = static_cast<TissDB::Crypto::byte>((i * 31 + 7) & 0xFF);
+    }
+    return buf;
+}
+} // anonymous namespace
+
+TEST_CASE(KMSHandleMatchesKeyCipher) {
+    TissDB::Crypto::KeyManagementSystem kms(test_master_key());
+    auto dek = kms.get_dek("coll");
+    auto handle = kms.get_dek_handle("coll");
+    ASSERT_TRUE(handle->key() == dek);
+
+    for (size_t size : {0, 1, 7, 31, 32, 33, 100, 4099}) {
+        auto plain = make_buffer(size);
+        auto legacy = kms.encrypt(plain, dek);
+        auto fast = kms.encrypt(plain, *handle);
+        ASSERT_TRUE(legacy == fast);
+        ASSERT_TRUE(kms.decrypt(fast, *handle) == plain);
+    }
+}
+
+TEST_CASE(KMSApplyKeystreamWithOffset) {
+    TissDB::Crypto::KeyManagementSystem kms(test_master_key());
+    auto handle = kms.get_dek_handle("coll");
+    auto plain = make_buffer(1000);
+    auto expected = kms.encrypt(plain, *handle);
+
+    // Encrypting a record in uneven pieces must give the same result as one pass.
+    auto pieces = plain;
+    size_t pos = 0;
+    for (size_t chunk : {3, 61, 5, 200, 731}) {
+        TissDB::Crypto::KeyManagementSystem::apply_keystream(pieces.data() + pos, chunk, *handle, pos);
+        pos += chunk;
+    }
+    ASSERT_EQ(plain.size(), pos);
+    ASSERT_TRUE(pieces == expected);
+}
+
+TEST_CASE(KMSBatchRoundTrip) {
+    TissDB::Crypto::KeyManagementSystem kms(test_master_key());
+    auto handle = kms.get_dek_handle("coll");
+
+    std::vector<TissDB::Crypto::Buffer> records = {make_buffer(10), make_buffer(0), make_buffer(257)};
+    auto originals = records;
+    TissDB::Crypto::KeyManagementSystem::encrypt_batch(records, *handle);
+    for (size_t i = 0; i < records.size(); ++i) {
+        ASSERT_TRUE(records[i] == kms.encrypt(originals[i], handle->key()));
+    }
+    TissDB::Crypto::KeyManagementSystem::decrypt_batch(records, *handle);
+    ASSERT_TRUE(records == originals);
+}
+
+TEST_CASE(KMSHandleCacheInvalidation) {
+    TissDB::Crypto::KeyManagementSystem kms(test_master_key());
+    auto first = kms.get_dek_handle("coll");
+    auto second = kms.get_dek_handle("coll");
+    ASSERT_TRUE(first.get() == second.get());
+
+    kms.delete_dek("coll");
+    auto third = kms.get_dek_handle("coll");
+    ASSERT_TRUE(first.get() != third.get());
+    // The old handle stays usable after the key is shredded.
+    ASSERT_FALSE(first->empty());
+}
@@ -0,0 +1,106 @@
+#include "test_framework.h"
+#include "../../tissdb/common/log.h"
+#include <cstdio>
+#include <string>
+#include <thread>
+
+namespace {
+// Redirects the log to a temporary file for the life of the object.
+class CapturedLog {
+public:
+    CapturedLog() : file_(std::tmpfile()) { TissDB::Log::set_output(file_); }
+    ~CapturedLog() {
+        TissDB::Log::set_output(stderr);
+        std::fclose(file_);
+    }
+
+    std::string text() {
+        TissDB::Log::flush();
+        std::string text;
+        std::rewind(file_);
+        char chunk[4096];
+        size_t n;
+        while ((n = std::fread(chunk, 1, sizeof(chunk), file_)) > 0) text.append(chunk, n);
+        return text;
+    }
+
+private:
+    std::FILE* file_;
+};
+
+size_t count_occurrences(const std::string& text, const std::string& needle) {
+    size_t count = 0;
+    for (size_t pos = text.find(needle); pos != std::string::npos; pos = text.find(needle, pos + 1)) ++count;
+    return count;
+}
+
+int log_argument_evaluations = 0;
+std::string counted_argument() {
+    ++log_argument_evaluations;
+    return "evaluated";
+}
+} // anonymous namespace
+
+TEST_CASE(LogSkipsDisabledLevelsWithoutFormatting) {
+    const LogLevel saved = TissDB::Log::level();
+    CapturedLog captured;
+    TissDB::Log::set_level(LogLevel::INFO);
+    log_argument_evaluations = 0;
+    LOG_DEBUG("hidden " << counted_argument());
+    ASSERT_EQ(0, log_argument_evaluations);
+    LOG_INFO("shown " << counted_argument() << " " << 42);
+    ASSERT_EQ(1, log_argument_evaluations);
+
+    TissDB::Log::set_level(LogLevel::DEBUG);
+    LOG_DEBUG("now shown " << counted_argument());
+    ASSERT_EQ(2, log_argument_evaluations);
+    TissDB::Log::set_level(saved);
+
+    const std::string text = captured.text();
+    ASSERT_EQ(std::string::npos, text.find("hidden"));
+    ASSERT_NE(std::string::npos, text.find("[INFO] "));
+    ASSERT_NE(std::string::npos, text.find("shown evaluated 42\n"));
+    ASSERT_NE(std::string::npos, text.find("[DEBUG] "));
+    ASSERT_NE(std::string::npos, text.find("now shown evaluated\n"));
+
+    LogLevel parsed;
+    ASSERT_TRUE(TissDB::Log::parse_level("Warning", parsed));
+    ASSERT_TRUE(parsed == LogLevel::WARNING);
+    ASSERT_FALSE(TissDB::Log::parse_level("verbose", parsed));
+}
+
+TEST_CASE(LogKeepsEveryThreadsLinesWhole) {
+    CapturedLog captured;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([t] {
+            for (int i = 0; i < 500; ++i) LOG_WARNING("thread " << t << " line " << i << " end");
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    const std::string text = captured.text();
+    ASSERT_EQ(2000, count_occurrences(text, " end\n"));
+    ASSERT_EQ(2000, count_occurrences(text, "[WARNING]"));
+    ASSERT_NE(std::string::npos, text.find("thread 3 line 499 end\n"));
+}
+
+TEST_CASE(LogRateLimitsRepeatedMessages) {
+    CapturedLog captured;
+    for (int i = 0; i < 100; ++i) {
+        LOG_EVERY_N_SEC(LogLevel::WARNING, 3600, "repeated failure " << i);
+    }
+    std::string text = captured.text();
+    ASSERT_EQ(1, count_occurrences(text, "repeated failure"));
+    ASSERT_NE(std::string::npos, text.find("repeated failure 0\n"));
+
+    // The next message through reports how many were held back.
+    TissDB::Log::RateLimiter limiter(std::chrono::milliseconds(20));
+    uint64_t suppressed = 0;
+    ASSERT_TRUE(limiter.allow(suppressed));
+    ASSERT_EQ(0, suppressed);
+    ASSERT_FALSE(limiter.allow(suppressed));
+    ASSERT_FALSE(limiter.allow(suppressed));
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    ASSERT_TRUE(limiter.allow(suppressed));
+    ASSERT_EQ(2, suppressed);
+}
@@ -2,6 +2,9 @@
 #include "../../tissdb/storage/lsm_tree.h"
 #include "../../tissdb/common/document.h"
 #include "../../tissdb/common/schema.h"
+#include <filesystem>
+#include <thread>
+#include <chrono>
 
 TEST_CASE(LSMTreeCreateDropCollection) {
     TissDB::Storage::LSMTree db;
@@ -89,3 +92,135 @@ TEST_CASE(LSMTreeOperationsOnNonExistentCollection) {
     ASSERT_FALSE(retrieved_doc_opt.has_value());
     //db.del("non_existent", "doc1");
 }
+
+TEST_CASE(LSMTreeCheckpointAndReopen) {
+    std::string db_path = "lsm_checkpoint_test_db";
+    std::filesystem::remove_all(db_path);
+
+    {
+        TissDB::Storage::LSMTree db(db_path);
+        db.create_collection("items", TissDB::Schema());
+        for (int i = 0; i < 40; ++i) {
+            TissDB::Document doc;
+            TissDB::Element elem; elem.key = "n"; elem.value = static_cast<double>(i);
+            doc.elements.push_back(elem);
+            db.put("items", "item" + std::to_string(i), doc);
+        }
+        db.checkpoint();
+
+        // Writes after the checkpoint live only in memory and the WAL.
+        ASSERT_TRUE(db.del("items", "item3"));
+        TissDB::Document doc;
+        TissDB::Element elem; elem.key = "n"; elem.value = 100.0;
+        doc.elements.push_back(elem);
+        db.put("items", "item5", doc);
+
+        ASSERT_EQ(1, db.get_collection("items").get_sstable_files().size());
+        auto deleted = db.get("items", "item3");
+        ASSERT_TRUE(deleted.has_value());
+        ASSERT_TRUE(*deleted == nullptr);
+        ASSERT_EQ(39, db.scan("items").size());
+    }
+
+    {
+        TissDB::Storage::LSMTree db(db_path);
+        ASSERT_EQ(39, db.scan("items").size());
+        auto item5 = db.get("items", "item5");
+        ASSERT_TRUE(item5.has_value() && *item5);
+        ASSERT_EQ(100.0, std::get<double>((*item5)->elements[0].value));
+        auto item7 = db.get("items", "item7");
+        ASSERT_TRUE(item7.has_value() && *item7);
+        ASSERT_EQ("item7", (*item7)->id);
+        ASSERT_FALSE(db.del("items", "item3"));
+    }
+
+    std::filesystem::remove_all(db_path);
+}
+
+TEST_CASE(LSMTreeLazyCollectionOpen) {
+    using TissDB::Storage::CollectionLoadState;
+    std::string db_path = "lsm_lazy_test_db";
+    std::filesystem::remove_all(db_path);
+
+    {
+        TissDB::Storage::LSMTree db(db_path);
+        for (const std::string name : {"hot", "cold"}) {
+            db.create_collection(name, TissDB::Schema());
+            TissDB::Document doc;
+            TissDB::Element elem; elem.key = "name"; elem.value = name;
+            doc.elements.push_back(elem);
+            db.put(name, "k", doc);
+        }
+        db.shutdown();
+    }
+
+    {
+        // Without a loader pool, collections open only when first used.
+        TissDB::Storage::LSMTree db(db_path);
+        auto states = db.get_collection_states();
+        ASSERT_EQ(2, states.size());
+        ASSERT_TRUE(states["hot"] == CollectionLoadState::Unloaded);
+        ASSERT_TRUE(states["cold"] == CollectionLoadState::Unloaded);
+
+        ASSERT_EQ(1, db.scan("hot").size());
+        states = db.get_collection_states();
+        ASSERT_TRUE(states["hot"] == CollectionLoadState::Ready);
+        ASSERT_TRUE(states["cold"] == CollectionLoadState::Unloaded);
+    }
+
+    {
+        // With a pool, every collection is loaded in the background.
+        TissDB::Common::ThreadPool pool(2);
+        {
+            TissDB::Storage::LSMTree db(db_path, &pool);
+            ASSERT_EQ(1, db.scan("cold").size());
+        }
+        TissDB::Storage::LSMTree db(db_path, &pool);
+        pool.submit([] {}).wait(); // FIFO: earlier load tasks have been picked up
+        for (int i = 0; i < 100; ++i) {
+            auto states = db.get_collection_states();
+            if (states["hot"] == CollectionLoadState::Ready && states["cold"] == CollectionLoadState::Ready) break;
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        auto states = db.get_collection_states();
+        ASSERT_TRUE(states["hot"] == CollectionLoadState::Ready);
+        ASSERT_TRUE(states["cold"] == CollectionLoadState::Ready);
+    }
+
+    std::filesystem::remove_all(db_path);
+}
+
+TEST_CASE(LSMTreeGetManyMergesSources) {
+    const std::string db_path = "lsm_get_many_test_db";
+    std::filesystem::remove_all(db_path);
+    {
+        TissDB::Storage::LSMTree db(db_path);
+        db.create_collection("items", TissDB::Schema());
+        auto make_doc = [](double v) {
+            TissDB::Document doc;
+            TissDB::Element elem; elem.key = "v"; elem.value = v;
+            doc.elements.push_back(elem);
+            return doc;
+        };
+        for (int i = 0; i < 100; ++i) {
+            db.put("items", "k" + std::to_string(i), make_doc(i));
+        }
+        db.checkpoint();
+        db.put("items", "k10", make_doc(1000)); // Newer version in memory
+        db.del("items", "k20");                 // Shadows the flushed document
+        db.checkpoint();
+        db.put("items", "k30", make_doc(3000));
+
+        // Results follow the requested order, duplicates included.
+        auto docs = db.get_many("items", {"k30", "k10", "missing", "k20", "k5", "k10"});
+        ASSERT_EQ(4, docs.size());
+        ASSERT_EQ("k30", docs[0].id);
+        ASSERT_EQ(3000.0, std::get<double>(docs[0].elements[0].value));
+        ASSERT_EQ("k10", docs[1].id);
+        ASSERT_EQ(1000.0, std::get<double>(docs[1].elements[0].value));
+        ASSERT_EQ("k5", docs[2].id);
+        ASSERT_EQ(5.0, std::get<double>(docs[2].elements[0].value));
+        ASSERT_EQ("k10", docs[3].id);
+    }
+    std::filesystem::remove_all(db_path);
+}
@@ -4,6 +4,10 @@
 // Include individual test files here
 #include "test_document.cpp"
 #include "test_wal.cpp"
+#include "test_kms.cpp"
+#include "test_checksum.cpp"
+#include "test_log.cpp"
+#include "test_metrics.cpp"
 
 #include "test_memtable_extended.cpp"
 #include "test_sstable.cpp"
@@ -12,6 +16,14 @@
 #include "test_collection.cpp"
 #include "test_constraints.cpp"
 #include "test_lsm_tree.cpp"
+#include "test_backup.cpp"
+#include "test_compaction.cpp"
+#include "test_memory_governor.cpp"
+#include "test_statistics.cpp"
+#include "test_change_feed.cpp"
+#include "test_replication.cpp"
+#include "test_sharding.cpp"
+#include "test_audit_logger.cpp"
 #include "test_parser.cpp"
 #include "test_executor.cpp"
 #include "test_serialization.cpp"
@@ -19,6 +31,16 @@
 #include "test_transactions.cpp"
 #include "test_stddev.cpp"
 #include "test_query_executor.cpp"
+#include "test_vectorized.cpp"
+#include "test_compiled_expression.cpp"
+#include "test_row_stream.cpp"
+#include "test_join.cpp"
+#include "test_top_n.cpp"
+#include "test_hash_aggregate.cpp"
+#include "test_parallel.cpp"
+#include "test_statement_cache.cpp"
+#include "test_explain.cpp"
+#include "test_batched_writes.cpp"
 #include "test_timestamp.cpp"
 
 #include "test_tissdb_client.cpp"
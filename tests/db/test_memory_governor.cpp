@@ -0,0 +1,81 @@
+#include "test_framework.h"
+#include "../../tissdb/common/memory_governor.h"
+#include "../../tissdb/storage/lsm_tree.h"
+#include <filesystem>
+
+TEST_CASE(MemoryGovernorAccounting) {
+    TissDB::Common::MemoryGovernor governor;
+    governor.adjust(TissDB::Common::MemorySubsystem::Memtable, 1000);
+    governor.adjust(TissDB::Common::MemorySubsystem::Index, 500);
+    governor.adjust(TissDB::Common::MemorySubsystem::Memtable, -400);
+    ASSERT_EQ(600, governor.usage(TissDB::Common::MemorySubsystem::Memtable));
+    ASSERT_EQ(1100, governor.total());
+    ASSERT_EQ(1500, governor.stats().peak);
+    ASSERT_FALSE(governor.over_budget()); // No budget set
+
+    governor.set_budget(1200);
+    ASSERT_TRUE(governor.try_reserve_query(100));
+    ASSERT_FALSE(governor.try_reserve_query(100)); // Nothing can be reclaimed
+    ASSERT_EQ(1, governor.stats().queries_rejected);
+    governor.release_query(100);
+    ASSERT_EQ(1100, governor.total());
+}
+
+TEST_CASE(MemoryGovernorReclaimsLargestFirst) {
+    TissDB::Common::MemoryGovernor governor;
+    governor.set_budget(1000);
+    size_t small = 100;
+    size_t large = 900;
+    governor.adjust(TissDB::Common::MemorySubsystem::Memtable, static_cast<int64_t>(small + large + 100));
+
+    auto make_reclaimer = [&governor](size_t& held) {
+        TissDB::Common::MemoryGovernor::Reclaimer reclaimer;
+        reclaimer.usage = [&held] { return held; };
+        reclaimer.reclaim = [&governor, &held] {
+            size_t freed = held;
+            governor.adjust(TissDB::Common::MemorySubsystem::Memtable, -static_cast<int64_t>(freed));
+            held = 0;
+            return freed;
+        };
+        return reclaimer;
+    };
+    uint64_t small_id = governor.register_reclaimer(make_reclaimer(small));
+    uint64_t large_id = governor.register_reclaimer(make_reclaimer(large));
+
+    governor.admit_write();
+    ASSERT_EQ(0, large); // Freeing the large one was enough
+    ASSERT_EQ(100, small);
+    ASSERT_FALSE(governor.over_budget());
+    ASSERT_EQ(1, governor.stats().reclaims);
+
+    governor.unregister_reclaimer(small_id);
+    governor.unregister_reclaimer(large_id);
+}
+
+TEST_CASE(MemoryGovernorFlushesDatabasesOverBudget) {
+    const std::string db_path = "memory_governor_test_db";
+    std::filesystem::remove_all(db_path);
+    auto& governor = TissDB::Common::MemoryGovernor::instance();
+    {
+        TissDB::Storage::CompactionOptions options;
+        options.background = false;
+        TissDB::Storage::LSMTree db(db_path, nullptr, options);
+        db.create_collection("docs", TissDB::Schema());
+
+        const uint64_t baseline = governor.total();
+        governor.set_budget(baseline + 64 * 1024);
+        TissDB::Document doc;
+        TissDB::Element elem; elem.key = "payload"; elem.value = std::string(1024, 'x');
+        doc.elements.push_back(elem);
+        for (int i = 0; i < 200; ++i) {
+            db.put("docs", "doc" + std::to_string(i), doc);
+        }
+        // 200 KiB of writes against a 64 KiB budget forced checkpoints.
+        ASSERT_TRUE(governor.stats().reclaims > 0);
+        ASSERT_FALSE(db.get_collection("docs").get_sstable_files().empty());
+        ASSERT_TRUE(governor.usage(TissDB::Common::MemorySubsystem::Memtable) < 64 * 1024);
+        ASSERT_EQ(200, db.scan("docs").size());
+        governor.set_budget(0);
+    }
+    std::filesystem::remove_all(db_path);
+}
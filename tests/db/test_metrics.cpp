@@ -0,0 +1,88 @@
+#include "test_framework.h"
+#include "../../tissdb/common/metrics.h"
+#include "../../tissdb/storage/lsm_tree.h"
+#include <filesystem>
+#include <string>
+#include <thread>
+
+TEST_CASE(MetricsHistogramBucketsAreLogLinear) {
+    using TissDB::Common::Histogram;
+    // Every value lands in a bucket whose bounds are within 12.5% of it.
+    for (uint64_t v : {0ull, 1ull, 7ull, 8ull, 9ull, 15ull, 16ull, 1000ull, 123456789ull, 1ull << 40}) {
+        const size_t bucket = Histogram::bucket_of(v);
+        ASSERT_TRUE(Histogram::bucket_lower_bound(bucket) <= v);
+        ASSERT_TRUE(v < Histogram::bucket_lower_bound(bucket + 1));
+        ASSERT_TRUE(Histogram::bucket_lower_bound(bucket + 1) - Histogram::bucket_lower_bound(bucket) <=
+                    std::max<uint64_t>(1, v / 8));
+    }
+    ASSERT_EQ(Histogram::BUCKETS - 1, Histogram::bucket_of(~0ull));
+
+    Histogram histogram;
+    for (uint64_t i = 1; i <= 1000; ++i) histogram.record(i * 1000); // 1 us .. 1 ms
+    const auto snapshot = histogram.snapshot();
+    ASSERT_EQ(1000, snapshot.count);
+    ASSERT_EQ(500500000ull, snapshot.sum_ns);
+    const uint64_t p50 = snapshot.quantile(0.5);
+    const uint64_t p99 = snapshot.quantile(0.99);
+    ASSERT_TRUE(p50 >= 500000 && p50 <= 500000 * 9 / 8);
+    ASSERT_TRUE(p99 >= 990000 && p99 <= 990000 * 9 / 8);
+    ASSERT_EQ(0, Histogram().snapshot().quantile(0.5));
+}
+
+TEST_CASE(MetricsCountersSumAcrossThreads) {
+    auto& counter = TissDB::Common::Metrics::instance().counter("test_counter_total", "Test counter.");
+    const uint64_t before = counter.value();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t) {
+        threads.emplace_back([&counter] {
+            for (int i = 0; i < 10000; ++i) counter.add();
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    ASSERT_EQ(before + 80000, counter.value());
+    // The same name and labels give back the same counter.
+    ASSERT_TRUE(&counter == &TissDB::Common::Metrics::instance().counter("test_counter_total", "Test counter."));
+}
+
+TEST_CASE(MetricsExportPrometheusText) {
+    auto& registry = TissDB::Common::Metrics::instance();
+    registry.histogram("test_latency_seconds", "Test latency.", "stage=\"a\"").record(3000); // 3 us
+    registry.counter("test_requests_total", "Test requests.", "code=\"200\"").add(2);
+
+    std::string text;
+    registry.export_prometheus(text);
+    ASSERT_NE(std::string::npos, text.find("# HELP test_latency_seconds Test latency.\n"));
+    ASSERT_NE(std::string::npos, text.find("# TYPE test_latency_seconds histogram\n"));
+    ASSERT_NE(std::string::npos, text.find("test_latency_seconds_bucket{stage=\"a\",le=\"2.048e-06\"} 0\n"));
+    ASSERT_NE(std::string::npos, text.find("test_latency_seconds_bucket{stage=\"a\",le=\"4.096e-06\"} 1\n"));
+    ASSERT_NE(std::string::npos, text.find("test_latency_seconds_bucket{stage=\"a\",le=\"+Inf\"} 1\n"));
+    ASSERT_NE(std::string::npos, text.find("test_latency_seconds_sum{stage=\"a\"} 3e-06\n"));
+    ASSERT_NE(std::string::npos, text.find("test_latency_seconds_count{stage=\"a\"} 1\n"));
+    ASSERT_NE(std::string::npos, text.find("# TYPE test_requests_total counter\n"));
+    ASSERT_NE(std::string::npos, text.find("test_requests_total{code=\"200\"} 2\n"));
+}
+
+TEST_CASE(MetricsRecordStorageOperations) {
+    const std::string path = "metrics_test_db";
+    std::filesystem::remove_all(path);
+    auto& registry = TissDB::Common::Metrics::instance();
+    auto& wal_appends = registry.histogram("tissdb_wal_append_seconds", "");
+    auto& wal_bytes = registry.counter("tissdb_wal_bytes_total", "");
+    auto& memtable_hits = registry.counter("tissdb_memtable_reads_total", "", "result=\"hit\"");
+    const uint64_t appends_before = wal_appends.snapshot().count;
+    const uint64_t bytes_before = wal_bytes.value();
+    const uint64_t hits_before = memtable_hits.value();
+    {
+        TissDB::Storage::LSMTree db(path);
+        db.create_collection("items", TissDB::Schema());
+        TissDB::Document doc;
+        doc.id = "a";
+        doc.elements.push_back({"name", std::string("widget")});
+        db.put("items", "a", doc);
+        ASSERT_TRUE(db.get("items", "a").has_value());
+    }
+    ASSERT_TRUE(wal_appends.snapshot().count >= appends_before + 2); // Create and put
+    ASSERT_TRUE(wal_bytes.value() > bytes_before);
+    ASSERT_TRUE(memtable_hits.value() > hits_before);
+    std::filesystem::remove_all(path);
+}
@@ -92,3 +92,22 @@ TEST_CASE(NativeBTreeSerialization) {
 
     std::filesystem::remove(file_path);
 }
+
+TEST_CASE(BTreeInsertReplacesExistingKey) {
+    TissDB::Storage::BTree<std::string, std::string> btree;
+    for (int i = 0; i < 500; ++i) {
+        btree.insert("key" + std::to_string(i), "old");
+    }
+    // Keys promoted into internal nodes by splits must be replaced too.
+    for (int i = 0; i < 500; ++i) {
+        btree.insert("key" + std::to_string(i), "new" + std::to_string(i));
+    }
+    size_t entries = 0;
+    btree.foreach([&](const std::string&, const std::string&) { ++entries; });
+    ASSERT_EQ(500, entries);
+    for (int i = 0; i < 500; ++i) {
+        auto result = btree.find("key" + std::to_string(i));
+        ASSERT_TRUE(result.has_value());
+        ASSERT_EQ("new" + std::to_string(i), result.value());
+    }
+}
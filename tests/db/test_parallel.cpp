@@ -0,0 +1,61 @@
+#include "test_framework.h"
+#include "../../tissdb/query/executor.h"
+#include "../../tissdb/query/parallel.h"
+#include "../../tissdb/query/parser.h"
+#include <atomic>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+TEST_CASE(MorselsRunOnceEach) {
+    std::vector<std::atomic<int>> runs(1000);
+    std::atomic<size_t> max_worker{0};
+    TissDB::Query::run_morsels(4, runs.size(), [&](size_t worker, size_t morsel) {
+        runs[morsel]++;
+        size_t seen = max_worker.load();
+        while (worker > seen && !max_worker.compare_exchange_weak(seen, worker)) {}
+    });
+    for (const auto& count : runs) ASSERT_EQ(1, count.load());
+    ASSERT_TRUE(max_worker.load() < 4);
+
+    // The first failure reaches the caller, after every worker has stopped.
+    std::atomic<int> started{0};
+    ASSERT_THROW(TissDB::Query::run_morsels(4, 1000, [&](size_t, size_t morsel) {
+        started++;
+        if (morsel == 7) throw std::runtime_error("morsel failed");
+    }), std::runtime_error);
+    ASSERT_TRUE(started.load() < 1000);
+}
+
+TEST_CASE(ParallelSelectMatchesSerial) {
+    MockLSMTree db;
+    db.create_collection("events", TissDB::Schema{});
+    for (int i = 0; i < 100000; ++i) {
+        const std::string id = "e" + std::to_string(i);
+        TissDB::Document doc{id, {{"kind", "k" + std::to_string(i % 13)}, {"size", static_cast<double>((i * 7) % 1000)}}};
+        if (i % 5 != 0) doc.elements.push_back({"user", static_cast<double>(i % 977)});
+        db.put("events", id, doc);
+    }
+    ASSERT_TRUE(TissDB::Query::parallel_task_count(100000) > 1);
+
+    const std::vector<std::string> queries = {
+        "SELECT kind, COUNT(*), SUM(size), MIN(size), MAX(size), AVG(size), COUNT(user) FROM events GROUP BY kind",
+        "SELECT user, COUNT(*) FROM events WHERE size > 500 GROUP BY user ORDER BY COUNT(*) DESC, user LIMIT 10",
+        "SELECT COUNT(*), SUM(user) FROM events WHERE kind = 'k3'",
+        "SELECT kind, size FROM events WHERE size < 20",
+        "SELECT * FROM events WHERE user >= 970",
+        "SELECT kind, user FROM events ORDER BY size DESC, _id LIMIT 25",
+    };
+    TissDB::Query::Parser parser;
+    for (const auto& query : queries) {
+        const auto ast = parser.parse(query);
+        TissDB::Query::Executor serial(db);
+        serial.set_parallelism(1);
+        const auto expected = serial.execute(ast, {});
+        TissDB::Query::Executor parallel(db);
+        const auto actual = parallel.execute(ast, {});
+        ASSERT_TRUE(!expected.empty());
+        ASSERT_EQ(expected.size(), actual.size());
+        ASSERT_TRUE(expected == actual);
+    }
+}
@@ -0,0 +1,101 @@
+#include "test_framework.h"
+#include "../../tissdb/storage/lsm_tree.h"
+#include "../../tissdb/replication/change_codec.h"
+#include "../../tissdb/replication/follower.h"
+#include "../../tissdb/common/document.h"
+#include <filesystem>
+
+namespace {
+TissDB::Storage::CompactionOptions replica_test_compaction() {
+    TissDB::Storage::CompactionOptions options;
+    options.background = false;
+    return options;
+}
+
+// Builds the reply the leader's `_changes` endpoint sends with format=binary.
+TissDB::Json::JsonValue changes_reply(const TissDB::Storage::ChangeBatch& batch) {
+    TissDB::Json::JsonArray changes;
+    for (const auto& event : batch.events) {
+        changes.push_back(TissDB::Json::JsonValue(TissDB::Replication::encode_change(event)));
+    }
+    TissDB::Json::JsonObject reply;
+    reply["changes"] = TissDB::Json::JsonValue(changes);
+    reply["next"] = TissDB::Json::JsonValue(static_cast<double>(batch.next_since));
+    reply["last_lsn"] = TissDB::Json::JsonValue(static_cast<double>(batch.last_lsn));
+    // Round-trip through text, as over the wire.
+    return TissDB::Json::JsonValue::parse(TissDB::Json::JsonValue(reply).serialize());
+}
+} // anonymous namespace
+
+TEST_CASE(ReplicaAppliesLeaderChanges) {
+    const std::string leader_path = "replication_leader_db";
+    const std::string replica_path = "replication_replica_db";
+    std::filesystem::remove_all(leader_path);
+    std::filesystem::remove_all(replica_path);
+    {
+        TissDB::Storage::LSMTree leader(leader_path, nullptr, replica_test_compaction());
+        TissDB::Storage::LSMTree replica(replica_path, nullptr, replica_test_compaction());
+        leader.create_collection("docs", TissDB::Schema());
+
+        TissDB::Document doc;
+        TissDB::Element text; text.key = "title"; text.value = std::string("hello");
+        TissDB::Element number; number.key = "score"; number.value = 0.5;
+        TissDB::Element flag; flag.key = "draft"; flag.value = true;
+        doc.elements = {text, number, flag};
+        leader.put("docs", "a", doc);
+        leader.put("docs", "b", doc);
+        ASSERT_TRUE(leader.del("docs", "a"));
+
+        auto reply = changes_reply(leader.read_changes(replica.last_sequence(), 100));
+        ASSERT_EQ(3, TissDB::Replication::Follower::apply_batch(replica, reply));
+        ASSERT_EQ(3, replica.last_sequence());
+        ASSERT_FALSE(replica.get("docs", "a").has_value() && *replica.get("docs", "a"));
+        auto copied = replica.get("docs", "b");
+        ASSERT_TRUE(copied.has_value() && *copied);
+        ASSERT_EQ("hello", std::get<std::string>((*copied)->elements[0].value));
+        ASSERT_EQ(0.5, std::get<double>((*copied)->elements[1].value));
+        ASSERT_TRUE(std::get<bool>((*copied)->elements[2].value));
+
+        // A batch that is delivered twice is applied once.
+        TissDB::Replication::Follower::apply_batch(replica, reply);
+        ASSERT_EQ(3, replica.last_sequence());
+        ASSERT_EQ(1, replica.scan("docs").size());
+
+        // The replica's own feed carries the leader's sequence numbers.
+        ASSERT_EQ(3, replica.read_changes(0, 100).events.back().lsn);
+    }
+    {
+        // After a restart the replica resumes from what it applied.
+        TissDB::Storage::LSMTree replica(replica_path, nullptr, replica_test_compaction());
+        ASSERT_EQ(3, replica.last_sequence());
+        ASSERT_EQ(1, replica.scan("docs").size());
+    }
+    std::filesystem::remove_all(leader_path);
+    std::filesystem::remove_all(replica_path);
+}
+
+TEST_CASE(ChangeFeedKeepsSegmentsForConsumers) {
+    const std::string db_path = "replication_hold_db";
+    std::filesystem::remove_all(db_path);
+    {
+        TissDB::Storage::ChangeFeedOptions feed_options;
+        feed_options.retained_segments = 0;
+        TissDB::Storage::LSMTree db(db_path, nullptr, replica_test_compaction(), feed_options);
+        db.create_collection("events", TissDB::Schema());
+        TissDB::Document doc;
+        db.hold_changes("replica-1", 1);
+        for (int i = 0; i < 3; ++i) {
+            db.put("events", "k" + std::to_string(i), doc);
+            db.checkpoint();
+        }
+        // The consumer has read change 1: the segments from 2 on are kept.
+        ASSERT_EQ(2, db.earliest_change());
+        ASSERT_EQ(2, db.read_changes(1, 100).events.size());
+
+        db.hold_changes("replica-1", 3);
+        db.put("events", "k3", doc);
+        db.checkpoint();
+        ASSERT_EQ(4, db.earliest_change()); // Only what the consumer has not read
+    }
+    std::filesystem::remove_all(db_path);
+}
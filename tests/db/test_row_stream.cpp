@@ -0,0 +1,93 @@
+#include "test_framework.h"
+#include "../../tissdb/query/executor.h"
+#include "../../tissdb/query/parser.h"
+#include "../../tissdb/query/row_stream.h"
+#include "../../tissdb/storage/lsm_tree.h"
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Counts the rows pulled through it.
+class CountingStream : public TissDB::Query::RowStream {
+public:
+    explicit CountingStream(TissDB::Query::RowStream& input) : input_(input) {}
+    const TissDB::Document* next() override {
+        const TissDB::Document* row = input_.next();
+        if (row) ++pulled;
+        return row;
+    }
+    size_t pulled = 0;
+
+private:
+    TissDB::Query::RowStream& input_;
+};
+
+TissDB::Query::QueryResult run_stream_query(TissDB::Storage::LSMTree& db, const std::string& query) {
+    TissDB::Query::Parser parser;
+    TissDB::Query::Executor executor(db);
+    return executor.execute(parser.parse(query), {});
+}
+
+} // anonymous namespace
+
+TEST_CASE(RowStreamLimitStopsPulling) {
+    std::vector<TissDB::Document> docs;
+    for (int i = 0; i < 100; ++i) {
+        docs.push_back(TissDB::Document{std::to_string(i), {{"level", std::string(i % 10 == 0 ? "ERROR" : "INFO")}}});
+    }
+    TissDB::Query::Parser parser;
+    auto ast = parser.parse("SELECT * FROM logs WHERE level = 'ERROR'");
+    const auto& where = *std::get<TissDB::Query::SelectStatement>(ast).where_clause;
+
+    TissDB::Query::DocumentRows rows;
+    for (const auto& doc : docs) rows.push_back(&doc);
+    TissDB::Query::ScanStream scan(rows);
+    CountingStream counted(scan);
+    TissDB::Query::FilterStream filter(counted, TissDB::Query::CompiledExpression::predicate(where, {}));
+    TissDB::Query::LimitStream limit(filter, 3);
+    auto result = TissDB::Query::drain(limit);
+
+    ASSERT_EQ(3, result.size());
+    ASSERT_EQ("20", result[2].id);
+    // The third match is the 21st document; nothing after it is read.
+    ASSERT_EQ(21, counted.pulled);
+}
+
+TEST_CASE(RowStreamSelectWithPushdown) {
+    const std::string db_path = "row_stream_test_db";
+    std::filesystem::remove_all(db_path);
+    {
+        TissDB::Storage::LSMTree db(db_path);
+        db.create_collection("logs", TissDB::Schema());
+        for (int i = 0; i < 50; ++i) {
+            const std::string id = "log" + std::to_string(100 + i);
+            db.put("logs", id, TissDB::Document{id, {{"level", std::string(i % 5 == 0 ? "ERROR" : "INFO")},
+                                                     {"code", static_cast<double>(i)}}});
+        }
+        // Half of the documents on disk, so the scan merges both sources.
+        db.checkpoint();
+        db.put("logs", "log100", TissDB::Document{"log100", {{"level", std::string("INFO")}, {"code", 0.0}}});
+
+        auto shared = db.scan_shared("logs");
+        ASSERT_EQ(50, shared.size());
+        ASSERT_EQ("log100", shared[0]->id);
+
+        auto limited = run_stream_query(db, "SELECT code FROM logs WHERE level = 'ERROR' LIMIT 3");
+        ASSERT_EQ(3, limited.size());
+        ASSERT_EQ(5.0, std::get<double>(limited[0].elements[0].value));
+
+        ASSERT_EQ(9, run_stream_query(db, "SELECT * FROM logs WHERE level = 'ERROR'").size());
+        ASSERT_EQ(0, run_stream_query(db, "SELECT * FROM logs LIMIT 0").size());
+
+        // LIMIT applies after ORDER BY and aggregation.
+        auto sorted = run_stream_query(db, "SELECT code FROM logs WHERE level = 'ERROR' ORDER BY code DESC LIMIT 2");
+        ASSERT_EQ(2, sorted.size());
+        ASSERT_EQ(45.0, std::get<double>(sorted[0].elements[0].value));
+        auto counted = run_stream_query(db, "SELECT level, COUNT(*) FROM logs WHERE code < 10 GROUP BY level");
+        ASSERT_EQ(2, counted.size());
+        ASSERT_EQ(1.0, std::get<double>(counted[0].elements[1].value));
+    }
+    std::filesystem::remove_all(db_path);
+}
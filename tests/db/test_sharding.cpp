@@ -0,0 +1,154 @@
+#include "test_framework.h"
+#include "../../tissdb/storage/lsm_tree.h"
+#include "../../tissdb/storage/sharding.h"
+#include "../../tissdb/query/executor.h"
+#include "../../tissdb/query/parser.h"
+#include "../../tissdb/common/document.h"
+#include <filesystem>
+#include <set>
+#include <thread>
+
+namespace {
+TissDB::Storage::CompactionOptions sharding_test_compaction() {
+    TissDB::Storage::CompactionOptions options;
+    options.background = false;
+    return options;
+}
+
+TissDB::Document make_shard_doc(const std::string& city, double amount) {
+    TissDB::Document doc;
+    TissDB::Element city_elem; city_elem.key = "city"; city_elem.value = city;
+    TissDB::Element amount_elem; amount_elem.key = "amount"; amount_elem.value = amount;
+    doc.elements = {city_elem, amount_elem};
+    return doc;
+}
+} // anonymous namespace
+
+TEST_CASE(ShardedCollectionRoutesAndGathers) {
+    const std::string db_path = "sharding_test_db";
+    std::filesystem::remove_all(db_path);
+    {
+        TissDB::Storage::LSMTree db(db_path, nullptr, sharding_test_compaction());
+        db.create_sharded_collection("orders", TissDB::Schema(), 4);
+        ASSERT_EQ(4, db.shard_count("orders"));
+        ASSERT_THROW(db.create_collection("orders", TissDB::Schema()), std::runtime_error);
+        ASSERT_THROW(db.create_sharded_collection("bad", TissDB::Schema(), 0), std::runtime_error);
+
+        std::set<size_t> used_shards;
+        for (int i = 0; i < 100; ++i) {
+            const std::string key = "o" + std::to_string(i);
+            db.put("orders", key, make_shard_doc(i % 2 ? "Oslo" : "Lima", i));
+            used_shards.insert(TissDB::Storage::shard_of(key, 4));
+        }
+        ASSERT_EQ(4, used_shards.size());
+        ASSERT_EQ(100, db.last_sequence());
+
+        // Point operations reach the shard holding the key.
+        auto doc = db.get("orders", "o42");
+        ASSERT_TRUE(doc.has_value() && *doc);
+        ASSERT_EQ(42.0, std::get<double>((*doc)->elements[1].value));
+        ASSERT_TRUE(db.del("orders", "o42"));
+        ASSERT_FALSE(db.get("orders", "o42").has_value() && *db.get("orders", "o42"));
+
+        // Batched lookups come back in the order asked for.
+        auto batch = db.get_many("orders", {"o7", "o42", "o3", "o7"});
+        ASSERT_EQ(3, batch.size());
+        ASSERT_EQ("o7", batch[0].id);
+        ASSERT_EQ("o3", batch[1].id);
+        ASSERT_EQ("o7", batch[2].id);
+
+        // Scans, index lookups and statistics cover every shard.
+        ASSERT_EQ(99, db.scan("orders").size());
+        db.create_index("orders", {"city"});
+        ASSERT_TRUE(db.has_index("orders", {"city"}));
+        ASSERT_EQ(50, db.find_by_index("orders", "city", "Oslo").size());
+        ASSERT_EQ(99, db.get_statistics("orders").row_count());
+        auto stats = db.analyze("orders");
+        ASSERT_EQ(99, stats.row_count());
+        ASSERT_EQ(0.0, *stats.field("amount")->min_number);
+        ASSERT_EQ(99.0, *stats.field("amount")->max_number);
+
+        TissDB::Query::Parser parser;
+        TissDB::Query::Executor executor(db);
+        auto result = executor.execute(parser.parse("SELECT * FROM orders WHERE city = 'Lima'"), {});
+        ASSERT_EQ(49, result.size());
+
+        // The shards are not listed as collections of their own.
+        auto names = db.list_collections();
+        ASSERT_EQ(1, names.size());
+        ASSERT_EQ("orders", names[0]);
+    }
+    std::filesystem::remove_all(db_path);
+}
+
+TEST_CASE(ShardedCollectionRecoversFromShardLogs) {
+    const std::string db_path = "sharding_recovery_db";
+    std::filesystem::remove_all(db_path);
+    {
+        TissDB::Storage::LSMTree db(db_path, nullptr, sharding_test_compaction());
+        db.create_sharded_collection("events", TissDB::Schema(), 3);
+        db.create_collection("plain", TissDB::Schema());
+        for (int i = 0; i < 10; ++i) {
+            db.put("events", "e" + std::to_string(i), make_shard_doc("Rome", i));
+        }
+        db.checkpoint();
+        for (int i = 10; i < 20; ++i) {
+            db.put("events", "e" + std::to_string(i), make_shard_doc("Rome", i));
+        }
+        db.put("plain", "p", make_shard_doc("Kyiv", 1));
+        ASSERT_TRUE(db.del("events", "e0"));
+    }
+    {
+        // Written without a checkpoint: replayed from each shard's own log.
+        TissDB::Storage::LSMTree db(db_path, nullptr, sharding_test_compaction());
+        ASSERT_EQ(3, db.shard_count("events"));
+        ASSERT_EQ(22, db.last_sequence());
+        ASSERT_EQ(19, db.scan("events").size());
+        ASSERT_TRUE(db.get("plain", "p").has_value());
+        db.put("events", "e20", make_shard_doc("Rome", 20));
+        ASSERT_EQ(23, db.last_sequence());
+    }
+    std::filesystem::remove_all(db_path);
+}
+
+TEST_CASE(ShardedWritesKeepChangeFeedOrder) {
+    const std::string db_path = "sharding_feed_db";
+    std::filesystem::remove_all(db_path);
+    {
+        TissDB::Storage::LSMTree db(db_path, nullptr, sharding_test_compaction());
+        db.create_sharded_collection("clicks", TissDB::Schema(), 4);
+        db.create_collection("users", TissDB::Schema());
+
+        const int writers = 4;
+        const int per_writer = 50;
+        std::vector<std::thread> threads;
+        for (int w = 0; w < writers; ++w) {
+            threads.emplace_back([&db, w] {
+                for (int i = 0; i < per_writer; ++i) {
+                    db.put("clicks", "w" + std::to_string(w) + "_" + std::to_string(i), make_shard_doc("Baku", i));
+                }
+            });
+        }
+        db.put("users", "u1", make_shard_doc("Baku", 0));
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        const uint64_t total = writers * per_writer + 1;
+        ASSERT_EQ(total, db.last_sequence());
+        ASSERT_EQ(writers * per_writer, db.scan("clicks").size());
+
+        // Every change exactly once and in sequence order, from the active
+        // shard logs and then from the segment they are merged into.
+        for (int pass = 0; pass < 2; ++pass) {
+            auto changes = db.read_changes(0, 10000);
+            ASSERT_EQ(total, changes.events.size());
+            for (size_t i = 0; i < changes.events.size(); ++i) {
+                ASSERT_EQ(i + 1, changes.events[i].lsn);
+            }
+            ASSERT_EQ(writers * per_writer, db.read_changes(0, 10000, "clicks").events.size());
+            db.checkpoint();
+        }
+        ASSERT_EQ(1, db.earliest_change());
+    }
+    std::filesystem::remove_all(db_path);
+}
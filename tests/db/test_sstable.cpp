@@ -24,9 +24,9 @@ TEST_CASE(SSTableWriteAndFind) {
     memtable.put("doc1", doc1);
     memtable.put("doc2", doc2);
 
-    std::string sstable_path = TissDB::Storage::SSTable::write_from_memtable(data_dir, memtable);
+    std::string sstable_path = TissDB::Storage::SSTable::write_from_memtable(data_dir, "test_collection", memtable);
 
-    TissDB::Storage::SSTable sstable(sstable_path);
+    TissDB::Storage::SSTable sstable(sstable_path, "test_collection");
 
     auto retrieved_doc_opt = sstable.find("doc1");
     ASSERT_TRUE(retrieved_doc_opt.has_value());
@@ -59,8 +59,8 @@ TEST_CASE(SSTableFindWithIndex) {
         memtable.put(doc.id, doc);
     }
 
-    std::string sstable_path = TissDB::Storage::SSTable::write_from_memtable(data_dir, memtable);
-    TissDB::Storage::SSTable sstable(sstable_path);
+    std::string sstable_path = TissDB::Storage::SSTable::write_from_memtable(data_dir, "test_collection", memtable);
+    TissDB::Storage::SSTable sstable(sstable_path, "test_collection");
 
     // Test finding all existing keys
     for (int i = 0; i < num_docs; ++i) {
@@ -81,6 +81,44 @@ TEST_CASE(SSTableFindWithIndex) {
     std::filesystem::remove_all(data_dir);
 }
 
+TEST_CASE(SSTableFindMany) {
+    std::string data_dir = "sstable_find_many_test_data";
+    std::filesystem::create_directories(data_dir);
+
+    TissDB::Storage::Memtable memtable;
+    for (int i = 0; i < 500; ++i) {
+        TissDB::Document doc;
+        doc.id = "doc" + std::string(3 - std::to_string(i).length(), '0') + std::to_string(i);
+        TissDB::Element elem; elem.key = "value"; elem.value = static_cast<double>(i);
+        doc.elements.push_back(elem);
+        memtable.put(doc.id, doc);
+    }
+    memtable.del("doc250");
+
+    std::string sstable_path = TissDB::Storage::SSTable::write_from_memtable(data_dir, "test_collection", memtable);
+    TissDB::Storage::SSTable sstable(sstable_path, "test_collection");
+
+    // Sorted and unique, spanning blocks both close together and far apart.
+    std::vector<std::string> keys = {"a_before_all", "doc000", "doc001", "doc017", "doc0175",
+                                     "doc250", "doc251", "doc499", "z_after_all"};
+    auto results = sstable.find_many(keys);
+    ASSERT_EQ(keys.size(), results.size());
+    for (size_t i = 0; i < keys.size(); ++i) {
+        auto expected = sstable.find(keys[i]);
+        ASSERT_EQ(expected.has_value(), results[i].has_value());
+        if (expected) {
+            ASSERT_TRUE(*expected == *results[i]);
+        }
+    }
+    ASSERT_FALSE(results[0].has_value());
+    ASSERT_EQ("doc017", TissDB::deserialize(*results[3]).id);
+    ASSERT_FALSE(results[4].has_value());
+    ASSERT_TRUE(results[5]->empty()); // Tombstone
+    ASSERT_EQ(499.0, std::get<double>(TissDB::deserialize(*results[7]).elements[0].value));
+
+    std::filesystem::remove_all(data_dir);
+}
+
 TEST_CASE(SSTableTombstone) {
     std::string data_dir = "sstable_tombstone_test_data";
     std::filesystem::create_directories(data_dir);
@@ -95,9 +133,9 @@ TEST_CASE(SSTableTombstone) {
     memtable.put("doc1", doc1);
     memtable.del("doc1"); // Add tombstone
 
-    std::string sstable_path = TissDB::Storage::SSTable::write_from_memtable(data_dir, memtable);
+    std::string sstable_path = TissDB::Storage::SSTable::write_from_memtable(data_dir, "test_collection", memtable);
 
-    TissDB::Storage::SSTable sstable(sstable_path);
+    TissDB::Storage::SSTable sstable(sstable_path, "test_collection");
 
     auto retrieved_doc_opt = sstable.find("doc1");
     ASSERT_TRUE(retrieved_doc_opt.has_value());
@@ -125,9 +163,9 @@ TEST_CASE(SSTableScan) {
     memtable.put("doc1", doc1);
     memtable.put("doc2", doc2);
 
-    std::string sstable_path = TissDB::Storage::SSTable::write_from_memtable(data_dir, memtable);
+    std::string sstable_path = TissDB::Storage::SSTable::write_from_memtable(data_dir, "test_collection", memtable);
 
-    TissDB::Storage::SSTable sstable(sstable_path);
+    TissDB::Storage::SSTable sstable(sstable_path, "test_collection");
     std::vector<TissDB::Document> docs = sstable.scan();
 
     ASSERT_EQ(2, docs.size());
@@ -0,0 +1,71 @@
+#include "test_framework.h"
+#include "../../tissdb/query/executor.h"
+#include "../../tissdb/query/statement_cache.h"
+#include "../../tissdb/storage/lsm_tree.h"
+#include <filesystem>
+#include <map>
+#include <string>
+
+TEST_CASE(StatementCacheReusesParses) {
+    ASSERT_EQ(std::string("SELECT * FROM t WHERE a = ' x  y '"),
+              TissDB::Query::normalize_query("  SELECT *\n  FROM t\tWHERE a = ' x  y ' ;"));
+
+    TissDB::Query::StatementCache cache(2);
+    auto first = cache.get("db", "SELECT * FROM t WHERE a = ?");
+    ASSERT_EQ(1, first->param_count);
+    ASSERT_TRUE(first == cache.get("db", "SELECT *  FROM t WHERE a = ?;"));
+    ASSERT_TRUE(first != cache.get("other", "SELECT * FROM t WHERE a = ?"));
+    ASSERT_THROW(cache.get("db", "SELECT FROM"), std::runtime_error);
+    ASSERT_EQ(2, cache.size());
+
+    // The least recently used statement goes first; a prepared one stays.
+    const std::string handle = cache.prepare("db", "SELECT * FROM t WHERE a = ?");
+    cache.get("db", "SELECT * FROM u");
+    ASSERT_EQ(2, cache.size());
+    ASSERT_TRUE(cache.find("db", handle) == first);
+    ASSERT_TRUE(cache.find("other", handle) == nullptr);
+    ASSERT_TRUE(cache.deallocate("db", handle));
+    ASSERT_FALSE(cache.deallocate("db", handle));
+
+    cache.prepare("db", "SELECT * FROM u");
+    cache.get("other", "SELECT * FROM u");
+    cache.forget_database("db");
+    ASSERT_EQ(1, cache.size());
+    ASSERT_EQ(0, cache.prepared_count());
+}
+
+TEST_CASE(PreparedStatementReplansOnIndexChange) {
+    const std::string db_path = "statement_cache_test_db";
+    std::filesystem::remove_all(db_path);
+    {
+        TissDB::Storage::LSMTree db(db_path);
+        db.create_collection("people", TissDB::Schema());
+        for (int i = 0; i < 200; ++i) {
+            const std::string id = "p" + std::to_string(i);
+            db.put("people", id, TissDB::Document{id, {{"city", "c" + std::to_string(i % 10)}, {"age", static_cast<double>(i % 50)}}});
+        }
+
+        TissDB::Query::StatementCache cache;
+        const std::string handle = cache.prepare("db", "SELECT * FROM people WHERE city = ? AND age < ?");
+        auto statement = cache.find("db", handle);
+        TissDB::Query::Executor executor(db);
+        ASSERT_EQ(12, executor.execute(*statement, {std::string("c3"), 25.0}).size());
+        ASSERT_THROW(executor.execute(*statement, {std::string("c3")}), std::runtime_error);
+
+        const std::map<std::string, std::string> conditions = {{"city", "c3"}};
+        TissDB::Query::AccessPath access;
+        const uint64_t version = db.catalog_version();
+        ASSERT_TRUE(statement->access_path.get(version, conditions, access));
+        ASSERT_FALSE(access.uses_index());
+
+        // A new index makes the cached plan stale; the next execution uses it.
+        db.create_index("people", {"city"});
+        ASSERT_TRUE(db.catalog_version() != version);
+        ASSERT_FALSE(statement->access_path.get(db.catalog_version(), conditions, access));
+        ASSERT_EQ(12, executor.execute(*statement, {std::string("c3"), 25.0}).size());
+        ASSERT_TRUE(statement->access_path.get(db.catalog_version(), conditions, access));
+        ASSERT_TRUE(access.uses_index());
+        ASSERT_EQ(0, executor.execute(*statement, {std::string("c11"), 25.0}).size());
+    }
+    std::filesystem::remove_all(db_path);
+}
@@ -0,0 +1,150 @@
+#include "test_framework.h"
+#include "../../tissdb/storage/lsm_tree.h"
+#include "../../tissdb/storage/statistics.h"
+#include "../../tissdb/query/cost_model.h"
+#include "../../tissdb/query/executor.h"
+#include "../../tissdb/query/parser.h"
+#include "../../tissdb/common/document.h"
+#include <cmath>
+#include <filesystem>
+
+namespace {
+TissDB::Document make_stats_doc(const std::vector<std::pair<std::string, TissDB::Value>>& fields) {
+    TissDB::Document doc;
+    for (const auto& [key, value] : fields) {
+        TissDB::Element elem; elem.key = key; elem.value = value;
+        doc.elements.push_back(elem);
+    }
+    return doc;
+}
+
+TissDB::Query::QueryResult run_stats_query(TissDB::Storage::LSMTree& db, const std::string& query) {
+    TissDB::Query::Parser parser;
+    TissDB::Query::Executor executor(db);
+    return executor.execute(parser.parse(query), {});
+}
+} // anonymous namespace
+
+TEST_CASE(HyperLogLogEstimatesDistinctValues) {
+    TissDB::Storage::FieldStatistics small;
+    for (int i = 0; i < 100; ++i) {
+        small.add(TissDB::Value(std::string("key") + std::to_string(i % 50)));
+    }
+    ASSERT_TRUE(std::abs(small.distinct_estimate() - 50.0) <= 3.0);
+
+    TissDB::Storage::FieldStatistics large;
+    for (int i = 0; i < 20000; ++i) {
+        large.add(TissDB::Value(static_cast<double>(i)));
+    }
+    ASSERT_TRUE(std::abs(large.distinct_estimate() - 20000.0) <= 2000.0);
+
+    // Sketches survive a round trip through their serialized form.
+    auto restored = TissDB::Storage::HyperLogLog::from_hex(large.distinct.to_hex());
+    ASSERT_EQ(large.distinct.estimate(), restored.estimate());
+}
+
+TEST_CASE(StatisticsTrackWritesAndAnalyze) {
+    const std::string db_path = "statistics_test_db";
+    std::filesystem::remove_all(db_path);
+    {
+        TissDB::Storage::LSMTree db(db_path);
+        db.create_collection("items", TissDB::Schema());
+        for (int i = 0; i < 100; ++i) {
+            db.put("items", "k" + std::to_string(i),
+                   make_stats_doc({{"group", static_cast<double>(i % 10)}, {"v", static_cast<double>(i)}}));
+        }
+        db.checkpoint();
+        // An update of a flushed document must not count as a new row.
+        db.put("items", "k5", make_stats_doc({{"group", 5.0}, {"v", 5.0}}));
+        ASSERT_TRUE(db.del("items", "k0"));
+        ASSERT_TRUE(db.del("items", "k1"));
+
+        auto stats = db.get_statistics("items");
+        ASSERT_EQ(98, stats.row_count());
+        ASSERT_EQ(0, stats.analyzed_at_ms());
+        ASSERT_EQ(103, stats.modifications_since_analyze());
+        ASSERT_TRUE(std::abs(stats.equality_selectivity("group") - 0.1) < 0.02);
+
+        auto summary = run_stats_query(db, "ANALYZE items");
+        ASSERT_EQ(1, summary.size());
+        stats = db.get_statistics("items");
+        ASSERT_EQ(98, stats.row_count());
+        ASSERT_TRUE(stats.analyzed_at_ms() > 0);
+        ASSERT_EQ(0, stats.modifications_since_analyze());
+        // v is uniform over 2..99, so about half the rows are below 51.
+        ASSERT_TRUE(std::abs(stats.range_selectivity("v", 51.0, true) - 0.5) < 0.05);
+        ASSERT_TRUE(std::abs(stats.range_selectivity("v", 51.0, false) - 0.5) < 0.05);
+        ASSERT_EQ(0.0, stats.range_selectivity("v", -1.0, true));
+        db.checkpoint();
+    }
+    {
+        TissDB::Storage::LSMTree db(db_path);
+        auto stats = db.get_statistics("items");
+        ASSERT_EQ(98, stats.row_count());
+        ASSERT_TRUE(stats.analyzed_at_ms() > 0);
+        ASSERT_TRUE(std::abs(stats.range_selectivity("v", 51.0, true) - 0.5) < 0.05);
+    }
+    std::filesystem::remove_all(db_path);
+}
+
+TEST_CASE(PlannerSkipsUnselectiveIndex) {
+    std::vector<TissDB::Document> docs;
+    for (int i = 0; i < 1000; ++i) {
+        docs.push_back(make_stats_doc({{"flag", std::string(i % 2 ? "on" : "off")},
+                                       {"serial", static_cast<double>(i)}}));
+    }
+    auto stats = TissDB::Storage::CollectionStatistics::analyze(docs);
+    std::vector<std::vector<std::string>> indexes = {{"flag"}, {"serial"}};
+
+    auto path = TissDB::Query::choose_access_path(stats, indexes, {{"flag", "on"}});
+    ASSERT_FALSE(path.uses_index()); // Half the collection: a scan is cheaper
+
+    path = TissDB::Query::choose_access_path(stats, indexes, {{"flag", "on"}, {"serial", "7"}});
+    ASSERT_TRUE(path.uses_index());
+    ASSERT_EQ(std::vector<std::string>{"serial"}, path.index_fields);
+
+    // Without statistics the widest usable index is still taken.
+    TissDB::Storage::CollectionStatistics none;
+    path = TissDB::Query::choose_access_path(none, indexes, {{"flag", "on"}});
+    ASSERT_EQ(std::vector<std::string>{"flag"}, path.index_fields);
+}
+
+TEST_CASE(PlannerDrivesJoinFromSmallSide) {
+    const std::string db_path = "statistics_join_test_db";
+    std::filesystem::remove_all(db_path);
+    {
+        TissDB::Storage::LSMTree db(db_path);
+        db.create_collection("orders", TissDB::Schema());
+        db.create_collection("customers", TissDB::Schema());
+        for (int i = 0; i < 200; ++i) {
+            db.put("orders", "o" + std::to_string(i), make_stats_doc({{"cust", "c" + std::to_string(i % 5)}}));
+        }
+        for (int i = 0; i < 5; ++i) {
+            db.put("customers", "c" + std::to_string(i), make_stats_doc({{"cid", "c" + std::to_string(i)}}));
+        }
+        db.create_index("orders", {"cust"});
+        run_stats_query(db, "ANALYZE orders");
+        run_stats_query(db, "ANALYZE customers");
+
+        auto orders = db.get_statistics("orders");
+        auto customers = db.get_statistics("customers");
+        TissDB::Query::JoinInputs inputs;
+        inputs.left_rows = 200;
+        inputs.left_stats = &orders;
+        inputs.right_stats = &customers;
+        inputs.left_key = "cust";
+        inputs.right_key = "cid";
+        inputs.left_indexed = true;
+        inputs.left_is_full_scan = true;
+        inputs.inner = true;
+        ASSERT_TRUE(TissDB::Query::JoinStrategy::LookupLeft == TissDB::Query::choose_join_strategy(inputs));
+        inputs.inner = false;
+        ASSERT_TRUE(TissDB::Query::JoinStrategy::Hash == TissDB::Query::choose_join_strategy(inputs));
+
+        auto joined = run_stats_query(db, "SELECT * FROM orders JOIN customers ON orders.cust = customers.cid");
+        ASSERT_EQ(200, joined.size());
+        auto left_joined = run_stats_query(db, "SELECT * FROM orders LEFT JOIN customers ON orders.cust = customers.cid");
+        ASSERT_EQ(200, left_joined.size());
+    }
+    std::filesystem::remove_all(db_path);
+}
@@ -44,6 +44,14 @@ public:
         return docs;
     }
 
+    std::vector<std::shared_ptr<const TissDB::Document>> scan_shared(const std::string& collection_name) override {
+        std::vector<std::shared_ptr<const TissDB::Document>> docs;
+        for (auto& doc : scan(collection_name)) {
+            docs.push_back(std::make_shared<const TissDB::Document>(std::move(doc)));
+        }
+        return docs;
+    }
+
     std::map<std::string, std::map<std::string, TissDB::Document>> mock_data_;
 };
 
@@ -68,7 +76,7 @@ TEST_CASE(ExecutorAggregateStdDev) {
     const auto& doc = result[0];
     ASSERT_EQ(1, doc.elements.size());
     const auto& elem = doc.elements[0];
-    ASSERT_EQ("stddev", elem.key);
+    ASSERT_EQ("STDDEV(value)", elem.key); // Named like every other aggregate
 
     // The population standard deviation of {10, 20, 30} is sqrt(((10-20)^2 + (20-20)^2 + (30-20)^2)/3) = sqrt(200/3) = 8.16496...
     double expected_stddev = 8.16496580927726;
@@ -0,0 +1,87 @@
+#include "test_framework.h"
+#include "../../tissdb/query/column_batch.h"
+#include <numeric>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using OrderBy = std::vector<std::pair<std::string, std::string>>;
+
+std::vector<uint32_t> sorted_positions(const TissDB::Query::DocumentRows& rows, const OrderBy& order_by,
+                                       size_t limit = SIZE_MAX) {
+    std::vector<uint32_t> positions(rows.size());
+    std::iota(positions.begin(), positions.end(), 0);
+    TissDB::Query::sort_rows(rows, positions, order_by, limit);
+    return positions;
+}
+
+} // anonymous namespace
+
+TEST_CASE(TopNMatchesFullSort) {
+    // Enough rows to be split across query threads.
+    std::vector<TissDB::Document> docs;
+    for (int i = 0; i < 100000; ++i) {
+        TissDB::Document doc;
+        doc.id = "event" + std::to_string(i);
+        doc.elements.push_back({"amount", static_cast<double>((i * 7919) % 1000) - 500.0});
+        doc.elements.push_back({"name", std::string("n") + std::to_string((i * 31) % 977)});
+        doc.elements.push_back({"ts", TissDB::Timestamp{1700000000000000LL + ((i * 104729LL) % 100000) * 1000}});
+        doc.elements.push_back({"mixed", i % 1000 == 0 ? TissDB::Value(std::string("x")) : TissDB::Value(static_cast<double>(i % 50))});
+        if (i % 3 != 0) doc.elements.push_back({"sparse", static_cast<double>(i % 11)});
+        docs.push_back(std::move(doc));
+    }
+    TissDB::Query::DocumentRows rows;
+    for (const auto& doc : docs) rows.push_back(&doc);
+
+    const std::vector<OrderBy> orders = {
+        {{"amount", "DESC"}},
+        {{"name", "ASC"}, {"amount", "DESC"}},
+        {{"ts", "DESC"}},
+        {{"_id", "ASC"}},
+        {{"mixed", "ASC"}, {"name", "DESC"}},
+        {{"sparse", "DESC"}, {"amount", "ASC"}},
+    };
+    for (const auto& order_by : orders) {
+        const auto full = sorted_positions(rows, order_by);
+        for (size_t limit : {size_t{0}, size_t{1}, size_t{20}, size_t{5000}}) {
+            const auto top = sorted_positions(rows, order_by, limit);
+            ASSERT_EQ(limit, top.size());
+            ASSERT_TRUE(std::vector<uint32_t>(full.begin(), full.begin() + limit) == top);
+        }
+    }
+}
+
+TEST_CASE(TopNEncodedKeysOrder) {
+    std::vector<TissDB::Document> docs = {
+        {"a", {{"n", -2.5}, {"s", std::string("b")}}},
+        {"b", {{"n", 0.0}, {"s", std::string("a\0b", 3)}}},
+        {"c", {{"n", -0.0}, {"s", std::string("a")}}},
+        {"d", {{"n", 1e300}, {"s", std::string("")}}},
+        {"e", {{"n", -1e300}, {"s", std::string("\xff")}}},
+        {"f", {{"n", 3.0}, {"s", std::string("ab")}}},
+    };
+    TissDB::Query::DocumentRows rows;
+    for (const auto& doc : docs) rows.push_back(&doc);
+
+    // -0 and 0 tie, and keep their order.
+    ASSERT_TRUE((std::vector<uint32_t>{4, 0, 1, 2, 5}) == sorted_positions(rows, {{"n", "ASC"}}, 5));
+    ASSERT_TRUE((std::vector<uint32_t>{3, 5, 1}) == sorted_positions(rows, {{"n", "DESC"}}, 3));
+    // A string sorts before the longer ones it prefixes, NUL bytes included.
+    ASSERT_TRUE((std::vector<uint32_t>{3, 2, 1, 5, 0}) == sorted_positions(rows, {{"s", "ASC"}}, 5));
+    ASSERT_TRUE((std::vector<uint32_t>{4, 0, 5}) == sorted_positions(rows, {{"s", "DESC"}}, 3));
+
+    // Missing values sort first, then numbers, timestamps and strings.
+    std::vector<TissDB::Document> mixed = {
+        {"a", {{"v", std::string("x")}}},
+        {"b", {{"v", TissDB::Timestamp{5}}}},
+        {"c", {}},
+        {"d", {{"v", 9.0}}},
+        {"e", {{"v", true}}},
+    };
+    rows.clear();
+    for (const auto& doc : mixed) rows.push_back(&doc);
+    ASSERT_TRUE((std::vector<uint32_t>{2, 3, 1, 0, 4}) == sorted_positions(rows, {{"v", "ASC"}}));
+    ASSERT_TRUE((std::vector<uint32_t>{4, 0, 1}) == sorted_positions(rows, {{"v", "DESC"}}, 3));
+}
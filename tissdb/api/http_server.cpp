@@ -1,15 +1,20 @@
 #include "http_server.h"
 #include "../common/log.h"
+#include "../common/memory_governor.h"
+#include "../common/metrics.h"
 #include "../common/schema.h"
 #include "../storage/database_manager.h"
 #include "../json/json.h"
 #include "../common/document.h"
-#include "../query/parser.h"
 #include "../query/ast.h"
 #include "../query/executor.h"
+#include "../query/query_metrics.h"
+#include "../query/statement_cache.h"
 #include "../auth/token_manager.h"
 #include "../auth/rbac.h"
 #include "../audit/audit_logger.h"
+#include "../replication/change_codec.h"
+#include "../replication/follower.h"
 #include <iostream>
 #include <string>
 #include <vector>
@@ -22,6 +27,7 @@
 #include <chrono>
 #include <algorithm>
 #include <cctype>
+#include <filesystem>
 #include <iomanip> // for std::put_time
 
 #ifdef _WIN32
@@ -52,6 +58,77 @@ void to_lower(std::string& s) {
                    [](unsigned char c){ return std::tolower(c); });
 }
 
+// Decodes %XX escapes and '+' (as a space) in a query string component.
+std::string url_decode(const std::string& s) {
+    std::string out;
+    out.reserve(s.size());
+    for (size_t i = 0; i < s.size(); ++i) {
+        if (s[i] == '+') {
+            out += ' ';
+        } else if (s[i] == '%' && i + 2 < s.size() &&
+                   std::isxdigit(static_cast<unsigned char>(s[i + 1])) &&
+                   std::isxdigit(static_cast<unsigned char>(s[i + 2]))) {
+            out += static_cast<char>(std::stoi(s.substr(i + 1, 2), nullptr, 16));
+            i += 2;
+        } else {
+            out += s[i];
+        }
+    }
+    return out;
+}
+
+std::map<std::string, std::string> parse_query_string(const std::string& query) {
+    std::map<std::string, std::string> params;
+    std::stringstream query_ss(query);
+    std::string pair;
+    while (std::getline(query_ss, pair, '&')) {
+        if (pair.empty()) continue;
+        auto eq_pos = pair.find('=');
+        if (eq_pos == std::string::npos) {
+            params[url_decode(pair)] = "";
+        } else {
+            params[url_decode(pair.substr(0, eq_pos))] = url_decode(pair.substr(eq_pos + 1));
+        }
+    }
+    return params;
+}
+
+// The "parallelism" of a _query request: the most threads the statement
+// may use, or 0 for the server's limit.
+size_t requested_parallelism(const Json::JsonValue& body) {
+    const auto& obj = body.as_object();
+    auto it = obj.find("parallelism");
+    if (it == obj.end() || !it->second.is_number() || it->second.as_number() < 1) return 0;
+    return static_cast<size_t>(std::min(it->second.as_number(), 4096.0));
+}
+
+// The "params" of a _query or _execute request: one literal per `?`.
+std::vector<Query::Literal> request_params(const Json::JsonValue& body) {
+    std::vector<Query::Literal> params;
+    const auto& obj = body.as_object();
+    auto it = obj.find("params");
+    if (it == obj.end()) return params;
+    for (const auto& param : it->second.as_array()) {
+        if (param.is_string()) params.push_back(param.as_string());
+        else if (param.is_number()) params.push_back(param.as_number());
+        else if (param.is_bool()) params.push_back(param.as_bool());
+        else if (param.is_null()) params.push_back(Query::Null{});
+        else throw std::runtime_error("Query parameters must be strings, numbers, booleans or null.");
+    }
+    return params;
+}
+
+// True if a backup destination from a request stays inside the backup
+// root: relative, non-empty and without ".." components.
+bool is_contained_path(const std::string& path) {
+    const std::filesystem::path relative(path);
+    if (relative.empty() || relative.has_root_name() || relative.has_root_directory()) return false;
+    for (const auto& part : relative) {
+        if (part == "..") return false;
+    }
+    return true;
+}
+
 Json::JsonValue value_to_json(const Value& value); // Forward declaration
 
 Json::JsonObject document_to_json(const Document& doc) {
@@ -181,10 +258,31 @@ Value json_to_value(const Json::JsonValue& json_val) {
 
 struct HttpRequest {
     std::string method;
-    std::string path;
+    std::string path; // Without the query string
+    std::map<std::string, std::string> query;
     std::map<std::string, std::string> headers;
     std::string body;
 };
+
+struct HttpMetrics {
+    Common::Counter& requests;
+    Common::Counter& bytes_in;
+    Common::Counter& bytes_out;
+    Common::Histogram& queue_wait;      // Accepted to picked up by a handler
+    Common::Histogram& request_latency; // Picked up to response sent
+};
+
+HttpMetrics& http_metrics() {
+    auto& registry = Common::Metrics::instance();
+    static HttpMetrics metrics{
+        registry.counter("tissdb_http_requests_total", "HTTP requests handled."),
+        registry.counter("tissdb_http_received_bytes_total", "Bytes read from HTTP clients."),
+        registry.counter("tissdb_http_sent_bytes_total", "Bytes of HTTP responses sent."),
+        registry.histogram("tissdb_http_queue_wait_seconds", "Time from accepting a connection to starting to handle it."),
+        registry.histogram("tissdb_http_request_seconds", "Time to read, handle and answer one HTTP request."),
+    };
+    return metrics;
+}
 } // anonymous namespace
 
 class HttpServer::Impl {
@@ -193,15 +291,25 @@ public:
     ~Impl();
     void start();
     void stop();
+    void set_replica(const Replication::Follower* follower) { replica_of_ = follower; }
+    void set_backup_root(const std::string& root) { backup_root_ = root; }
 private:
     void server_loop();
-    void handle_client(int client_socket);
+    void handle_client(int client_socket, std::chrono::steady_clock::time_point accepted_at);
+    std::string export_metrics() const;
     void send_response(int sock, const std::string& code, const std::string& ctype, const std::string& body);
+    // Runs a statement for a _query or _execute request and sends its result.
+    // A replica only runs SELECT.
+    void run_statement(int sock, Storage::LSMTree& storage_engine, Query::PreparedStatement& statement,
+                       const Json::JsonValue& body);
 
     Auth::TokenManager token_manager_;
     Auth::RBACManager rbac_manager_;
     Audit::AuditLogger audit_logger_;
     Storage::DatabaseManager& db_manager_;
+    const Replication::Follower* replica_of_ = nullptr; // Set on a read replica
+    std::string backup_root_ = "tissdb_backups"; // Where POST /<db>/_backup may write
+    Query::StatementCache statement_cache_;
     int server_fd = -1;
     int server_port;
     std::atomic<bool> is_running{false};
@@ -211,7 +319,7 @@ private:
 HttpServer::Impl::Impl(Storage::DatabaseManager& manager, int port)
     : db_manager_(manager),
       server_port(port),
-      audit_logger_("tissdb_audit.log") {
+      audit_logger_("tissdb_audit") {
 #ifdef _WIN32
     WSADATA wsaData;
     if (WSAStartup(MAKEWORD(2,2), &wsaData) != 0) throw std::runtime_error("WSAStartup failed");
@@ -255,10 +363,40 @@ void HttpServer::Impl::server_loop() {
     while (is_running) {
         int client_socket = accept(server_fd, nullptr, nullptr);
         if (client_socket < 0) continue;
-        std::thread(&HttpServer::Impl::handle_client, this, client_socket).detach();
+        std::thread(&HttpServer::Impl::handle_client, this, client_socket, std::chrono::steady_clock::now()).detach();
     }
 }
 
+// Prometheus text exposition: the registered latency histograms and counters,
+// then values other components own, read now.
+std::string HttpServer::Impl::export_metrics() const {
+    std::string out;
+    Common::Metrics::instance().export_prometheus(out);
+
+    const Common::MemoryGovernor::Stats memory = Common::MemoryGovernor::instance().stats();
+    Common::append_prometheus_sample(out, "tissdb_memory_budget_bytes", "gauge",
+                                     "Memory budget shared by all databases; 0 for none.", memory.budget);
+    Common::append_prometheus_sample(out, "tissdb_memory_used_bytes", "gauge",
+                                     "Memory accounted to all subsystems.", memory.total);
+    Common::append_prometheus_sample(out, "tissdb_memory_reclaims_total", "counter",
+                                     "Times the memory governor flushed memtables to get under budget.", memory.reclaims);
+    Common::append_prometheus_sample(out, "tissdb_write_stalls_total", "counter",
+                                     "Writes that waited for memory to be reclaimed.", memory.write_stalls);
+
+    const Audit::AuditStats audit = audit_logger_.stats();
+    Common::append_prometheus_sample(out, "tissdb_audit_events_written_total", "counter",
+                                     "Audit events written to disk.", audit.written);
+    Common::append_prometheus_sample(out, "tissdb_audit_events_dropped_total", "counter",
+                                     "Audit events dropped because the writer fell behind.", audit.dropped);
+
+    const Log::Stats log = Log::stats();
+    Common::append_prometheus_sample(out, "tissdb_log_lines_written_total", "counter",
+                                     "Log lines written.", log.written);
+    Common::append_prometheus_sample(out, "tissdb_log_lines_dropped_total", "counter",
+                                     "DEBUG and INFO log lines dropped because the writer fell behind.", log.dropped);
+    return out;
+}
+
 void HttpServer::Impl::send_response(int sock, const std::string& code, const std::string& ctype, const std::string& body) {
     std::stringstream ss;
     ss << "HTTP/1.1 " << code << "\r\n";
@@ -268,9 +406,14 @@ void HttpServer::Impl::send_response(int sock, const std::string& code, const st
     ss << body;
     std::string response = ss.str();
     send(sock, response.c_str(), response.length(), 0);
+    http_metrics().bytes_out.add(response.length());
 }
 
-void HttpServer::Impl::handle_client(int client_socket) {
+void HttpServer::Impl::handle_client(int client_socket, std::chrono::steady_clock::time_point accepted_at) {
+    HttpMetrics& metrics = http_metrics();
+    metrics.queue_wait.record(std::chrono::steady_clock::now() - accepted_at);
+    metrics.requests.add();
+    Common::ScopedTimer request_timer(metrics.request_latency);
     // Note: In a real server, we'd get the client's IP address from the socket.
     // This is a placeholder.
     std::string source_ip = "127.0.0.1";
@@ -282,6 +425,7 @@ void HttpServer::Impl::handle_client(int client_socket) {
         close(client_socket);
         return;
     }
+    metrics.bytes_in.add(bytes_received);
     buffer[bytes_received] = '\0';
     request_str.append(buffer, bytes_received);
     std::stringstream request_ss(request_str);
@@ -295,8 +439,13 @@ void HttpServer::Impl::handle_client(int client_socket) {
     }
     std::stringstream request_line_ss(request_line);
     request_line_ss >> req.method >> req.path;
+    auto query_pos = req.path.find('?');
+    if (query_pos != std::string::npos) {
+        req.query = parse_query_string(req.path.substr(query_pos + 1));
+        req.path.erase(query_pos);
+    }
 
-    LOG_INFO("Incoming request: " + req.method + " " + req.path);
+    LOG_DEBUG("Incoming request: " << req.method << " " << req.path);
 
     audit_logger_.log({std::chrono::system_clock::now(), "", source_ip,
         Audit::EventType::RequestBegin, req.method + " " + req.path, true, "Request received."});
@@ -328,6 +477,7 @@ void HttpServer::Impl::handle_client(int client_socket) {
             while (current_body_len < content_length) {
                 bytes_received = recv(client_socket, buffer, sizeof(buffer) - 1, 0);
                 if (bytes_received <= 0) break;
+                metrics.bytes_in.add(bytes_received);
                 request_str.append(buffer, bytes_received);
                 current_body_len += bytes_received;
             }
@@ -418,6 +568,28 @@ void HttpServer::Impl::handle_client(int client_socket) {
             return;
         }
 
+        if (req.method == "GET" && path_parts.size() == 1 && path_parts[0] == "_ready") {
+            // Reports per-collection load state. Collections that are not ready
+            // yet are still served; they are opened on first access.
+            bool all_ready = true;
+            Json::JsonObject dbs_obj;
+            for (const auto& name : db_manager_.list_databases()) {
+                Json::JsonObject colls_obj;
+                for (const auto& [coll_name, state] : db_manager_.get_database(name).get_collection_states()) {
+                    colls_obj[coll_name] = Json::JsonValue(Storage::to_string(state));
+                    all_ready = all_ready && state == Storage::CollectionLoadState::Ready;
+                }
+                dbs_obj[name] = Json::JsonValue(colls_obj);
+            }
+            Json::JsonObject response_obj;
+            response_obj["ready"] = Json::JsonValue(all_ready);
+            response_obj["databases"] = Json::JsonValue(dbs_obj);
+            send_response(client_socket, all_ready ? "200 OK" : "503 Service Unavailable", "application/json",
+                          Json::JsonValue(response_obj).serialize());
+            close(client_socket);
+            return;
+        }
+
         if (req.method == "GET" && path_parts.size() == 1 && path_parts[0] == "_databases") {
             Json::JsonArray db_array;
             for (const auto& name : db_manager_.list_databases()) {
@@ -428,6 +600,59 @@ void HttpServer::Impl::handle_client(int client_socket) {
             return;
         }
 
+        if (req.method == "GET" && path_parts.size() == 1 && path_parts[0] == "_metrics") {
+            send_response(client_socket, "200 OK", "text/plain; version=0.0.4", export_metrics());
+            close(client_socket);
+            return;
+        }
+
+        if (req.method == "GET" && path_parts.size() == 1 && path_parts[0] == "_replication") {
+            Json::JsonObject response_obj;
+            Json::JsonObject dbs_obj;
+            if (replica_of_) {
+                response_obj["role"] = Json::JsonValue("replica");
+                response_obj["leader"] = Json::JsonValue(replica_of_->leader_endpoint());
+                for (const auto& [name, status] : replica_of_->status()) {
+                    Json::JsonObject db_obj;
+                    db_obj["state"] = Json::JsonValue(Replication::to_string(status.state));
+                    db_obj["applied_lsn"] = Json::JsonValue(static_cast<double>(status.applied_lsn));
+                    db_obj["leader_lsn"] = Json::JsonValue(static_cast<double>(status.leader_lsn));
+                    db_obj["lag_changes"] = Json::JsonValue(static_cast<double>(
+                        status.leader_lsn > status.applied_lsn ? status.leader_lsn - status.applied_lsn : 0));
+                    db_obj["lag_ms"] = Json::JsonValue(static_cast<double>(status.lag_ms));
+                    if (!status.last_error.empty()) {
+                        db_obj["error"] = Json::JsonValue(status.last_error);
+                    }
+                    dbs_obj[name] = Json::JsonValue(db_obj);
+                }
+            } else {
+                response_obj["role"] = Json::JsonValue("leader");
+                for (const auto& name : db_manager_.list_databases()) {
+                    auto& db = db_manager_.get_database(name);
+                    Json::JsonObject db_obj;
+                    db_obj["last_lsn"] = Json::JsonValue(static_cast<double>(db.last_sequence()));
+                    db_obj["earliest_lsn"] = Json::JsonValue(static_cast<double>(db.earliest_change()));
+                    dbs_obj[name] = Json::JsonValue(db_obj);
+                }
+            }
+            response_obj["databases"] = Json::JsonValue(dbs_obj);
+            send_response(client_socket, "200 OK", "application/json", Json::JsonValue(response_obj).serialize());
+            close(client_socket);
+            return;
+        }
+
+        // A replica only changes through replication. Queries are checked
+        // once parsed, below.
+        bool is_query = (req.method == "POST" && (path_parts.size() == 2 || path_parts.size() == 3) &&
+                         path_parts.back() == "_query") ||
+                        (path_parts.size() >= 2 && (path_parts[1] == "_prepare" || path_parts[1] == "_execute"));
+        if (replica_of_ && req.method != "GET" && !is_query) {
+            send_response(client_socket, "403 Forbidden", "text/plain",
+                          "This server is a read-only replica of " + replica_of_->leader_endpoint() + ".");
+            close(client_socket);
+            return;
+        }
+
         if (req.method == "PUT" && path_parts.size() == 1) {
             db_manager_.create_database(path_parts[0]);
             send_response(client_socket, "201 Created", "text/plain", "Database '" + path_parts[0] + "' created.");
@@ -437,6 +662,7 @@ void HttpServer::Impl::handle_client(int client_socket) {
 
         if (req.method == "DELETE" && path_parts.size() == 1) {
             db_manager_.delete_database(path_parts[0]);
+            statement_cache_.forget_database(path_parts[0]);
             audit_logger_.log({std::chrono::system_clock::now(), token_val, source_ip, Audit::EventType::DbDelete,
                 req.path, true, "Database deleted successfully."});
             send_response(client_socket, "204 No Content", "text/plain", "");
@@ -453,7 +679,7 @@ void HttpServer::Impl::handle_client(int client_socket) {
             try {
                 transaction_id = std::stoi(req.headers.at("x-transaction-id"));
             } catch (const std::exception& e) {
-                LOG_WARNING("Could not parse X-Transaction-ID header: " + std::string(e.what()));
+                LOG_EVERY_N_SEC(LogLevel::WARNING, 10, "Could not parse X-Transaction-ID header: " << e.what());
                 // Invalid header, proceed without transaction context
                 transaction_id = -1;
             }
@@ -498,12 +724,158 @@ void HttpServer::Impl::handle_client(int client_socket) {
             } catch (const std::exception& e) {
                 send_response(client_socket, "400 Bad Request", "text/plain", "Invalid JSON body.");
             }
+        } else if (sub_path_parts[0] == "_ready" && req.method == "GET") {
+            bool all_ready = true;
+            Json::JsonObject colls_obj;
+            for (const auto& [coll_name, state] : storage_engine.get_collection_states()) {
+                colls_obj[coll_name] = Json::JsonValue(Storage::to_string(state));
+                all_ready = all_ready && state == Storage::CollectionLoadState::Ready;
+            }
+            Json::JsonObject response_obj;
+            response_obj["ready"] = Json::JsonValue(all_ready);
+            response_obj["collections"] = Json::JsonValue(colls_obj);
+            send_response(client_socket, all_ready ? "200 OK" : "503 Service Unavailable", "application/json",
+                          Json::JsonValue(response_obj).serialize());
+        } else if (sub_path_parts[0] == "_backup" && req.method == "POST") {
+            if (!rbac_manager_.has_permission(user_role, Auth::Permission::Admin)) {
+                audit_logger_.log({std::chrono::system_clock::now(), token_val, source_ip, Audit::EventType::PermissionCheckFailure,
+                    req.path, false, "User does not have Admin permission."});
+                send_response(client_socket, "403 Forbidden", "text/plain", "You do not have permission to back up a database.");
+                close(client_socket);
+                return;
+            }
+            Json::JsonValue parsed_body;
+            try {
+                parsed_body = Json::JsonValue::parse(req.body);
+            } catch (const std::exception& e) {
+                send_response(client_socket, "400 Bad Request", "text/plain", "Invalid JSON body.");
+                close(client_socket);
+                return;
+            }
+            if (!parsed_body.is_object() || !parsed_body.as_object().count("destination") ||
+                !parsed_body.as_object().at("destination").is_string()) {
+                send_response(client_socket, "400 Bad Request", "text/plain", "Missing destination in request body.");
+                close(client_socket);
+                return;
+            }
+            const auto& body_obj = parsed_body.as_object();
+            const std::string destination = body_obj.at("destination").as_string();
+            if (!is_contained_path(destination)) {
+                audit_logger_.log({std::chrono::system_clock::now(), token_val, source_ip, Audit::EventType::Backup,
+                    req.path, false, "Rejected backup destination '" + destination + "'."});
+                send_response(client_socket, "400 Bad Request", "text/plain",
+                              "destination must be a relative path inside the server's backup directory.");
+                close(client_socket);
+                return;
+            }
+            bool flush_first = body_obj.count("flush") && body_obj.at("flush").as_bool();
+            Storage::BackupResult backup;
+            try {
+                backup = storage_engine.create_backup((std::filesystem::path(backup_root_) / destination).string(), flush_first);
+            } catch (const std::exception& e) {
+                audit_logger_.log({std::chrono::system_clock::now(), token_val, source_ip, Audit::EventType::Backup,
+                    req.path, false, std::string("Backup failed: ") + e.what()});
+                throw;
+            }
+            audit_logger_.log({std::chrono::system_clock::now(), token_val, source_ip, Audit::EventType::Backup,
+                req.path, true, "Database '" + db_name + "' backed up to '" + backup.backup_path + "'."});
+
+            Json::JsonObject response_obj;
+            response_obj["backup_id"] = Json::JsonValue(backup.backup_id);
+            response_obj["path"] = Json::JsonValue(backup.backup_path);
+            response_obj["parent_backup_id"] = Json::JsonValue(backup.parent_backup_id);
+            response_obj["files_linked"] = Json::JsonValue(static_cast<double>(backup.files_linked));
+            response_obj["files_reused"] = Json::JsonValue(static_cast<double>(backup.files_reused));
+            response_obj["files_copied"] = Json::JsonValue(static_cast<double>(backup.files_copied));
+            response_obj["bytes_copied"] = Json::JsonValue(static_cast<double>(backup.bytes_copied));
+            send_response(client_socket, "200 OK", "application/json", Json::JsonValue(response_obj).serialize());
         } else if (sub_path_parts[0] == "_stats" && req.method == "GET") {
             Json::JsonObject stats_obj;
             stats_obj["total_docs"] = Json::JsonValue(static_cast<double>(storage_engine.scan("knowledge").size()));
             stats_obj["feedback_entries"] = Json::JsonValue(static_cast<double>(storage_engine.scan("knowledge_feedback").size()));
             stats_obj["total_accesses"] = Json::JsonValue(0.0); // Placeholder
+            stats_obj["last_sequence"] = Json::JsonValue(static_cast<double>(storage_engine.last_sequence()));
+            Storage::CompactionStats compaction = storage_engine.get_compaction_stats();
+            Json::JsonObject compaction_obj;
+            compaction_obj["runs"] = Json::JsonValue(static_cast<double>(compaction.runs));
+            compaction_obj["bytes_read"] = Json::JsonValue(static_cast<double>(compaction.bytes_read));
+            compaction_obj["bytes_written"] = Json::JsonValue(static_cast<double>(compaction.bytes_written));
+            compaction_obj["tombstones_purged"] = Json::JsonValue(static_cast<double>(compaction.tombstones_purged));
+            compaction_obj["tombstones_retained"] = Json::JsonValue(static_cast<double>(compaction.tombstones_retained));
+            compaction_obj["documents_expired"] = Json::JsonValue(static_cast<double>(compaction.documents_expired));
+            compaction_obj["sstables_removed"] = Json::JsonValue(static_cast<double>(compaction.sstables_removed));
+            compaction_obj["last_duration_ms"] = Json::JsonValue(static_cast<double>(compaction.last_duration_ms));
+            stats_obj["compaction"] = Json::JsonValue(compaction_obj);
+            Common::MemoryGovernor::Stats memory = Common::MemoryGovernor::instance().stats();
+            Json::JsonObject memory_obj;
+            memory_obj["budget_bytes"] = Json::JsonValue(static_cast<double>(memory.budget));
+            memory_obj["total_bytes"] = Json::JsonValue(static_cast<double>(memory.total));
+            memory_obj["peak_bytes"] = Json::JsonValue(static_cast<double>(memory.peak));
+            Json::JsonObject subsystems_obj;
+            for (size_t i = 0; i < memory.usage.size(); ++i) {
+                subsystems_obj[Common::to_string(static_cast<Common::MemorySubsystem>(i))] =
+                    Json::JsonValue(static_cast<double>(memory.usage[i]));
+            }
+            memory_obj["subsystems"] = Json::JsonValue(subsystems_obj);
+            memory_obj["reclaims"] = Json::JsonValue(static_cast<double>(memory.reclaims));
+            memory_obj["bytes_reclaimed"] = Json::JsonValue(static_cast<double>(memory.bytes_reclaimed));
+            memory_obj["write_stalls"] = Json::JsonValue(static_cast<double>(memory.write_stalls));
+            memory_obj["write_stall_ms"] = Json::JsonValue(static_cast<double>(memory.write_stall_ms));
+            memory_obj["queries_rejected"] = Json::JsonValue(static_cast<double>(memory.queries_rejected));
+            stats_obj["memory"] = Json::JsonValue(memory_obj);
             send_response(client_socket, "200 OK", "application/json", Json::JsonValue(stats_obj).serialize());
+        } else if (sub_path_parts[0] == "_changes" && req.method == "GET") {
+            // Change feed: GET /<db>/_changes?since=<lsn>&limit=&timeout_ms=&collection=
+            // Returns the puts and deletes after `since`, waiting up to
+            // `timeout_ms` for one if there are none yet. Without `since`, the
+            // feed starts at the current end. Resume from the returned `next`.
+            const uint64_t since = req.query.count("since") ? std::stoull(req.query.at("since"))
+                                                            : storage_engine.last_sequence();
+            const size_t limit = std::min<size_t>(
+                req.query.count("limit") ? std::stoul(req.query.at("limit")) : 1000, 10000);
+            const long timeout_ms = std::min<long>(
+                req.query.count("timeout_ms") ? std::stol(req.query.at("timeout_ms")) : 0, 60000);
+            const std::string collection_filter = req.query.count("collection") ? req.query.at("collection") : "";
+            // Replicas ask for documents in binary form and name themselves so
+            // the changes they have not read yet are kept for them.
+            const bool binary_documents = req.query.count("format") && req.query.at("format") == "binary";
+            if (req.query.count("consumer")) {
+                storage_engine.hold_changes(req.query.at("consumer"), since);
+            }
+
+            const uint64_t earliest = storage_engine.earliest_change();
+            if (since + 1 < earliest) {
+                Json::JsonObject error_obj;
+                error_obj["error"] = Json::JsonValue("Changes after " + std::to_string(since) + " are no longer retained.");
+                error_obj["earliest_lsn"] = Json::JsonValue(static_cast<double>(earliest));
+                send_response(client_socket, "410 Gone", "application/json", Json::JsonValue(error_obj).serialize());
+            } else {
+                if (timeout_ms > 0) {
+                    storage_engine.wait_for_changes(since, std::chrono::milliseconds(timeout_ms));
+                }
+                Storage::ChangeBatch batch = storage_engine.read_changes(since, limit, collection_filter);
+                Json::JsonArray changes_array;
+                for (const auto& event : batch.events) {
+                    if (binary_documents) {
+                        changes_array.push_back(Json::JsonValue(Replication::encode_change(event)));
+                        continue;
+                    }
+                    Json::JsonObject change_obj;
+                    change_obj["lsn"] = Json::JsonValue(static_cast<double>(event.lsn));
+                    change_obj["op"] = Json::JsonValue(event.type == Storage::LogEntryType::PUT ? "put" : "delete");
+                    change_obj["collection"] = Json::JsonValue(event.collection_name);
+                    change_obj["id"] = Json::JsonValue(event.document_id);
+                    if (event.type == Storage::LogEntryType::PUT) {
+                        change_obj["doc"] = Json::JsonValue(document_to_json(event.doc));
+                    }
+                    changes_array.push_back(Json::JsonValue(change_obj));
+                }
+                Json::JsonObject response_obj;
+                response_obj["changes"] = Json::JsonValue(changes_array);
+                response_obj["next"] = Json::JsonValue(static_cast<double>(batch.next_since));
+                response_obj["last_lsn"] = Json::JsonValue(static_cast<double>(batch.last_lsn));
+                send_response(client_socket, "200 OK", "application/json", Json::JsonValue(response_obj).serialize());
+            }
         } else if (sub_path_parts[0] == "_feedback" && req.method == "POST") {
             Json::JsonValue parsed_body = Json::JsonValue::parse(req.body);
             Document doc = json_to_document(parsed_body.as_object());
@@ -513,16 +885,32 @@ void HttpServer::Impl::handle_client(int client_socket) {
             send_response(client_socket, "201 Created", "text/plain", "Feedback created with ID: " + id);
         } else if (sub_path_parts[0] == "_query" && req.method == "POST") {
             const Json::JsonValue parsed_body = Json::JsonValue::parse(req.body);
-            std::string query_string = parsed_body.as_object().at("query").as_string();
-            Query::Parser parser;
-            Query::AST ast = parser.parse(query_string);
-            Query::Executor executor(storage_engine);
-            Query::QueryResult result = executor.execute(ast, {});
-            Json::JsonArray result_array;
-            for (const auto& doc : result) {
-                result_array.push_back(Json::JsonValue(document_to_json(doc)));
+            const std::string& query_string = parsed_body.as_object().at("query").as_string();
+            run_statement(client_socket, storage_engine, *statement_cache_.get(db_name, query_string), parsed_body);
+        } else if (sub_path_parts[0] == "_prepare" && sub_path_parts.size() == 1 && req.method == "POST") {
+            const Json::JsonValue parsed_body = Json::JsonValue::parse(req.body);
+            const std::string& query_string = parsed_body.as_object().at("query").as_string();
+            const std::string handle = statement_cache_.prepare(db_name, query_string);
+            const auto statement = statement_cache_.find(db_name, handle);
+            Json::JsonObject response_obj;
+            response_obj["handle"] = Json::JsonValue(handle);
+            response_obj["statement"] = Json::JsonValue(std::string(Query::statement_name(statement->ast)));
+            response_obj["params"] = Json::JsonValue(static_cast<double>(statement->param_count));
+            send_response(client_socket, "200 OK", "application/json", Json::JsonValue(response_obj).serialize());
+        } else if (sub_path_parts[0] == "_prepare" && sub_path_parts.size() == 2 && req.method == "DELETE") {
+            if (statement_cache_.deallocate(db_name, sub_path_parts[1])) {
+                send_response(client_socket, "204 No Content", "text/plain", "");
+            } else {
+                send_response(client_socket, "404 Not Found", "text/plain", "Prepared statement not found.");
+            }
+        } else if (sub_path_parts[0] == "_execute" && req.method == "POST") {
+            const Json::JsonValue parsed_body = Json::JsonValue::parse(req.body);
+            const auto statement = statement_cache_.find(db_name, parsed_body.as_object().at("handle").as_string());
+            if (!statement) {
+                send_response(client_socket, "404 Not Found", "text/plain", "Prepared statement not found.");
+            } else {
+                run_statement(client_socket, storage_engine, *statement, parsed_body);
             }
-            send_response(client_socket, "200 OK", "application/json", Json::JsonValue(result_array).serialize());
         } else if (sub_path_parts[0] == "_collections" && req.method == "GET") {
             Json::JsonArray collections_array;
             for (const auto& name : storage_engine.list_collections()) {
@@ -546,18 +934,25 @@ void HttpServer::Impl::handle_client(int client_socket) {
                     }
                     storage_engine.create_index(collection_name, field_names);
                     send_response(client_socket, "200 OK", "text/plain", "Index creation initiated.");
-                } else if (doc_path_parts[0] == "_query") {
+                } else if (doc_path_parts[0] == "_ttl") {
                     const Json::JsonValue parsed_body = Json::JsonValue::parse(req.body);
-                    std::string query_str = parsed_body.as_object().at("query").as_string();
-                    Query::Parser parser;
-                    Query::AST ast = parser.parse(query_str);
-                    Query::Executor executor(storage_engine);
-                    auto result_docs = executor.execute(ast, {});
-                    Json::JsonArray result_array;
-                    for (const auto& doc : result_docs) {
-                        result_array.push_back(Json::JsonValue(document_to_json(doc)));
+                    const auto& body_obj = parsed_body.as_object();
+                    Storage::TtlPolicy policy;
+                    if (body_obj.count("ttl_seconds")) {
+                        policy.default_ttl_seconds = static_cast<uint64_t>(body_obj.at("ttl_seconds").as_number());
                     }
-                    send_response(client_socket, "200 OK", "application/json", Json::JsonValue(result_array).serialize());
+                    if (body_obj.count("expiry_field")) {
+                        policy.expiry_field = body_obj.at("expiry_field").as_string();
+                    }
+                    storage_engine.set_ttl_policy(collection_name, policy);
+                    Json::JsonObject response_obj;
+                    response_obj["ttl_seconds"] = Json::JsonValue(static_cast<double>(policy.default_ttl_seconds));
+                    response_obj["expiry_field"] = Json::JsonValue(policy.enabled() ? policy.field() : std::string());
+                    send_response(client_socket, "200 OK", "application/json", Json::JsonValue(response_obj).serialize());
+                } else if (doc_path_parts[0] == "_query") {
+                    const Json::JsonValue parsed_body = Json::JsonValue::parse(req.body);
+                    const std::string& query_str = parsed_body.as_object().at("query").as_string();
+                    run_statement(client_socket, storage_engine, *statement_cache_.get(db_name, query_str), parsed_body);
                 }
                 else {
                     send_response(client_socket, "404 Not Found", "text/plain", "Endpoint not found.");
@@ -601,8 +996,23 @@ void HttpServer::Impl::handle_client(int client_socket) {
                         break;
                     }
                 }
-                if (exists) {
+                // An optional body {"shards": N} hash-partitions the collection.
+                double shards = 0;
+                if (!req.body.empty()) {
+                    Json::JsonValue options = Json::JsonValue::parse(req.body);
+                    if (options.is_object() && options.as_object().count("shards")) {
+                        shards = options.as_object().at("shards").as_number();
+                    }
+                }
+                if (shards != 0 && (shards < 1 || shards > TissDB::Storage::MAX_SHARDS)) {
+                    send_response(client_socket, "400 Bad Request", "text/plain",
+                                  "shards must be between 1 and " + std::to_string(TissDB::Storage::MAX_SHARDS) + ".");
+                } else if (exists) {
                     send_response(client_socket, "200 OK", "text/plain", "Collection '" + collection_name + "' already exists.");
+                } else if (shards > 0) {
+                    const size_t shard_count = static_cast<size_t>(shards);
+                    storage_engine.create_sharded_collection(collection_name, TissDB::Schema(), shard_count);
+                    send_response(client_socket, "201 Created", "text/plain", "Collection '" + collection_name + "' created with " + std::to_string(shard_count) + " shards.");
                 } else {
                     storage_engine.create_collection(collection_name, TissDB::Schema());
                     send_response(client_socket, "201 Created", "text/plain", "Collection '" + collection_name + "' created.");
@@ -623,16 +1033,36 @@ void HttpServer::Impl::handle_client(int client_socket) {
                         req.path, false, "User does not have AdminRead permission."});
                     send_response(client_socket, "403 Forbidden", "text/plain", "You do not have permission to access the audit log.");
                 } else {
-                    // In a real implementation, this would return a JSON array of log entries.
-                    // The get_logs function is a placeholder and will throw an exception.
+                    // Events between `from` and `to` (Unix milliseconds; default the last 24 hours).
+                    const auto now = std::chrono::system_clock::now();
+                    auto from = now - std::chrono::hours(24);
+                    auto to = now;
+                    size_t limit = 1000;
+                    bool valid_range = true;
                     try {
-                        // TODO: Add time range filtering from query params
-                        auto logs = audit_logger_.get_logs(std::chrono::system_clock::now() - std::chrono::hours(24),
-                                                         std::chrono::system_clock::now());
-                        // This part will not be reached due to the placeholder exception.
-                        send_response(client_socket, "200 OK", "application/json", "[]");
-                    } catch (const std::logic_error& e) {
-                        send_response(client_socket, "501 Not Implemented", "text/plain", e.what());
+                        if (req.query.count("from")) from = std::chrono::system_clock::time_point(std::chrono::milliseconds(std::stoll(req.query.at("from"))));
+                        if (req.query.count("to")) to = std::chrono::system_clock::time_point(std::chrono::milliseconds(std::stoll(req.query.at("to"))));
+                        if (req.query.count("limit")) limit = std::min<size_t>(std::stoull(req.query.at("limit")), 100000);
+                    } catch (const std::exception&) {
+                        valid_range = false;
+                    }
+                    if (!valid_range) {
+                        send_response(client_socket, "400 Bad Request", "text/plain", "from, to and limit must be integers.");
+                    } else {
+                        Json::JsonArray entries;
+                        for (const auto& entry : audit_logger_.get_logs(from, to, limit)) {
+                            Json::JsonObject obj;
+                            obj["timestamp_ms"] = Json::JsonValue(static_cast<double>(
+                                std::chrono::duration_cast<std::chrono::milliseconds>(entry.timestamp.time_since_epoch()).count()));
+                            obj["user"] = Json::JsonValue(entry.user_token_id);
+                            obj["source_ip"] = Json::JsonValue(entry.source_ip);
+                            obj["event_type"] = Json::JsonValue(Audit::event_type_to_string(entry.event_type));
+                            obj["resource"] = Json::JsonValue(entry.resource_accessed);
+                            obj["success"] = Json::JsonValue(entry.success);
+                            obj["description"] = Json::JsonValue(entry.description);
+                            entries.push_back(Json::JsonValue(obj));
+                        }
+                        send_response(client_socket, "200 OK", "application/json", Json::JsonValue(entries).serialize());
                     }
                 }
             } else {
@@ -648,10 +1078,30 @@ void HttpServer::Impl::handle_client(int client_socket) {
     close(client_socket);
 }
 
+void HttpServer::Impl::run_statement(int sock, Storage::LSMTree& storage_engine, Query::PreparedStatement& statement,
+                                     const Json::JsonValue& body) {
+    if (replica_of_ && !std::holds_alternative<Query::SelectStatement>(statement.ast) &&
+        !std::holds_alternative<Query::ExplainStatement>(statement.ast)) {
+        send_response(sock, "403 Forbidden", "text/plain",
+                      "This server is a read-only replica; only SELECT queries are accepted.");
+        return;
+    }
+    Query::Executor executor(storage_engine);
+    executor.set_parallelism(requested_parallelism(body));
+    const Query::QueryResult result = executor.execute(statement, request_params(body));
+    Json::JsonArray result_array;
+    for (const auto& doc : result) {
+        result_array.push_back(Json::JsonValue(document_to_json(doc)));
+    }
+    send_response(sock, "200 OK", "application/json", Json::JsonValue(result_array).serialize());
+}
+
 HttpServer::HttpServer(Storage::DatabaseManager& db_manager, int port) : pimpl(std::make_unique<Impl>(db_manager, port)) {}
 HttpServer::~HttpServer() = default;
 void HttpServer::start() { pimpl->start(); }
 void HttpServer::stop() { pimpl->stop(); }
+void HttpServer::set_replica(const Replication::Follower* follower) { pimpl->set_replica(follower); }
+void HttpServer::set_backup_root(const std::string& root) { pimpl->set_backup_root(root); }
 
 } // namespace API
 } // namespace TissDB
@@ -1,9 +1,11 @@
 #pragma once
 
 #include <memory>
+#include <string>
 
 // Forward declaration of the database manager to avoid including the full header.
 namespace TissDB { namespace Storage { class DatabaseManager; } }
+namespace TissDB { namespace Replication { class Follower; } }
 
 namespace TissDB {
 namespace API {
@@ -23,6 +25,14 @@ public:
     // Stops the running server.
     void stop();
 
+    // Serves as a read replica of `follower`'s leader: writes are refused and
+    // `GET /_replication` reports the follower's progress. Call before start().
+    void set_replica(const Replication::Follower* follower);
+
+    // Directory that POST /<db>/_backup writes into; a request names a
+    // subdirectory of it. Call before start().
+    void set_backup_root(const std::string& root);
+
 private:
     // PIMPL (Pointer to Implementation) idiom to hide the low-level socket
     // implementation details from this public header file. This reduces compile
@@ -1,12 +1,152 @@
 #include "audit_logger.h"
+#include "../common/checksum.h"
+#include "../common/log.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
 #include <fstream>
-#include <iostream>
-#include <iomanip> // For std::put_time
-#include <sstream>
+
+#ifdef _WIN32
+    #include <io.h>
+#else
+    #include <unistd.h>
+#endif
 
 namespace TissDB {
 namespace Audit {
 
+namespace {
+constexpr uint32_t AUDIT_MAGIC = 0x44554154; // "TAUD"
+constexpr uint32_t AUDIT_FORMAT_VERSION = 1;
+constexpr uint64_t SEGMENT_HEADER_SIZE = 8;
+constexpr uint32_t MAX_RECORD_SIZE = 16 * 1024 * 1024;
+constexpr size_t BLOCK_RECORDS = 256; // Records per index entry
+constexpr size_t MAX_BATCH = 1024;
+constexpr std::chrono::seconds DROP_REPORT_INTERVAL{10};
+const char* const SEGMENT_PREFIX = "audit_";
+
+struct IndexEntry {
+    uint64_t offset;
+    uint64_t length;
+    int64_t min_us;
+    int64_t max_us;
+};
+
+int64_t to_us(std::chrono::system_clock::time_point time) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(time.time_since_epoch()).count();
+}
+
+// Request bookkeeping and reads; the rest (authentication, permission
+// failures, changes) must not be lost.
+bool is_routine(EventType type) {
+    return type == EventType::RequestBegin || type == EventType::RequestEnd || type == EventType::DocRead;
+}
+
+template <typename T>
+void put(std::string& out, T value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+void put_string(std::string& out, const std::string& value) {
+    put<uint32_t>(out, static_cast<uint32_t>(value.size()));
+    out.append(value);
+}
+
+// Reads from a record payload; fails once past its end.
+class PayloadReader {
+public:
+    PayloadReader(const std::string& data) : data_(data) {}
+
+    template <typename T>
+    bool get(T& value) {
+        if (pos_ + sizeof(T) > data_.size()) return false;
+        std::memcpy(&value, data_.data() + pos_, sizeof(T));
+        pos_ += sizeof(T);
+        return true;
+    }
+
+    bool get_string(std::string& value) {
+        uint32_t size = 0;
+        if (!get(size) || pos_ + size > data_.size()) return false;
+        value.assign(data_, pos_, size);
+        pos_ += size;
+        return true;
+    }
+
+private:
+    const std::string& data_;
+    size_t pos_ = 0;
+};
+
+std::string encode_record(const AuditLogEntry& entry) {
+    std::string payload;
+    put<int64_t>(payload, to_us(entry.timestamp));
+    put<uint8_t>(payload, static_cast<uint8_t>(entry.event_type));
+    put<uint8_t>(payload, entry.success ? 1 : 0);
+    put_string(payload, entry.user_token_id);
+    put_string(payload, entry.source_ip);
+    put_string(payload, entry.resource_accessed);
+    put_string(payload, entry.description);
+
+    std::string record;
+    record.reserve(payload.size() + 8);
+    put<uint32_t>(record, static_cast<uint32_t>(payload.size()));
+    put<uint32_t>(record, Common::crc32c(payload.data(), payload.size()));
+    record.append(payload);
+    return record;
+}
+
+bool decode_payload(const std::string& payload, AuditLogEntry& entry) {
+    PayloadReader reader(payload);
+    int64_t timestamp_us = 0;
+    uint8_t type = 0;
+    uint8_t success = 0;
+    if (!reader.get(timestamp_us) || !reader.get(type) || !reader.get(success) ||
+        !reader.get_string(entry.user_token_id) || !reader.get_string(entry.source_ip) ||
+        !reader.get_string(entry.resource_accessed) || !reader.get_string(entry.description)) {
+        return false;
+    }
+    entry.timestamp = std::chrono::system_clock::time_point(std::chrono::microseconds(timestamp_us));
+    entry.event_type = static_cast<EventType>(type);
+    entry.success = success != 0;
+    return true;
+}
+
+// Reads the records in [offset, offset + length) (to the end of the file if
+// length is 0), keeping those in [start_us, end_us].
+void scan_records(std::ifstream& in, uint64_t offset, uint64_t length, int64_t start_us, int64_t end_us,
+                  std::vector<AuditLogEntry>& out) {
+    in.clear();
+    in.seekg(static_cast<std::streamoff>(offset));
+    uint64_t consumed = 0;
+    while (length == 0 || consumed < length) {
+        uint32_t header[2];
+        if (!in.read(reinterpret_cast<char*>(header), sizeof(header))) return;
+        if (header[0] > MAX_RECORD_SIZE) return;
+        std::string payload(header[0], '\0');
+        if (!in.read(&payload[0], header[0])) return; // Torn tail
+        if (Common::crc32c(payload.data(), payload.size()) != header[1]) return;
+        consumed += sizeof(header) + header[0];
+
+        AuditLogEntry entry;
+        if (!decode_payload(payload, entry)) return;
+        const int64_t timestamp_us = to_us(entry.timestamp);
+        if (timestamp_us >= start_us && timestamp_us <= end_us) {
+            out.push_back(std::move(entry));
+        }
+    }
+}
+
+void sync_file(std::FILE* file) {
+    std::fflush(file);
+#ifdef _WIN32
+    _commit(_fileno(file));
+#else
+    ::fsync(fileno(file));
+#endif
+}
+} // anonymous namespace
+
 // Helper to convert EventType to string
 std::string event_type_to_string(EventType type) {
     switch (type) {
@@ -22,45 +162,271 @@ std::string event_type_to_string(EventType type) {
         case EventType::DocWrite: return "DocWrite";
         case EventType::DocDelete: return "DocDelete";
         case EventType::PermissionCheckFailure: return "PermissionCheckFailure";
+        case EventType::Backup: return "Backup";
         default: return "Unknown";
     }
 }
 
-AuditLogger::AuditLogger(const std::string& log_file_path) : log_path_(log_file_path) {}
+AuditLogger::AuditLogger(const std::string& log_dir, const AuditLoggerOptions& options)
+    : log_dir_(log_dir), options_(options), queue_(options.queue_capacity) {
+    writer_ = std::thread([this] { writer_loop(); });
+}
 
-AuditLogger::~AuditLogger() {}
+AuditLogger::~AuditLogger() {
+    {
+        std::lock_guard<std::mutex> lock(writer_mutex_);
+        stop_.store(true);
+    }
+    wake_writer_.notify_one();
+    writer_.join();
+}
 
-void AuditLogger::log(const AuditLogEntry& entry) {
-    // In a real system, this should be thread-safe.
-    // For now, we open, append, and close on each call.
-    std::ofstream log_file(log_path_, std::ios::app);
-    if (!log_file.is_open()) {
-        std::cerr << "CRITICAL: Could not open audit log file: " << log_path_ << std::endl;
+void AuditLogger::log(AuditLogEntry entry) {
+    if (!queue_.try_push(std::move(entry))) {
+        const OverflowPolicy policy = options_.overflow_policy;
+        if (policy == OverflowPolicy::Drop ||
+            (policy == OverflowPolicy::DropRoutine && is_routine(entry.event_type))) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        blocked_.fetch_add(1, std::memory_order_relaxed);
+        do {
+            wake_writer_.notify_one();
+            std::this_thread::yield();
+        } while (!queue_.try_push(std::move(entry)));
+    }
+    logged_.fetch_add(1, std::memory_order_release);
+    // A notification missed while the writer goes idle costs at most one
+    // flush interval of latency.
+    if (writer_idle_.load(std::memory_order_acquire)) {
+        wake_writer_.notify_one();
+    }
+}
+
+void AuditLogger::flush() {
+    std::unique_lock<std::mutex> lock(writer_mutex_);
+    const uint64_t target = logged_.load(std::memory_order_acquire);
+    flush_target_ = std::max(flush_target_, target);
+    wake_writer_.notify_one();
+    written_cv_.wait(lock, [&] { return synced_ >= target; });
+}
+
+std::vector<AuditLogEntry> AuditLogger::get_logs(
+    std::chrono::system_clock::time_point start,
+    std::chrono::system_clock::time_point end,
+    size_t limit) {
+    flush();
+    return read_audit_log(log_dir_, start, end, limit);
+}
+
+AuditStats AuditLogger::stats() const {
+    AuditStats stats;
+    stats.logged = logged_.load();
+    stats.dropped = dropped_.load();
+    stats.blocked = blocked_.load();
+    std::lock_guard<std::mutex> lock(writer_mutex_);
+    stats.written = written_;
+    return stats;
+}
+
+void AuditLogger::writer_loop() {
+    using Clock = std::chrono::steady_clock;
+    std::vector<AuditLogEntry> batch;
+    batch.reserve(MAX_BATCH);
+    Clock::time_point last_sync = Clock::now();
+    bool unsynced = false;
+    uint64_t reported_drops = 0;
+    Clock::time_point last_drop_report;
+
+    for (;;) {
+        AuditLogEntry entry;
+        while (batch.size() < MAX_BATCH && queue_.try_pop(entry)) {
+            batch.push_back(std::move(entry));
+        }
+        const size_t drained = batch.size();
+        if (drained > 0) {
+            write_batch(batch);
+            batch.clear();
+            unsynced = true;
+        }
+
+        std::unique_lock<std::mutex> lock(writer_mutex_);
+        written_ += drained;
+        const bool flush_wanted = flush_target_ > synced_;
+        if (unsynced && (flush_wanted || Clock::now() - last_sync >= options_.flush_interval)) {
+            lock.unlock();
+            sync();
+            lock.lock();
+            unsynced = false;
+            last_sync = Clock::now();
+        }
+        if (!unsynced && synced_ != written_) {
+            synced_ = written_;
+            written_cv_.notify_all();
+        }
+
+        const uint64_t dropped = dropped_.load(std::memory_order_relaxed);
+        if (dropped != reported_drops && (stop_.load() || Clock::now() - last_drop_report >= DROP_REPORT_INTERVAL)) {
+            LOG_WARNING("Audit log dropped " + std::to_string(dropped - reported_drops) + " events.");
+            reported_drops = dropped;
+            last_drop_report = Clock::now();
+        }
+
+        if (drained == MAX_BATCH) continue;
+        const bool behind = written_ < logged_.load(std::memory_order_acquire);
+        if (stop_.load() && !behind) break;
+        if (behind) {
+            // A producer has claimed a slot but not filled it yet.
+            lock.unlock();
+            std::this_thread::yield();
+            continue;
+        }
+        writer_idle_.store(true, std::memory_order_release);
+        const auto timeout = unsynced ? options_.flush_interval - (Clock::now() - last_sync) : options_.flush_interval;
+        wake_writer_.wait_for(lock, std::chrono::duration_cast<std::chrono::milliseconds>(timeout) +
+                                        std::chrono::milliseconds(1));
+        writer_idle_.store(false, std::memory_order_release);
+    }
+    close_segment();
+}
+
+void AuditLogger::open_segment() {
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    fs::create_directories(log_dir_, ec);
+    // Named after the time it was opened, so names sort in write order.
+    int64_t opened_us = to_us(std::chrono::system_clock::now());
+    fs::path segment_path;
+    do {
+        char digits[21];
+        std::snprintf(digits, sizeof(digits), "%020lld", static_cast<long long>(opened_us++));
+        segment_path = fs::path(log_dir_) / (SEGMENT_PREFIX + std::string(digits) + ".log");
+    } while (fs::exists(segment_path));
+
+    segment_ = std::fopen(segment_path.string().c_str(), "wb");
+    index_ = segment_ ? std::fopen(fs::path(segment_path).replace_extension(".idx").string().c_str(), "wb") : nullptr;
+    if (!segment_ || !index_) {
+        if (!write_failed_) {
+            LOG_ERROR("CRITICAL: Could not open audit log segment in " + log_dir_);
+            write_failed_ = true;
+        }
+        close_segment();
         return;
     }
+    const uint32_t header[2] = {AUDIT_MAGIC, AUDIT_FORMAT_VERSION};
+    std::fwrite(header, sizeof(header), 1, segment_);
+    segment_size_ = SEGMENT_HEADER_SIZE;
+    block_offset_ = segment_size_;
+    block_records_ = 0;
+    write_failed_ = false;
+}
 
-    // Format as JSON for structured logging
-    std::time_t time = std::chrono::system_clock::to_time_t(entry.timestamp);
-    std::tm tm = *std::gmtime(&time); // Using gmtime for UTC
+void AuditLogger::write_batch(std::vector<AuditLogEntry>& batch) {
+    for (const auto& entry : batch) {
+        if (!segment_ || segment_size_ >= options_.segment_bytes) {
+            close_segment();
+            open_segment();
+        }
+        const std::string record = encode_record(entry);
+        if (!segment_ || std::fwrite(record.data(), record.size(), 1, segment_) != 1) {
+            if (segment_ && !write_failed_) {
+                LOG_ERROR("CRITICAL: Could not write audit log segment in " + log_dir_);
+                write_failed_ = true;
+            }
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        segment_size_ += record.size();
 
-    log_file << "{";
-    log_file << "\"timestamp\":\"" << std::put_time(&tm, "%Y-%m-%dT%H:%M:%SZ") << "\",";
-    log_file << "\"user\":\"" << entry.user_token_id << "\",";
-    log_file << "\"source_ip\":\"" << entry.source_ip << "\",";
-    log_file << "\"event_type\":\"" << event_type_to_string(entry.event_type) << "\",";
-    log_file << "\"resource\":\"" << entry.resource_accessed << "\",";
-    log_file << "\"success\":" << (entry.success ? "true" : "false") << ",";
-    log_file << "\"description\":\"" << entry.description << "\"";
-    log_file << "}" << std::endl; // newline for each entry
+        const int64_t timestamp_us = to_us(entry.timestamp);
+        if (block_records_ == 0) {
+            block_min_us_ = block_max_us_ = timestamp_us;
+        } else {
+            block_min_us_ = std::min(block_min_us_, timestamp_us);
+            block_max_us_ = std::max(block_max_us_, timestamp_us);
+        }
+        if (++block_records_ == BLOCK_RECORDS) {
+            const IndexEntry index_entry{block_offset_, segment_size_ - block_offset_, block_min_us_, block_max_us_};
+            std::fwrite(&index_entry, sizeof(index_entry), 1, index_);
+            block_offset_ = segment_size_;
+            block_records_ = 0;
+        }
+    }
 }
 
-std::vector<AuditLogEntry> AuditLogger::get_logs(
+void AuditLogger::sync() {
+    if (!segment_) return;
+    // Records before the index entries that point at them.
+    sync_file(segment_);
+    sync_file(index_);
+}
+
+void AuditLogger::close_segment() {
+    if (segment_ && index_ && block_records_ > 0) {
+        const IndexEntry index_entry{block_offset_, segment_size_ - block_offset_, block_min_us_, block_max_us_};
+        std::fwrite(&index_entry, sizeof(index_entry), 1, index_);
+        block_records_ = 0;
+    }
+    if (segment_) {
+        sync_file(segment_);
+        std::fclose(segment_);
+        segment_ = nullptr;
+    }
+    if (index_) {
+        sync_file(index_);
+        std::fclose(index_);
+        index_ = nullptr;
+    }
+}
+
+std::vector<AuditLogEntry> read_audit_log(
+    const std::string& log_dir,
     std::chrono::system_clock::time_point start,
-    std::chrono::system_clock::time_point end) {
-    // Placeholder: A real implementation would need to parse the JSON log file
-    // and filter by the time range. This is non-trivial and left for a future
-    // developer with a test environment.
-    throw std::logic_error("AuditLogger::get_logs() is not implemented.");
+    std::chrono::system_clock::time_point end,
+    size_t limit) {
+    namespace fs = std::filesystem;
+    std::vector<AuditLogEntry> result;
+    std::error_code ec;
+    if (!fs::is_directory(log_dir, ec)) return result;
+
+    std::vector<fs::path> segments;
+    for (const auto& entry : fs::directory_iterator(log_dir)) {
+        const std::string name = entry.path().filename().string();
+        if (entry.is_regular_file() && name.rfind(SEGMENT_PREFIX, 0) == 0 && entry.path().extension() == ".log") {
+            segments.push_back(entry.path());
+        }
+    }
+    std::sort(segments.begin(), segments.end());
+
+    const int64_t start_us = to_us(start);
+    const int64_t end_us = to_us(end);
+    for (const auto& segment_path : segments) {
+        std::ifstream in(segment_path, std::ios::binary);
+        uint32_t header[2];
+        if (!in.read(reinterpret_cast<char*>(header), sizeof(header)) || header[0] != AUDIT_MAGIC) {
+            LOG_WARNING("Skipping unrecognised audit log segment: " + segment_path.string());
+            continue;
+        }
+
+        // Indexed blocks outside the range are skipped; records written since
+        // the last index entry are scanned.
+        uint64_t tail_offset = SEGMENT_HEADER_SIZE;
+        std::ifstream index_in(fs::path(segment_path).replace_extension(".idx"), std::ios::binary);
+        IndexEntry block;
+        while (index_in.read(reinterpret_cast<char*>(&block), sizeof(block))) {
+            tail_offset = std::max(tail_offset, block.offset + block.length);
+            if (block.max_us < start_us || block.min_us > end_us) continue;
+            scan_records(in, block.offset, block.length, start_us, end_us, result);
+        }
+        scan_records(in, tail_offset, 0, start_us, end_us, result);
+    }
+
+    std::stable_sort(result.begin(), result.end(),
+                     [](const AuditLogEntry& a, const AuditLogEntry& b) { return a.timestamp < b.timestamp; });
+    if (result.size() > limit) {
+        result.resize(limit);
+    }
+    return result;
 }
 
 } // namespace Audit
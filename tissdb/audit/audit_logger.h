@@ -3,8 +3,17 @@
 
 #include <string>
 #include <vector>
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <limits>
+#include <mutex>
+#include <thread>
 #include "../auth/rbac.h" // For Role enum
+#include "../common/ring_buffer.h"
 
 namespace TissDB {
 namespace Audit {
@@ -21,9 +30,12 @@ enum class EventType {
     DocRead,
     DocWrite,
     DocDelete,
-    PermissionCheckFailure
+    PermissionCheckFailure,
+    Backup
 };
 
+std::string event_type_to_string(EventType type);
+
 struct AuditLogEntry {
     std::chrono::system_clock::time_point timestamp;
     std::string user_token_id; // Or a hash of the token
@@ -34,25 +46,111 @@ struct AuditLogEntry {
     std::string description;
 };
 
+// What log() does when the queue is full because the writer cannot keep up.
+enum class OverflowPolicy {
+    Block,       // Wait for room: nothing is lost, requests slow down
+    Drop,        // Drop the event and count it
+    DropRoutine  // Drop request begin/end and read events; wait for room for the rest
+};
+
+struct AuditLoggerOptions {
+    size_t queue_capacity = 16384;
+    // The writer syncs the log to disk at most this long after an event is queued.
+    std::chrono::milliseconds flush_interval{200};
+    // A new segment file is started past this size.
+    uint64_t segment_bytes = 64ull * 1024 * 1024;
+    OverflowPolicy overflow_policy = OverflowPolicy::DropRoutine;
+};
+
+struct AuditStats {
+    uint64_t logged = 0;   // Accepted by log()
+    uint64_t written = 0;  // On disk
+    uint64_t dropped = 0;  // Refused by the overflow policy, or lost to a write error
+    uint64_t blocked = 0;  // Calls to log() that had to wait for room
+};
+
+// Audit events are queued on a lock-free ring buffer by the request threads
+// and written by a dedicated thread, in batches, to a directory of binary
+// segment files:
+//
+//   audit_<opened_us>.log   "TAUD" magic and version, then records of
+//                           [u32 length][u32 CRC32C][payload]
+//   audit_<opened_us>.idx   one entry per block of records:
+//                           [u64 offset][u64 length][i64 min_us][i64 max_us]
+//
+// Time-range reads use the block index to skip blocks outside the range and
+// scan only the records after the last indexed block.
 class AuditLogger {
 public:
-    // The logger would be initialized with a path to its log file.
-    AuditLogger(const std::string& log_file_path);
+    AuditLogger(const std::string& log_dir, const AuditLoggerOptions& options = AuditLoggerOptions());
+    // Writes out every queued event.
     ~AuditLogger();
 
-    void log(const AuditLogEntry& entry);
+    AuditLogger(const AuditLogger&) = delete;
+    AuditLogger& operator=(const AuditLogger&) = delete;
+
+    void log(AuditLogEntry entry);
 
-    // Method to retrieve logs for the admin API.
+    // Returns once every event logged before the call is on disk.
+    void flush();
+
+    // Method to retrieve logs for the admin API: events in [start, end], by
+    // time, at most `limit` of them.
     std::vector<AuditLogEntry> get_logs(
         std::chrono::system_clock::time_point start,
-        std::chrono::system_clock::time_point end);
+        std::chrono::system_clock::time_point end,
+        size_t limit = std::numeric_limits<size_t>::max());
+
+    AuditStats stats() const;
+    const std::string& get_path() const { return log_dir_; }
 
 private:
-    std::string log_path_;
-    // In a real system, a thread-safe queue and a dedicated writer thread
-    // would be used to avoid blocking request threads. For now, we'll write directly.
+    void writer_loop();
+    // Writer thread only.
+    void open_segment();
+    void write_batch(std::vector<AuditLogEntry>& batch);
+    void sync();
+    void close_segment();
+
+    std::string log_dir_;
+    AuditLoggerOptions options_;
+    Common::MpscRingBuffer<AuditLogEntry> queue_;
+
+    std::atomic<uint64_t> logged_{0};
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<uint64_t> blocked_{0};
+    std::atomic<bool> writer_idle_{false};
+    std::atomic<bool> stop_{false};
+
+    mutable std::mutex writer_mutex_;
+    std::condition_variable wake_writer_;
+    std::condition_variable written_cv_;
+    uint64_t written_ = 0;     // Events handled by the writer (on disk or lost)
+    uint64_t flush_target_ = 0; // A flush() is waiting for this many to be synced
+    uint64_t synced_ = 0;
+
+    // Writer thread state.
+    std::FILE* segment_ = nullptr;
+    std::FILE* index_ = nullptr;
+    uint64_t segment_size_ = 0;
+    uint64_t block_offset_ = 0;
+    size_t block_records_ = 0;
+    int64_t block_min_us_ = 0;
+    int64_t block_max_us_ = 0;
+    bool write_failed_ = false;
+
+    std::thread writer_;
 };
 
+// Reads the events in [start, end] from an audit log directory, by time, at
+// most `limit` of them. Stops quietly at a torn record, so the directory of a
+// running logger can be read.
+std::vector<AuditLogEntry> read_audit_log(
+    const std::string& log_dir,
+    std::chrono::system_clock::time_point start,
+    std::chrono::system_clock::time_point end,
+    size_t limit = std::numeric_limits<size_t>::max());
+
 } // namespace Audit
 } // namespace TissDB
 
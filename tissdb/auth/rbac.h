@@ -24,7 +24,8 @@ enum class Permission {
     DocRead,
     DocWrite,
     DocDelete,
-    AdminRead // For admin-only endpoints like log access
+    AdminRead, // For admin-only endpoints like log access
+    Admin      // Administrative operations that touch the server's filesystem, such as backups
 };
 
 class RBACManager {
@@ -1,5 +1,12 @@
 #include "checksum.h"
 
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <nmmintrin.h>
+#define TISSDB_CRC32C_X86 1
+#endif
+
 namespace TissDB {
 namespace Common {
 namespace Crc32Impl {
@@ -46,5 +53,243 @@ namespace Crc32Impl {
         return ~crc;
     }
 }
+
+namespace Crc32cImpl {
+namespace {
+    constexpr uint32_t kPoly = 0x82F63B78; // Castagnoli, reflected
+
+    struct SliceTables {
+        uint32_t t[8][256];
+        SliceTables() {
+            for (uint32_t n = 0; n < 256; ++n) {
+                uint32_t crc = n;
+                for (int k = 0; k < 8; ++k) {
+                    crc = (crc & 1) ? (crc >> 1) ^ kPoly : crc >> 1;
+                }
+                t[0][n] = crc;
+            }
+            for (uint32_t n = 0; n < 256; ++n) {
+                uint32_t crc = t[0][n];
+                for (int k = 1; k < 8; ++k) {
+                    crc = t[0][crc & 0xFF] ^ (crc >> 8);
+                    t[k][n] = crc;
+                }
+            }
+        }
+    };
+
+    const SliceTables& slice_tables() {
+        static const SliceTables tables;
+        return tables;
+    }
+
+    inline uint32_t load_le32(const uint8_t* p) {
+        return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+               (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+    }
+} // anonymous namespace
+
+static uint32_t extend_portable_bytes(uint32_t crc, const uint8_t* p, size_t size) {
+    const auto& t = slice_tables().t;
+    crc = ~crc;
+
+    while (size >= 8) {
+        uint32_t lo = load_le32(p) ^ crc;
+        uint32_t hi = load_le32(p + 4);
+        crc = t[7][lo & 0xFF] ^ t[6][(lo >> 8) & 0xFF] ^ t[5][(lo >> 16) & 0xFF] ^ t[4][lo >> 24] ^
+              t[3][hi & 0xFF] ^ t[2][(hi >> 8) & 0xFF] ^ t[1][(hi >> 16) & 0xFF] ^ t[0][hi >> 24];
+        p += 8;
+        size -= 8;
+    }
+    while (size--) {
+        crc = t[0][(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+uint32_t extend_portable(uint32_t crc, const void* data, size_t size) {
+    return extend_portable_bytes(crc, static_cast<const uint8_t*>(data), size);
+}
+
+#ifdef TISSDB_CRC32C_X86
+namespace {
+    // The hardware path runs three independent crc32 streams to hide the
+    // instruction's latency, then merges them. Merging needs "CRC of crc
+    // followed by N zero bytes", which is a linear map over GF(2); it is
+    // precomputed as four byte-indexed tables for each stream length.
+    constexpr size_t kLong = 8192;
+    constexpr size_t kShort = 256;
+
+    uint32_t gf2_matrix_times(const uint32_t* mat, uint32_t vec) {
+        uint32_t sum = 0;
+        while (vec) {
+            if (vec & 1) sum ^= *mat;
+            vec >>= 1;
+            mat++;
+        }
+        return sum;
+    }
+
+    void gf2_matrix_square(uint32_t* square, const uint32_t* mat) {
+        for (int n = 0; n < 32; ++n) {
+            square[n] = gf2_matrix_times(mat, mat[n]);
+        }
+    }
+
+    // Builds the operator that appends `len` zero bytes to a CRC.
+    void zeros_operator(uint32_t* even, size_t len) {
+        uint32_t odd[32];
+        odd[0] = kPoly; // operator for one zero bit
+        uint32_t row = 1;
+        for (int n = 1; n < 32; ++n) {
+            odd[n] = row;
+            row <<= 1;
+        }
+        gf2_matrix_square(even, odd); // two zero bits
+        gf2_matrix_square(odd, even); // four zero bits
+
+        // Each squaring doubles the number of zeros; the first pass reaches one byte.
+        do {
+            gf2_matrix_square(even, odd);
+            len >>= 1;
+            if (len == 0) return;
+            gf2_matrix_square(odd, even);
+            len >>= 1;
+        } while (len);
+        std::memcpy(even, odd, sizeof(odd));
+    }
+
+    struct ShiftTable {
+        uint32_t t[4][256];
+        explicit ShiftTable(size_t len) {
+            uint32_t op[32];
+            zeros_operator(op, len);
+            for (uint32_t n = 0; n < 256; ++n) {
+                t[0][n] = gf2_matrix_times(op, n);
+                t[1][n] = gf2_matrix_times(op, n << 8);
+                t[2][n] = gf2_matrix_times(op, n << 16);
+                t[3][n] = gf2_matrix_times(op, n << 24);
+            }
+        }
+        uint32_t shift(uint32_t crc) const {
+            return t[0][crc & 0xFF] ^ t[1][(crc >> 8) & 0xFF] ^ t[2][(crc >> 16) & 0xFF] ^ t[3][crc >> 24];
+        }
+    };
+
+    const ShiftTable& long_shift() {
+        static const ShiftTable table(kLong);
+        return table;
+    }
+
+    const ShiftTable& short_shift() {
+        static const ShiftTable table(kShort);
+        return table;
+    }
+
+    inline uint64_t load64(const uint8_t* p) {
+        uint64_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    __attribute__((target("sse4.2")))
+    uint32_t crc32c_sse42(uint32_t crc, const uint8_t* next, size_t len) {
+#if defined(__x86_64__)
+        uint64_t crc0 = ~crc;
+        while (len && (reinterpret_cast<uintptr_t>(next) & 7) != 0) {
+            crc0 = _mm_crc32_u8(static_cast<uint32_t>(crc0), *next++);
+            len--;
+        }
+
+        const ShiftTable& long_table = long_shift();
+        while (len >= kLong * 3) {
+            uint64_t crc1 = 0, crc2 = 0;
+            const uint8_t* end = next + kLong;
+            do {
+                crc0 = _mm_crc32_u64(crc0, load64(next));
+                crc1 = _mm_crc32_u64(crc1, load64(next + kLong));
+                crc2 = _mm_crc32_u64(crc2, load64(next + kLong * 2));
+                next += 8;
+            } while (next < end);
+            crc0 = long_table.shift(static_cast<uint32_t>(crc0)) ^ crc1;
+            crc0 = long_table.shift(static_cast<uint32_t>(crc0)) ^ crc2;
+            next += kLong * 2;
+            len -= kLong * 3;
+        }
+
+        const ShiftTable& short_table = short_shift();
+        while (len >= kShort * 3) {
+            uint64_t crc1 = 0, crc2 = 0;
+            const uint8_t* end = next + kShort;
+            do {
+                crc0 = _mm_crc32_u64(crc0, load64(next));
+                crc1 = _mm_crc32_u64(crc1, load64(next + kShort));
+                crc2 = _mm_crc32_u64(crc2, load64(next + kShort * 2));
+                next += 8;
+            } while (next < end);
+            crc0 = short_table.shift(static_cast<uint32_t>(crc0)) ^ crc1;
+            crc0 = short_table.shift(static_cast<uint32_t>(crc0)) ^ crc2;
+            next += kShort * 2;
+            len -= kShort * 3;
+        }
+
+        while (len >= 8) {
+            crc0 = _mm_crc32_u64(crc0, load64(next));
+            next += 8;
+            len -= 8;
+        }
+        uint32_t crc32 = static_cast<uint32_t>(crc0);
+#else
+        uint32_t crc32 = ~crc;
+        while (len >= 4) {
+            uint32_t v;
+            std::memcpy(&v, next, sizeof(v));
+            crc32 = _mm_crc32_u32(crc32, v);
+            next += 4;
+            len -= 4;
+        }
+#endif
+        while (len--) {
+            crc32 = _mm_crc32_u8(crc32, *next++);
+        }
+        return ~crc32;
+    }
+} // anonymous namespace
+#endif
+
+bool hardware_available() {
+#ifdef TISSDB_CRC32C_X86
+    static const bool available = __builtin_cpu_supports("sse4.2");
+    return available;
+#else
+    return false;
+#endif
+}
+
+uint32_t extend_hardware(uint32_t crc, const void* data, size_t size) {
+#ifdef TISSDB_CRC32C_X86
+    if (hardware_available()) {
+        return crc32c_sse42(crc, static_cast<const uint8_t*>(data), size);
+    }
+#endif
+    return extend_portable(crc, data, size);
+}
+
+const char* active_implementation() {
+    return hardware_available() ? "sse4.2" : "slicing-by-8";
+}
+} // namespace Crc32cImpl
+
+uint32_t crc32c_extend(uint32_t crc, const void* data, size_t size) {
+    using ExtendFn = uint32_t (*)(uint32_t, const uint8_t*, size_t);
+#ifdef TISSDB_CRC32C_X86
+    static const ExtendFn extend = Crc32cImpl::hardware_available()
+        ? Crc32cImpl::crc32c_sse42 : Crc32cImpl::extend_portable_bytes;
+#else
+    static const ExtendFn extend = Crc32cImpl::extend_portable_bytes;
+#endif
+    return extend(crc, static_cast<const uint8_t*>(data), size);
+}
+
 }
 }
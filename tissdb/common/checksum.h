@@ -10,9 +10,53 @@ namespace Crc32Impl {
     uint32_t calculate(const void* data, size_t size, uint32_t crc = 0xFFFFFFFF);
 }
 
+// Legacy CRC-32 (IEEE 802.3). Kept so files written before CRC32C was
+// introduced remain readable.
 inline uint32_t crc32(const void* data, size_t size) {
     return Crc32Impl::calculate(data, size);
 }
 
+namespace Crc32cImpl {
+    // Each function continues a finalized CRC32C value `crc` over `size` more
+    // bytes, so extend(extend(0, a), b) == extend(0, a + b).
+    uint32_t extend_portable(uint32_t crc, const void* data, size_t size); // slicing-by-8
+    uint32_t extend_hardware(uint32_t crc, const void* data, size_t size); // SSE4.2 crc32 instruction
+
+    // True if extend_hardware may be called on this CPU.
+    bool hardware_available();
+
+    // The implementation picked at startup, e.g. "sse4.2" or "slicing-by-8".
+    const char* active_implementation();
+}
+
+// CRC-32C (Castagnoli). Dispatches to the fastest implementation the CPU
+// supports; the choice is made once at startup.
+uint32_t crc32c_extend(uint32_t crc, const void* data, size_t size);
+
+inline uint32_t crc32c(const void* data, size_t size) {
+    return crc32c_extend(0, data, size);
+}
+
+// Incremental CRC32C over data that is not contiguous in memory.
+class Crc32c {
+public:
+    void update(const void* data, size_t size) { crc_ = crc32c_extend(crc_, data, size); }
+    uint32_t value() const { return crc_; }
+    void reset() { crc_ = 0; }
+
+private:
+    uint32_t crc_ = 0;
+};
+
+// Identifies the checksum algorithm recorded in on-disk file headers/footers.
+enum class ChecksumType : uint8_t {
+    CRC32 = 1,
+    CRC32C = 2
+};
+
+inline uint32_t checksum(ChecksumType type, const void* data, size_t size) {
+    return type == ChecksumType::CRC32C ? crc32c(data, size) : crc32(data, size);
+}
+
 }
 }
@@ -0,0 +1,271 @@
+#include "log.h"
+#include "ring_buffer.h"
+
+#include <algorithm>
+#include <cctype>
+#include <condition_variable>
+#include <cstdlib>
+#include <ctime>
+#include <mutex>
+#include <streambuf>
+#include <thread>
+
+namespace TissDB {
+namespace Log {
+
+namespace detail {
+std::atomic<int> runtime_level{static_cast<int>(LogLevel::INFO)};
+} // namespace detail
+
+namespace {
+
+constexpr size_t QUEUE_CAPACITY = 8192;
+constexpr size_t MAX_BATCH = 512;
+constexpr auto IDLE_WAIT = std::chrono::milliseconds(100);
+constexpr auto DROP_REPORT_INTERVAL = std::chrono::seconds(10);
+
+// Formats "[YYYY-mm-dd HH:MM:SS.mmm]" into `out`. localtime and strftime run
+// once per second per thread; within a second only the milliseconds change.
+void append_timestamp(std::string& out) {
+    thread_local int64_t cached_second = -1;
+    thread_local char cached[32];
+    thread_local size_t cached_length = 0;
+
+    const auto now = std::chrono::system_clock::now();
+    const int64_t ms = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count();
+    const int64_t second = ms / 1000;
+    if (second != cached_second) {
+        const std::time_t t = static_cast<std::time_t>(second);
+        std::tm local{};
+#ifdef _WIN32
+        localtime_s(&local, &t);
+#else
+        localtime_r(&t, &local);
+#endif
+        cached_length = std::strftime(cached, sizeof(cached), "[%Y-%m-%d %H:%M:%S.", &local);
+        cached_second = second;
+    }
+    out.append(cached, cached_length);
+    const int millis = static_cast<int>(ms % 1000);
+    out.push_back(static_cast<char>('0' + millis / 100));
+    out.push_back(static_cast<char>('0' + millis / 10 % 10));
+    out.push_back(static_cast<char>('0' + millis % 10));
+    out.push_back(']');
+}
+
+void append_prefix(std::string& out, LogLevel level, const char* file, int line) {
+    append_timestamp(out);
+    out += " [";
+    out += LogLevelToString(level);
+    out += "] [";
+    out += file;
+    out.push_back(':');
+    out += std::to_string(line);
+    out += "] ";
+}
+
+// Lines are queued on a lock-free ring buffer and written by one background
+// thread, in batches. When the writer falls behind, DEBUG and INFO lines are
+// dropped and counted; WARNING and ERROR lines wait for room.
+class Sink {
+public:
+    // Never destroyed, so lines logged from static destructors still have
+    // somewhere to go; queued lines are written out at exit.
+    static Sink& instance() {
+        static Sink* sink = new Sink();
+        return *sink;
+    }
+
+    void write(std::string&& line, LogLevel level) {
+        if (!queue_.try_push(std::move(line))) {
+            if (level < LogLevel::WARNING) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            do {
+                wake_writer_.notify_one();
+                std::this_thread::yield();
+            } while (!queue_.try_push(std::move(line)));
+        }
+        queued_.fetch_add(1, std::memory_order_release);
+        if (writer_idle_.load(std::memory_order_acquire)) {
+            wake_writer_.notify_one();
+        }
+    }
+
+    void flush() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        const uint64_t target = queued_.load(std::memory_order_acquire);
+        wake_writer_.notify_one();
+        written_cv_.wait(lock, [&] { return written_ >= target; });
+    }
+
+    void set_output(std::FILE* file) {
+        flush();
+        output_.store(file);
+    }
+
+    Stats stats() {
+        Stats stats;
+        stats.dropped = dropped_.load();
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats.written = written_;
+        return stats;
+    }
+
+private:
+    Sink() : queue_(QUEUE_CAPACITY) {
+        std::thread([this] { writer_loop(); }).detach();
+        std::atexit([] { Sink::instance().flush(); });
+    }
+
+    void writer_loop() {
+        using Clock = std::chrono::steady_clock;
+        std::string batch;
+        std::string line;
+        uint64_t reported_drops = 0;
+        Clock::time_point last_drop_report;
+
+        for (;;) {
+            size_t drained = 0;
+            while (drained < MAX_BATCH && queue_.try_pop(line)) {
+                batch += line;
+                ++drained;
+            }
+            const uint64_t dropped = dropped_.load(std::memory_order_relaxed);
+            if (dropped != reported_drops && Clock::now() - last_drop_report >= DROP_REPORT_INTERVAL) {
+                append_prefix(batch, LogLevel::WARNING, __FILE__, __LINE__);
+                batch += "Log writer fell behind; dropped " + std::to_string(dropped - reported_drops) + " lines.\n";
+                reported_drops = dropped;
+                last_drop_report = Clock::now();
+            }
+            if (!batch.empty()) {
+                std::FILE* out = output_.load();
+                std::fwrite(batch.data(), 1, batch.size(), out);
+                std::fflush(out);
+                batch.clear();
+            }
+
+            std::unique_lock<std::mutex> lock(mutex_);
+            written_ += drained;
+            if (drained > 0) written_cv_.notify_all();
+            if (drained == MAX_BATCH) continue;
+            if (written_ < queued_.load(std::memory_order_acquire)) {
+                // A producer has claimed a slot but not filled it yet.
+                lock.unlock();
+                std::this_thread::yield();
+                continue;
+            }
+            writer_idle_.store(true, std::memory_order_release);
+            wake_writer_.wait_for(lock, IDLE_WAIT);
+            writer_idle_.store(false, std::memory_order_release);
+        }
+    }
+
+    Common::MpscRingBuffer<std::string> queue_;
+    std::atomic<std::FILE*> output_{stderr};
+    std::atomic<uint64_t> queued_{0};
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<bool> writer_idle_{false};
+
+    std::mutex mutex_;
+    std::condition_variable wake_writer_;
+    std::condition_variable written_cv_;
+    uint64_t written_ = 0;
+};
+
+// Applies TISSDB_LOG_LEVEL before main() runs.
+struct EnvironmentLevel {
+    EnvironmentLevel() {
+        LogLevel level;
+        const char* name = std::getenv("TISSDB_LOG_LEVEL");
+        if (name && parse_level(name, level)) set_level(level);
+    }
+} environment_level;
+
+} // anonymous namespace
+
+// The text of a line being formatted. Each thread keeps one and reuses its
+// capacity, so formatting a line normally allocates only the copy handed to
+// the writer.
+struct Line::Buffer : std::streambuf {
+    std::string text;
+    std::ostream stream{this};
+    bool in_use = false;
+
+protected:
+    int_type overflow(int_type c) override {
+        if (!traits_type::eq_int_type(c, traits_type::eof())) text.push_back(traits_type::to_char_type(c));
+        return traits_type::not_eof(c);
+    }
+    std::streamsize xsputn(const char* s, std::streamsize n) override {
+        text.append(s, static_cast<size_t>(n));
+        return n;
+    }
+};
+
+Line::Line(LogLevel level, const char* file, int line) : level_(level) {
+    thread_local Buffer thread_buffer;
+    owned_ = thread_buffer.in_use;
+    buffer_ = owned_ ? new Buffer() : &thread_buffer;
+    buffer_->in_use = true;
+    stream_ = &buffer_->stream;
+    append_prefix(buffer_->text, level, file, line);
+}
+
+Line::~Line() {
+    buffer_->text.push_back('\n');
+    Sink::instance().write(std::string(buffer_->text), level_);
+    if (owned_) {
+        delete buffer_;
+        return;
+    }
+    buffer_->text.clear();
+    buffer_->stream.clear();
+    buffer_->in_use = false;
+}
+
+bool RateLimiter::allow(uint64_t& suppressed) {
+    const auto now = std::chrono::steady_clock::now().time_since_epoch().count();
+    auto next = next_.load(std::memory_order_relaxed);
+    if (now < next || !next_.compare_exchange_strong(next, now + interval_, std::memory_order_relaxed)) {
+        suppressed_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    suppressed = suppressed_.exchange(0, std::memory_order_relaxed);
+    return true;
+}
+
+void set_level(LogLevel level) {
+    detail::runtime_level.store(static_cast<int>(level), std::memory_order_relaxed);
+}
+
+LogLevel level() {
+    return static_cast<LogLevel>(detail::runtime_level.load(std::memory_order_relaxed));
+}
+
+bool parse_level(const std::string& name, LogLevel& level) {
+    std::string lower = name;
+    std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return std::tolower(c); });
+    if (lower == "debug") level = LogLevel::DEBUG;
+    else if (lower == "info") level = LogLevel::INFO;
+    else if (lower == "warning" || lower == "warn") level = LogLevel::WARNING;
+    else if (lower == "error") level = LogLevel::ERROR;
+    else return false;
+    return true;
+}
+
+void set_output(std::FILE* file) {
+    Sink::instance().set_output(file);
+}
+
+void flush() {
+    Sink::instance().flush();
+}
+
+Stats stats() {
+    return Sink::instance().stats();
+}
+
+} // namespace Log
+} // namespace TissDB
@@ -1,12 +1,13 @@
 #ifndef TISSDB_LOG_H
 #define TISSDB_LOG_H
 
-#include <iostream>
-#include <string>
+#include <atomic>
 #include <chrono>
-#include <ctime>
-#include <iomanip>
-#include <sstream>
+#include <cstdint>
+#include <cstdio>
+#include <limits>
+#include <ostream>
+#include <string>
 
 // Log levels
 enum class LogLevel {
@@ -16,8 +17,10 @@ enum class LogLevel {
     ERROR
 };
 
-// This allows controlling the verbosity at compile time.
-// For example, a release build could set this to LogLevel::INFO.
+// This allows controlling the verbosity at compile time: statements below
+// this level compile to nothing. For example, a release build could set this
+// to LogLevel::INFO. Statements at or above it are still filtered at run time
+// by TissDB::Log::set_level().
 #ifndef LOG_LEVEL
 #define LOG_LEVEL LogLevel::DEBUG
 #endif
@@ -32,19 +35,110 @@ inline std::string LogLevelToString(LogLevel level) {
     return "UNKNOWN";
 }
 
+namespace TissDB {
+namespace Log {
+
+// Minimum level written at run time. Defaults to INFO, or to the value of the
+// TISSDB_LOG_LEVEL environment variable (debug, info, warning or error).
+void set_level(LogLevel level);
+LogLevel level();
+// Parses a level name, case-insensitively. Returns false if it is not one.
+bool parse_level(const std::string& name, LogLevel& level);
+
+// Where the log goes; stderr by default. The file must outlive its use.
+void set_output(std::FILE* file);
+
+// Returns once every line logged before the call has been written out.
+void flush();
+
+struct Stats {
+    uint64_t written = 0;
+    uint64_t dropped = 0; // DEBUG and INFO lines refused because the sink was full
+};
+Stats stats();
+
+namespace detail {
+extern std::atomic<int> runtime_level;
+} // namespace detail
+
+constexpr bool compiled_in(LogLevel level) {
+    return static_cast<int>(level) >= static_cast<int>(LOG_LEVEL);
+}
+
+inline bool enabled(LogLevel level) {
+    return static_cast<int>(level) >= detail::runtime_level.load(std::memory_order_relaxed);
+}
+
+// One log line. The message is formatted into a per-thread buffer and handed
+// to the background writer when the line goes out of scope, so the calling
+// thread never waits on the terminal or a file.
+class Line {
+public:
+    Line(LogLevel level, const char* file, int line);
+    ~Line();
+
+    Line(const Line&) = delete;
+    Line& operator=(const Line&) = delete;
+
+    std::ostream& stream() { return *stream_; }
+
+private:
+    struct Buffer;
+
+    LogLevel level_;
+    Buffer* buffer_;
+    std::ostream* stream_;
+    bool owned_; // Formatting the message logged something itself, so the thread's buffer was taken
+};
+
+// Lets through at most one message per interval and counts the rest, for a
+// single LOG_EVERY_N_SEC call site.
+class RateLimiter {
+public:
+    explicit RateLimiter(std::chrono::steady_clock::duration interval) : interval_(interval.count()) {}
+
+    // On true, `suppressed` is the number of messages refused since the last
+    // one let through.
+    bool allow(uint64_t& suppressed);
+
+private:
+    const std::chrono::steady_clock::rep interval_;
+    std::atomic<std::chrono::steady_clock::rep> next_{std::numeric_limits<std::chrono::steady_clock::rep>::min()};
+    std::atomic<uint64_t> suppressed_{0};
+};
+
+} // namespace Log
+} // namespace TissDB
+
 // The core logging macro.
-// Using a macro allows us to automatically capture __FILE__ and __LINE__.
+// Using a macro allows us to automatically capture __FILE__ and __LINE__, and
+// to skip evaluating the message entirely when the level is filtered out:
+// below LOG_LEVEL the whole statement is dead code, and otherwise a disabled
+// statement costs one relaxed load and a branch. The message is streamed, so
+// LOG_DEBUG("GET key: " << key) formats nothing unless it is written.
 #define LOG(level, message) \
     do { \
-        if (level >= LOG_LEVEL) { \
-            auto now = std::chrono::system_clock::now(); \
-            auto in_time_t = std::chrono::system_clock::to_time_t(now); \
-            std::stringstream ss; \
-            ss << "[" << std::put_time(std::localtime(&in_time_t), "%Y-%m-%d %X") << "]"; \
-            ss << " [" << LogLevelToString(level) << "]"; \
-            ss << " [" << __FILE__ << ":" << __LINE__ << "] "; \
-            ss << message; \
-            std::cerr << ss.str() << std::endl; \
+        if (::TissDB::Log::compiled_in(level) && ::TissDB::Log::enabled(level)) { \
+            ::TissDB::Log::Line tissdb_log_line_(level, __FILE__, __LINE__); \
+            tissdb_log_line_.stream() << message; \
+        } \
+    } while (0)
+
+// Like LOG, but writes at most one message per `interval_seconds` from this call site
+// and notes how many were suppressed in between. For messages a client or a
+// damaged file can trigger over and over.
+#define LOG_EVERY_N_SEC(level, interval_seconds, message) \
+    do { \
+        if (::TissDB::Log::compiled_in(level) && ::TissDB::Log::enabled(level)) { \
+            static ::TissDB::Log::RateLimiter tissdb_log_limiter_{std::chrono::seconds(interval_seconds)}; \
+            uint64_t tissdb_log_suppressed_ = 0; \
+            if (tissdb_log_limiter_.allow(tissdb_log_suppressed_)) { \
+                ::TissDB::Log::Line tissdb_log_line_(level, __FILE__, __LINE__); \
+                tissdb_log_line_.stream() << message; \
+                if (tissdb_log_suppressed_ > 0) { \
+                    tissdb_log_line_.stream() << " (" << tissdb_log_suppressed_ << " similar messages suppressed)"; \
+                } \
+            } \
         } \
     } while (0)
 
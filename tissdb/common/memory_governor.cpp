@@ -0,0 +1,160 @@
+#include "memory_governor.h"
+#include "log.h"
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace TissDB {
+namespace Common {
+
+const char* to_string(MemorySubsystem subsystem) {
+    switch (subsystem) {
+        case MemorySubsystem::Memtable: return "memtable";
+        case MemorySubsystem::Index: return "index";
+        case MemorySubsystem::SSTable: return "sstable";
+        case MemorySubsystem::Query: return "query";
+        case MemorySubsystem::Count: break;
+    }
+    return "unknown";
+}
+
+MemoryGovernor& MemoryGovernor::instance() {
+    static MemoryGovernor governor;
+    return governor;
+}
+
+void MemoryGovernor::adjust(MemorySubsystem subsystem, int64_t delta) {
+    if (delta == 0) return;
+    usage_[static_cast<size_t>(subsystem)].fetch_add(delta);
+    uint64_t total = total_.fetch_add(static_cast<uint64_t>(delta)) + static_cast<uint64_t>(delta);
+    uint64_t peak = peak_.load();
+    while (total > peak && !peak_.compare_exchange_weak(peak, total)) {
+    }
+}
+
+uint64_t MemoryGovernor::usage(MemorySubsystem subsystem) const {
+    int64_t value = usage_[static_cast<size_t>(subsystem)].load();
+    return value > 0 ? static_cast<uint64_t>(value) : 0;
+}
+
+bool MemoryGovernor::over_budget() const {
+    uint64_t budget = budget_.load();
+    return budget != 0 && total_.load() > budget;
+}
+
+uint64_t MemoryGovernor::register_reclaimer(Reclaimer reclaimer) {
+    std::lock_guard<std::mutex> lock(reclaim_mutex_);
+    uint64_t id = next_reclaimer_id_++;
+    reclaimers_[id] = std::move(reclaimer);
+    return id;
+}
+
+void MemoryGovernor::unregister_reclaimer(uint64_t id) {
+    std::lock_guard<std::mutex> lock(reclaim_mutex_);
+    reclaimers_.erase(id);
+}
+
+size_t MemoryGovernor::reclaim(size_t bytes) {
+    std::lock_guard<std::mutex> lock(reclaim_mutex_);
+    return reclaim_locked(bytes);
+}
+
+size_t MemoryGovernor::reclaim_locked(size_t bytes) {
+    std::vector<std::pair<size_t, const Reclaimer*>> candidates;
+    for (const auto& [id, reclaimer] : reclaimers_) {
+        size_t reclaimable = reclaimer.usage();
+        if (reclaimable > 0) candidates.emplace_back(reclaimable, &reclaimer);
+    }
+    std::sort(candidates.begin(), candidates.end(),
+              [](const auto& a, const auto& b) { return a.first > b.first; });
+
+    reclaiming_.store(true);
+    size_t freed = 0;
+    for (const auto& candidate : candidates) {
+        if (freed >= bytes) break;
+        try {
+            freed += candidate.second->reclaim();
+        } catch (const std::exception& e) {
+            LOG_ERROR(std::string("Memory reclaim failed: ") + e.what());
+        }
+    }
+    reclaiming_.store(false);
+    reclaims_.fetch_add(1);
+    bytes_reclaimed_.fetch_add(freed);
+    return freed;
+}
+
+void MemoryGovernor::admit_write() {
+    if (!over_budget()) return;
+
+    const bool stalled = reclaiming_.load();
+    const auto started = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(reclaim_mutex_);
+    if (stalled) {
+        write_stalls_.fetch_add(1);
+        write_stall_ms_.fetch_add(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - started).count()));
+    }
+    // Another writer may have reclaimed while this one waited.
+    if (!over_budget()) return;
+
+    const uint64_t budget = budget_.load();
+    const uint64_t reclaimable = usage(MemorySubsystem::Memtable);
+    if (reclaimable < budget / 16) return;
+    // Aim below the budget so the next writes do not trigger another reclaim right away.
+    const uint64_t target = budget - budget / 8;
+    const uint64_t total = total_.load();
+    if (total > target) {
+        reclaim_locked(total - target);
+    }
+}
+
+bool MemoryGovernor::try_reserve_query(size_t bytes) {
+    uint64_t budget = budget_.load();
+    if (budget != 0 && total_.load() + bytes > budget) {
+        if (usage(MemorySubsystem::Memtable) >= budget / 16) {
+            reclaim(total_.load() + bytes - budget);
+        }
+        if (total_.load() + bytes > budget) {
+            queries_rejected_.fetch_add(1);
+            return false;
+        }
+    }
+    adjust(MemorySubsystem::Query, static_cast<int64_t>(bytes));
+    return true;
+}
+
+MemoryGovernor::Stats MemoryGovernor::stats() const {
+    Stats stats;
+    stats.budget = budget_.load();
+    stats.total = total_.load();
+    stats.peak = peak_.load();
+    for (size_t i = 0; i < stats.usage.size(); ++i) {
+        stats.usage[i] = usage(static_cast<MemorySubsystem>(i));
+    }
+    stats.reclaims = reclaims_.load();
+    stats.bytes_reclaimed = bytes_reclaimed_.load();
+    stats.write_stalls = write_stalls_.load();
+    stats.write_stall_ms = write_stall_ms_.load();
+    stats.queries_rejected = queries_rejected_.load();
+    return stats;
+}
+
+void MemoryReservation::grow(size_t bytes) {
+    if (!MemoryGovernor::instance().try_reserve_query(bytes)) {
+        throw std::runtime_error("Query exceeds the memory budget (" + std::to_string(bytes_ + bytes) + " bytes requested).");
+    }
+    bytes_ += bytes;
+}
+
+void MemoryReservation::release() {
+    if (bytes_ == 0) return;
+    MemoryGovernor::instance().release_query(bytes_);
+    bytes_ = 0;
+}
+
+} // namespace Common
+} // namespace TissDB
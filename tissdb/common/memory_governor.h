@@ -0,0 +1,122 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+
+namespace TissDB {
+namespace Common {
+
+// Consumers of memory tracked by the governor.
+enum class MemorySubsystem {
+    Memtable,   // Unflushed writes in collections
+    Index,      // In-memory B+ tree indexes
+    SSTable,    // Per-table sparse indexes kept while a table is open
+    Query,      // Working memory of running queries
+    Count
+};
+
+const char* to_string(MemorySubsystem subsystem);
+
+// Process-wide memory accounting against a single budget.
+//
+// Subsystems report their usage as deltas. Databases register a reclaimer
+// that frees memory (by flushing memtables) when asked. Writers call
+// admit_write() before taking any database lock: over budget, the first one
+// runs the reclaimers and the others wait for it, which is the backpressure.
+// Queries reserve working memory and are refused past the budget.
+class MemoryGovernor {
+public:
+    struct Reclaimer {
+        std::function<size_t()> usage;   // Bytes this reclaimer could free
+        std::function<size_t()> reclaim; // Frees what it can, returns bytes freed
+    };
+
+    struct Stats {
+        uint64_t budget = 0;
+        uint64_t total = 0;
+        uint64_t peak = 0;
+        std::array<uint64_t, static_cast<size_t>(MemorySubsystem::Count)> usage{};
+        uint64_t reclaims = 0;
+        uint64_t bytes_reclaimed = 0;
+        uint64_t write_stalls = 0;
+        uint64_t write_stall_ms = 0;
+        uint64_t queries_rejected = 0;
+    };
+
+    static MemoryGovernor& instance();
+
+    MemoryGovernor() = default;
+    MemoryGovernor(const MemoryGovernor&) = delete;
+    MemoryGovernor& operator=(const MemoryGovernor&) = delete;
+
+    // 0 disables the budget (accounting still happens).
+    void set_budget(uint64_t bytes) { budget_.store(bytes); }
+    uint64_t budget() const { return budget_.load(); }
+
+    void adjust(MemorySubsystem subsystem, int64_t delta);
+    uint64_t usage(MemorySubsystem subsystem) const;
+    uint64_t total() const { return total_.load(); }
+    bool over_budget() const;
+
+    uint64_t register_reclaimer(Reclaimer reclaimer);
+    void unregister_reclaimer(uint64_t id);
+
+    // Asks reclaimers, largest first, to free at least `bytes`. Returns bytes freed.
+    size_t reclaim(size_t bytes);
+
+    // Over budget, reclaims down to 7/8 of it, or waits for a reclaim already
+    // in progress. Memtables smaller than 1/16 of the budget in total are not
+    // worth a flush; writes then go through even though the budget is exceeded.
+    void admit_write();
+
+    // Reserves query working memory. Returns false (after trying to reclaim,
+    // as admit_write() does) if the reservation would exceed the budget.
+    bool try_reserve_query(size_t bytes);
+    void release_query(size_t bytes) { adjust(MemorySubsystem::Query, -static_cast<int64_t>(bytes)); }
+
+    Stats stats() const;
+
+private:
+    std::array<std::atomic<int64_t>, static_cast<size_t>(MemorySubsystem::Count)> usage_{};
+    std::atomic<uint64_t> total_{0};
+    std::atomic<uint64_t> peak_{0};
+    std::atomic<uint64_t> budget_{0};
+
+    std::mutex reclaim_mutex_; // Held while reclaimers run and while they change
+    std::map<uint64_t, Reclaimer> reclaimers_;
+    uint64_t next_reclaimer_id_ = 1;
+    std::atomic<bool> reclaiming_{false};
+
+    size_t reclaim_locked(size_t bytes);
+
+    std::atomic<uint64_t> reclaims_{0};
+    std::atomic<uint64_t> bytes_reclaimed_{0};
+    std::atomic<uint64_t> write_stalls_{0};
+    std::atomic<uint64_t> write_stall_ms_{0};
+    std::atomic<uint64_t> queries_rejected_{0};
+};
+
+// Query working memory held for the lifetime of the object.
+class MemoryReservation {
+public:
+    MemoryReservation() = default;
+    ~MemoryReservation() { release(); }
+    MemoryReservation(const MemoryReservation&) = delete;
+    MemoryReservation& operator=(const MemoryReservation&) = delete;
+
+    // Throws std::runtime_error if the governor refuses the memory.
+    void grow(size_t bytes);
+    void release();
+    size_t size() const { return bytes_; }
+
+private:
+    size_t bytes_ = 0;
+};
+
+} // namespace Common
+} // namespace TissDB
@@ -0,0 +1,158 @@
+#include "metrics.h"
+
+#include <cstdio>
+
+namespace TissDB {
+namespace Common {
+
+namespace {
+// Prometheus buckets are exported at powers of two from ~1 us to ~34 s; the
+// finer HDR buckets are kept for quantile().
+constexpr int EXPORT_MIN_EXPONENT = 10;
+constexpr int EXPORT_MAX_EXPONENT = 35;
+
+std::string format_double(double value) {
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.9g", value);
+    return text;
+}
+
+std::string with_labels(const std::string& name, const std::string& labels, const std::string& extra = "") {
+    if (labels.empty() && extra.empty()) return name;
+    std::string out = name + "{" + labels;
+    if (!labels.empty() && !extra.empty()) out += ",";
+    return out + extra + "}";
+}
+} // anonymous namespace
+
+namespace detail {
+size_t metric_shard() {
+    static std::atomic<size_t> next{0};
+    thread_local const size_t shard = next.fetch_add(1, std::memory_order_relaxed) % METRIC_SHARDS;
+    return shard;
+}
+} // namespace detail
+
+uint64_t Counter::value() const {
+    uint64_t total = 0;
+    for (const auto& shard : shards_) total += shard.value.load(std::memory_order_relaxed);
+    return total;
+}
+
+size_t Histogram::bucket_of(uint64_t ns) {
+    if (ns < SUB_BUCKETS) return static_cast<size_t>(ns);
+#if defined(__GNUC__) || defined(__clang__)
+    const int exponent = 63 - __builtin_clzll(ns);
+#else
+    int exponent = 63;
+    while (!(ns >> exponent)) --exponent;
+#endif
+    if (exponent > MAX_EXPONENT) return BUCKETS - 1;
+    const size_t sub = static_cast<size_t>(ns >> (exponent - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1);
+    return static_cast<size_t>(exponent - SUB_BUCKET_BITS + 1) * SUB_BUCKETS + sub;
+}
+
+uint64_t Histogram::bucket_lower_bound(size_t bucket) {
+    if (bucket < SUB_BUCKETS) return bucket;
+    const int exponent = static_cast<int>(bucket / SUB_BUCKETS) + SUB_BUCKET_BITS - 1;
+    return (SUB_BUCKETS + bucket % SUB_BUCKETS) << (exponent - SUB_BUCKET_BITS);
+}
+
+void Histogram::record(uint64_t ns) {
+    Shard& shard = shards_[detail::metric_shard()];
+    shard.buckets[bucket_of(ns)].fetch_add(1, std::memory_order_relaxed);
+    shard.sum_ns.fetch_add(ns, std::memory_order_relaxed);
+}
+
+Histogram::Snapshot Histogram::snapshot() const {
+    Snapshot snapshot;
+    snapshot.buckets.assign(BUCKETS, 0);
+    for (const auto& shard : shards_) {
+        for (size_t i = 0; i < BUCKETS; ++i) {
+            snapshot.buckets[i] += shard.buckets[i].load(std::memory_order_relaxed);
+        }
+        snapshot.sum_ns += shard.sum_ns.load(std::memory_order_relaxed);
+    }
+    // Counted from the buckets so the two always agree, even while recording.
+    for (uint64_t n : snapshot.buckets) snapshot.count += n;
+    return snapshot;
+}
+
+uint64_t Histogram::Snapshot::quantile(double q) const {
+    if (count == 0) return 0;
+    const double target = std::min(std::max(q, 0.0), 1.0) * static_cast<double>(count);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < buckets.size(); ++i) {
+        seen += buckets[i];
+        if (buckets[i] > 0 && static_cast<double>(seen) >= target) {
+            return i + 1 < BUCKETS ? bucket_lower_bound(i + 1) - 1 : bucket_lower_bound(i);
+        }
+    }
+    return bucket_lower_bound(BUCKETS - 1);
+}
+
+Metrics& Metrics::instance() {
+    // Never destroyed: detached threads may still record during exit.
+    static Metrics* metrics = new Metrics();
+    return *metrics;
+}
+
+Metrics::Family& Metrics::family(const std::string& name, const std::string& help, bool is_histogram) {
+    auto [it, inserted] = families_.try_emplace(name);
+    if (inserted) {
+        it->second.help = help;
+        it->second.is_histogram = is_histogram;
+    }
+    return it->second;
+}
+
+Counter& Metrics::counter(const std::string& name, const std::string& help, const std::string& labels) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& slot = family(name, help, false).counters[labels];
+    if (!slot) slot = std::make_unique<Counter>();
+    return *slot;
+}
+
+Histogram& Metrics::histogram(const std::string& name, const std::string& help, const std::string& labels) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& slot = family(name, help, true).histograms[labels];
+    if (!slot) slot = std::make_unique<Histogram>();
+    return *slot;
+}
+
+void Metrics::export_prometheus(std::string& out) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& [name, family] : families_) {
+        out += "# HELP " + name + " " + family.help + "\n";
+        out += "# TYPE " + name + (family.is_histogram ? " histogram\n" : " counter\n");
+        for (const auto& [labels, counter] : family.counters) {
+            out += with_labels(name, labels) + " " + std::to_string(counter->value()) + "\n";
+        }
+        for (const auto& [labels, histogram] : family.histograms) {
+            const Histogram::Snapshot snapshot = histogram->snapshot();
+            uint64_t cumulative = 0;
+            size_t bucket = 0;
+            for (int exponent = EXPORT_MIN_EXPONENT; exponent <= EXPORT_MAX_EXPONENT; ++exponent) {
+                const size_t end = Histogram::bucket_of(uint64_t(1) << exponent);
+                for (; bucket < end; ++bucket) cumulative += snapshot.buckets[bucket];
+                const double le = static_cast<double>(uint64_t(1) << exponent) / 1e9;
+                out += with_labels(name + "_bucket", labels, "le=\"" + format_double(le) + "\"") + " " +
+                       std::to_string(cumulative) + "\n";
+            }
+            out += with_labels(name + "_bucket", labels, "le=\"+Inf\"") + " " + std::to_string(snapshot.count) + "\n";
+            out += with_labels(name + "_sum", labels) + " " +
+                   format_double(static_cast<double>(snapshot.sum_ns) / 1e9) + "\n";
+            out += with_labels(name + "_count", labels) + " " + std::to_string(snapshot.count) + "\n";
+        }
+    }
+}
+
+void append_prometheus_sample(std::string& out, const std::string& name, const std::string& type,
+                              const std::string& help, double value) {
+    out += "# HELP " + name + " " + help + "\n";
+    out += "# TYPE " + name + " " + type + "\n";
+    out += name + " " + format_double(value) + "\n";
+}
+
+} // namespace Common
+} // namespace TissDB
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace TissDB {
+namespace Common {
+
+// Counters and histograms are split into this many cache-line sized shards;
+// each thread updates one, so recording does not contend across cores.
+constexpr size_t METRIC_SHARDS = 8;
+
+namespace detail {
+// The shard the calling thread records into.
+size_t metric_shard();
+} // namespace detail
+
+// A monotonically increasing count.
+class Counter {
+public:
+    void add(uint64_t n = 1) {
+        shards_[detail::metric_shard()].value.fetch_add(n, std::memory_order_relaxed);
+    }
+    uint64_t value() const;
+
+private:
+    struct alignas(64) Shard {
+        std::atomic<uint64_t> value{0};
+    };
+    std::array<Shard, METRIC_SHARDS> shards_;
+};
+
+// A latency distribution in nanoseconds, in HDR-style log-linear buckets:
+// each power of two is split into 8 sub-buckets, so any recorded value is
+// known to within 12.5%, from 1 ns up to about 4.9 hours.
+class Histogram {
+public:
+    static constexpr int SUB_BUCKET_BITS = 3;
+    static constexpr size_t SUB_BUCKETS = size_t(1) << SUB_BUCKET_BITS;
+    static constexpr int MAX_EXPONENT = 44;
+    static constexpr size_t BUCKETS = (MAX_EXPONENT - SUB_BUCKET_BITS + 2) * SUB_BUCKETS;
+
+    static size_t bucket_of(uint64_t ns);
+    // Smallest value that falls in `bucket`.
+    static uint64_t bucket_lower_bound(size_t bucket);
+
+    void record(uint64_t ns);
+    void record(std::chrono::steady_clock::duration elapsed) {
+        record(static_cast<uint64_t>(std::max<std::chrono::nanoseconds::rep>(
+            0, std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count())));
+    }
+
+    struct Snapshot {
+        std::vector<uint64_t> buckets; // BUCKETS counts
+        uint64_t count = 0;
+        uint64_t sum_ns = 0;
+
+        // The value below which a fraction `q` of the recorded values fall,
+        // as the upper bound of its bucket. 0 when nothing was recorded.
+        uint64_t quantile(double q) const;
+    };
+    Snapshot snapshot() const;
+
+private:
+    struct alignas(64) Shard {
+        std::atomic<uint64_t> sum_ns{0};
+        std::array<std::atomic<uint64_t>, BUCKETS> buckets{};
+    };
+    std::array<Shard, METRIC_SHARDS> shards_;
+};
+
+// Records the time from construction to destruction into a histogram.
+class ScopedTimer {
+public:
+    explicit ScopedTimer(Histogram& histogram)
+        : histogram_(histogram), start_(std::chrono::steady_clock::now()) {}
+    ~ScopedTimer() { histogram_.record(std::chrono::steady_clock::now() - start_); }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    Histogram& histogram_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+// Process-wide registry of named metrics, exported in the Prometheus text
+// format. Metrics are created on first use and live as long as the process,
+// so call sites look them up once and keep the reference:
+//
+//   static Common::Histogram& latency = Common::Metrics::instance().histogram(
+//       "tissdb_wal_append_seconds", "Time to append one WAL record.");
+//
+// `labels` is the Prometheus label set without braces, e.g. `stage="parse"`;
+// metrics sharing a name share their help text.
+class Metrics {
+public:
+    static Metrics& instance();
+
+    Metrics() = default;
+    Metrics(const Metrics&) = delete;
+    Metrics& operator=(const Metrics&) = delete;
+
+    Counter& counter(const std::string& name, const std::string& help, const std::string& labels = "");
+    Histogram& histogram(const std::string& name, const std::string& help, const std::string& labels = "");
+
+    // Appends the Prometheus exposition of every registered metric.
+    void export_prometheus(std::string& out) const;
+
+private:
+    struct Family {
+        std::string help;
+        bool is_histogram = false;
+        std::map<std::string, std::unique_ptr<Counter>> counters;     // By label set
+        std::map<std::string, std::unique_ptr<Histogram>> histograms; // By label set
+    };
+    Family& family(const std::string& name, const std::string& help, bool is_histogram);
+
+    mutable std::mutex mutex_;
+    std::map<std::string, Family> families_;
+};
+
+// Appends one gauge or counter sample, with its HELP and TYPE lines, for
+// values owned elsewhere (the memory governor, the audit log) that are read
+// at scrape time.
+void append_prometheus_sample(std::string& out, const std::string& name, const std::string& type,
+                              const std::string& help, double value);
+
+} // namespace Common
+} // namespace TissDB
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+namespace TissDB {
+namespace Common {
+
+// Token bucket limiting a byte rate. acquire() blocks until the requested
+// number of bytes may proceed. A rate of 0 disables limiting.
+class RateLimiter {
+public:
+    explicit RateLimiter(uint64_t bytes_per_second = 0)
+        : rate_(bytes_per_second),
+          available_(static_cast<double>(bytes_per_second)),
+          last_refill_(std::chrono::steady_clock::now()) {}
+
+    void set_rate(uint64_t bytes_per_second) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        rate_ = bytes_per_second;
+        available_ = std::min(available_, static_cast<double>(rate_));
+    }
+
+    uint64_t rate() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return rate_;
+    }
+
+    // Requests larger than one second's budget are let through once the
+    // bucket is full and leave it in debt, so they are paid for afterwards.
+    void acquire(uint64_t bytes) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (rate_ == 0) return;
+        for (;;) {
+            refill();
+            const double needed = std::min(static_cast<double>(bytes), static_cast<double>(rate_));
+            if (available_ >= needed) {
+                available_ -= static_cast<double>(bytes);
+                return;
+            }
+            const auto wait = std::chrono::duration<double>((needed - available_) / static_cast<double>(rate_));
+            lock.unlock();
+            std::this_thread::sleep_for(wait);
+            lock.lock();
+            if (rate_ == 0) return;
+        }
+    }
+
+private:
+    void refill() {
+        const auto now = std::chrono::steady_clock::now();
+        const double elapsed = std::chrono::duration<double>(now - last_refill_).count();
+        last_refill_ = now;
+        available_ = std::min(static_cast<double>(rate_), available_ + elapsed * static_cast<double>(rate_));
+    }
+
+    mutable std::mutex mutex_;
+    uint64_t rate_;
+    double available_;
+    std::chrono::steady_clock::time_point last_refill_;
+};
+
+} // namespace Common
+} // namespace TissDB
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+namespace TissDB {
+namespace Common {
+
+// Bounded lock-free queue for many producers and a single consumer.
+//
+// Each cell carries a sequence number telling whose turn it is: a producer
+// claims a position with one CAS on the head, fills the cell and publishes it
+// by advancing the cell's sequence; the consumer takes cells in position order
+// and hands them back to the producers one lap ahead. Producers never wait on
+// each other except to retry a lost CAS, and a full queue is reported instead
+// of waited on, so the caller chooses the overflow policy.
+template <typename T>
+class MpscRingBuffer {
+public:
+    // `capacity` is rounded up to a power of two.
+    explicit MpscRingBuffer(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) size <<= 1;
+        mask_ = size - 1;
+        cells_ = std::make_unique<Cell[]>(size);
+        for (size_t i = 0; i < size; ++i) {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MpscRingBuffer(const MpscRingBuffer&) = delete;
+    MpscRingBuffer& operator=(const MpscRingBuffer&) = delete;
+
+    // Enqueues `value`, leaving it untouched and returning false if the queue is full.
+    bool try_push(T&& value) {
+        size_t pos = head_.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            cell = &cells_[pos & mask_];
+            const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            const intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                return false; // The consumer has not freed this cell yet
+            } else {
+                pos = head_.load(std::memory_order_relaxed);
+            }
+        }
+        cell->value = std::move(value);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Dequeues the oldest value. Only one thread may call this.
+    bool try_pop(T& value) {
+        Cell& cell = cells_[tail_ & mask_];
+        if (cell.sequence.load(std::memory_order_acquire) != tail_ + 1) {
+            return false; // Empty, or the next producer has not finished writing
+        }
+        value = std::move(cell.value);
+        cell.sequence.store(tail_ + mask_ + 1, std::memory_order_release);
+        ++tail_;
+        return true;
+    }
+
+    size_t capacity() const { return mask_ + 1; }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence{0};
+        T value;
+    };
+
+    std::unique_ptr<Cell[]> cells_;
+    size_t mask_ = 0;
+    alignas(64) std::atomic<size_t> head_{0}; // Next position to claim
+    alignas(64) size_t tail_ = 0;             // Next position to consume
+};
+
+} // namespace Common
+} // namespace TissDB
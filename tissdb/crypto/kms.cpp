@@ -1,5 +1,7 @@
 #include "kms.h"
 #include <stdexcept>
+#include <cstdint>
+#include <numeric>
 
 // NOTE: The actual cryptographic functions are placeholders. A real implementation
 // would use a library like OpenSSL and would require proper error handling,
@@ -8,6 +10,33 @@
 namespace TissDB {
 namespace Crypto {
 
+namespace {
+// Mixed into a placeholder DEK so each name gets its own key. Names that were
+// issued keys before they differed by name keep the original key, so data
+// already encrypted under them still decrypts.
+uint64_t key_name_salt(const std::string& name) {
+    if (name == "default_collection" || name == "wal_key") return 0;
+    uint64_t hash = 14695981039346656037ULL; // FNV-1a
+    for (unsigned char c : name) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+} // anonymous namespace
+
+DekHandle::DekHandle(Key key) : key_(std::move(key)) {
+    if (key_.empty()) return;
+    // Placeholder: a real AEAD cipher would expand its round keys here. For the
+    // XOR cipher the "schedule" is the key repeated out to a whole number of
+    // 8-byte words, so the hot loop never has to wrap mid-word.
+    const size_t period = std::lcm(key_.size(), static_cast<size_t>(8));
+    schedule_.resize(period);
+    for (size_t i = 0; i < period; ++i) {
+        schedule_[i] = key_[i % key_.size()];
+    }
+}
+
 KeyManagementSystem::KeyManagementSystem(const Key& master_key) : master_encryption_key_(master_key) {
     if (master_key.empty()) {
         throw std::invalid_argument("Master key cannot be empty.");
@@ -19,35 +48,63 @@ KeyManagementSystem::~KeyManagementSystem() {
 }
 
 Key KeyManagementSystem::generate_new_dek(const std::string& collection_name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return generate_new_dek_locked(collection_name);
+}
+
+Key KeyManagementSystem::generate_new_dek_locked(const std::string& collection_name) {
     // 1. Generate a new random DEK.
-    // Placeholder: In a real system, use a cryptographically secure RNG.
+    // Placeholder: In a real system, use a cryptographically secure RNG. DEKs
+    // are not persisted yet, so the key must come out the same on every run:
+    // it is derived from the collection name, keeping collections' keys apart.
+    const uint64_t salt = key_name_salt(collection_name);
     Key dek(32, 0); // 32 bytes for AES-256
     for(size_t i = 0; i < dek.size(); ++i) {
-        dek[i] = static_cast<byte>(i); // Simple predictable key for now.
+        dek[i] = static_cast<byte>(i ^ (salt >> (8 * (i % 8)))); // Simple predictable key for now.
     }
 
     // 2. Encrypt the DEK with the master key.
     Buffer encrypted_dek = encrypt_dek(dek);
 
-    // 3. Store the encrypted DEK.
+    // 3. Store the encrypted DEK, dropping any handle derived from an older key.
     encrypted_deks_[collection_name] = encrypted_dek;
+    dek_handles_.erase(collection_name);
 
     return dek;
 }
 
 Key KeyManagementSystem::get_dek(const std::string& collection_name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return get_dek_locked(collection_name);
+}
+
+Key KeyManagementSystem::get_dek_locked(const std::string& collection_name) {
     auto it = encrypted_deks_.find(collection_name);
     if (it == encrypted_deks_.end()) {
         // If key doesn't exist, create one. This simplifies the storage engine logic.
-        return generate_new_dek(collection_name);
+        return generate_new_dek_locked(collection_name);
     }
 
     // Decrypt the stored DEK with the master key.
     return decrypt_dek(it->second);
 }
 
+DekHandlePtr KeyManagementSystem::get_dek_handle(const std::string& collection_name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = dek_handles_.find(collection_name);
+    if (it != dek_handles_.end()) {
+        return it->second;
+    }
+
+    DekHandlePtr handle(new DekHandle(get_dek_locked(collection_name)));
+    dek_handles_[collection_name] = handle;
+    return handle;
+}
+
 void KeyManagementSystem::delete_dek(const std::string& collection_name) {
+    std::lock_guard<std::mutex> lock(mutex_);
     encrypted_deks_.erase(collection_name);
+    dek_handles_.erase(collection_name);
 }
 
 Buffer KeyManagementSystem::encrypt(const Buffer& plaintext, const Key& dek) {
@@ -72,6 +129,57 @@ Buffer KeyManagementSystem::decrypt(const Buffer& ciphertext, const Key& dek) {
     return plaintext;
 }
 
+Buffer KeyManagementSystem::encrypt(const Buffer& plaintext, const DekHandle& dek) const {
+    Buffer ciphertext = plaintext;
+    apply_keystream(ciphertext.data(), ciphertext.size(), dek);
+    return ciphertext;
+}
+
+Buffer KeyManagementSystem::decrypt(const Buffer& ciphertext, const DekHandle& dek) const {
+    Buffer plaintext = ciphertext;
+    apply_keystream(plaintext.data(), plaintext.size(), dek);
+    return plaintext;
+}
+
+void KeyManagementSystem::apply_keystream(byte* data, size_t size, const DekHandle& dek, size_t stream_offset) {
+    if (dek.empty() || size == 0) return;
+
+    const byte* schedule = dek.schedule().data();
+    const size_t period = dek.schedule().size();
+    size_t pos = stream_offset % period;
+    size_t i = 0;
+
+    // Align to the start of the schedule so the main loop runs over whole periods.
+    while (i < size && pos != 0) {
+        data[i++] ^= schedule[pos++];
+        if (pos == period) pos = 0;
+    }
+
+    // Fixed-length, branch-free inner loop; compilers turn this into wide XORs.
+    while (size - i >= period) {
+        byte* block = data + i;
+        for (size_t j = 0; j < period; ++j) {
+            block[j] ^= schedule[j];
+        }
+        i += period;
+    }
+
+    for (size_t j = 0; i < size; ++i, ++j) {
+        data[i] ^= schedule[j];
+    }
+}
+
+void KeyManagementSystem::encrypt_batch(std::vector<Buffer>& records, const DekHandle& dek) {
+    for (auto& record : records) {
+        apply_keystream(record.data(), record.size(), dek);
+    }
+}
+
+void KeyManagementSystem::decrypt_batch(std::vector<Buffer>& records, const DekHandle& dek) {
+    // The placeholder cipher is symmetric.
+    encrypt_batch(records, dek);
+}
+
 
 // --- Private Helper Methods ---
 
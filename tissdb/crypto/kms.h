@@ -1,10 +1,12 @@
 #ifndef TISSDB_KMS_H
 #define TISSDB_KMS_H
 
+#include <cstddef>
 #include <string>
 #include <vector>
 #include <map>
 #include <memory>
+#include <mutex>
 
 // NOTE: This implementation will require a cryptographic library like OpenSSL.
 // The necessary headers (e.g., <openssl/evp.h>, <openssl/rand.h>) should be
@@ -18,6 +20,29 @@ using byte = unsigned char;
 using Buffer = std::vector<byte>;
 using Key = std::vector<byte>;
 
+// A resolved Data Encryption Key together with its expanded key schedule.
+// Handles are immutable once created, so the storage layer can resolve one
+// per collection (or per SSTable / WAL) and reuse it for every record without
+// going back through the KMS.
+class DekHandle {
+public:
+    const Key& key() const { return key_; }
+    bool empty() const { return key_.empty(); }
+
+    // The expanded keystream pattern. Its length is a multiple of 8 so the
+    // cipher loop can work on whole words and be auto-vectorized.
+    const Buffer& schedule() const { return schedule_; }
+
+private:
+    friend class KeyManagementSystem;
+    explicit DekHandle(Key key);
+
+    Key key_;
+    Buffer schedule_;
+};
+
+using DekHandlePtr = std::shared_ptr<const DekHandle>;
+
 class KeyManagementSystem {
 public:
     // The KMS would be initialized with a master key, perhaps from a secure vault or config file.
@@ -31,7 +56,13 @@ public:
     // Retrieves the plaintext DEK for a given collection.
     Key get_dek(const std::string& collection_name);
 
+    // Retrieves a cached handle to the DEK for a given collection. The DEK is
+    // decrypted and its key schedule derived only on the first call; later
+    // calls are a single map lookup. Creates the DEK if it does not exist.
+    DekHandlePtr get_dek_handle(const std::string& collection_name);
+
     // Securely deletes a DEK, part of cryptographic shredding.
+    // Outstanding handles keep working, but new lookups will not see the key.
     void delete_dek(const std::string& collection_name);
 
     // Placeholder for authenticated encryption (e.g., AES-256-GCM).
@@ -43,6 +74,21 @@ public:
     // Returns an empty buffer on failure (e.g., tag mismatch).
     Buffer decrypt(const Buffer& ciphertext, const Key& dek);
 
+    // Handle-based variants of encrypt/decrypt. They produce the same output as
+    // the Key overloads but skip the per-call key setup.
+    Buffer encrypt(const Buffer& plaintext, const DekHandle& dek) const;
+    Buffer decrypt(const Buffer& ciphertext, const DekHandle& dek) const;
+
+    // Runs the cipher in place over `size` bytes. `stream_offset` is the
+    // position of data[0] within the record, which lets a caller process a
+    // record in several pieces. The placeholder cipher is symmetric, so this
+    // is used for both encryption and decryption.
+    static void apply_keystream(byte* data, size_t size, const DekHandle& dek, size_t stream_offset = 0);
+
+    // Encrypts or decrypts a batch of independent records in place in one pass.
+    static void encrypt_batch(std::vector<Buffer>& records, const DekHandle& dek);
+    static void decrypt_batch(std::vector<Buffer>& records, const DekHandle& dek);
+
 private:
     Key master_encryption_key_;
 
@@ -50,6 +96,13 @@ private:
     // In a real system, this would be persisted securely.
     std::map<std::string, Buffer> encrypted_deks_;
 
+    // Plaintext handles derived from `encrypted_deks_`, keyed the same way.
+    std::map<std::string, DekHandlePtr> dek_handles_;
+    mutable std::mutex mutex_;
+
+    Key generate_new_dek_locked(const std::string& collection_name);
+    Key get_dek_locked(const std::string& collection_name);
+
     // Helper methods for cryptographic operations, which would wrap OpenSSL calls.
     Buffer encrypt_dek(const Key& dek);
     Key decrypt_dek(const Buffer& encrypted_dek);
@@ -3,6 +3,9 @@
 #include <cctype>
 #include <stdexcept>
 #include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
 
 namespace TissDB {
 namespace Json {
@@ -165,7 +168,19 @@ std::string JsonValue::serialize() const {
             } else if constexpr (std::is_same_v<T, bool>) {
                 ss << (arg ? "true" : "false");
             } else if constexpr (std::is_same_v<T, double>) {
-                ss << arg;
+                // Integral values (ids, sizes, timestamps) are written exactly;
+                // other values with enough digits to round-trip.
+                if (std::isfinite(arg) && std::trunc(arg) == arg && std::fabs(arg) < 9.007199254740992e15) {
+                    ss << static_cast<long long>(arg);
+                } else {
+                    std::ostringstream num;
+                    num << std::setprecision(15) << arg;
+                    if (std::strtod(num.str().c_str(), nullptr) != arg) {
+                        num.str("");
+                        num << std::setprecision(17) << arg;
+                    }
+                    ss << num.str();
+                }
             } else if constexpr (std::is_same_v<T, std::string>) {
                 // A proper implementation would handle escape characters.
                 ss << '"' << arg << '"';
@@ -1,5 +1,9 @@
 #include "storage/database_manager.h"
 #include "api/http_server.h"
+#include "common/memory_governor.h"
+#include "replication/follower.h"
+#include "common/log.h"
+#include "query/parallel.h"
 #include <iostream>
 #include <string>
 #include <thread>
@@ -7,10 +11,13 @@
 #include <stdexcept>
 #include <csignal>
 #include <atomic>
+#include <memory>
 
 // --- Configuration ---
 const int DEFAULT_PORT = 9876;
 const std::string DEFAULT_DATA_DIR = "tissdb_data";
+const std::string DEFAULT_BACKUP_DIR = "tissdb_backups";
+const uint64_t DEFAULT_MEMORY_BUDGET_MB = 1024;
 
 // Global flag for signal handling
 std::atomic<bool> shutdown_requested(false);
@@ -26,6 +33,13 @@ void print_usage(const char* prog_name) {
               << "  -h, --help           Show this help message and exit\n"
               << "  --port <port>        Specify the port to listen on (default: " << DEFAULT_PORT << ")\n"
               << "  --data-dir <path>    Specify the data directory (default: " << DEFAULT_DATA_DIR << ")\n"
+              << "  --backup-dir <path>  Directory online backups are written into (default: " << DEFAULT_BACKUP_DIR << ")\n"
+              << "  --memory-budget-mb <n>  Memory budget for all databases, 0 for none (default: " << DEFAULT_MEMORY_BUDGET_MB << ")\n"
+              << "  --follow <host:port> Run as a read-only replica of the leader at host:port\n"
+              << "  --leader-token <t>   Bearer token for the leader's API (with --follow)\n"
+              << "  --replica-id <id>    Name the leader keeps changes for (default: replica-<port>)\n"
+              << "  --log-level <level>  debug, info, warning or error (default: info, or $TISSDB_LOG_LEVEL)\n"
+              << "  --query-threads <n>  Most threads one query may use, 0 for every core (default: 0)\n"
               << std::endl;
 }
 
@@ -33,6 +47,12 @@ int main(int argc, char* argv[]) {
     // --- Argument Parsing ---
     int port = DEFAULT_PORT;
     std::string data_dir = DEFAULT_DATA_DIR;
+    std::string backup_dir = DEFAULT_BACKUP_DIR;
+    uint64_t memory_budget_mb = DEFAULT_MEMORY_BUDGET_MB;
+    size_t query_threads = 0;
+    std::string follow;
+    std::string leader_token;
+    std::string replica_id;
 
     for (int i = 1; i < argc; ++i) {
         std::string arg = argv[i];
@@ -61,6 +81,52 @@ int main(int argc, char* argv[]) {
                 std::cerr << "Error: --data-dir option requires an argument." << std::endl;
                 return 1;
             }
+        } else if (arg == "--backup-dir") {
+            if (i + 1 < argc) {
+                backup_dir = argv[++i];
+            } else {
+                std::cerr << "Error: --backup-dir option requires an argument." << std::endl;
+                return 1;
+            }
+        } else if (arg == "--memory-budget-mb") {
+            if (i + 1 < argc) {
+                try {
+                    memory_budget_mb = std::stoull(argv[++i]);
+                } catch (const std::exception& e) {
+                    std::cerr << "Error: Invalid memory budget '" << argv[i] << "'." << std::endl;
+                    return 1;
+                }
+            } else {
+                std::cerr << "Error: --memory-budget-mb option requires an argument." << std::endl;
+                return 1;
+            }
+        } else if (arg == "--query-threads") {
+            if (i + 1 < argc) {
+                try {
+                    query_threads = std::stoul(argv[++i]);
+                } catch (const std::exception& e) {
+                    std::cerr << "Error: Invalid thread count '" << argv[i] << "'." << std::endl;
+                    return 1;
+                }
+            } else {
+                std::cerr << "Error: --query-threads option requires an argument." << std::endl;
+                return 1;
+            }
+        } else if (arg == "--log-level") {
+            LogLevel level;
+            if (i + 1 >= argc || !TissDB::Log::parse_level(argv[i + 1], level)) {
+                std::cerr << "Error: --log-level option requires one of debug, info, warning or error." << std::endl;
+                return 1;
+            }
+            TissDB::Log::set_level(level);
+            ++i;
+        } else if (arg == "--follow" || arg == "--leader-token" || arg == "--replica-id") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: " << arg << " option requires an argument." << std::endl;
+                return 1;
+            }
+            std::string& target = arg == "--follow" ? follow : arg == "--leader-token" ? leader_token : replica_id;
+            target = argv[++i];
         } else {
             std::cerr << "Error: Unknown option '" << arg << "'." << std::endl;
             print_usage(argv[0]);
@@ -72,31 +138,64 @@ int main(int argc, char* argv[]) {
     try {
         std::cout << "TissDB starting..." << std::endl;
 
+        TissDB::Common::MemoryGovernor::instance().set_budget(memory_budget_mb * 1024 * 1024);
+        std::cout << "  - Memory budget: " << memory_budget_mb << " MiB" << std::endl;
+        TissDB::Query::set_max_query_parallelism(query_threads);
+        std::cout << "  - Threads per query: " << TissDB::Query::max_query_parallelism() << std::endl;
+
         // 1. Initialize the database manager
         TissDB::Storage::DatabaseManager db_manager(data_dir);
         std::cout << "  - Data directory: " << data_dir << std::endl;
 
-        // 2. Initialize the API server
+        // 2. In replica mode, start following the leader
+        std::unique_ptr<TissDB::Replication::Follower> follower;
+        if (!follow.empty()) {
+            TissDB::Replication::FollowerOptions follower_options;
+            auto colon = follow.rfind(':');
+            try {
+                follower_options.leader_host = follow.substr(0, colon);
+                follower_options.leader_port = colon == std::string::npos ? DEFAULT_PORT : std::stoi(follow.substr(colon + 1));
+            } catch (const std::exception& e) {
+                std::cerr << "Error: Invalid leader address '" << follow << "'." << std::endl;
+                return 1;
+            }
+            follower_options.token = leader_token;
+            follower_options.replica_id = replica_id.empty() ? "replica-" + std::to_string(port) : replica_id;
+            follower = std::make_unique<TissDB::Replication::Follower>(db_manager, follower_options);
+            follower->start();
+            std::cout << "  - Replica of: " << follower->leader_endpoint() << std::endl;
+        }
+
+        // 3. Initialize the API server
         TissDB::API::HttpServer server(db_manager, port);
+        server.set_backup_root(backup_dir);
+        std::cout << "  - Backup directory: " << backup_dir << std::endl;
+        if (follower) {
+            server.set_replica(follower.get());
+        }
         std::cout << "  - Listening on port: " << port << std::endl;
 
-        // 3. Start the server (this will start a background thread)
+        // 4. Start the server (this will start a background thread)
         server.start();
         std::cout << "Server has started successfully." << std::endl;
 
-        // 4. Register signal handlers for graceful shutdown
+        // 5. Register signal handlers for graceful shutdown
         signal(SIGINT, signal_handler);
         signal(SIGTERM, signal_handler);
         std::cout << "Press Ctrl+C to exit." << std::endl;
 
-        // 5. Wait for shutdown signal
+        // 6. Wait for shutdown signal
         while (!shutdown_requested) {
             std::this_thread::sleep_for(std::chrono::milliseconds(100));
         }
 
-        // 6. Perform graceful shutdown
+        // 7. Perform graceful shutdown
         std::cout << "Stopping server..." << std::endl;
         server.stop();
+        if (follower) {
+            std::cout << "Stopping replication..." << std::endl;
+            follower->stop();
+        }
         std::cout << "Shutting down database manager..." << std::endl;
         db_manager.shutdown();
         std::cout << "Shutdown complete." << std::endl;
@@ -71,7 +71,8 @@ enum class AggregateType {
     AVG,
     SUM,
     MIN,
-    MAX
+    MAX,
+    STDDEV
 };
 
 // Represents an aggregate function call
@@ -179,9 +180,20 @@ struct CreateTableStatement {
     std::vector<Constraint> constraints;
 };
 
+// Represents a TissQL ANALYZE statement, which rebuilds a collection's planner statistics.
+struct AnalyzeStatement {
+    std::string collection_name;
+};
+
+// Represents EXPLAIN [ANALYZE] SELECT ...: the plan of the SELECT and, with
+// ANALYZE, what running it did.
+struct ExplainStatement {
+    bool analyze = false;
+    SelectStatement select;
+};
 
 // The Abstract Syntax Tree (AST) for a query.
-using AST = std::variant<SelectStatement, UpdateStatement, DeleteStatement, InsertStatement, CreateTableStatement>;
+using AST = std::variant<SelectStatement, UpdateStatement, DeleteStatement, InsertStatement, CreateTableStatement, AnalyzeStatement, ExplainStatement>;
 
 } // namespace Query
 } // namespace TissDB
@@ -0,0 +1,329 @@
+#include "column_batch.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <numeric>
+
+namespace TissDB {
+namespace Query {
+
+namespace {
+
+ColumnVector::Type type_of(const Value& value) {
+    if (std::holds_alternative<double>(value)) return ColumnVector::Type::Number;
+    if (std::holds_alternative<std::string>(value)) return ColumnVector::Type::String;
+    if (std::holds_alternative<bool>(value)) return ColumnVector::Type::Boolean;
+    if (std::holds_alternative<Timestamp>(value)) return ColumnVector::Type::Timestamp;
+    return ColumnVector::Type::Mixed;
+}
+
+// Shared by decode_column and gather_column; `doc_at(i)` is the i-th row.
+template <typename DocAt>
+void decode(ColumnVector& column, const std::string& field, size_t count, DocAt doc_at) {
+    column.size = count;
+    column.numbers.clear();
+    column.strings.clear();
+    column.booleans.clear();
+    column.timestamps.clear();
+    column.values.clear();
+    column.present.clear();
+
+    if (field == "id" || field == "_id") {
+        column.type = ColumnVector::Type::String;
+        column.all_present = true;
+        column.strings.resize(count);
+        for (size_t i = 0; i < count; ++i) column.strings[i] = doc_at(i).id;
+        return;
+    }
+
+    column.values.resize(count);
+    column.present.assign((count + 63) / 64, 0);
+    size_t present_rows = 0;
+    ColumnVector::Type type = ColumnVector::Type::Missing;
+    for (size_t i = 0; i < count; ++i) {
+        const Value* value = nullptr;
+        for (const auto& elem : doc_at(i).elements) {
+            if (elem.key == field) {
+                value = &elem.value;
+                break;
+            }
+        }
+        column.values[i] = value;
+        if (!value) continue;
+        column.present[i >> 6] |= uint64_t(1) << (i & 63);
+        ++present_rows;
+        const ColumnVector::Type row_type = type_of(*value);
+        if (type == ColumnVector::Type::Missing) {
+            type = row_type;
+        } else if (type != row_type) {
+            type = ColumnVector::Type::Mixed;
+        }
+    }
+    column.type = type;
+    column.all_present = present_rows == count;
+
+    switch (type) {
+        case ColumnVector::Type::Number:
+            column.numbers.resize(count);
+            for (size_t i = 0; i < count; ++i) {
+                if (column.values[i]) column.numbers[i] = std::get<double>(*column.values[i]);
+            }
+            break;
+        case ColumnVector::Type::String:
+            column.strings.resize(count);
+            for (size_t i = 0; i < count; ++i) {
+                if (column.values[i]) column.strings[i] = std::get<std::string>(*column.values[i]);
+            }
+            break;
+        case ColumnVector::Type::Boolean:
+            column.booleans.resize(count);
+            for (size_t i = 0; i < count; ++i) {
+                if (column.values[i]) column.booleans[i] = std::get<bool>(*column.values[i]);
+            }
+            break;
+        case ColumnVector::Type::Timestamp:
+            column.timestamps.resize(count);
+            for (size_t i = 0; i < count; ++i) {
+                if (column.values[i]) {
+                    column.timestamps[i] = std::get<Timestamp>(*column.values[i]).microseconds_since_epoch_utc;
+                }
+            }
+            break;
+        case ColumnVector::Type::Missing:
+        case ColumnVector::Type::Mixed:
+            break;
+    }
+}
+
+// Where a row's value on a key ranks among the kinds of value: a missing one
+// sorts lowest, then numbers, timestamps and strings; the rest, which are
+// not ordered among themselves, come last.
+uint8_t key_rank(const ColumnVector& key, uint32_t row) {
+    if (!key.is_present(row)) return 0;
+    ColumnVector::Type type = key.type;
+    if (type == ColumnVector::Type::Mixed) type = type_of(*key.values[row]);
+    switch (type) {
+        case ColumnVector::Type::Number: return 1;
+        case ColumnVector::Type::Timestamp: return 2;
+        case ColumnVector::Type::String: return 3;
+        default: return 4;
+    }
+}
+
+template <typename T>
+int three_way(const T& a, const T& b) {
+    return a < b ? -1 : (b < a ? 1 : 0);
+}
+
+// Compares rows `a` and `b` on one key: negative, zero or positive.
+int compare_key(const ColumnVector& key, uint32_t a, uint32_t b) {
+    const uint8_t rank = key_rank(key, a);
+    if (const int cmp = three_way(rank, key_rank(key, b)); cmp != 0) return cmp;
+    if (key.type == ColumnVector::Type::Mixed) {
+        switch (rank) {
+            case 1: return three_way(std::get<double>(*key.values[a]), std::get<double>(*key.values[b]));
+            case 2: return three_way(std::get<Timestamp>(*key.values[a]).microseconds_since_epoch_utc,
+                                     std::get<Timestamp>(*key.values[b]).microseconds_since_epoch_utc);
+            case 3: return std::get<std::string>(*key.values[a]).compare(std::get<std::string>(*key.values[b]));
+            default: return 0;
+        }
+    }
+    switch (rank) {
+        case 1: return three_way(key.numbers[a], key.numbers[b]);
+        case 2: return three_way(key.timestamps[a], key.timestamps[b]);
+        case 3: return key.strings[a].compare(key.strings[b]);
+        default: return 0;
+    }
+}
+
+// The ORDER BY keys of rows[begin, end), decoded once up front rather than
+// looked up per comparison. Key rows are positions relative to `begin`.
+struct SortKeys {
+    std::vector<ColumnVector> columns;
+    std::vector<bool> ascending;
+
+    template <typename DocAt>
+    SortKeys(const std::vector<uint32_t>& rows, size_t begin, size_t end,
+             const std::vector<std::pair<std::string, std::string>>& order_by, DocAt doc_at)
+        : columns(order_by.size()), ascending(order_by.size()) {
+        for (size_t k = 0; k < order_by.size(); ++k) {
+            decode(columns[k], order_by[k].first, end - begin,
+                   [&](size_t i) -> const Document& { return doc_at(rows[begin + i]); });
+            ascending[k] = order_by[k].second != "DESC";
+        }
+    }
+
+    // Ties keep their order in `rows`.
+    bool less(uint32_t a, uint32_t b) const {
+        for (size_t k = 0; k < columns.size(); ++k) {
+            const int cmp = compare_key(columns[k], a, b);
+            if (cmp != 0) return ascending[k] ? cmp < 0 : cmp > 0;
+        }
+        return a < b;
+    }
+};
+
+// Memcomparable keys: the ORDER BY order of rows is the byte order of their
+// encoded keys, so rows from separately decoded runs can be compared. Each
+// key is its rank (see key_rank) followed by the value.
+
+void append_bytes(std::string& out, uint64_t bits, bool ascending) {
+    if (!ascending) bits = ~bits;
+    for (int shift = 56; shift >= 0; shift -= 8) out.push_back(static_cast<char>(bits >> shift));
+}
+
+void append_number_key(std::string& out, double value, bool ascending) {
+    if (value == 0) value = 0; // -0 equals 0
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    // Negative numbers order in reverse of their bits; positive ones after them.
+    bits = (bits >> 63) ? ~bits : bits | (uint64_t(1) << 63);
+    append_bytes(out, bits, ascending);
+}
+
+void append_timestamp_key(std::string& out, int64_t value, bool ascending) {
+    append_bytes(out, static_cast<uint64_t>(value) ^ (uint64_t(1) << 63), ascending);
+}
+
+// NUL bytes are escaped and the end is marked with two NULs, so a string
+// sorts before any longer one it prefixes.
+void append_string_key(std::string& out, std::string_view value, bool ascending) {
+    const char flip = ascending ? 0 : static_cast<char>(0xFF);
+    for (char c : value) {
+        out.push_back(c ^ flip);
+        if (c == 0) out.push_back(static_cast<char>(0xFF) ^ flip);
+    }
+    out.push_back(flip);
+    out.push_back(flip);
+}
+
+void append_key(std::string& out, const ColumnVector& column, uint32_t row, bool ascending) {
+    const uint8_t rank = key_rank(column, row);
+    out.push_back(static_cast<char>(ascending ? rank : ~rank));
+    const Value* value = column.type == ColumnVector::Type::Mixed ? column.values[row] : nullptr;
+    switch (rank) {
+        case 1:
+            append_number_key(out, value ? std::get<double>(*value) : column.numbers[row], ascending);
+            break;
+        case 2:
+            append_timestamp_key(out, value ? std::get<Timestamp>(*value).microseconds_since_epoch_utc
+                                            : column.timestamps[row], ascending);
+            break;
+        case 3:
+            append_string_key(out, value ? std::string_view(std::get<std::string>(*value)) : column.strings[row],
+                              ascending);
+            break;
+        default:
+            break;
+    }
+}
+
+// A row's encoded key and its position in `rows`, which breaks ties.
+using KeyedRow = std::pair<std::string, uint32_t>;
+
+// The first `limit` rows of rows[begin, end) in ORDER BY order, found with a
+// bounded max-heap; each row's key is encoded once, and only the rows that
+// make the cut are kept.
+template <typename DocAt>
+std::vector<KeyedRow> top_of_run(const std::vector<uint32_t>& rows, size_t begin, size_t end, size_t limit,
+                                 const std::vector<std::pair<std::string, std::string>>& order_by,
+                                 DocAt doc_at) {
+    const SortKeys keys(rows, begin, end, order_by, doc_at);
+    std::vector<KeyedRow> top;
+    std::string key;
+    for (uint32_t i = 0; i < end - begin; ++i) {
+        key.clear();
+        for (size_t k = 0; k < keys.columns.size(); ++k) {
+            append_key(key, keys.columns[k], i, keys.ascending[k]);
+        }
+        const uint32_t position = static_cast<uint32_t>(begin + i);
+        if (top.size() < limit) {
+            top.emplace_back(key, position);
+            std::push_heap(top.begin(), top.end());
+        } else if (key < top.front().first) {
+            // Positions only grow, so an equal key never displaces the top.
+            std::pop_heap(top.begin(), top.end());
+            top.back().first.swap(key);
+            top.back().second = position;
+            std::push_heap(top.begin(), top.end());
+        }
+    }
+    return top;
+}
+
+// Keeps the top `limit` rows, splitting them across up to `parallelism`
+// threads when there are enough of them and merging the threads' heaps.
+template <typename DocAt>
+void top_rows(std::vector<uint32_t>& rows, const std::vector<std::pair<std::string, std::string>>& order_by,
+              size_t limit, size_t parallelism, DocAt doc_at) {
+    const size_t tasks = parallel_task_count(rows.size(), parallelism);
+    const size_t per_task = (rows.size() + tasks - 1) / tasks;
+    std::vector<std::vector<KeyedRow>> runs(tasks);
+    run_morsels(tasks, tasks, [&](size_t, size_t t) {
+        const size_t begin = t * per_task, end = std::min(rows.size(), begin + per_task);
+        runs[t] = top_of_run(rows, begin, end, limit, order_by, doc_at);
+    });
+
+    std::vector<KeyedRow> candidates = std::move(runs[0]);
+    for (size_t t = 1; t < tasks; ++t) {
+        std::move(runs[t].begin(), runs[t].end(), std::back_inserter(candidates));
+    }
+    const size_t kept = std::min(limit, candidates.size());
+    std::partial_sort(candidates.begin(), candidates.begin() + kept, candidates.end());
+    std::vector<uint32_t> top(kept);
+    for (size_t i = 0; i < kept; ++i) top[i] = rows[candidates[i].second];
+    rows = std::move(top);
+}
+
+// Shared by both sort_rows; `doc_at(row)` is the document at a row.
+template <typename DocAt>
+void sort_by_keys(std::vector<uint32_t>& rows, const std::vector<std::pair<std::string, std::string>>& order_by,
+                  size_t limit, size_t parallelism, DocAt doc_at) {
+    if (order_by.empty() || limit == 0) {
+        if (limit < rows.size()) rows.resize(limit);
+        return;
+    }
+    if (limit < rows.size()) {
+        top_rows(rows, order_by, limit, parallelism, doc_at);
+        return;
+    }
+    if (rows.size() < 2) return;
+
+    const SortKeys keys(rows, 0, rows.size(), order_by, doc_at);
+    std::vector<uint32_t> positions(rows.size());
+    std::iota(positions.begin(), positions.end(), 0);
+    std::sort(positions.begin(), positions.end(), [&](uint32_t a, uint32_t b) { return keys.less(a, b); });
+
+    std::vector<uint32_t> sorted(rows.size());
+    for (size_t i = 0; i < rows.size(); ++i) sorted[i] = rows[positions[i]];
+    rows = std::move(sorted);
+}
+
+} // anonymous namespace
+
+void decode_column(ColumnVector& column, const std::string& field, const DocumentRows& docs,
+                   size_t begin, size_t count) {
+    decode(column, field, count, [&](size_t i) -> const Document& { return *docs[begin + i]; });
+}
+
+void gather_column(ColumnVector& column, const std::string& field, const DocumentRows& docs,
+                   const std::vector<uint32_t>& rows) {
+    decode(column, field, rows.size(), [&](size_t i) -> const Document& { return *docs[rows[i]]; });
+}
+
+void sort_rows(const DocumentRows& docs, std::vector<uint32_t>& rows,
+               const std::vector<std::pair<std::string, std::string>>& order_by, size_t limit,
+               size_t parallelism) {
+    sort_by_keys(rows, order_by, limit, parallelism, [&](uint32_t row) -> const Document& { return *docs[row]; });
+}
+
+void sort_rows(const std::vector<Document>& docs, std::vector<uint32_t>& rows,
+               const std::vector<std::pair<std::string, std::string>>& order_by, size_t limit,
+               size_t parallelism) {
+    sort_by_keys(rows, order_by, limit, parallelism, [&](uint32_t row) -> const Document& { return docs[row]; });
+}
+
+} // namespace Query
+} // namespace TissDB
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "../common/document.h"
+
+namespace TissDB {
+namespace Query {
+
+// Documents are decoded and filtered this many at a time: enough to amortize
+// the per-batch work, few enough that a batch's columns stay in cache.
+constexpr size_t BATCH_ROWS = 2048;
+
+// The rows of a batch still in play, as ascending positions within it.
+using SelectionVector = std::vector<uint32_t>;
+
+// The documents a vectorized query runs over, owned elsewhere: by a shared
+// collection scan, or by the caller that read them through an index.
+using DocumentRows = std::vector<const Document*>;
+
+// One field of a run of documents, decoded into a typed vector. When every
+// document that has the field holds the same kind of value, the column is
+// typed and only the matching vector is filled; otherwise it is Mixed and
+// only `values` is. A row without the field is absent from `present`.
+struct ColumnVector {
+    enum class Type { Missing, Number, String, Boolean, Timestamp, Mixed };
+
+    Type type = Type::Missing;
+    size_t size = 0;
+    std::vector<double> numbers;
+    // Views of whole strings owned by the documents, so each is NUL-terminated.
+    std::vector<std::string_view> strings;
+    std::vector<uint8_t> booleans;
+    std::vector<int64_t> timestamps;
+    // Each row's value, null where it is missing. Left empty for the
+    // document id, which is always a present string.
+    std::vector<const Value*> values;
+    // One bit per row; not filled when every row has the field.
+    std::vector<uint64_t> present;
+    bool all_present = false;
+
+    bool is_present(size_t row) const {
+        return all_present || ((present[row >> 6] >> (row & 63)) & 1);
+    }
+};
+
+// Decodes `field` of docs[begin, begin + count).
+void decode_column(ColumnVector& column, const std::string& field, const DocumentRows& docs,
+                   size_t begin, size_t count);
+
+// Decodes `field` of the documents at `rows`, in that order.
+void gather_column(ColumnVector& column, const std::string& field, const DocumentRows& docs,
+                   const std::vector<uint32_t>& rows);
+
+// Reorders `rows`, positions in `docs`, by an ORDER BY clause, and keeps
+// the first `limit` of them. A row lacking a field sorts before every row
+// that has it; values of different types order numbers first, then
+// timestamps, strings and the rest, which compare equal among themselves.
+// Rows that compare equal keep their order.
+//
+// With a limit below the row count, only the top rows are sorted: each row's
+// sort key is encoded once into bytes that compare in ORDER BY order, and a
+// heap of `limit` rows keeps the smallest. Large inputs are split across up
+// to `parallelism` query threads (see parallel_task_count), each keeping its
+// own heap, and the heaps are then merged.
+void sort_rows(const DocumentRows& docs, std::vector<uint32_t>& rows,
+               const std::vector<std::pair<std::string, std::string>>& order_by,
+               size_t limit = SIZE_MAX, size_t parallelism = 0);
+void sort_rows(const std::vector<Document>& docs, std::vector<uint32_t>& rows,
+               const std::vector<std::pair<std::string, std::string>>& order_by,
+               size_t limit = SIZE_MAX, size_t parallelism = 0);
+
+} // namespace Query
+} // namespace TissDB
@@ -0,0 +1,595 @@
+#include "compiled_expression.h"
+#include "executor_common.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+
+namespace TissDB {
+namespace Query {
+
+namespace {
+
+const Value null_value{nullptr};
+const Document empty_document{};
+
+int64_t interval_to_microseconds(const IntervalLiteral& interval) {
+    std::string unit = interval.unit;
+    std::transform(unit.begin(), unit.end(), unit.begin(), ::tolower);
+    if (unit == "microsecond" || unit == "microseconds") return static_cast<int64_t>(interval.value);
+    if (unit == "millisecond" || unit == "milliseconds") return static_cast<int64_t>(interval.value * 1000.0);
+    if (unit == "second" || unit == "seconds") return static_cast<int64_t>(interval.value * 1000000.0);
+    if (unit == "minute" || unit == "minutes") return static_cast<int64_t>(interval.value * 60.0 * 1000000.0);
+    if (unit == "hour" || unit == "hours") return static_cast<int64_t>(interval.value * 3600.0 * 1000000.0);
+    if (unit == "day" || unit == "days") return static_cast<int64_t>(interval.value * 86400.0 * 1000000.0);
+    return static_cast<int64_t>(interval.value * 1000000.0);
+}
+
+Timestamp now_timestamp() {
+    auto now = std::chrono::system_clock::now();
+    auto micros = std::chrono::duration_cast<std::chrono::microseconds>(now.time_since_epoch()).count();
+    return Timestamp{micros};
+}
+
+std::tm timestamp_to_tm(const Timestamp& ts) {
+    std::time_t tt = static_cast<std::time_t>(ts.microseconds_since_epoch_utc / 1000000);
+    std::tm tm{};
+#ifdef _WIN32
+    gmtime_s(&tm, &tt);
+#else
+    gmtime_r(&tt, &tm);
+#endif
+    return tm;
+}
+
+Date timestamp_to_date(const Timestamp& ts) {
+    const std::tm tm = timestamp_to_tm(ts);
+    return Date{static_cast<uint16_t>(tm.tm_year + 1900), static_cast<uint8_t>(tm.tm_mon + 1), static_cast<uint8_t>(tm.tm_mday)};
+}
+
+Time timestamp_to_time(const Timestamp& ts) {
+    const std::tm tm = timestamp_to_tm(ts);
+    return Time{static_cast<uint8_t>(tm.tm_hour), static_cast<uint8_t>(tm.tm_min), static_cast<uint8_t>(tm.tm_sec)};
+}
+
+double extract_part_from_timestamp(const std::string& part, const Timestamp& ts) {
+    const std::tm tm = timestamp_to_tm(ts);
+    if (part == "year") return tm.tm_year + 1900;
+    if (part == "month") return tm.tm_mon + 1;
+    if (part == "day") return tm.tm_mday;
+    if (part == "hour") return tm.tm_hour;
+    if (part == "minute") return tm.tm_min;
+    if (part == "second") return tm.tm_sec;
+    return 0.0;
+}
+
+Value literal_to_value(const Literal& literal) {
+    return std::visit([](const auto& v) -> Value {
+        using T = std::decay_t<decltype(v)>;
+        if constexpr (std::is_same_v<T, Null>) {
+            return nullptr;
+        } else {
+            return Value(std::in_place_type<T>, v);
+        }
+    }, literal);
+}
+
+// The numeric and the text reading of a value that comparisons fall back
+// to, as get_as_numeric and get_as_string give them, but without copying
+// strings. `buffer` holds the text when it has to be formatted.
+bool as_number(const Value& value, double& number) {
+    if (const auto* num_val = std::get_if<double>(&value)) {
+        number = *num_val;
+        return true;
+    }
+    if (const auto* str_val = std::get_if<std::string>(&value)) {
+        return parse_number(str_val->c_str(), number);
+    }
+    return false;
+}
+
+bool as_text(const Value& value, std::string_view& text, std::string& buffer) {
+    if (const auto* str_val = std::get_if<std::string>(&value)) {
+        text = *str_val;
+    } else if (const auto* num_val = std::get_if<double>(&value)) {
+        buffer = std::to_string(*num_val);
+        text = buffer;
+    } else if (const auto* bool_val = std::get_if<bool>(&value)) {
+        text = *bool_val ? "true" : "false";
+    } else if (std::holds_alternative<std::nullptr_t>(value)) {
+        text = "null";
+    } else if (const auto* ts_val = std::get_if<Timestamp>(&value)) {
+        buffer = std::to_string(ts_val->microseconds_since_epoch_utc);
+        text = buffer;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool is_ordering(CompareOp op) {
+    return op != CompareOp::Like && op != CompareOp::Other;
+}
+
+template <typename T>
+bool compare_direct(CompareOp op, const T& a, const T& b) {
+    switch (op) {
+        case CompareOp::Equal: return a == b;
+        case CompareOp::NotEqual: return a != b;
+        case CompareOp::Less: return a < b;
+        case CompareOp::Greater: return a > b;
+        case CompareOp::LessEqual: return a <= b;
+        case CompareOp::GreaterEqual: return a >= b;
+        default: return false;
+    }
+}
+
+// For types that only define == and <.
+template <typename T>
+bool compare_ordered(CompareOp op, const T& a, const T& b) {
+    switch (op) {
+        case CompareOp::Equal: return a == b;
+        case CompareOp::NotEqual: return !(a == b);
+        case CompareOp::Less: return a < b;
+        case CompareOp::Greater: return b < a;
+        case CompareOp::LessEqual: return !(b < a);
+        case CompareOp::GreaterEqual: return !(a < b);
+        default: return false;
+    }
+}
+
+// `pattern` is used for LIKE when `constant_pattern` is set; otherwise the
+// right operand is turned into a regex here.
+bool compare_values(CompareOp op, const Value& left, const Value& right,
+                    bool constant_pattern, const std::regex* pattern) {
+    if (const auto* left_date = std::get_if<Date>(&left)) {
+        if (const auto* right_date = std::get_if<Date>(&right)) return compare_ordered(op, *left_date, *right_date);
+    }
+    if (const auto* left_time = std::get_if<Time>(&left)) {
+        if (const auto* right_time = std::get_if<Time>(&right)) return compare_ordered(op, *left_time, *right_time);
+    }
+    if (const auto* left_dt = std::get_if<DateTime>(&left)) {
+        if (const auto* right_dt = std::get_if<DateTime>(&right)) return compare_direct(op, *left_dt, *right_dt);
+    }
+    if (const auto* left_ts = std::get_if<Timestamp>(&left)) {
+        if (const auto* right_ts = std::get_if<Timestamp>(&right)) return compare_direct(op, *left_ts, *right_ts);
+    }
+
+    double left_num, right_num;
+    if (is_ordering(op) && as_number(left, left_num) && as_number(right, right_num)) {
+        return compare_direct(op, left_num, right_num);
+    }
+
+    std::string left_buffer, right_buffer;
+    std::string_view left_str, right_str;
+    if (!as_text(left, left_str, left_buffer) || !as_text(right, right_str, right_buffer)) return false;
+    if (is_ordering(op)) return compare_direct(op, left_str, right_str);
+    if (op != CompareOp::Like) return false;
+    if (constant_pattern) {
+        return pattern && std::regex_match(left_str.begin(), left_str.end(), *pattern);
+    }
+    try {
+        std::regex re(like_to_regex(std::string(right_str)));
+        return std::regex_match(left_str.begin(), left_str.end(), re);
+    } catch (const std::regex_error&) {
+        return false;
+    }
+}
+
+} // anonymous namespace
+
+CompareOp parse_compare_op(const std::string& op) {
+    if (op == "=") return CompareOp::Equal;
+    if (op == "!=") return CompareOp::NotEqual;
+    if (op == "<") return CompareOp::Less;
+    if (op == ">") return CompareOp::Greater;
+    if (op == "<=") return CompareOp::LessEqual;
+    if (op == ">=") return CompareOp::GreaterEqual;
+    if (op == "LIKE") return CompareOp::Like;
+    return CompareOp::Other;
+}
+
+// Scratch space of one evaluation: a value for each node that computes one,
+// and the fields looked up so far. Entries of the field cache are valid only
+// if their stamp is the current evaluation's.
+struct CompiledExpression::Frame {
+    std::vector<Value> scratch;
+    std::vector<const Value*> fields;
+    std::vector<uint64_t> field_stamps;
+    uint64_t stamp = 0;
+};
+
+CompiledExpression CompiledExpression::predicate(const Expression& expr, const std::vector<Literal>& params) {
+    CompiledExpression compiled;
+    compiled.root_ = compiled.compile_condition(expr, params);
+    return compiled;
+}
+
+CompiledExpression CompiledExpression::value(const Expression& expr, const std::vector<Literal>& params) {
+    CompiledExpression compiled;
+    compiled.root_ = compiled.compile_value(expr, params);
+    return compiled;
+}
+
+bool CompiledExpression::matches(const Document& doc) const {
+    return test(root_, doc, frame());
+}
+
+Value CompiledExpression::evaluate(const Document& doc) const {
+    return resolve(root_, doc, frame());
+}
+
+bool CompiledExpression::is_constant() const {
+    return is_constant_node(root_) || nodes_[root_].kind == Kind::Bool;
+}
+
+uint32_t CompiledExpression::add(Node node) {
+    nodes_.push_back(std::move(node));
+    return static_cast<uint32_t>(nodes_.size() - 1);
+}
+
+uint32_t CompiledExpression::add_error(const std::string& message) {
+    Node node{Kind::Error};
+    node.text = message;
+    return add(std::move(node));
+}
+
+bool CompiledExpression::is_constant_node(uint32_t index) const {
+    return nodes_[index].kind == Kind::Constant;
+}
+
+uint32_t CompiledExpression::compile_condition(const Expression& expr, const std::vector<Literal>& params) {
+    if (const auto* logical_ptr = std::get_if<std::shared_ptr<LogicalExpression>>(&expr)) {
+        const auto& logical = *logical_ptr;
+        if (logical->op == "AND" || logical->op == "OR") {
+            Node node{logical->op == "AND" ? Kind::And : Kind::Or};
+            node.operands[0] = compile_condition(logical->left, params);
+            node.operands[1] = compile_condition(logical->right, params);
+            const uint32_t index = add(std::move(node));
+            fold_condition(index);
+            return index;
+        }
+    } else if (const auto* between_ptr = std::get_if<std::shared_ptr<BetweenExpression>>(&expr)) {
+        const auto& between = *between_ptr;
+        Node node{Kind::Between};
+        node.flag = between->negated;
+        node.operands[0] = compile_value(between->value, params);
+        node.operands[1] = compile_value(between->lower, params);
+        node.operands[2] = compile_value(between->upper, params);
+        const uint32_t index = add(std::move(node));
+        fold_condition(index);
+        return index;
+    } else if (const auto* binary_ptr = std::get_if<std::shared_ptr<BinaryExpression>>(&expr)) {
+        const auto& binary = *binary_ptr;
+        Node node{Kind::Compare};
+        node.compare = parse_compare_op(binary->op);
+        node.operands[0] = compile_value(binary->left, params);
+        node.operands[1] = compile_value(binary->right, params);
+        std::string buffer;
+        std::string_view text;
+        if (node.compare == CompareOp::Like && is_constant_node(node.operands[1]) &&
+            as_text(nodes_[node.operands[1]].constant, text, buffer)) {
+            node.has_pattern = true;
+            try {
+                node.pattern = std::make_shared<const std::regex>(like_to_regex(std::string(text)));
+            } catch (const std::regex_error&) {
+                // Matches nothing.
+            }
+        }
+        const uint32_t index = add(std::move(node));
+        fold_condition(index);
+        return index;
+    }
+    Node node{Kind::Bool};
+    node.flag = false;
+    return add(std::move(node));
+}
+
+uint32_t CompiledExpression::compile_value(const Expression& expr, const std::vector<Literal>& params) {
+    if (const auto* ident = std::get_if<Identifier>(&expr)) {
+        if (ident->name == "id" || ident->name == "_id") return add(Node{Kind::DocumentId});
+        Node node{Kind::Field};
+        node.text = ident->name;
+        node.slot = field_count_;
+        for (const auto& other : nodes_) {
+            if (other.kind == Kind::Field && other.text == ident->name) {
+                node.slot = other.slot;
+                break;
+            }
+        }
+        if (node.slot == field_count_) ++field_count_;
+        return add(std::move(node));
+    }
+    if (const auto* literal = std::get_if<Literal>(&expr)) {
+        Node node{Kind::Constant};
+        node.constant = literal_to_value(*literal);
+        return add(std::move(node));
+    }
+    if (const auto* interval = std::get_if<IntervalLiteral>(&expr)) {
+        Node node{Kind::Constant};
+        node.constant = Timestamp{interval_to_microseconds(*interval)};
+        return add(std::move(node));
+    }
+    if (const auto* param = std::get_if<ParameterExpression>(&expr)) {
+        if (param->index >= params.size()) return add_error("Parameter index out of bounds.");
+        Node node{Kind::Constant};
+        node.constant = literal_to_value(params[param->index]);
+        return add(std::move(node));
+    }
+    if (const auto* fn_ptr = std::get_if<std::shared_ptr<FunctionExpression>>(&expr)) {
+        const auto& fn = *fn_ptr;
+        if (fn->name == "NOW") {
+            // Evaluated once for the whole statement.
+            Node node{Kind::Constant};
+            node.constant = now_timestamp();
+            return add(std::move(node));
+        }
+        Node node{Kind::Error};
+        if (fn->name == "DATE" || fn->name == "TIME") {
+            if (fn->args.empty()) return add_error(fn->name + "() requires an argument.");
+            node.kind = fn->name == "DATE" ? Kind::ToDate : Kind::ToTime;
+            node.operands[0] = compile_value(fn->args[0], params);
+        } else if (fn->name == "EXTRACT") {
+            if (fn->args.size() != 2) return add_error("EXTRACT requires 2 arguments.");
+            const auto* part = std::get_if<Literal>(&fn->args[0]);
+            if (!part || !std::holds_alternative<std::string>(*part)) {
+                return add_error("EXTRACT part must be string literal.");
+            }
+            node.kind = Kind::Extract;
+            node.text = std::get<std::string>(*part);
+            node.operands[0] = compile_value(fn->args[1], params);
+        } else {
+            return add_error("Unsupported function: " + fn->name);
+        }
+        const uint32_t index = add(std::move(node));
+        fold_value(index);
+        return index;
+    }
+    if (const auto* binary_ptr = std::get_if<std::shared_ptr<BinaryExpression>>(&expr)) {
+        const auto& binary = *binary_ptr;
+        Node node{Kind::Arithmetic};
+        if (binary->op == "+") node.arithmetic = ArithmeticOp::Add;
+        else if (binary->op == "-") node.arithmetic = ArithmeticOp::Subtract;
+        else if (binary->op == "*") node.arithmetic = ArithmeticOp::Multiply;
+        else if (binary->op == "/") node.arithmetic = ArithmeticOp::Divide;
+        node.operands[0] = compile_value(binary->left, params);
+        node.operands[1] = compile_value(binary->right, params);
+        const uint32_t index = add(std::move(node));
+        fold_value(index);
+        return index;
+    }
+    return add_error("Unsupported expression type for value resolution.");
+}
+
+void CompiledExpression::fold_value(uint32_t index) {
+    const Node& node = nodes_[index];
+    const size_t operand_count = node.kind == Kind::Arithmetic ? 2 : 1;
+    for (size_t i = 0; i < operand_count; ++i) {
+        if (!is_constant_node(node.operands[i])) return;
+    }
+    try {
+        Node folded{Kind::Constant};
+        folded.constant = resolve(index, empty_document, frame());
+        nodes_[index] = std::move(folded);
+    } catch (const std::exception&) {
+        // E.g. a division by zero: left for evaluation to raise, which only
+        // happens if a document reaches it.
+    }
+}
+
+void CompiledExpression::fold_condition(uint32_t index) {
+    const Node& node = nodes_[index];
+    if (node.kind == Kind::And || node.kind == Kind::Or) {
+        // Only the left side can be folded away: the right side is not
+        // evaluated at all when the left side decides the result.
+        const Node& left = nodes_[node.operands[0]];
+        if (left.kind != Kind::Bool) return;
+        const bool decides = node.kind == Kind::And ? !left.flag : left.flag;
+        if (decides) {
+            Node folded{Kind::Bool};
+            folded.flag = left.flag;
+            nodes_[index] = std::move(folded);
+        } else {
+            nodes_[index] = Node(nodes_[node.operands[1]]);
+        }
+        return;
+    }
+    const size_t operand_count = node.kind == Kind::Between ? 3 : 2;
+    for (size_t i = 0; i < operand_count; ++i) {
+        if (!is_constant_node(node.operands[i])) return;
+    }
+    try {
+        Node folded{Kind::Bool};
+        folded.flag = test(index, empty_document, frame());
+        nodes_[index] = std::move(folded);
+    } catch (const std::exception&) {
+    }
+}
+
+CompiledExpression::Frame& CompiledExpression::frame() const {
+    static thread_local Frame frame;
+    if (frame.scratch.size() < nodes_.size()) frame.scratch.resize(nodes_.size());
+    if (frame.fields.size() < field_count_) {
+        frame.fields.resize(field_count_);
+        frame.field_stamps.resize(field_count_, 0);
+    }
+    ++frame.stamp;
+    return frame;
+}
+
+bool CompiledExpression::test(uint32_t index, const Document& doc, Frame& frame) const {
+    const Node& node = nodes_[index];
+    switch (node.kind) {
+        case Kind::And:
+            return test(node.operands[0], doc, frame) && test(node.operands[1], doc, frame);
+        case Kind::Or:
+            return test(node.operands[0], doc, frame) || test(node.operands[1], doc, frame);
+        case Kind::Bool:
+            return node.flag;
+        case Kind::Compare:
+            return compare_values(node.compare, resolve(node.operands[0], doc, frame),
+                                  resolve(node.operands[1], doc, frame), node.has_pattern, node.pattern.get());
+        case Kind::Between: {
+            const Value& value = resolve(node.operands[0], doc, frame);
+            const Value& lower = resolve(node.operands[1], doc, frame);
+            const Value& upper = resolve(node.operands[2], doc, frame);
+            bool in_range = false;
+            double v_num, l_num, u_num;
+            if (as_number(value, v_num) && as_number(lower, l_num) && as_number(upper, u_num)) {
+                in_range = v_num >= l_num && v_num <= u_num;
+            } else if (const auto* v_date = std::get_if<Date>(&value)) {
+                const auto* l_date = std::get_if<Date>(&lower);
+                const auto* u_date = std::get_if<Date>(&upper);
+                in_range = l_date && u_date && !(*v_date < *l_date) && !(*u_date < *v_date);
+            } else if (const auto* v_ts = std::get_if<Timestamp>(&value)) {
+                const auto* l_ts = std::get_if<Timestamp>(&lower);
+                const auto* u_ts = std::get_if<Timestamp>(&upper);
+                in_range = l_ts && u_ts && *v_ts >= *l_ts && *v_ts <= *u_ts;
+            }
+            return node.flag ? !in_range : in_range;
+        }
+        default:
+            // A value where a condition is expected.
+            return false;
+    }
+}
+
+const Value& CompiledExpression::resolve(uint32_t index, const Document& doc, Frame& frame) const {
+    const Node& node = nodes_[index];
+    Value& result = frame.scratch[index];
+    switch (node.kind) {
+        case Kind::Constant:
+            return node.constant;
+        case Kind::Field: {
+            if (frame.field_stamps[node.slot] != frame.stamp) {
+                const Value* found = nullptr;
+                for (const auto& elem : doc.elements) {
+                    if (elem.key == node.text) {
+                        found = &elem.value;
+                        break;
+                    }
+                }
+                frame.fields[node.slot] = found;
+                frame.field_stamps[node.slot] = frame.stamp;
+            }
+            const Value* value = frame.fields[node.slot];
+            return value ? *value : null_value;
+        }
+        case Kind::DocumentId:
+            // Reuses the scratch string's buffer from the previous document.
+            if (auto* id = std::get_if<std::string>(&result)) {
+                id->assign(doc.id);
+            } else {
+                result = doc.id;
+            }
+            return result;
+        case Kind::Error:
+            throw std::runtime_error(node.text);
+        case Kind::ToDate: {
+            const Value& arg = resolve(node.operands[0], doc, frame);
+            if (const auto* ts = std::get_if<Timestamp>(&arg)) {
+                result = timestamp_to_date(*ts);
+                return result;
+            }
+            if (const auto* str = std::get_if<std::string>(&arg)) {
+                int y, m, d;
+                if (std::sscanf(str->c_str(), "%d-%d-%d", &y, &m, &d) == 3) {
+                    result = Date{static_cast<uint16_t>(y), static_cast<uint8_t>(m), static_cast<uint8_t>(d)};
+                    return result;
+                }
+            }
+            if (std::holds_alternative<Date>(arg)) return arg;
+            throw std::runtime_error("DATE() argument must be DATE, TIMESTAMP, or date string.");
+        }
+        case Kind::ToTime: {
+            const Value& arg = resolve(node.operands[0], doc, frame);
+            if (const auto* ts = std::get_if<Timestamp>(&arg)) {
+                result = timestamp_to_time(*ts);
+                return result;
+            }
+            if (const auto* str = std::get_if<std::string>(&arg)) {
+                int h, m, sec;
+                if (std::sscanf(str->c_str(), "%d:%d:%d", &h, &m, &sec) == 3) {
+                    result = Time{static_cast<uint8_t>(h), static_cast<uint8_t>(m), static_cast<uint8_t>(sec)};
+                    return result;
+                }
+            }
+            if (std::holds_alternative<Time>(arg)) return arg;
+            throw std::runtime_error("TIME() argument must be TIME, TIMESTAMP, or time string.");
+        }
+        case Kind::Extract: {
+            const Value& target = resolve(node.operands[0], doc, frame);
+            const std::string& part = node.text;
+            if (const auto* ts = std::get_if<Timestamp>(&target)) {
+                result = extract_part_from_timestamp(part, *ts);
+                return result;
+            }
+            if (const auto* d = std::get_if<Date>(&target)) {
+                if (part == "year") result = static_cast<double>(d->year);
+                else if (part == "month") result = static_cast<double>(d->month);
+                else if (part == "day") result = static_cast<double>(d->day);
+                else result = 0.0;
+                return result;
+            }
+            throw std::runtime_error("EXTRACT target must be TIMESTAMP or DATE.");
+        }
+        case Kind::Arithmetic: {
+            const Value& left = resolve(node.operands[0], doc, frame);
+            const Value& right = resolve(node.operands[1], doc, frame);
+            const ArithmeticOp op = node.arithmetic;
+
+            double left_num, right_num;
+            if (op != ArithmeticOp::Other && as_number(left, left_num) && as_number(right, right_num)) {
+                switch (op) {
+                    case ArithmeticOp::Add: result = left_num + right_num; break;
+                    case ArithmeticOp::Subtract: result = left_num - right_num; break;
+                    case ArithmeticOp::Multiply: result = left_num * right_num; break;
+                    default:
+                        if (right_num == 0) throw std::runtime_error("Division by zero");
+                        result = left_num / right_num;
+                        break;
+                }
+                return result;
+            }
+
+            const auto* right_interval = std::get_if<Timestamp>(&right);
+            if (const auto* left_ts = std::get_if<Timestamp>(&left); left_ts && right_interval) {
+                if (op == ArithmeticOp::Add) {
+                    result = Timestamp{left_ts->microseconds_since_epoch_utc + right_interval->microseconds_since_epoch_utc};
+                    return result;
+                }
+                if (op == ArithmeticOp::Subtract) {
+                    result = Timestamp{left_ts->microseconds_since_epoch_utc - right_interval->microseconds_since_epoch_utc};
+                    return result;
+                }
+            }
+            if (const auto* left_date = std::get_if<Date>(&left); left_date && right_interval) {
+                std::tm tm{};
+                tm.tm_year = left_date->year - 1900;
+                tm.tm_mon = left_date->month - 1;
+                tm.tm_mday = left_date->day;
+#ifdef _WIN32
+                std::time_t base = _mkgmtime(&tm);
+#else
+                std::time_t base = timegm(&tm);
+#endif
+                auto micros = static_cast<int64_t>(base) * 1000000;
+                if (op == ArithmeticOp::Add) micros += right_interval->microseconds_since_epoch_utc;
+                else if (op == ArithmeticOp::Subtract) micros -= right_interval->microseconds_since_epoch_utc;
+                else throw std::runtime_error("Unsupported DATE arithmetic operation.");
+                result = timestamp_to_date(Timestamp{micros});
+                return result;
+            }
+            throw std::runtime_error("Unsupported arithmetic operation or type mismatch.");
+        }
+        default:
+            throw std::runtime_error("Unsupported expression type for value resolution.");
+    }
+}
+
+} // namespace Query
+} // namespace TissDB
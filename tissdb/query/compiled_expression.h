@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <regex>
+#include <string>
+#include <vector>
+#include "ast.h"
+#include "../common/document.h"
+
+namespace TissDB {
+namespace Query {
+
+enum class CompareOp : uint8_t { Equal, NotEqual, Less, Greater, LessEqual, GreaterEqual, Like, Other };
+
+CompareOp parse_compare_op(const std::string& op);
+
+// An expression compiled once per statement, then evaluated per document.
+//
+// Compilation resolves everything that does not depend on the document:
+// operators become enums, parameters and literals become Values, constant
+// subexpressions (including NOW()) are folded, LIKE patterns against a
+// constant are turned into a regex, and each field gets a slot so it is
+// looked up at most once per document. Evaluation then walks a flat array of
+// nodes without comparing operator strings or copying field values.
+//
+// The result, including any error raised, is the one the expression gives
+// when interpreted directly. Errors that depend on the document (a division
+// by zero, a function argument of the wrong type) are raised during
+// evaluation, and so are errors the interpreter raises only when it reaches
+// the subexpression, such as an unbound parameter on the unevaluated side of
+// an OR.
+class CompiledExpression {
+public:
+    // As a condition: WHERE, ON, HAVING.
+    static CompiledExpression predicate(const Expression& expr, const std::vector<Literal>& params);
+    // As a value: a SET or VALUES expression, or a comparison operand.
+    static CompiledExpression value(const Expression& expr, const std::vector<Literal>& params);
+
+    bool matches(const Document& doc) const;
+    Value evaluate(const Document& doc) const;
+
+    // Whether the result does not depend on the document, so evaluate() of
+    // any document returns it.
+    bool is_constant() const;
+
+private:
+    enum class Kind : uint8_t {
+        // Conditions
+        And, Or, Compare, Between, Bool,
+        // Values
+        Constant, Field, DocumentId, Arithmetic, ToDate, ToTime, Extract, Error
+    };
+    enum class ArithmeticOp : uint8_t { Add, Subtract, Multiply, Divide, Other };
+
+    struct Node {
+        Kind kind;
+        CompareOp compare = CompareOp::Other;
+        ArithmeticOp arithmetic = ArithmeticOp::Other;
+        bool flag = false;            // Bool: its value. Between: NOT BETWEEN.
+        uint32_t operands[3] = {0, 0, 0};
+        uint32_t slot = 0;            // Field: index into the per-document field cache
+        std::string text{};           // Field: key. Extract: part. Error: message.
+        Value constant{};             // Constant
+        // Compare LIKE against a constant pattern; null if the pattern is
+        // not a valid regex, so nothing matches.
+        std::shared_ptr<const std::regex> pattern{};
+        bool has_pattern = false;
+    };
+    struct Frame;
+
+    uint32_t compile_condition(const Expression& expr, const std::vector<Literal>& params);
+    uint32_t compile_value(const Expression& expr, const std::vector<Literal>& params);
+    uint32_t add(Node node);
+    uint32_t add_error(const std::string& message);
+    bool is_constant_node(uint32_t index) const;
+    void fold_value(uint32_t index);
+    void fold_condition(uint32_t index);
+
+    bool test(uint32_t index, const Document& doc, Frame& frame) const;
+    const Value& resolve(uint32_t index, const Document& doc, Frame& frame) const;
+    Frame& frame() const;
+
+    std::vector<Node> nodes_;
+    uint32_t root_ = 0;
+    uint32_t field_count_ = 0;
+};
+
+} // namespace Query
+} // namespace TissDB
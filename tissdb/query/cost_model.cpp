@@ -0,0 +1,133 @@
+#include "cost_model.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace TissDB {
+namespace Query {
+
+namespace {
+bool has_statistics(const Storage::CollectionStatistics* stats) {
+    return stats && !stats->empty();
+}
+
+double row_count(const Storage::CollectionStatistics& stats) {
+    return static_cast<double>(stats.row_count());
+}
+
+// A side already in key order is only checked.
+double sort_cost(double rows, bool sorted) {
+    if (sorted || rows < 2) return rows * SORT_COMPARE_COST;
+    return rows * std::log2(rows) * SORT_COMPARE_COST;
+}
+} // anonymous namespace
+
+double estimate_equality_matches(const Storage::CollectionStatistics& stats, const std::string& field) {
+    return row_count(stats) * stats.equality_selectivity(field);
+}
+
+AccessPath choose_access_path(const Storage::CollectionStatistics& stats,
+                              const std::vector<std::vector<std::string>>& indexes,
+                              const std::map<std::string, std::string>& conditions) {
+    AccessPath best;
+    best.estimated_rows = row_count(stats);
+    const bool use_statistics = !stats.empty();
+    double best_cost = best.estimated_rows; // Cost of the full scan
+
+    for (const auto& index_fields : indexes) {
+        bool all_fields_present = std::all_of(index_fields.begin(), index_fields.end(),
+            [&](const std::string& field) { return conditions.count(field) > 0; });
+        if (!all_fields_present || index_fields.empty()) continue;
+
+        if (!use_statistics) {
+            if (index_fields.size() > best.index_fields.size()) {
+                best.index_fields = index_fields;
+            }
+            continue;
+        }
+        // Fields are assumed independent.
+        double selectivity = 1.0;
+        for (const auto& field : index_fields) {
+            selectivity *= stats.equality_selectivity(field);
+        }
+        const double rows = row_count(stats) * selectivity;
+        const double cost = rows * INDEX_LOOKUP_COST;
+        if (cost < best_cost ||
+            (cost == best_cost && best.uses_index() && index_fields.size() > best.index_fields.size())) {
+            best.index_fields = index_fields;
+            best.estimated_rows = rows;
+            best_cost = cost;
+        }
+    }
+    return best;
+}
+
+JoinStrategy choose_join_strategy(const JoinInputs& inputs) {
+    if (!has_statistics(inputs.right_stats)) {
+        return inputs.right_indexed ? JoinStrategy::LookupRight : JoinStrategy::Hash;
+    }
+
+    const double left_rows = inputs.left_rows;
+    const double right_rows = row_count(*inputs.right_stats);
+
+    const double scan_cost = right_rows + left_rows * right_rows * NESTED_LOOP_PAIR_COST;
+    JoinStrategy best = JoinStrategy::ScanRight;
+    double best_cost = scan_cost;
+
+    if (inputs.right_indexed) {
+        const double matches = estimate_equality_matches(*inputs.right_stats, inputs.right_key);
+        const double lookup_cost = left_rows * (INDEX_LOOKUP_COST + matches);
+        if (lookup_cost < best_cost) {
+            best = JoinStrategy::LookupRight;
+            best_cost = lookup_cost;
+        }
+    }
+
+    const double build_rows = std::min(left_rows, right_rows);
+    const double probe_rows = std::max(left_rows, right_rows);
+    double hash_cost = right_rows + build_rows * HASH_BUILD_COST + probe_rows * HASH_PROBE_COST;
+    const bool limited = inputs.memory_rows > 0;
+    if (limited && build_rows > inputs.memory_rows) {
+        hash_cost += (left_rows + right_rows) * SPILL_ROW_COST;
+    }
+    if (hash_cost < best_cost) {
+        best = JoinStrategy::Hash;
+        best_cost = hash_cost;
+    }
+
+    if (!limited || left_rows + right_rows <= inputs.memory_rows) {
+        const double merge_cost = right_rows + sort_cost(left_rows, inputs.left_sorted) +
+                                  sort_cost(right_rows, inputs.right_sorted) +
+                                  (left_rows + right_rows) * MERGE_ROW_COST;
+        if (merge_cost < best_cost) {
+            best = JoinStrategy::SortMerge;
+            best_cost = merge_cost;
+        }
+    }
+
+    // Driving from the right side only pays off if it spares the scan of the
+    // left collection, which is then reached through its index instead.
+    if (inputs.inner && inputs.left_indexed && inputs.left_is_full_scan && has_statistics(inputs.left_stats)) {
+        const double matches = estimate_equality_matches(*inputs.left_stats, inputs.left_key);
+        const double swapped_cost = right_rows + right_rows * (INDEX_LOOKUP_COST + matches);
+        // The other strategies also pay for scanning the left collection.
+        if (swapped_cost < best_cost + left_rows) {
+            best = JoinStrategy::LookupLeft;
+        }
+    }
+    return best;
+}
+
+const char* to_string(JoinStrategy strategy) {
+    switch (strategy) {
+        case JoinStrategy::LookupRight: return "index lookup into right";
+        case JoinStrategy::ScanRight:   return "scan right";
+        case JoinStrategy::LookupLeft:  return "scan right, index lookup into left";
+        case JoinStrategy::Hash:        return "hash join";
+        case JoinStrategy::SortMerge:   return "sort-merge join";
+    }
+    return "unknown";
+}
+
+} // namespace Query
+} // namespace TissDB
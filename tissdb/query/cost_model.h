@@ -0,0 +1,73 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "../storage/statistics.h"
+
+namespace TissDB {
+namespace Query {
+
+// Costs are in units of one document read by a sequential scan.
+constexpr double INDEX_LOOKUP_COST = 3.0;      // Index probe plus a point read
+constexpr double NESTED_LOOP_PAIR_COST = 0.1;  // Evaluating the ON condition for one pair
+constexpr double HASH_BUILD_COST = 0.3;        // Inserting one document into a join hash table
+constexpr double HASH_PROBE_COST = 0.2;        // Probing the hash table with one document
+constexpr double SORT_COMPARE_COST = 0.05;     // One key comparison while sorting
+constexpr double MERGE_ROW_COST = 0.05;        // Stepping past one document while merging
+constexpr double SPILL_ROW_COST = 2.0;         // Writing one document to a spill file and reading it back
+constexpr double ESTIMATED_DOCUMENT_BYTES = 512; // In memory, when sizing a hash join without reading the data
+
+// How to read the documents of a single collection.
+struct AccessPath {
+    std::vector<std::string> index_fields; // Empty: full scan
+    double estimated_rows = 0;
+
+    bool uses_index() const { return !index_fields.empty(); }
+};
+
+// Picks the cheapest index whose fields are all bound by the equality
+// `conditions`, or a full scan if every index would touch too much of the
+// collection. Without statistics, the index covering the most fields wins.
+AccessPath choose_access_path(const Storage::CollectionStatistics& stats,
+                              const std::vector<std::vector<std::string>>& indexes,
+                              const std::map<std::string, std::string>& conditions);
+
+// Estimated documents matching `field = <constant>`.
+double estimate_equality_matches(const Storage::CollectionStatistics& stats, const std::string& field);
+
+// How an equi-join reaches its documents.
+enum class JoinStrategy {
+    LookupRight, // Per left document, probe the right collection's index
+    ScanRight,   // Scan the right collection once and loop over the pairs
+    LookupLeft,  // Scan the right collection, probe the left collection's index
+    Hash,        // Scan the right collection, hash the smaller side, probe with the other
+    SortMerge,   // Scan the right collection, sort both sides on the key and merge
+};
+
+struct JoinInputs {
+    double left_rows = 0;                       // Documents the left side produces
+    const Storage::CollectionStatistics* left_stats = nullptr;
+    const Storage::CollectionStatistics* right_stats = nullptr;
+    std::string left_key;                       // Unqualified join fields
+    std::string right_key;
+    bool left_indexed = false;                  // Left collection has an index on left_key
+    bool right_indexed = false;
+    bool left_is_full_scan = false;             // The left side is not narrowed by an index
+    bool inner = false;                         // Only INNER joins may swap sides
+    bool left_sorted = false;                   // The left side arrives in key order
+    bool right_sorted = false;
+    double memory_rows = 0;                     // Documents a join may hold in memory; 0: no limit
+};
+
+// Without statistics, an index on the right key is used, and a hash join
+// otherwise. With them, the cheapest strategy wins: a hash join that would
+// spill pays for writing and reading back both sides, and a sort-merge join,
+// which keeps both sides in memory, is only considered if they fit.
+JoinStrategy choose_join_strategy(const JoinInputs& inputs);
+
+const char* to_string(JoinStrategy strategy);
+
+} // namespace Query
+} // namespace TissDB
@@ -3,7 +3,11 @@
 #include "executor_insert.h"
 #include "executor_update.h"
 #include "executor_delete.h"
+#include "explain.h"
+#include "query_metrics.h"
+#include "statement_cache.h"
 #include <stdexcept>
+#include <string>
 
 namespace TissDB {
 namespace Query {
@@ -11,8 +15,9 @@ namespace Query {
 Executor::Executor(Storage::LSMTree& storage) : storage_engine(storage) {}
 
 QueryResult Executor::execute(const AST& ast, const std::vector<Literal>& params) {
+    Common::ScopedTimer timer(stage_latency(QueryStage::Execute, ast));
     if (auto* select_stmt = std::get_if<SelectStatement>(&ast)) {
-        return execute_select_statement(storage_engine, *select_stmt, params);
+        return execute_select_statement(storage_engine, *select_stmt, params, parallelism_);
     } else if (auto* insert_stmt = std::get_if<InsertStatement>(&ast)) {
         // INSERT statements do not use the parameter substitution logic in the same way,
         // as their values are already parsed into a list of literals.
@@ -22,9 +27,40 @@ QueryResult Executor::execute(const AST& ast, const std::vector<Literal>& params
         return execute_update_statement(storage_engine, *update_stmt, params);
     } else if (auto* delete_stmt = std::get_if<DeleteStatement>(&ast)) {
         return execute_delete_statement(storage_engine, *delete_stmt, params);
+    } else if (auto* analyze_stmt = std::get_if<AnalyzeStatement>(&ast)) {
+        const auto stats = storage_engine.analyze(analyze_stmt->collection_name);
+        Document summary;
+        summary.elements.push_back({"collection", analyze_stmt->collection_name});
+        summary.elements.push_back({"row_count", static_cast<double>(stats.row_count())});
+        summary.elements.push_back({"fields", static_cast<double>(stats.fields().size())});
+        return {summary};
+    } else if (auto* explain_stmt = std::get_if<ExplainStatement>(&ast)) {
+        ExplainContext context;
+        context.analyze = explain_stmt->analyze;
+        const QueryResult result = execute_select_statement(storage_engine, explain_stmt->select, params,
+                                                            parallelism_, nullptr, &context);
+        return explain_result(context, result.size());
     }
     return {};
 }
 
+QueryResult Executor::execute(PreparedStatement& statement, const std::vector<Literal>& params) {
+    if (params.size() != statement.param_count) {
+        throw std::runtime_error("Statement expects " + std::to_string(statement.param_count) +
+                                 " parameters, got " + std::to_string(params.size()) + ".");
+    }
+    if (auto* select_stmt = std::get_if<SelectStatement>(&statement.ast)) {
+        Common::ScopedTimer timer(stage_latency(QueryStage::Execute, statement.ast));
+        return execute_select_statement(storage_engine, *select_stmt, params, parallelism_, &statement.access_path);
+    } else if (auto* update_stmt = std::get_if<UpdateStatement>(&statement.ast)) {
+        Common::ScopedTimer timer(stage_latency(QueryStage::Execute, statement.ast));
+        return execute_update_statement(storage_engine, *update_stmt, params, &statement.access_path);
+    } else if (auto* delete_stmt = std::get_if<DeleteStatement>(&statement.ast)) {
+        Common::ScopedTimer timer(stage_latency(QueryStage::Execute, statement.ast));
+        return execute_delete_statement(storage_engine, *delete_stmt, params, &statement.access_path);
+    }
+    return execute(statement.ast, params);
+}
+
 } // namespace Query
 } // namespace TissDB
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include "ast.h"
 #include "../common/document.h"
+#include <cstddef>
 #include <vector>
 
 // Forward declaration for the storage engine
@@ -10,6 +11,8 @@ namespace TissDB { namespace Storage { class LSMTree; } }
 namespace TissDB {
 namespace Query {
 
+struct PreparedStatement;
+
 // A query result is typically a list of documents.
 using QueryResult = std::vector<Document>;
 
@@ -22,10 +25,18 @@ public:
 
     // Executes a query represented by an AST.
     QueryResult execute(const AST& ast, const std::vector<Literal>& params);
+    // Executes a cached statement, reusing its plan where still valid.
+    // Throws unless `params` has one value per placeholder.
+    QueryResult execute(PreparedStatement& statement, const std::vector<Literal>& params);
+
+    // The most threads a SELECT may use; 0, the default, for the server's
+    // limit (see set_max_query_parallelism), which also caps this one.
+    void set_parallelism(size_t threads) { parallelism_ = threads; }
 
 private:
     // A reference to the underlying storage engine.
     Storage::LSMTree& storage_engine;
+    size_t parallelism_ = 0;
 };
 
 } // namespace Query
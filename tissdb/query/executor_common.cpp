@@ -1,15 +1,18 @@
 #include "executor_common.h"
+#include "compiled_expression.h"
+#include "cost_model.h"
+#include "statement_cache.h"
+#include "../storage/lsm_tree.h"
+#include "../common/checksum.h"
 #include <stdexcept>
 #include <iostream>
 #include <sstream>
 #include <functional>
 #include <cmath>
 #include <algorithm>
-#include <regex>
-#include <chrono>
-#include <ctime>
-#include <cctype>
+#include <cerrno>
 #include <cstdio>
+#include <cstdlib>
 
 namespace TissDB {
 namespace Query {
@@ -33,16 +36,25 @@ std::string like_to_regex(std::string pattern) {
 }
 
 // --- Conversion helpers to make evaluation more robust ---
+bool parse_number(const char* text, double& value) {
+    const int saved_errno = errno;
+    errno = 0;
+    char* end = nullptr;
+    const double parsed = std::strtod(text, &end);
+    const bool out_of_range = errno == ERANGE;
+    errno = saved_errno;
+    if (end == text || out_of_range) return false;
+    value = parsed;
+    return true;
+}
+
 std::optional<double> get_as_numeric(const Value& val) {
     if (const auto* num_val = std::get_if<double>(&val)) {
         return *num_val;
     }
     if (const auto* str_val = std::get_if<std::string>(&val)) {
-        try {
-            return std::stod(*str_val);
-        } catch (const std::invalid_argument&) {
-            return std::nullopt;
-        }
+        double parsed;
+        if (parse_number(str_val->c_str(), parsed)) return parsed;
     }
     return std::nullopt;
 }
@@ -69,366 +81,23 @@ std::optional<std::string> get_as_string(const Value& val) {
     return std::nullopt; // Incompatible types for string comparison
 }
 
-namespace {
-int64_t interval_to_microseconds(const IntervalLiteral& interval) {
-    std::string unit = interval.unit;
-    std::transform(unit.begin(), unit.end(), unit.begin(), ::tolower);
-    if (unit == "microsecond" || unit == "microseconds") return static_cast<int64_t>(interval.value);
-    if (unit == "millisecond" || unit == "milliseconds") return static_cast<int64_t>(interval.value * 1000.0);
-    if (unit == "second" || unit == "seconds") return static_cast<int64_t>(interval.value * 1000000.0);
-    if (unit == "minute" || unit == "minutes") return static_cast<int64_t>(interval.value * 60.0 * 1000000.0);
-    if (unit == "hour" || unit == "hours") return static_cast<int64_t>(interval.value * 3600.0 * 1000000.0);
-    if (unit == "day" || unit == "days") return static_cast<int64_t>(interval.value * 86400.0 * 1000000.0);
-    return static_cast<int64_t>(interval.value * 1000000.0);
-}
-
-Timestamp now_timestamp() {
-    auto now = std::chrono::system_clock::now();
-    auto micros = std::chrono::duration_cast<std::chrono::microseconds>(now.time_since_epoch()).count();
-    return Timestamp{micros};
-}
-
-Date timestamp_to_date(const Timestamp& ts) {
-    std::time_t tt = static_cast<std::time_t>(ts.microseconds_since_epoch_utc / 1000000);
-    std::tm tm{};
-#ifdef _WIN32
-    gmtime_s(&tm, &tt);
-#else
-    gmtime_r(&tt, &tm);
-#endif
-    return Date{static_cast<uint16_t>(tm.tm_year + 1900), static_cast<uint8_t>(tm.tm_mon + 1), static_cast<uint8_t>(tm.tm_mday)};
-}
-
-
-Time timestamp_to_time(const Timestamp& ts) {
-    std::time_t tt = static_cast<std::time_t>(ts.microseconds_since_epoch_utc / 1000000);
-    std::tm tm{};
-#ifdef _WIN32
-    gmtime_s(&tm, &tt);
-#else
-    gmtime_r(&tt, &tm);
-#endif
-    return Time{static_cast<uint8_t>(tm.tm_hour), static_cast<uint8_t>(tm.tm_min), static_cast<uint8_t>(tm.tm_sec)};
-}
-
-double extract_part_from_timestamp(const std::string& part, const Timestamp& ts) {
-    std::time_t tt = static_cast<std::time_t>(ts.microseconds_since_epoch_utc / 1000000);
-    std::tm tm{};
-#ifdef _WIN32
-    gmtime_s(&tm, &tt);
-#else
-    gmtime_r(&tt, &tm);
-#endif
-    if (part == "year") return tm.tm_year + 1900;
-    if (part == "month") return tm.tm_mon + 1;
-    if (part == "day") return tm.tm_mday;
-    if (part == "hour") return tm.tm_hour;
-    if (part == "minute") return tm.tm_min;
-    if (part == "second") return tm.tm_sec;
-    return 0.0;
-}
-}
-
 // --- Expression Resolution ---
+// One-off evaluations. Executors that evaluate an expression once per
+// document compile it once with CompiledExpression instead.
 
 Value resolve_expression_to_value(const Expression& expr, const Document& doc, const std::vector<Literal>& params) {
-    if (const auto* ident_ptr = std::get_if<Identifier>(&expr)) {
-        std::string key = ident_ptr->name;
-        // Handle qualified names like 'c.name' by splitting them
-        std::string alias;
-        std::string field_name;
-        if (auto dot_pos = key.find('.'); dot_pos != std::string::npos) {
-            alias = key.substr(0, dot_pos);
-            field_name = key.substr(dot_pos + 1);
-        } else {
-            field_name = key;
-        }
-
-        // In a combined document, the key is already aliased, so we just look for it.
-        const Value* val = get_value_from_doc(doc, key);
-        return val ? *val : Value{std::nullptr_t{}};
-    }
-    if (const auto* lit_ptr = std::get_if<Literal>(&expr)) {
-        if (const auto* str_val = std::get_if<std::string>(lit_ptr)) return *str_val;
-        if (const auto* num_val = std::get_if<double>(lit_ptr)) return *num_val;
-        if (const auto* bool_val = std::get_if<bool>(lit_ptr)) return *bool_val;
-        if (const auto* date_val = std::get_if<Date>(lit_ptr)) return *date_val;
-        if (const auto* time_val = std::get_if<Time>(lit_ptr)) return *time_val;
-        if (const auto* ts_val = std::get_if<TissDB::Timestamp>(lit_ptr)) return *ts_val;
-        if (const auto* dt_val = std::get_if<DateTime>(lit_ptr)) return *dt_val;
-        if (const auto* ts_val = std::get_if<Timestamp>(lit_ptr)) return *ts_val;
-        if (std::holds_alternative<Null>(*lit_ptr)) return std::nullptr_t{};
-    }
-    if (const auto* interval_ptr = std::get_if<IntervalLiteral>(&expr)) {
-        return Timestamp{interval_to_microseconds(*interval_ptr)};
-    }
-    if (const auto* param_ptr = std::get_if<ParameterExpression>(&expr)) {
-        if (param_ptr->index >= params.size()) {
-            throw std::runtime_error("Parameter index out of bounds.");
-        }
-        const auto& param_lit = params[param_ptr->index];
-        if (const auto* str_val = std::get_if<std::string>(&param_lit)) return *str_val;
-        if (const auto* num_val = std::get_if<double>(&param_lit)) return *num_val;
-        if (const auto* bool_val = std::get_if<bool>(&param_lit)) return *bool_val;
-        if (const auto* date_val = std::get_if<Date>(&param_lit)) return *date_val;
-        if (const auto* time_val = std::get_if<Time>(&param_lit)) return *time_val;
-        if (const auto* ts_val = std::get_if<TissDB::Timestamp>(&param_lit)) return *ts_val;
-        if (const auto* dt_val = std::get_if<DateTime>(&param_lit)) return *dt_val;
-        if (const auto* ts_val = std::get_if<Timestamp>(&param_lit)) return *ts_val;
-        if (std::holds_alternative<Null>(param_lit)) return std::nullptr_t{};
-    }
-    if (const auto* fn_ptr = std::get_if<std::shared_ptr<FunctionExpression>>(&expr)) {
-        const auto& fn = *fn_ptr;
-        if (fn->name == "NOW") {
-            return now_timestamp();
-        }
-        if (fn->name == "DATE") {
-            if (fn->args.empty()) {
-                throw std::runtime_error("DATE() requires an argument.");
-            }
-            Value arg = resolve_expression_to_value(fn->args[0], doc, params);
-            if (const auto* ts = std::get_if<Timestamp>(&arg)) {
-                return timestamp_to_date(*ts);
-            }
-            if (const auto* str = std::get_if<std::string>(&arg)) {
-                int y, m, d;
-                if (std::sscanf(str->c_str(), "%d-%d-%d", &y, &m, &d) == 3) {
-                    return Date{static_cast<uint16_t>(y), static_cast<uint8_t>(m), static_cast<uint8_t>(d)};
-                }
-            }
-            if (const auto* d = std::get_if<Date>(&arg)) {
-                return *d;
-            }
-            throw std::runtime_error("DATE() argument must be DATE, TIMESTAMP, or date string.");
-        }
-        if (fn->name == "TIME") {
-            if (fn->args.empty()) {
-                throw std::runtime_error("TIME() requires an argument.");
-            }
-            Value arg = resolve_expression_to_value(fn->args[0], doc, params);
-            if (const auto* ts = std::get_if<Timestamp>(&arg)) {
-                return timestamp_to_time(*ts);
-            }
-            if (const auto* str = std::get_if<std::string>(&arg)) {
-                int h, m, sec;
-                if (std::sscanf(str->c_str(), "%d:%d:%d", &h, &m, &sec) == 3) {
-                    return Time{static_cast<uint8_t>(h), static_cast<uint8_t>(m), static_cast<uint8_t>(sec)};
-                }
-            }
-            if (const auto* t = std::get_if<Time>(&arg)) {
-                return *t;
-            }
-            throw std::runtime_error("TIME() argument must be TIME, TIMESTAMP, or time string.");
-        }
-        if (fn->name == "EXTRACT") {
-            if (fn->args.size() != 2) {
-                throw std::runtime_error("EXTRACT requires 2 arguments.");
-            }
-            auto* part_lit = std::get_if<Literal>(&fn->args[0]);
-            if (!part_lit || !std::holds_alternative<std::string>(*part_lit)) {
-                throw std::runtime_error("EXTRACT part must be string literal.");
-            }
-            std::string part = std::get<std::string>(*part_lit);
-            Value target = resolve_expression_to_value(fn->args[1], doc, params);
-            if (const auto* ts = std::get_if<Timestamp>(&target)) {
-                return extract_part_from_timestamp(part, *ts);
-            }
-            if (const auto* d = std::get_if<Date>(&target)) {
-                if (part == "year") return static_cast<double>(d->year);
-                if (part == "month") return static_cast<double>(d->month);
-                if (part == "day") return static_cast<double>(d->day);
-                return 0.0;
-            }
-            throw std::runtime_error("EXTRACT target must be TIMESTAMP or DATE.");
-        }
-        throw std::runtime_error("Unsupported function: " + fn->name);
-    }
-
-    if (const auto* binary_expr_ptr = std::get_if<std::shared_ptr<BinaryExpression>>(&expr)) {
-        const auto& binary_expr = *binary_expr_ptr;
-        Value left_val = resolve_expression_to_value(binary_expr->left, doc, params);
-        Value right_val = resolve_expression_to_value(binary_expr->right, doc, params);
-
-        auto left_num_opt = get_as_numeric(left_val);
-        auto right_num_opt = get_as_numeric(right_val);
-
-        if (left_num_opt && right_num_opt) {
-            if (binary_expr->op == "+") return *left_num_opt + *right_num_opt;
-            if (binary_expr->op == "-") return *left_num_opt - *right_num_opt;
-            if (binary_expr->op == "*") return *left_num_opt * *right_num_opt;
-            if (binary_expr->op == "/") {
-                if (*right_num_opt == 0) throw std::runtime_error("Division by zero");
-                return *left_num_opt / *right_num_opt;
-            }
-        }
-
-        if (const auto* left_ts = std::get_if<Timestamp>(&left_val)) {
-            if (const auto* right_interval = std::get_if<Timestamp>(&right_val)) {
-                if (binary_expr->op == "+") return Timestamp{left_ts->microseconds_since_epoch_utc + right_interval->microseconds_since_epoch_utc};
-                if (binary_expr->op == "-") return Timestamp{left_ts->microseconds_since_epoch_utc - right_interval->microseconds_since_epoch_utc};
-            }
-        }
-
-        if (const auto* left_date = std::get_if<Date>(&left_val)) {
-            if (const auto* right_interval = std::get_if<Timestamp>(&right_val)) {
-                std::tm tm{};
-                tm.tm_year = left_date->year - 1900;
-                tm.tm_mon = left_date->month - 1;
-                tm.tm_mday = left_date->day;
-#ifdef _WIN32
-                std::time_t base = _mkgmtime(&tm);
-#else
-                std::time_t base = timegm(&tm);
-#endif
-                auto micros = static_cast<int64_t>(base) * 1000000;
-                if (binary_expr->op == "+") micros += right_interval->microseconds_since_epoch_utc;
-                else if (binary_expr->op == "-") micros -= right_interval->microseconds_since_epoch_utc;
-                else throw std::runtime_error("Unsupported DATE arithmetic operation.");
-                return timestamp_to_date(Timestamp{micros});
-            }
-        }
-
-        throw std::runtime_error("Unsupported arithmetic operation or type mismatch.");
-    }
-    throw std::runtime_error("Unsupported expression type for value resolution.");
+    return CompiledExpression::value(expr, params).evaluate(doc);
 }
 
-
-// Evaluate an expression against a document
 bool evaluate_expression(const Expression& expr, const Document& doc, const std::vector<Literal>& params) {
-    if (const auto* logical_expr_ptr = std::get_if<std::shared_ptr<LogicalExpression>>(&expr)) {
-        const auto& logical_expr = *logical_expr_ptr;
-        if (logical_expr->op == "AND") {
-            return evaluate_expression(logical_expr->left, doc, params) && evaluate_expression(logical_expr->right, doc, params);
-        } else if (logical_expr->op == "OR") {
-            return evaluate_expression(logical_expr->left, doc, params) || evaluate_expression(logical_expr->right, doc, params);
-        }
-    } else if (const auto* between_expr_ptr = std::get_if<std::shared_ptr<BetweenExpression>>(&expr)) {
-        const auto& between_expr = *between_expr_ptr;
-        Value value = resolve_expression_to_value(between_expr->value, doc, params);
-        Value lower = resolve_expression_to_value(between_expr->lower, doc, params);
-        Value upper = resolve_expression_to_value(between_expr->upper, doc, params);
-        bool in_range = false;
-
-        auto v_num = get_as_numeric(value);
-        auto l_num = get_as_numeric(lower);
-        auto u_num = get_as_numeric(upper);
-        if (v_num && l_num && u_num) {
-            in_range = (*v_num >= *l_num && *v_num <= *u_num);
-        } else if (auto v_date = std::get_if<Date>(&value)) {
-            if (auto l_date = std::get_if<Date>(&lower)) {
-                if (auto u_date = std::get_if<Date>(&upper)) {
-                    in_range = !(*v_date < *l_date) && !(*u_date < *v_date);
-                }
-            }
-        } else if (auto v_ts = std::get_if<Timestamp>(&value)) {
-            if (auto l_ts = std::get_if<Timestamp>(&lower)) {
-                if (auto u_ts = std::get_if<Timestamp>(&upper)) {
-                    in_range = (*v_ts >= *l_ts) && (*v_ts <= *u_ts);
-                }
-            }
-        }
-
-        return between_expr->negated ? !in_range : in_range;
-    } else if (const auto* binary_expr_ptr = std::get_if<std::shared_ptr<BinaryExpression>>(&expr)) {
-        const auto& binary_expr = *binary_expr_ptr;
-
-        Value left_value = resolve_expression_to_value(binary_expr->left, doc, params);
-        Value right_value = resolve_expression_to_value(binary_expr->right, doc, params);
-
-        const std::string& op = binary_expr->op;
-
-        // Type-specific comparisons
-        if (const auto* left_date = std::get_if<Date>(&left_value)) {
-            if (const auto* right_date = std::get_if<Date>(&right_value)) {
-                if (op == "=") return *left_date == *right_date;
-                if (op == "!=") return !(*left_date == *right_date);
-                if (op == ">") return *right_date < *left_date;
-                if (op == "<") return *left_date < *right_date;
-                if (op == ">=") return !(*left_date < *right_date);
-                if (op == "<=") return !(*right_date < *left_date);
-                return false; // Unsupported operator for Date
-            }
-        }
-
-        if (const auto* left_time = std::get_if<Time>(&left_value)) {
-            if (const auto* right_time = std::get_if<Time>(&right_value)) {
-                if (op == "=") return *left_time == *right_time;
-                if (op == "!=") return !(*left_time == *right_time);
-                if (op == ">") return *right_time < *left_time;
-                if (op == "<") return *left_time < *right_time;
-                if (op == ">=") return !(*left_time < *right_time);
-                if (op == "<=") return !(*right_time < *left_time);
-                return false; // Unsupported operator for Time
-            }
-        }
-
-        if (const auto* left_dt = std::get_if<DateTime>(&left_value)) {
-            if (const auto* right_dt = std::get_if<DateTime>(&right_value)) {
-                if (op == "=") return *left_dt == *right_dt;
-                if (op == "!=") return *left_dt != *right_dt;
-                if (op == ">") return *left_dt > *right_dt;
-                if (op == "<") return *left_dt < *right_dt;
-                if (op == ">=") return *left_dt >= *right_dt;
-                if (op == "<=") return *left_dt <= *right_dt;
-                return false; // Unsupported operator for DateTime
-            }
-        }
-
-        if (const auto* left_ts = std::get_if<TissDB::Timestamp>(&left_value)) {
-            if (const auto* right_ts = std::get_if<TissDB::Timestamp>(&right_value)) {
-                if (op == "=") return *left_ts == *right_ts;
-                if (op == "!=") return *left_ts != *right_ts;
-                if (op == ">") return *left_ts > *right_ts;
-                if (op == "<") return *left_ts < *right_ts;
-                if (op == ">=") return *left_ts >= *right_ts;
-                if (op == "<=") return *left_ts <= *right_ts;
-                return false; // Unsupported operator for Timestamp
-            }
-        }
-
-        // Fallback to numeric and string comparisons
-        auto left_num_opt = get_as_numeric(left_value);
-        auto right_num_opt = get_as_numeric(right_value);
-
-        if (left_num_opt && right_num_opt) {
-            double left_num = *left_num_opt;
-            double right_num = *right_num_opt;
-            if (op == "=") return left_num == right_num;
-            if (op == "!=") return left_num != right_num;
-            if (op == ">") return left_num > right_num;
-            if (op == "<") return left_num < right_num;
-            if (op == ">=") return left_num >= right_num;
-            if (op == "<=") return left_num <= right_num;
-        }
-
-        auto left_str_opt = get_as_string(left_value);
-        auto right_str_opt = get_as_string(right_value);
-
-        if (left_str_opt && right_str_opt) {
-            const std::string& left_str = *left_str_opt;
-            const std::string& right_str = *right_str_opt;
-            if (op == "=") return left_str == right_str;
-            if (op == "!=") return left_str != right_str;
-            if (op == ">") return left_str > right_str;
-            if (op == "<") return left_str < right_str;
-            if (op == ">=") return left_str >= right_str;
-            if (op == "<=") return left_str <= right_str;
-            if (op == "LIKE") {
-                try {
-                    std::regex re(like_to_regex(right_str));
-                    return std::regex_match(left_str, re);
-                } catch (const std::regex_error& e) {
-                    return false;
-                }
-            }
-        }
-    }
-    return false;
+    return CompiledExpression::predicate(expr, params).matches(doc);
 }
 
 Literal evaluate_update_expression(const Expression& expr, const Document& doc, const std::vector<Literal>& params) {
-    Value resolved_value = resolve_expression_to_value(expr, doc, params);
+    return value_to_literal(resolve_expression_to_value(expr, doc, params));
+}
+
+Literal value_to_literal(const Value& resolved_value) {
     if (const auto* str_val = std::get_if<std::string>(&resolved_value)) {
         return *str_val;
     }
@@ -474,52 +143,179 @@ void process_aggregation(std::map<std::string, AggregateResult>& results_map, co
     const Value* value_ptr = get_value_from_doc(doc, field);
     if (!value_ptr) return;
 
-    auto& result = results_map[result_key];
-    if (agg_func.type == AggregateType::COUNT) {
+    accumulate_aggregate(results_map[result_key], *value_ptr, agg_func.type);
+}
+
+void accumulate_aggregate(AggregateResult& result, const Value& value, AggregateType type) {
+    if (type == AggregateType::COUNT) {
         result.count++;
     }
+    if (auto num_val_opt = get_as_numeric(value)) {
+        accumulate_number(result, type, *num_val_opt);
+    } else if (auto str_val_opt = get_as_string(value)) {
+        accumulate_string(result, type, *str_val_opt);
+    }
+}
+
+void merge_aggregate(AggregateResult& into, const AggregateResult& from) {
+    into.sum += from.sum;
+    into.count += from.count;
+    if (from.avg_count > 0) {
+        // Chan et al.'s combination of two Welford states.
+        const double n_a = static_cast<double>(into.avg_count);
+        const double n_b = static_cast<double>(from.avg_count);
+        const double delta = from.mean - into.mean;
+        into.avg_count += from.avg_count;
+        into.mean += delta * n_b / (n_a + n_b);
+        into.m2 += from.m2 + delta * delta * n_a * n_b / (n_a + n_b);
+    }
+    if (from.min && (!into.min || *from.min < *into.min)) into.min = from.min;
+    if (from.max && (!into.max || *from.max > *into.max)) into.max = from.max;
+    if (from.min_str && (!into.min_str || *from.min_str < *into.min_str)) into.min_str = from.min_str;
+    if (from.max_str && (!into.max_str || *from.max_str > *into.max_str)) into.max_str = from.max_str;
+}
+
+Value finalize_aggregate(const AggregateResult& result, AggregateType type) {
+    switch (type) {
+        case AggregateType::SUM:
+            return result.sum;
+        case AggregateType::AVG:
+            return result.avg_count > 0 ? result.sum / static_cast<double>(result.avg_count) : 0.0;
+        case AggregateType::COUNT:
+            return static_cast<double>(result.count);
+        case AggregateType::MIN:
+            if (result.min_str.has_value()) return result.min_str.value();
+            return result.min.value_or(0.0);
+        case AggregateType::MAX:
+            if (result.max_str.has_value()) return result.max_str.value();
+            return result.max.value_or(0.0);
+        case AggregateType::STDDEV:
+            // Of the population, as a whole collection is aggregated.
+            return result.avg_count > 0 ? std::sqrt(result.m2 / static_cast<double>(result.avg_count)) : 0.0;
+    }
+    return std::nullptr_t{};
+}
+
+std::string get_aggregate_result_key(const AggregateFunction& agg_func) {
+    std::string key;
+    switch (agg_func.type) {
+        case AggregateType::COUNT: key = "COUNT"; break;
+        case AggregateType::AVG:   key = "AVG";   break;
+        case AggregateType::SUM:   key = "SUM";   break;
+        case AggregateType::MIN:   key = "MIN";   break;
+        case AggregateType::MAX:   key = "MAX";   break;
+        case AggregateType::STDDEV: key = "STDDEV"; break;
+    }
+    key += "(";
+    if (agg_func.field_name.has_value()) {
+        key += agg_func.field_name.value();
+    } else {
+        key += "*";
+    }
+    key += ")";
+    return key;
+}
 
-    if (auto num_val_opt = get_as_numeric(*value_ptr)) {
-        double num_val = *num_val_opt;
-        switch (agg_func.type) {
-            case AggregateType::SUM:
-                result.sum += num_val;
-                break;
-            case AggregateType::AVG:
-                result.sum += num_val;
-                result.avg_count++;
-                break;
-            case AggregateType::MIN:
-                if (!result.min.has_value() || num_val < result.min.value()) {
-                    result.min = num_val;
+namespace {
+// Appends the text of a Value variant to a GROUP BY key.
+struct GroupKeyVisitor {
+    std::string& key;
+    void operator()(const std::string& s) const { key += s; }
+    void operator()(const Number& n) const {
+        // As an ostream with default flags would print it.
+        char text[32];
+        std::snprintf(text, sizeof(text), "%g", n);
+        key += text;
+    }
+    void operator()(const Boolean& b) const { key += b ? "true" : "false"; }
+    void operator()(const Date& d) const {
+        char text[32];
+        std::snprintf(text, sizeof(text), "%04d-%02d-%02d", d.year, d.month, d.day);
+        key += text;
+    }
+    void operator()(const Time& t) const {
+        char text[32];
+        std::snprintf(text, sizeof(text), "%02d:%02d:%02d", t.hour, t.minute, t.second);
+        key += text;
+    }
+    void operator()(const DateTime& dt) const {
+        key += std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(dt.time_since_epoch()).count());
+    }
+    void operator()(const TissDB::Timestamp& ts) const {
+        key += std::to_string(ts.microseconds_since_epoch_utc);
+    }
+    void operator()(const BinaryData& bd) const {
+        // Note: Grouping by binary data is tricky.
+        // A proper implementation might hash the data.
+        key += "hash:" + std::to_string(TissDB::Common::crc32c(bd.data(), bd.size()));
+    }
+    void operator()(const std::vector<TissDB::Element>&) const {
+        // Note: Grouping by a whole sub-document is also tricky.
+        // A proper implementation might serialize and hash.
+        // For now, we'll use a placeholder.
+        key += "[sub_document]";
+    }
+    void operator()(std::nullptr_t) const { key += "null"; }
+    void operator()(const std::shared_ptr<TissDB::Array>&) const { key += "[array]"; }
+    void operator()(const std::shared_ptr<TissDB::Object>&) const { key += "[object]"; }
+};
+} // anonymous namespace
+
+void append_group_key(std::string& key, const Value& value) {
+    std::visit(GroupKeyVisitor{key}, value);
+}
+
+Document project_fields(const Document& doc, const std::vector<std::variant<std::string, AggregateFunction>>& fields) {
+    Document projected_doc;
+    projected_doc.id = doc.id;
+    for (const auto& field_variant : fields) {
+        if (const auto* ident_str_ptr = std::get_if<std::string>(&field_variant)) {
+            const std::string& qualified_name = *ident_str_ptr;
+            // Check for qualified name first (e.g., "c.name")
+            bool found = false;
+            for (const auto& elem : doc.elements) {
+                if (elem.key == qualified_name) {
+                    projected_doc.elements.push_back(elem);
+                    found = true;
+                    break;
+                }
+            }
+            // If not found, try unqualified name (e.g., "name")
+            if (!found) {
+                std::string unqualified_name = qualified_name;
+                if (auto dot_pos = qualified_name.find('.'); dot_pos != std::string::npos) {
+                    unqualified_name = qualified_name.substr(dot_pos + 1);
                 }
-                break;
-            case AggregateType::MAX:
-                if (!result.max.has_value() || num_val > result.max.value()) {
-                    result.max = num_val;
+                for (const auto& elem : doc.elements) {
+                    if (elem.key == unqualified_name) {
+                        projected_doc.elements.push_back({qualified_name, elem.value});
+                        break;
+                    }
                 }
-                break;
-            default:
-                break;
+            }
         }
     }
-    else if (auto str_val_opt = get_as_string(*value_ptr)) {
-        const std::string& str_val = *str_val_opt;
-        switch (agg_func.type) {
-            case AggregateType::MIN:
-                if (!result.min_str.has_value() || str_val < result.min_str.value()) {
-                    result.min_str = str_val;
-                }
-                break;
-            case AggregateType::MAX:
-                if (!result.max_str.has_value() || str_val > result.max_str.value()) {
-                    result.max_str = str_val;
-                }
-                break;
-            default:
-                break;
+    return projected_doc;
+}
+
+Document project_aggregate_fields(const Document& doc, const std::vector<std::variant<std::string, AggregateFunction>>& fields) {
+    Document projected_doc;
+    projected_doc.id = doc.id;
+    for (const auto& field_variant : fields) {
+        std::string field_name_to_find;
+        if (const auto* ident_str = std::get_if<std::string>(&field_variant)) {
+            field_name_to_find = *ident_str;
+        } else if (const auto* agg_func = std::get_if<AggregateFunction>(&field_variant)) {
+            field_name_to_find = get_aggregate_result_key(*agg_func);
+        }
+
+        for (const auto& elem : doc.elements) {
+            if (elem.key == field_name_to_find) {
+                projected_doc.elements.push_back(elem);
+            }
         }
     }
+    return projected_doc;
 }
 
 
@@ -540,20 +336,22 @@ Document combine_documents(const Document& doc1, const std::string& alias1, cons
     return combined_doc;
 }
 
-void extract_equality_conditions(const Expression& expr, std::map<std::string, std::string>& conditions) {
-    // This function is used for potential query optimization and does not support parameters.
-    // It only extracts simple `field = 'literal'` conditions.
+void extract_equality_conditions(const Expression& expr, std::map<std::string, std::string>& conditions,
+                                 const std::vector<Literal>& params) {
     if (const auto* logical_expr_ptr = std::get_if<std::shared_ptr<LogicalExpression>>(&expr)) {
         const auto& logical_expr = *logical_expr_ptr;
         if (logical_expr->op == "AND") {
-            extract_equality_conditions(logical_expr->left, conditions);
-            extract_equality_conditions(logical_expr->right, conditions);
+            extract_equality_conditions(logical_expr->left, conditions, params);
+            extract_equality_conditions(logical_expr->right, conditions, params);
         }
     } else if (const auto* binary_expr_ptr = std::get_if<std::shared_ptr<BinaryExpression>>(&expr)) {
         const auto& binary_expr = *binary_expr_ptr;
         if (binary_expr->op == "=") {
             const auto* left_ident = std::get_if<Identifier>(&binary_expr->left);
-            const auto* right_literal = std::get_if<Literal>(&binary_expr->right);
+            const Literal* right_literal = std::get_if<Literal>(&binary_expr->right);
+            if (const auto* param = std::get_if<ParameterExpression>(&binary_expr->right)) {
+                right_literal = param->index < params.size() ? &params[param->index] : nullptr;
+            }
             if (left_ident && right_literal) {
                 if (const auto* str_lit = std::get_if<std::string>(right_literal)) {
                     conditions[left_ident->name] = *str_lit;
@@ -563,6 +361,62 @@ void extract_equality_conditions(const Expression& expr, std::map<std::string, s
     }
 }
 
+std::optional<std::vector<std::string>> find_candidate_keys(Storage::LSMTree& storage_engine, const std::string& collection,
+                                                            const Expression& where, const std::vector<Literal>& params,
+                                                            CachedAccessPath* cached_access) {
+    std::map<std::string, std::string> conditions;
+    extract_equality_conditions(where, conditions, params);
+    for (const char* id_field : {"_id", "id"}) {
+        if (auto it = conditions.find(id_field); it != conditions.end()) {
+            return std::vector<std::string>{it->second};
+        }
+    }
+    if (conditions.empty()) return std::nullopt;
+
+    AccessPath access;
+    const uint64_t catalog_version = storage_engine.catalog_version();
+    if (!cached_access || !cached_access->get(catalog_version, conditions, access)) {
+        access = choose_access_path(storage_engine.get_statistics(collection),
+                                    storage_engine.get_available_indexes(collection), conditions);
+        if (cached_access) cached_access->set(catalog_version, conditions, access);
+    }
+    if (!access.uses_index()) return std::nullopt;
+    std::vector<std::string> values;
+    for (const auto& field : access.index_fields) {
+        values.push_back(conditions.at(field));
+    }
+    return storage_engine.find_by_index(collection, access.index_fields, values);
+}
+
+namespace {
+size_t estimate_elements_memory(const std::vector<Element>& elements) {
+    size_t bytes = 0;
+    for (const auto& element : elements) {
+        bytes += sizeof(Element) + element.key.capacity();
+        if (const auto* str = std::get_if<std::string>(&element.value)) {
+            bytes += str->capacity();
+        } else if (const auto* binary = std::get_if<BinaryData>(&element.value)) {
+            bytes += binary->capacity();
+        } else if (const auto* nested = std::get_if<std::vector<Element>>(&element.value)) {
+            bytes += estimate_elements_memory(*nested);
+        }
+    }
+    return bytes;
+}
+} // anonymous namespace
+
+size_t estimate_document_memory(const Document& doc) {
+    return sizeof(Document) + doc.id.capacity() + estimate_elements_memory(doc.elements);
+}
+
+size_t estimate_documents_memory(const std::vector<Document>& docs) {
+    size_t bytes = 0;
+    for (const auto& doc : docs) {
+        bytes += estimate_document_memory(doc);
+    }
+    return bytes;
+}
+
 const Value* get_value_from_doc(const Document& doc, const std::string& key) {
     if (key == "id" || key == "_id") {
         static thread_local Value id_val;
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <map>
 #include <optional>
@@ -8,35 +9,136 @@
 #include "../common/document.h"
 
 namespace TissDB {
+namespace Storage {
+class LSMTree;
+} // namespace Storage
+
 namespace Query {
 
+class CachedAccessPath;
+
 // --- Aggregation Helper ---
 #include <cstdint>
 
+// The running state of one aggregate. Partial results over parts of the
+// same input combine with merge_aggregate.
 struct AggregateResult {
     double sum = 0;
     int64_t count = 0; // For COUNT aggregate
-    int64_t avg_count = 0; // For AVG aggregate, only counts numeric values
-    double sum_sq = 0;
+    int64_t avg_count = 0; // For AVG and STDDEV, only counts numeric values
+    double mean = 0; // STDDEV: running mean and sum of squared deviations
+    double m2 = 0;
     std::optional<double> min;
     std::optional<double> max;
     std::optional<std::string> min_str;
     std::optional<std::string> max_str;
 };
 
+// Folds a numeric or a string value of an aggregate's field into its result.
+inline void accumulate_number(AggregateResult& result, AggregateType type, double value) {
+    switch (type) {
+        case AggregateType::SUM:
+            result.sum += value;
+            break;
+        case AggregateType::AVG:
+            result.sum += value;
+            result.avg_count++;
+            break;
+        case AggregateType::MIN:
+            if (!result.min.has_value() || value < result.min.value()) {
+                result.min = value;
+            }
+            break;
+        case AggregateType::MAX:
+            if (!result.max.has_value() || value > result.max.value()) {
+                result.max = value;
+            }
+            break;
+        case AggregateType::STDDEV: {
+            // Welford's update; stable where the sum of squares is not.
+            result.avg_count++;
+            const double delta = value - result.mean;
+            result.mean += delta / static_cast<double>(result.avg_count);
+            result.m2 += delta * (value - result.mean);
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+inline void accumulate_string(AggregateResult& result, AggregateType type, std::string_view value) {
+    switch (type) {
+        case AggregateType::MIN:
+            if (!result.min_str.has_value() || value < result.min_str.value()) {
+                result.min_str = std::string(value);
+            }
+            break;
+        case AggregateType::MAX:
+            if (!result.max_str.has_value() || value > result.max_str.value()) {
+                result.max_str = std::string(value);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
 // --- Helper function declarations ---
 
 // Resolves an expression node to a final Value, using document fields and query parameters.
 Value resolve_expression_to_value(const Expression& expr, const Document& doc, const std::vector<Literal>& params);
 
 std::string like_to_regex(std::string pattern);
+// Parses the leading number of a NUL-terminated string the way std::stod
+// does, but returns false, rather than throwing, when there is none or it
+// does not fit in a double.
+bool parse_number(const char* text, double& value);
+std::optional<double> get_as_numeric(const Value& val);
+std::optional<std::string> get_as_string(const Value& val);
 bool evaluate_expression(const Expression& expr, const Document& doc, const std::vector<Literal>& params);
 Literal evaluate_update_expression(const Expression& expr, const Document& doc, const std::vector<Literal>& params);
+// The literal a resolved value is stored as by INSERT and UPDATE.
+Literal value_to_literal(const Value& value);
 void process_aggregation(std::map<std::string, AggregateResult>& results_map, const std::string& result_key, const Document& doc, const AggregateFunction& agg_func);
+// Folds one present value of an aggregate's field into its result.
+void accumulate_aggregate(AggregateResult& result, const Value& value, AggregateType type);
+// Folds the partial result `from` into `into`, as if `into` had also seen
+// the values `from` did.
+void merge_aggregate(AggregateResult& into, const AggregateResult& from);
+// The final value of an aggregate, as it appears in the result document.
+Value finalize_aggregate(const AggregateResult& result, AggregateType type);
+// The result column of an aggregate, e.g. "COUNT(*)" or "SUM(amount)".
+std::string get_aggregate_result_key(const AggregateFunction& agg_func);
+// Appends the GROUP BY key text of one value.
+void append_group_key(std::string& key, const Value& value);
+// The output document of a plain SELECT list: each named field, looked up by
+// its qualified name and then by its unqualified one.
+Document project_fields(const Document& doc, const std::vector<std::variant<std::string, AggregateFunction>>& fields);
+// The output document of an aggregate query: the group fields and aggregate
+// results named in the SELECT list, in its order.
+Document project_aggregate_fields(const Document& doc, const std::vector<std::variant<std::string, AggregateFunction>>& fields);
 Document combine_documents(const Document& doc1, const std::string& alias1, const Document& doc2, const std::string& alias2);
-void extract_equality_conditions(const Expression& expr, std::map<std::string, std::string>& conditions);
+// The `field = 'string'` conditions ANDed together in `expr`, for index
+// selection; a `field = ?` condition counts if its parameter is a string.
+void extract_equality_conditions(const Expression& expr, std::map<std::string, std::string>& conditions,
+                                 const std::vector<Literal>& params = {});
+// Documents UPDATE and DELETE write per WAL group.
+constexpr size_t WRITE_BATCH_SIZE = 1024;
+
+// Keys of the documents in `collection` that can satisfy `where`, found
+// without a scan: the key itself for `id = 'value'`, otherwise through the
+// index SELECT would choose for the equality conditions. Empty if the
+// collection has to be scanned. Callers still apply `where` to each document.
+std::optional<std::vector<std::string>> find_candidate_keys(Storage::LSMTree& storage_engine, const std::string& collection,
+                                                            const Expression& where, const std::vector<Literal>& params,
+                                                            CachedAccessPath* cached_access = nullptr);
 const Value* get_value_from_doc(const Document& doc, const std::string& key);
 std::string value_to_string(const Value& value);
 
+// Approximate heap footprint of materialized documents, for query memory accounting.
+size_t estimate_document_memory(const Document& doc);
+size_t estimate_documents_memory(const std::vector<Document>& docs);
+
 } // namespace Query
 } // namespace TissDB
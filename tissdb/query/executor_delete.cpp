@@ -1,29 +1,41 @@
 #include "executor_delete.h"
 #include "executor_common.h"
+#include "compiled_expression.h"
+#include <algorithm>
 
 namespace TissDB {
 namespace Query {
 
-QueryResult execute_delete_statement(Storage::LSMTree& storage_engine, const DeleteStatement& delete_stmt, const std::vector<Literal>& params) {
-    auto all_docs = storage_engine.scan(delete_stmt.collection_name);
-    int deleted_count = 0;
-
-    for (const auto& doc : all_docs) {
-        bool should_delete = false;
-        if (delete_stmt.where_clause) {
-            if (evaluate_expression(*delete_stmt.where_clause, doc, params)) {
-                should_delete = true;
+QueryResult execute_delete_statement(Storage::LSMTree& storage_engine, const DeleteStatement& delete_stmt,
+                                     const std::vector<Literal>& params, CachedAccessPath* cached_access) {
+    std::vector<std::string> doomed;
+    if (delete_stmt.where_clause) {
+        const CompiledExpression where = CompiledExpression::predicate(*delete_stmt.where_clause, params);
+        const auto keys = find_candidate_keys(storage_engine, delete_stmt.collection_name, *delete_stmt.where_clause,
+                                              params, cached_access);
+        if (keys) {
+            for (const auto& doc : storage_engine.get_many(delete_stmt.collection_name, *keys)) {
+                if (where.matches(doc)) doomed.push_back(doc.id);
             }
         } else {
-            should_delete = true; // No WHERE clause, delete all documents
+            for (const auto& doc : storage_engine.scan_shared(delete_stmt.collection_name)) {
+                if (where.matches(*doc)) doomed.push_back(doc->id);
+            }
         }
-
-        if (should_delete) {
-            storage_engine.del(delete_stmt.collection_name, doc.id);
-            deleted_count++;
+    } else {
+        // No WHERE clause, delete all documents
+        for (const auto& doc : storage_engine.scan_shared(delete_stmt.collection_name)) {
+            doomed.push_back(doc->id);
         }
     }
 
+    size_t deleted_count = 0;
+    for (size_t i = 0; i < doomed.size(); i += WRITE_BATCH_SIZE) {
+        const size_t end = std::min(doomed.size(), i + WRITE_BATCH_SIZE);
+        deleted_count += storage_engine.del_many(delete_stmt.collection_name,
+                                                 std::vector<std::string>(doomed.begin() + i, doomed.begin() + end));
+    }
+
     Document result_doc;
     result_doc.id = "summary";
     result_doc.elements.push_back({"deleted_count", (double)deleted_count});
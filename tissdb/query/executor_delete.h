@@ -7,7 +7,13 @@
 namespace TissDB {
 namespace Query {
 
-QueryResult execute_delete_statement(Storage::LSMTree& storage_engine, const DeleteStatement& delete_stmt, const std::vector<Literal>& params);
+class CachedAccessPath;
+
+// Deletes the matching documents in batches of WRITE_BATCH_SIZE. The WHERE
+// clause finds them by document id or through an index when it can, and
+// `cached_access`, if given, keeps the index choice between runs.
+QueryResult execute_delete_statement(Storage::LSMTree& storage_engine, const DeleteStatement& delete_stmt,
+                                     const std::vector<Literal>& params, CachedAccessPath* cached_access = nullptr);
 
 } // namespace Query
 } // namespace TissDB
@@ -1,81 +1,127 @@
 #include "executor_select.h"
 #include "executor_common.h"
+#include "column_batch.h"
+#include "compiled_expression.h"
+#include "cost_model.h"
+#include "executor_vectorized.h"
+#include "explain.h"
+#include "hash_aggregate.h"
 #include "join_algorithms.h"
-#include "../common/checksum.h"
+#include "parallel.h"
+#include "query_metrics.h"
+#include "row_stream.h"
+#include "statement_cache.h"
+#include "../common/log.h"
+#include "../common/memory_governor.h"
 #include <iostream>
-#include <sstream>
 #include <algorithm>
 #include <cmath>
 #include <chrono>
-#include <iomanip>
+#include <unordered_set>
 
 namespace TissDB {
 namespace Query {
 
-// Visitor for creating a string representation of a Value variant for group by keys.
-struct GroupKeyVisitor {
-    std::stringstream& ss;
-    void operator()(const std::string& s) const { ss << s; }
-    void operator()(const Number& n) const { ss << n; }
-    void operator()(const Boolean& b) const { ss << (b ? "true" : "false"); }
-    void operator()(const Date& d) const {
-        ss << std::setfill('0') << std::setw(4) << d.year << "-"
-           << std::setw(2) << static_cast<int>(d.month) << "-"
-           << std::setw(2) << static_cast<int>(d.day);
-    }
-    void operator()(const Time& t) const {
-        ss << std::setfill('0') << std::setw(2) << static_cast<int>(t.hour) << ":"
-           << std::setw(2) << static_cast<int>(t.minute) << ":"
-           << std::setw(2) << static_cast<int>(t.second);
-    }
-    void operator()(const DateTime& dt) const {
-        ss << std::chrono::duration_cast<std::chrono::milliseconds>(dt.time_since_epoch()).count();
-    }
-    void operator()(const TissDB::Timestamp& ts) const {
-        ss << ts.microseconds_since_epoch_utc;
-    }
-    void operator()(const BinaryData& bd) const {
-        // Note: Grouping by binary data is tricky.
-        // A proper implementation might hash the data.
-        ss << "hash:" << TissDB::Common::crc32(bd.data(), bd.size());
-    }
-    void operator()(const std::vector<TissDB::Element>& elements) const {
-        // Note: Grouping by a whole sub-document is also tricky.
-        // A proper implementation might serialize and hash.
-        // For now, we'll use a placeholder.
-        ss << "[sub_document]";
+namespace {
+
+std::string list_fields(const std::vector<std::string>& fields) {
+    std::string text;
+    for (const auto& field : fields) {
+        if (!text.empty()) text += ", ";
+        text += field;
     }
-    void operator()(std::nullptr_t) const { ss << "null"; }
-    void operator()(const std::shared_ptr<TissDB::Array>&) const { ss << "[array]"; }
-    void operator()(const std::shared_ptr<TissDB::Object>&) const { ss << "[object]"; }
-};
-
-// Helper to create a string representation for an aggregate function, e.g., "COUNT(field)" or "COUNT(*)"
-std::string get_aggregate_result_key(const AggregateFunction& agg_func) {
-    std::string key;
-    switch (agg_func.type) {
-        case AggregateType::COUNT: key = "COUNT"; break;
-        case AggregateType::AVG:   key = "AVG";   break;
-        case AggregateType::SUM:   key = "SUM";   break;
-        case AggregateType::MIN:   key = "MIN";   break;
-        case AggregateType::MAX:   key = "MAX";   break;
+    return text;
+}
+
+const char* join_type_name(JoinType type) {
+    switch (type) {
+        case JoinType::LEFT: return "left";
+        case JoinType::RIGHT: return "right";
+        case JoinType::FULL: return "full";
+        case JoinType::CROSS: return "cross";
+        default: return "inner";
     }
-    key += "(";
-    if (agg_func.field_name.has_value()) {
-        key += agg_func.field_name.value();
-    } else {
-        key += "*";
+}
+
+const char* join_algorithm_name(JoinStrategy strategy) {
+    switch (strategy) {
+        case JoinStrategy::LookupRight:
+        case JoinStrategy::LookupLeft: return "index_lookup";
+        case JoinStrategy::Hash: return "hash";
+        case JoinStrategy::SortMerge: return "sort_merge";
+        default: return "nested_loop";
     }
-    key += ")";
-    return key;
 }
 
-QueryResult execute_select_statement(Storage::LSMTree& storage_engine, const SelectStatement& select_stmt, const std::vector<Literal>& params) {
+PlanNode plan_node(std::string op, std::map<std::string, Value> details = {}) {
+    PlanNode node;
+    node.op = std::move(op);
+    node.details = std::move(details);
+    return node;
+}
+
+PlanNode aggregate_node(const SelectStatement& select_stmt) {
+    std::map<std::string, Value> details;
+    if (!select_stmt.group_by_clause.empty()) details["group_by"] = list_fields(select_stmt.group_by_clause);
+    return plan_node("HashAggregate", std::move(details));
+}
+
+// A sort with a LIMIT keeps only the best rows, in a heap.
+PlanNode sort_node(const SelectStatement& select_stmt) {
+    std::vector<std::string> keys;
+    for (const auto& [field, direction] : select_stmt.order_by_clause) keys.push_back(field + " " + direction);
+    std::map<std::string, Value> details = {{"keys", list_fields(keys)}};
+    if (select_stmt.limit_clause) details["limit"] = static_cast<double>(limit_rows(*select_stmt.limit_clause));
+    return plan_node(select_stmt.limit_clause ? "TopN" : "Sort", std::move(details));
+}
+
+PlanNode limit_node(const SelectStatement& select_stmt) {
+    return plan_node("Limit", {{"limit", static_cast<double>(limit_rows(*select_stmt.limit_clause))}});
+}
+
+// Filtering, aggregation, sorting and projection, run a batch at a time.
+PlanNode vectorized_node(const SelectStatement& select_stmt, bool aggregate, size_t workers) {
+    std::map<std::string, Value> details = {{"workers", static_cast<double>(workers)}};
+    if (select_stmt.where_clause) details["filter"] = true;
+    if (aggregate) details["aggregate"] = aggregate_node(select_stmt).to_value();
+    if (!select_stmt.order_by_clause.empty()) details["sort"] = sort_node(select_stmt).to_value();
+    if (select_stmt.limit_clause) details["limit"] = static_cast<double>(limit_rows(*select_stmt.limit_clause));
+    return plan_node("Vectorized", std::move(details));
+}
+
+size_t shared_documents_memory(const SharedDocuments& docs) {
+    size_t bytes = 0;
+    for (const auto& doc : docs) bytes += estimate_document_memory(*doc);
+    return bytes;
+}
+
+// The plan of one side of a UNION, measured against the same clock.
+std::optional<ExplainContext> union_side(const ExplainContext* explain) {
+    if (!explain) return std::nullopt;
+    std::optional<ExplainContext> side(std::in_place);
+    side->analyze = explain->analyze;
+    side->start = explain->start;
+    return side;
+}
+
+} // anonymous namespace
+
+QueryResult execute_select_statement(Storage::LSMTree& storage_engine, const SelectStatement& select_stmt,
+                                     const std::vector<Literal>& params, size_t parallelism,
+                                     CachedAccessPath* cached_access, ExplainContext* explain) {
+    // Only EXPLAIN ANALYZE runs the statement it explains.
+    const bool analyze = explain && explain->analyze;
+    const bool plan_only = explain && !explain->analyze;
+
     // --- UNION Operation ---
     if (select_stmt.union_clause) {
         // Recursively execute the left and right select statements
-        auto left_result = execute_select_statement(storage_engine, *select_stmt.union_clause->left_select, params);
-        auto right_result = execute_select_statement(storage_engine, *select_stmt.union_clause->right_select, params);
+        auto left_explain = union_side(explain);
+        auto right_explain = union_side(explain);
+        auto left_result = execute_select_statement(storage_engine, *select_stmt.union_clause->left_select, params, parallelism,
+                                                    nullptr, left_explain ? &*left_explain : nullptr);
+        auto right_result = execute_select_statement(storage_engine, *select_stmt.union_clause->right_select, params, parallelism,
+                                                     nullptr, right_explain ? &*right_explain : nullptr);
 
         // Combine the results
         std::vector<Document> combined_docs = left_result;
@@ -94,403 +140,458 @@ QueryResult execute_select_statement(Storage::LSMTree& storage_engine, const Sel
             combined_docs.erase(std::unique(combined_docs.begin(), combined_docs.end()), combined_docs.end());
         }
 
+        if (explain) {
+            PlanNode node = plan_node("Union", {{"all", select_stmt.union_clause->all}});
+            node.children = {std::move(left_explain->plan), std::move(right_explain->plan)};
+            if (analyze) explain->measure(node, combined_docs.size(), estimate_documents_memory(combined_docs), 0);
+            explain->push(std::move(node));
+        }
         return {combined_docs};
     }
 
     std::vector<Document> result_docs;
     std::vector<std::string> doc_ids_from_index;
     bool index_used = false;
+    // Time spent choosing how to run the statement, not running it.
+    static Common::Histogram& plan_latency = Common::Metrics::instance().histogram(
+        "tissdb_query_seconds", QUERY_SECONDS_HELP, "stage=\"plan\",statement=\"select\"");
+    auto plan_start = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::duration plan_time{0};
 
     // --- Index Selection Logic ---
+    // Statistics are copied out only if a plan needs them.
+    std::optional<Storage::CollectionStatistics> from_stats;
+    auto from_statistics = [&]() -> const Storage::CollectionStatistics& {
+        if (!from_stats) from_stats = storage_engine.get_statistics(select_stmt.from_collection);
+        return *from_stats;
+    };
+    AccessPath access;
     if (select_stmt.where_clause) {
         std::map<std::string, std::string> conditions;
-        extract_equality_conditions(*select_stmt.where_clause, conditions);
+        extract_equality_conditions(*select_stmt.where_clause, conditions, params);
 
         if (!conditions.empty()) {
-            auto available_indexes = storage_engine.get_available_indexes(select_stmt.from_collection);
-            std::vector<std::string> best_index_fields;
-            for (const auto& index_fields : available_indexes) {
-                bool all_fields_present = true;
-                for (const auto& field : index_fields) {
-                    if (conditions.find(field) == conditions.end()) {
-                        all_fields_present = false;
-                        break;
-                    }
-                }
-                if (all_fields_present && index_fields.size() > best_index_fields.size()) {
-                    best_index_fields = index_fields;
-                }
+            const uint64_t catalog_version = storage_engine.catalog_version();
+            if (!cached_access || !cached_access->get(catalog_version, conditions, access)) {
+                auto available_indexes = storage_engine.get_available_indexes(select_stmt.from_collection);
+                access = choose_access_path(from_statistics(), available_indexes, conditions);
+                if (cached_access) cached_access->set(catalog_version, conditions, access);
             }
-
-            if (!best_index_fields.empty()) {
+            plan_time += std::chrono::steady_clock::now() - plan_start;
+            plan_start = {}; // Paused while the index is read
+            if (access.uses_index()) {
                 std::vector<std::string> values;
-                for (const auto& field : best_index_fields) {
+                for (const auto& field : access.index_fields) {
                     values.push_back(conditions.at(field));
                 }
-                doc_ids_from_index = storage_engine.find_by_index(select_stmt.from_collection, best_index_fields, values);
+                if (!plan_only) {
+                    doc_ids_from_index = storage_engine.find_by_index(select_stmt.from_collection, access.index_fields, values);
+                }
                 index_used = true;
-                std::cout << "Using compound index for query." << std::endl;
+                LOG_DEBUG("Using compound index for query.");
             }
         }
     }
+    // Rows the left side starts with; estimated if the index was not read.
+    const double index_rows = plan_only ? access.estimated_rows : static_cast<double>(doc_ids_from_index.size());
+    PlanNode access_node;
+    if (explain) {
+        if (index_used) {
+            access_node = plan_node("IndexScan", {{"collection", select_stmt.from_collection},
+                                                  {"index", list_fields(access.index_fields)}});
+            access_node.estimated_rows = access.estimated_rows;
+        } else {
+            access_node = plan_node("Scan", {{"collection", select_stmt.from_collection}});
+            access_node.estimated_rows = static_cast<double>(from_statistics().row_count());
+        }
+    }
+
+    // --- Join planning ---
+    // Decided before reading the left side, which may then not need a scan.
+    if (plan_start == std::chrono::steady_clock::time_point()) plan_start = std::chrono::steady_clock::now();
+    std::string left_key, right_key;
+    JoinStrategy join_strategy = JoinStrategy::ScanRight;
+    auto get_unqualified = [](const std::string& s) {
+        if (auto dot_pos = s.find('.'); dot_pos != std::string::npos) {
+            return s.substr(dot_pos + 1);
+        }
+        return s;
+    };
+    auto get_qualifier = [](const std::string& s) {
+        auto dot_pos = s.find('.');
+        return dot_pos == std::string::npos ? std::string() : s.substr(0, dot_pos);
+    };
+    if (select_stmt.join_clause && select_stmt.join_clause->type != JoinType::CROSS) {
+        const auto& join_clause = select_stmt.join_clause.value();
+        const auto* on_cond = std::get_if<std::shared_ptr<BinaryExpression>>(&join_clause.on_condition);
+        if (on_cond && (*on_cond)->op == "=") {
+            if (const auto* left_ident = std::get_if<Identifier>(&(*on_cond)->left)) {
+                left_key = left_ident->name;
+            }
+            if (const auto* right_ident = std::get_if<Identifier>(&(*on_cond)->right)) {
+                right_key = right_ident->name;
+            }
+            // `ON b.x = a.y` names the right collection's field first.
+            if (select_stmt.from_alias != join_clause.join_alias &&
+                get_qualifier(left_key) == join_clause.join_alias &&
+                get_qualifier(right_key) == select_stmt.from_alias) {
+                std::swap(left_key, right_key);
+            }
+        }
+        if (!left_key.empty() && !right_key.empty()) {
+            const Storage::CollectionStatistics right_stats = storage_engine.get_statistics(join_clause.collection_name);
+            JoinInputs inputs;
+            inputs.left_rows = index_used ? index_rows : static_cast<double>(from_statistics().row_count());
+            inputs.left_stats = &from_statistics();
+            inputs.right_stats = &right_stats;
+            inputs.left_key = get_unqualified(left_key);
+            inputs.right_key = get_unqualified(right_key);
+            inputs.left_indexed = storage_engine.has_index(select_stmt.from_collection, {inputs.left_key});
+            inputs.right_indexed = storage_engine.has_index(join_clause.collection_name, {inputs.right_key});
+            inputs.left_is_full_scan = !index_used;
+            inputs.inner = join_clause.type == JoinType::INNER;
+            // Scans return documents in key order.
+            inputs.left_sorted = !index_used && inputs.left_key == "_id";
+            inputs.right_sorted = inputs.right_key == "_id";
+            inputs.memory_rows = static_cast<double>(join_memory_limit()) / ESTIMATED_DOCUMENT_BYTES;
+            join_strategy = choose_join_strategy(inputs);
+        }
+    }
+    const bool drive_from_right = join_strategy == JoinStrategy::LookupLeft;
+    plan_time += std::chrono::steady_clock::now() - plan_start;
+    plan_latency.record(plan_time);
+
+    bool has_aggregate = std::any_of(select_stmt.fields.begin(), select_stmt.fields.end(),
+                                     [](const auto& field){ return std::holds_alternative<AggregateFunction>(field); });
+    const bool aggregating = has_aggregate || !select_stmt.group_by_clause.empty();
+    const bool select_all = !select_stmt.fields.empty() && std::holds_alternative<std::string>(select_stmt.fields[0]) &&
+                            std::get<std::string>(select_stmt.fields[0]) == "*";
+
+    // The join's inputs and the join itself, as EXPLAIN reports them.
+    PlanNode right_node;
+    if (explain && select_stmt.join_clause) {
+        const auto& join_clause = *select_stmt.join_clause;
+        if (drive_from_right) {
+            access_node = plan_node("IndexLookup", {{"collection", select_stmt.from_collection},
+                                                    {"index", get_unqualified(left_key)}});
+        }
+        if (join_strategy == JoinStrategy::LookupRight && join_clause.type != JoinType::CROSS) {
+            right_node = plan_node("IndexLookup", {{"collection", join_clause.collection_name},
+                                                   {"index", get_unqualified(right_key)}});
+        } else {
+            right_node = plan_node("Scan", {{"collection", join_clause.collection_name}});
+            right_node.estimated_rows = static_cast<double>(storage_engine.get_statistics(join_clause.collection_name).row_count());
+        }
+    }
+    auto join_node = [&]() {
+        const auto& join_clause = *select_stmt.join_clause;
+        PlanNode node = plan_node("Join", {{"type", join_type_name(join_clause.type)},
+                                           {"algorithm", join_clause.type == JoinType::CROSS ? "nested_loop" : join_algorithm_name(join_strategy)}});
+        if (!left_key.empty() && !right_key.empty()) node.details["on"] = left_key + " = " + right_key;
+        node.children = {std::move(access_node), std::move(right_node)};
+        return node;
+    };
+    // After the rows are read (and joined, and filtered if the scan did not):
+    // aggregation, sorting, the LIMIT and projection.
+    auto plan_tail = [&]() {
+        if (aggregating) explain->push(aggregate_node(select_stmt));
+        if (!select_stmt.order_by_clause.empty()) explain->push(sort_node(select_stmt));
+        else if (select_stmt.limit_clause) explain->push(limit_node(select_stmt));
+        if (!select_all) explain->push(plan_node("Project"));
+    };
+
+    if (plan_only) {
+        // EXPLAIN: the operators the statement would run, without running them.
+        if (select_stmt.join_clause) {
+            explain->push(join_node());
+            if (select_stmt.where_clause) explain->push(plan_node("Filter"));
+            plan_tail();
+            return {};
+        }
+        const double rows = *access_node.estimated_rows;
+        const bool streamable = !aggregating && select_stmt.order_by_clause.empty();
+        const size_t workers = parallel_task_count(static_cast<size_t>(rows), parallelism);
+        explain->push(std::move(access_node));
+        if ((!streamable || (!select_stmt.limit_clause && workers > 1)) && vectorized_execution_enabled() &&
+            can_execute_vectorized(select_stmt, static_cast<size_t>(rows))) {
+            explain->push(vectorized_node(select_stmt, aggregating, workers));
+            return {};
+        }
+        if (select_stmt.where_clause) explain->push(plan_node("Filter"));
+        plan_tail();
+        return {};
+    }
 
     // --- Data retrieval ---
     std::vector<Document> all_docs;
-    if (index_used) {
-        for (const auto& doc_id : doc_ids_from_index) {
-            auto doc = storage_engine.get(select_stmt.from_collection, doc_id);
-            if (doc) {
-                all_docs.push_back(**doc);
+    SharedDocuments left_docs; // The left side of a join
+    // Whether `all_docs` only holds documents that satisfy the WHERE clause.
+    bool filtered = false;
+    // Held until the statement returns; throws if the budget cannot cover it.
+    Common::MemoryReservation working_memory;
+    if (drive_from_right) {
+        // The join reads the left documents it needs through the index.
+    } else if (!select_stmt.join_clause) {
+        // Without a join, the collection's documents are shared with the
+        // storage engine rather than copied, and the WHERE clause is applied
+        // to them in place: only the documents in the result are copied.
+        std::vector<std::shared_ptr<const Document>> scanned;
+        std::vector<Document> index_docs;
+        DocumentRows rows;
+        if (index_used) {
+            index_docs = storage_engine.get_many(select_stmt.from_collection, doc_ids_from_index);
+            working_memory.grow(estimate_documents_memory(index_docs));
+            for (const auto& doc : index_docs) rows.push_back(&doc);
+        } else {
+            LOG_DEBUG("No suitable index found. Performing full collection scan.");
+            scanned = storage_engine.scan_shared(select_stmt.from_collection);
+            for (const auto& doc : scanned) rows.push_back(doc.get());
+        }
+
+        const bool streamable = !aggregating && select_stmt.order_by_clause.empty();
+        // A stream stops at the LIMIT, but runs on one thread: without a
+        // LIMIT, a scan that can be split is filtered and projected in parallel.
+        const bool parallel = !select_stmt.limit_clause && parallel_task_count(rows.size(), parallelism) > 1;
+        if ((!streamable || parallel) && vectorized_execution_enabled() && can_execute_vectorized(select_stmt, rows.size())) {
+            if (analyze) {
+                size_t bytes = 0;
+                for (const Document* doc : rows) bytes += estimate_document_memory(*doc);
+                explain->measure(access_node, rows.size(), bytes, working_memory.size());
+                explain->push(std::move(access_node));
+            }
+            QueryResult result = execute_select_vectorized(select_stmt, rows, params, parallelism);
+            if (analyze) {
+                PlanNode node = vectorized_node(select_stmt, aggregating, parallel_task_count(rows.size(), parallelism));
+                explain->measure(node, result.size(), estimate_documents_memory(result), working_memory.size());
+                explain->push(std::move(node));
             }
+            return result;
+        }
+
+        ScanStream scan(rows);
+        RowStream* stream = &scan;
+        // EXPLAIN ANALYZE counts the rows passed from each operator to the next.
+        std::vector<std::pair<PlanNode, std::unique_ptr<ProfileStream>>> profiled;
+        auto profile = [&](PlanNode node) {
+            if (!analyze) return;
+            profiled.emplace_back(std::move(node), std::make_unique<ProfileStream>(*stream, *explain));
+            stream = profiled.back().second.get();
+        };
+        auto finish_profile = [&]() {
+            for (auto& [node, counter] : profiled) {
+                counter->measure(node, working_memory.size());
+                explain->push(std::move(node));
+            }
+        };
+        profile(std::move(access_node));
+        std::optional<FilterStream> filter;
+        if (select_stmt.where_clause) {
+            stream = &filter.emplace(*stream, CompiledExpression::predicate(*select_stmt.where_clause, params));
+            profile(plan_node("Filter"));
+        }
+        if (streamable) {
+            // Nothing needs every row at once: stream them to the result, and
+            // stop scanning once the LIMIT is reached.
+            std::optional<LimitStream> limit;
+            if (select_stmt.limit_clause) {
+                stream = &limit.emplace(*stream, limit_rows(*select_stmt.limit_clause));
+                profile(limit_node(select_stmt));
+            }
+            ProjectStream project(*stream, select_stmt.fields);
+            stream = &project;
+            if (!select_all) profile(plan_node("Project"));
+            QueryResult result = drain(*stream);
+            working_memory.grow(estimate_documents_memory(result));
+            finish_profile();
+            return result;
+        }
+        all_docs = drain(*stream);
+        filtered = true;
+        finish_profile();
+    } else if (index_used) {
+        std::vector<Document> index_docs = storage_engine.get_many(select_stmt.from_collection, doc_ids_from_index);
+        working_memory.grow(estimate_documents_memory(index_docs));
+        for (auto& doc : index_docs) {
+            left_docs.push_back(std::make_shared<const Document>(std::move(doc)));
         }
     } else {
-        std::cout << "No suitable index found. Performing full collection scan." << std::endl;
-        all_docs = storage_engine.scan(select_stmt.from_collection);
+        LOG_DEBUG("No suitable index found. Performing full collection scan.");
+        left_docs = storage_engine.scan_shared(select_stmt.from_collection);
+    }
+    if (analyze && select_stmt.join_clause && !drive_from_right) {
+        explain->measure(access_node, left_docs.size(), shared_documents_memory(left_docs), working_memory.size());
     }
 
     // --- Join Operation ---
     if (select_stmt.join_clause) {
         const auto& join_clause = select_stmt.join_clause.value();
+        const auto on_condition = CompiledExpression::predicate(join_clause.on_condition, params);
+        JoinSpec spec;
+        spec.type = join_clause.type;
+        spec.left_alias = select_stmt.from_alias;
+        spec.right_alias = join_clause.join_alias;
+        spec.left_key = get_unqualified(left_key);
+        spec.right_key = get_unqualified(right_key);
+        spec.on_condition = &on_condition;
+        const bool keep_left = join_clause.type == JoinType::LEFT || join_clause.type == JoinType::FULL;
+        const bool keep_right = join_clause.type == JoinType::RIGHT || join_clause.type == JoinType::FULL;
         std::vector<Document> joined_docs;
+        // Documents read through an index, for EXPLAIN ANALYZE.
+        size_t lookup_rows = 0;
+        size_t lookup_bytes = 0;
 
         if (join_clause.type == JoinType::CROSS) {
-            std::vector<Document> right_docs = storage_engine.scan(join_clause.collection_name);
-            for (const auto& left_doc : all_docs) {
+            const SharedDocuments right_docs = storage_engine.scan_shared(join_clause.collection_name);
+            if (analyze) explain->measure(right_node, right_docs.size(), shared_documents_memory(right_docs), working_memory.size());
+            for (const auto& left_doc : left_docs) {
                 for (const auto& right_doc : right_docs) {
-                    joined_docs.push_back(combine_documents(left_doc, select_stmt.from_alias, right_doc, join_clause.join_alias));
+                    joined_docs.push_back(combine_documents(*left_doc, select_stmt.from_alias, *right_doc, join_clause.join_alias));
                 }
             }
-        } else {
-            // Improved join logic with index lookup
-            const auto* on_cond = std::get_if<std::shared_ptr<BinaryExpression>>(&join_clause.on_condition);
-            std::string left_key, right_key;
-
-            if (on_cond && (*on_cond)->op == "=") {
-                if (const auto* left_ident = std::get_if<Identifier>(&(*on_cond)->left)) {
-                    left_key = left_ident->name;
-                }
-                if (const auto* right_ident = std::get_if<Identifier>(&(*on_cond)->right)) {
-                    right_key = right_ident->name;
+        } else if (drive_from_right) {
+            LOG_DEBUG("Join strategy: " << to_string(join_strategy));
+            const SharedDocuments right_docs = storage_engine.scan_shared(join_clause.collection_name);
+            if (analyze) explain->measure(right_node, right_docs.size(), shared_documents_memory(right_docs), working_memory.size());
+            for (const auto& right_doc : right_docs) {
+                const auto* right_val_ptr = get_value_from_doc(*right_doc, spec.right_key);
+                if (!right_val_ptr) continue;
+                auto doc_ids = storage_engine.find_by_index(select_stmt.from_collection, {spec.left_key}, {value_to_string(*right_val_ptr)});
+                for (const auto& left_doc : storage_engine.get_many(select_stmt.from_collection, doc_ids)) {
+                    lookup_rows++;
+                    if (analyze) lookup_bytes += estimate_document_memory(left_doc);
+                    Document combined = combine_documents(left_doc, select_stmt.from_alias, *right_doc, join_clause.join_alias);
+                    if (on_condition.matches(combined)) {
+                        joined_docs.push_back(std::move(combined));
+                    }
                 }
             }
-
-            auto get_unqualified = [](const std::string& s) {
-                if (auto dot_pos = s.find('.'); dot_pos != std::string::npos) {
-                    return s.substr(dot_pos + 1);
-                }
-                return s;
-            };
-
-            std::string unqualified_right_key = get_unqualified(right_key);
-            bool can_use_index = !left_key.empty() && !right_key.empty() && storage_engine.has_index(join_clause.collection_name, {unqualified_right_key});
-
-            for (const auto& left_doc : all_docs) {
+            if (analyze) explain->measure(access_node, lookup_rows, lookup_bytes, working_memory.size());
+        } else if (join_strategy == JoinStrategy::LookupRight) {
+            LOG_DEBUG("Join strategy: " << to_string(join_strategy));
+            std::unordered_set<std::string> matched_right;
+            for (const auto& left_doc : left_docs) {
                 bool left_doc_matched = false;
-                std::vector<Document> right_docs_to_join;
-
-                if (can_use_index) {
-                    const auto* left_val_ptr = get_value_from_doc(left_doc, get_unqualified(left_key));
-                    if (left_val_ptr) {
-                        std::string val_str = value_to_string(*left_val_ptr);
-                        auto doc_ids = storage_engine.find_by_index(join_clause.collection_name, {unqualified_right_key}, {val_str});
-                        right_docs_to_join = storage_engine.get_many(join_clause.collection_name, doc_ids);
-                    }
-                } else {
-                    right_docs_to_join = storage_engine.scan(join_clause.collection_name);
+                std::vector<Document> looked_up;
+                if (const auto* left_val_ptr = get_value_from_doc(*left_doc, spec.left_key)) {
+                    auto doc_ids = storage_engine.find_by_index(join_clause.collection_name, {spec.right_key}, {value_to_string(*left_val_ptr)});
+                    looked_up = storage_engine.get_many(join_clause.collection_name, doc_ids);
+                    lookup_rows += looked_up.size();
+                    if (analyze) lookup_bytes += estimate_documents_memory(looked_up);
                 }
-
-                for (const auto& right_doc : right_docs_to_join) {
-                    if (evaluate_expression(join_clause.on_condition, combine_documents(left_doc, select_stmt.from_alias, right_doc, join_clause.join_alias), params)) {
-                        joined_docs.push_back(combine_documents(left_doc, select_stmt.from_alias, right_doc, join_clause.join_alias));
+                for (const auto& right_doc : looked_up) {
+                    Document combined = combine_documents(*left_doc, select_stmt.from_alias, right_doc, join_clause.join_alias);
+                    if (on_condition.matches(combined)) {
+                        joined_docs.push_back(std::move(combined));
                         left_doc_matched = true;
+                        if (keep_right) matched_right.insert(right_doc.id);
                     }
                 }
-
-                if (!left_doc_matched && (join_clause.type == JoinType::LEFT || join_clause.type == JoinType::FULL)) {
-                    joined_docs.push_back(left_doc);
+                if (!left_doc_matched && keep_left) {
+                    joined_docs.push_back(outer_join_row(*left_doc, select_stmt.from_alias));
                 }
             }
-
-            if (join_clause.type == JoinType::RIGHT || join_clause.type == JoinType::FULL) {
-                std::vector<Document> right_docs = storage_engine.scan(join_clause.collection_name);
-                for (const auto& right_doc : right_docs) {
-                    bool right_doc_matched = false;
-                    for (const auto& left_doc : all_docs) {
-                        if (evaluate_expression(join_clause.on_condition, combine_documents(left_doc, select_stmt.from_alias, right_doc, join_clause.join_alias), params)) {
-                            right_doc_matched = true;
-                            break;
-                        }
-                    }
-                    if (!right_doc_matched) {
-                        joined_docs.push_back(right_doc);
+            if (keep_right) {
+                for (const auto& right_doc : storage_engine.scan_shared(join_clause.collection_name)) {
+                    if (!matched_right.count(right_doc->id)) {
+                        joined_docs.push_back(outer_join_row(*right_doc, join_clause.join_alias));
                     }
                 }
             }
+            if (analyze) explain->measure(right_node, lookup_rows, lookup_bytes, working_memory.size());
+        } else {
+            LOG_DEBUG("Join strategy: " << to_string(join_strategy));
+            SharedDocuments right_docs = storage_engine.scan_shared(join_clause.collection_name);
+            if (analyze) explain->measure(right_node, right_docs.size(), shared_documents_memory(right_docs), working_memory.size());
+            switch (join_strategy) {
+                case JoinStrategy::Hash:
+                    joined_docs = JoinAlgorithms::hashJoin(std::move(left_docs), std::move(right_docs), spec, join_memory_limit());
+                    break;
+                case JoinStrategy::SortMerge:
+                    joined_docs = JoinAlgorithms::sortMergeJoin(left_docs, right_docs, spec);
+                    break;
+                default: // No equality key, or statistics favour testing every pair
+                    joined_docs = JoinAlgorithms::nestedLoopJoin(left_docs, right_docs, spec);
+                    break;
+            }
         }
-        all_docs = joined_docs;
+        const size_t joined_bytes = estimate_documents_memory(joined_docs);
+        working_memory.grow(joined_bytes);
+        if (analyze) {
+            PlanNode node = join_node();
+            explain->measure(node, joined_docs.size(), joined_bytes, working_memory.size());
+            explain->push(std::move(node));
+        }
+        all_docs = std::move(joined_docs);
     }
 
+    // EXPLAIN ANALYZE: each remaining operator, once it has produced its rows.
+    auto record = [&](PlanNode node, const std::vector<Document>& output) {
+        if (!analyze) return;
+        explain->measure(node, output.size(), estimate_documents_memory(output), working_memory.size());
+        explain->push(std::move(node));
+    };
+
     // --- Filtering ---
-    if (select_stmt.where_clause) {
+    if (select_stmt.where_clause && !filtered) {
         std::vector<Document> filtered_docs;
-        // Always filter the documents if a WHERE clause exists.
-        // `all_docs` contains either the full scan or the index results,
+        // Unless the scan already applied it, filter by the WHERE clause.
+        // `all_docs` contains either the joined rows or the index results,
         // both of which need to be filtered by the full WHERE clause.
+        const auto where = CompiledExpression::predicate(*select_stmt.where_clause, params);
         for (const auto& doc : all_docs) {
-            if (evaluate_expression(*select_stmt.where_clause, doc, params)) {
+            if (where.matches(doc)) {
                 filtered_docs.push_back(doc);
             }
         }
         result_docs = filtered_docs;
+        record(plan_node("Filter"), result_docs);
     } else {
         // No WHERE clause, so all retrieved documents are the result.
         result_docs = all_docs;
     }
 
     // --- Aggregation and Grouping ---
-    bool has_aggregate = std::any_of(select_stmt.fields.begin(), select_stmt.fields.end(),
-                                     [](const auto& field){ return std::holds_alternative<AggregateFunction>(field); });
-
-    if (has_aggregate || !select_stmt.group_by_clause.empty()) {
-        std::vector<Document> aggregated_docs;
-        // --- GROUP BY flow ---
-        if (!select_stmt.group_by_clause.empty()) {
-            std::map<std::string, std::vector<Document>> grouped_docs;
-            for (const auto& doc : result_docs) { // Use result_docs which contains the filtered set
-                std::stringstream group_key_ss;
-                for (size_t i = 0; i < select_stmt.group_by_clause.size(); ++i) {
-                    const auto& field_name = select_stmt.group_by_clause[i];
-                    const auto* val_ptr = get_value_from_doc(doc, field_name);
-                    if (val_ptr) {
-                        std::visit(GroupKeyVisitor{group_key_ss}, *val_ptr);
-                    } else {
-                        group_key_ss << "NULL";
-                    }
-                    if (i < select_stmt.group_by_clause.size() - 1) {
-                        group_key_ss << "::";
-                    }
-                }
-                grouped_docs[group_key_ss.str()].push_back(doc);
-            }
-
-            for (auto const& [group_key, docs] : grouped_docs) {
-                Document aggregated_doc;
-                aggregated_doc.id = group_key;
-                std::map<std::string, AggregateResult> group_results;
-
-                // Add the group by fields to the result doc from the first doc in the group
-                if (!docs.empty()) {
-                    const auto& first_doc = docs.front();
-                    for (const auto& field_name : select_stmt.group_by_clause) {
-                        if (const auto* val_ptr = get_value_from_doc(first_doc, field_name)) {
-                            aggregated_doc.elements.push_back({field_name, *val_ptr});
-                        }
-                    }
-                }
-
-                // Process aggregations for the group
-                for (const auto& field : select_stmt.fields) {
-                    if (auto* agg_func = std::get_if<AggregateFunction>(&field)) {
-                        std::string result_key = get_aggregate_result_key(*agg_func);
-                        for (const auto& doc : docs) {
-                            process_aggregation(group_results, result_key, doc, *agg_func);
-                        }
-                    }
-                }
-
-                // Finalize and add results to the aggregated doc
-                for (const auto& field : select_stmt.fields) {
-                    if (auto* agg_func = std::get_if<AggregateFunction>(&field)) {
-                        std::string result_key = get_aggregate_result_key(*agg_func);
-                        const auto& result = group_results.at(result_key);
-                        switch(agg_func->type) {
-                            case AggregateType::SUM:
-                                aggregated_doc.elements.push_back({result_key, result.sum});
-                                break;
-                            case AggregateType::AVG:
-                                aggregated_doc.elements.push_back({result_key, result.avg_count > 0 ? result.sum / static_cast<double>(result.avg_count) : 0.0});
-                                break;
-                            case AggregateType::COUNT:
-                                aggregated_doc.elements.push_back({result_key, static_cast<double>(result.count)});
-                                break;
-                            case AggregateType::MIN:
-                                if (result.min_str.has_value()) {
-                                    aggregated_doc.elements.push_back({result_key, result.min_str.value()});
-                                } else {
-                                    aggregated_doc.elements.push_back({result_key, result.min.value_or(0.0)});
-                                }
-                                break;
-                            case AggregateType::MAX:
-                                if (result.max_str.has_value()) {
-                                    aggregated_doc.elements.push_back({result_key, result.max_str.value()});
-                                } else {
-                                    aggregated_doc.elements.push_back({result_key, result.max.value_or(0.0)});
-                                }
-                                break;
-                        }
-                    }
-                }
-                aggregated_docs.push_back(aggregated_doc);
-            }
-        } else { // --- Aggregation without GROUP BY ---
-            Document aggregated_doc;
-            aggregated_doc.id = "aggregate";
-            std::map<std::string, AggregateResult> group_results;
-
-            // First, initialize all aggregate functions in the map
-            for (const auto& field : select_stmt.fields) {
-                if (const auto* agg_func = std::get_if<AggregateFunction>(&field)) {
-                    std::string result_key = get_aggregate_result_key(*agg_func);
-                    group_results[result_key] = AggregateResult{}; // Default initialization
-                }
-            }
-            // Then, process the documents
-            for (const auto& doc : result_docs) { // Use result_docs which is the filtered set
-                for (const auto& field : select_stmt.fields) {
-                    if (const auto* agg_func = std::get_if<AggregateFunction>(&field)) {
-                        std::string result_key = get_aggregate_result_key(*agg_func);
-                        process_aggregation(group_results, result_key, doc, *agg_func);
-                    }
-                }
-            }
-             for (const auto& field : select_stmt.fields) {
-                if (auto* agg_func = std::get_if<AggregateFunction>(&field)) {
-                    std::string result_key = get_aggregate_result_key(*agg_func);
-                    const auto& result = group_results.at(result_key);
-                     switch(agg_func->type) {
-                        case AggregateType::SUM:
-                            aggregated_doc.elements.push_back({result_key, result.sum});
-                            break;
-                        case AggregateType::AVG:
-                            aggregated_doc.elements.push_back({result_key, result.avg_count > 0 ? result.sum / static_cast<double>(result.avg_count) : 0.0});
-                            break;
-                        case AggregateType::COUNT:
-                            aggregated_doc.elements.push_back({result_key, static_cast<double>(result.count)});
-                            break;
-                        case AggregateType::MIN:
-                            if (result.min_str.has_value()) {
-                                aggregated_doc.elements.push_back({result_key, result.min_str.value()});
-                            } else {
-                                aggregated_doc.elements.push_back({result_key, result.min.value_or(0.0)});
-                            }
-                            break;
-                        case AggregateType::MAX:
-                            if (result.max_str.has_value()) {
-                                aggregated_doc.elements.push_back({result_key, result.max_str.value()});
-                            } else {
-                                aggregated_doc.elements.push_back({result_key, result.max.value_or(0.0)});
-                            }
-                            break;
-                    }
-                }
-            }
-            aggregated_docs.push_back(aggregated_doc);
+    if (aggregating) {
+        HashAggregator aggregator(select_stmt);
+        for (const auto& doc : result_docs) { // Use result_docs which contains the filtered set
+            aggregator.add(doc);
         }
-        result_docs = aggregated_docs;
+        result_docs = aggregator.finish();
+        record(aggregate_node(select_stmt), result_docs);
     }
 
     // --- Sorting ---
     if (!select_stmt.order_by_clause.empty()) {
-        std::sort(result_docs.begin(), result_docs.end(), [&](const Document& a, const Document& b) {
-            for (const auto& order_by_pair : select_stmt.order_by_clause) {
-                const std::string& field_name = order_by_pair.first;
-                const std::string& sort_order = order_by_pair.second;
-
-                const Value* val_a_ptr = get_value_from_doc(a, field_name);
-                const Value* val_b_ptr = get_value_from_doc(b, field_name);
-
-                if (!val_a_ptr || !val_b_ptr) {
-                    // Handle missing fields by treating them as equal for this level of sorting
-                    continue;
-                }
-
-                const auto& val_a = *val_a_ptr;
-                const auto& val_b = *val_b_ptr;
-
-                bool is_asc = (sort_order != "DESC");
-
-                // If types are different, they are considered "equal" for sorting purposes
-                if (val_a.index() != val_b.index()) {
-                    continue;
-                }
-
-                if (const auto* val_a_str = std::get_if<std::string>(&val_a)) {
-                    int cmp = val_a_str->compare(std::get<std::string>(val_b));
-                    if (cmp != 0) return is_asc ? cmp < 0 : cmp > 0;
-                } else if (const auto* val_a_num = std::get_if<double>(&val_a)) {
-                    double diff = *val_a_num - std::get<double>(val_b);
-                    if (diff != 0) return is_asc ? diff < 0 : diff > 0;
-                }
-            }
-            return false; // Equal
-        });
+        std::vector<uint32_t> order(result_docs.size());
+        for (size_t i = 0; i < order.size(); ++i) order[i] = static_cast<uint32_t>(i);
+        sort_rows(result_docs, order, select_stmt.order_by_clause,
+                  select_stmt.limit_clause ? limit_rows(*select_stmt.limit_clause) : SIZE_MAX, parallelism);
+        std::vector<Document> sorted_docs;
+        sorted_docs.reserve(order.size());
+        for (uint32_t i : order) sorted_docs.push_back(std::move(result_docs[i]));
+        result_docs = std::move(sorted_docs);
+        apply_limit(result_docs, select_stmt.limit_clause);
+        record(sort_node(select_stmt), result_docs);
+    } else if (select_stmt.limit_clause) {
+        apply_limit(result_docs, select_stmt.limit_clause);
+        record(limit_node(select_stmt), result_docs);
     }
 
     // --- Projection ---
-    bool select_all = !select_stmt.fields.empty() && std::holds_alternative<std::string>(select_stmt.fields[0]) && std::get<std::string>(select_stmt.fields[0]) == "*";
-
     if (select_all) {
         return {result_docs};
     }
 
-    if (has_aggregate || !select_stmt.group_by_clause.empty()) {
-        std::vector<Document> projected_docs;
-        for (const auto& doc : result_docs) {
-            Document projected_doc;
-            projected_doc.id = doc.id;
-            for (const auto& field_variant : select_stmt.fields) {
-                std::string field_name_to_find;
-                if (const auto* ident_str = std::get_if<std::string>(&field_variant)) {
-                    field_name_to_find = *ident_str;
-                } else if (const auto* agg_func = std::get_if<AggregateFunction>(&field_variant)) {
-                    field_name_to_find = get_aggregate_result_key(*agg_func);
-                }
-
-                for (const auto& elem : doc.elements) {
-                    if (elem.key == field_name_to_find) {
-                        projected_doc.elements.push_back(elem);
-                    }
-                }
-            }
-            projected_docs.push_back(projected_doc);
-        }
-        return {projected_docs};
-    } else {
-        std::vector<Document> projected_docs;
-        for (const auto& doc : result_docs) {
-            Document projected_doc;
-            projected_doc.id = doc.id;
-            for (const auto& field_variant : select_stmt.fields) {
-                 if (const auto* ident_str_ptr = std::get_if<std::string>(&field_variant)) {
-                    const std::string& qualified_name = *ident_str_ptr;
-                    // Check for qualified name first (e.g., "c.name")
-                    bool found = false;
-                    for (const auto& elem : doc.elements) {
-                        if (elem.key == qualified_name) {
-                            projected_doc.elements.push_back(elem);
-                            found = true;
-                            break;
-                        }
-                    }
-                    // If not found, try unqualified name (e.g., "name")
-                    if (!found) {
-                        std::string unqualified_name = qualified_name;
-                        if (auto dot_pos = qualified_name.find('.'); dot_pos != std::string::npos) {
-                            unqualified_name = qualified_name.substr(dot_pos + 1);
-                        }
-                        for (const auto& elem : doc.elements) {
-                            if (elem.key == unqualified_name) {
-                                projected_doc.elements.push_back({qualified_name, elem.value});
-                                break;
-                            }
-                        }
-                    }
-                }
-            }
-            projected_docs.push_back(projected_doc);
+    std::vector<Document> projected_docs;
+    for (const auto& doc : result_docs) {
+        if (aggregating) {
+            projected_docs.push_back(project_aggregate_fields(doc, select_stmt.fields));
+        } else {
+            projected_docs.push_back(project_fields(doc, select_stmt.fields));
         }
-        return {projected_docs};
     }
+    record(plan_node("Project"), projected_docs);
+    return {projected_docs};
 }
 
 } // namespace Query
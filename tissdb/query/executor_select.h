@@ -7,7 +7,17 @@
 namespace TissDB {
 namespace Query {
 
-QueryResult execute_select_statement(Storage::LSMTree& storage_engine, const SelectStatement& select_stmt, const std::vector<Literal>& params);
+class CachedAccessPath;
+struct ExplainContext;
+
+// `parallelism` caps the threads the statement may use, as for
+// Executor::set_parallelism. With `cached_access`, the access path chosen
+// by an earlier execution of the same statement is reused while it is valid.
+// With `explain`, the plan is recorded there, and the statement only runs
+// (returning its result as usual) for EXPLAIN ANALYZE.
+QueryResult execute_select_statement(Storage::LSMTree& storage_engine, const SelectStatement& select_stmt,
+                                     const std::vector<Literal>& params, size_t parallelism = 0,
+                                     CachedAccessPath* cached_access = nullptr, ExplainContext* explain = nullptr);
 
 } // namespace Query
 } // namespace TissDB
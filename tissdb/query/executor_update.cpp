@@ -1,67 +1,90 @@
 #include "executor_update.h"
 #include "executor_common.h"
+#include "compiled_expression.h"
+#include "../common/memory_governor.h"
 #include <algorithm>
+#include <optional>
 
 namespace TissDB {
 namespace Query {
 
-QueryResult execute_update_statement(Storage::LSMTree& storage_engine, const UpdateStatement& update_stmt, const std::vector<Literal>& params) {
-    auto all_docs = storage_engine.scan(update_stmt.collection_name);
-    int updated_count = 0;
+QueryResult execute_update_statement(Storage::LSMTree& storage_engine, const UpdateStatement& update_stmt,
+                                     const std::vector<Literal>& params, CachedAccessPath* cached_access) {
+    std::optional<CompiledExpression> where;
+    std::optional<std::vector<std::string>> keys;
+    if (update_stmt.where_clause) {
+        where = CompiledExpression::predicate(*update_stmt.where_clause, params);
+        keys = find_candidate_keys(storage_engine, update_stmt.collection_name, *update_stmt.where_clause, params, cached_access);
+    }
+    std::vector<CompiledExpression> set_values;
+    for (const auto& set_pair : update_stmt.set_clause) {
+        set_values.push_back(CompiledExpression::value(set_pair.second, params));
+    }
 
-    for (auto& doc : all_docs) {
-        bool should_update = false;
-        if (update_stmt.where_clause) {
-            if (evaluate_expression(*update_stmt.where_clause, doc, params)) {
-                should_update = true;
-            }
-        } else {
-            should_update = true; // No WHERE clause, update all documents
+    // Candidates are read shared; only the documents being changed are copied.
+    std::vector<std::shared_ptr<const Document>> candidates;
+    if (keys) {
+        for (auto& doc : storage_engine.get_many(update_stmt.collection_name, *keys)) {
+            candidates.push_back(std::make_shared<const Document>(std::move(doc)));
         }
+    } else {
+        candidates = storage_engine.scan_shared(update_stmt.collection_name);
+    }
 
-        if (should_update) {
-            Document original_doc = doc; // Copy original document for expression evaluation
-            for (const auto& set_pair : update_stmt.set_clause) {
-                const std::string& field_to_update = set_pair.first;
-                const Expression& value_expr = set_pair.second;
+    Common::MemoryReservation working_memory;
+    int updated_count = 0;
+    std::vector<Document> batch;
+    for (const auto& candidate : candidates) {
+        const Document& original_doc = *candidate; // Expressions see the document as it was
+        if (where && !where->matches(original_doc)) continue;
+
+        Document doc = original_doc;
+        for (size_t i = 0; i < update_stmt.set_clause.size(); ++i) {
+            const std::string& field_to_update = update_stmt.set_clause[i].first;
 
-                // Evaluate the expression based on the original document state
-                Literal new_value = evaluate_update_expression(value_expr, original_doc, params);
+            // Evaluate the expression based on the original document state
+            Literal new_value = value_to_literal(set_values[i].evaluate(original_doc));
 
-                auto it = std::find_if(doc.elements.begin(), doc.elements.end(),
-                                       [&](const Element& elem) { return elem.key == field_to_update; });
+            auto it = std::find_if(doc.elements.begin(), doc.elements.end(),
+                                   [&](const Element& elem) { return elem.key == field_to_update; });
 
-                if (it != doc.elements.end()) {
-                    // Field exists, update it
-                    if (const auto* str_val = std::get_if<std::string>(&new_value)) {
-                        it->value = *str_val;
-                    } else if (const auto* num_val = std::get_if<double>(&new_value)) {
-                        it->value = *num_val;
-                    } else if (const auto* bool_val = std::get_if<bool>(&new_value)) {
-                        it->value = *bool_val;
-                    } else if (std::get_if<Null>(&new_value)) {
-                        it->value = nullptr;
-                    }
-                } else {
-                    // Field does not exist, add it
-                    Element new_element;
-                    new_element.key = field_to_update;
-                    if (const auto* str_val = std::get_if<std::string>(&new_value)) {
-                        new_element.value = *str_val;
-                    } else if (const auto* num_val = std::get_if<double>(&new_value)) {
-                        new_element.value = *num_val;
-                    } else if (const auto* bool_val = std::get_if<bool>(&new_value)) {
-                        new_element.value = *bool_val;
-                    } else if (std::get_if<Null>(&new_value)) {
-                        new_element.value = nullptr;
-                    }
-                    doc.elements.push_back(new_element);
+            if (it != doc.elements.end()) {
+                // Field exists, update it
+                if (const auto* str_val = std::get_if<std::string>(&new_value)) {
+                    it->value = *str_val;
+                } else if (const auto* num_val = std::get_if<double>(&new_value)) {
+                    it->value = *num_val;
+                } else if (const auto* bool_val = std::get_if<bool>(&new_value)) {
+                    it->value = *bool_val;
+                } else if (std::get_if<Null>(&new_value)) {
+                    it->value = nullptr;
                 }
+            } else {
+                // Field does not exist, add it
+                Element new_element;
+                new_element.key = field_to_update;
+                if (const auto* str_val = std::get_if<std::string>(&new_value)) {
+                    new_element.value = *str_val;
+                } else if (const auto* num_val = std::get_if<double>(&new_value)) {
+                    new_element.value = *num_val;
+                } else if (const auto* bool_val = std::get_if<bool>(&new_value)) {
+                    new_element.value = *bool_val;
+                } else if (std::get_if<Null>(&new_value)) {
+                    new_element.value = nullptr;
+                }
+                doc.elements.push_back(new_element);
             }
-            storage_engine.put(update_stmt.collection_name, doc.id, doc);
-            updated_count++;
+        }
+        working_memory.grow(estimate_document_memory(doc));
+        batch.push_back(std::move(doc));
+        updated_count++;
+        if (batch.size() == WRITE_BATCH_SIZE) {
+            storage_engine.put_many(update_stmt.collection_name, std::move(batch));
+            batch.clear();
+            working_memory.release();
         }
     }
+    storage_engine.put_many(update_stmt.collection_name, std::move(batch));
 
     Document result_doc;
     result_doc.id = "summary";
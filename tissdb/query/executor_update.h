@@ -7,7 +7,13 @@
 namespace TissDB {
 namespace Query {
 
-QueryResult execute_update_statement(Storage::LSMTree& storage_engine, const UpdateStatement& update_stmt, const std::vector<Literal>& params);
+class CachedAccessPath;
+
+// Updates the matching documents in batches of WRITE_BATCH_SIZE. The WHERE
+// clause finds them by document id or through an index when it can, and
+// `cached_access`, if given, keeps the index choice between runs.
+QueryResult execute_update_statement(Storage::LSMTree& storage_engine, const UpdateStatement& update_stmt,
+                                     const std::vector<Literal>& params, CachedAccessPath* cached_access = nullptr);
 
 } // namespace Query
 } // namespace TissDB
@@ -0,0 +1,640 @@
+#include "executor_vectorized.h"
+#include "column_batch.h"
+#include "compiled_expression.h"
+#include "executor_common.h"
+#include "hash_aggregate.h"
+#include "parallel.h"
+#include "row_stream.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <numeric>
+#include <optional>
+#include <regex>
+
+namespace TissDB {
+namespace Query {
+
+namespace {
+
+std::atomic<bool> vectorized_enabled{true};
+
+bool is_ordering(CompareOp op) {
+    return op != CompareOp::Like && op != CompareOp::Other;
+}
+
+template <typename T, typename U>
+bool compare(CompareOp op, const T& a, const U& b) {
+    switch (op) {
+        case CompareOp::Equal: return a == b;
+        case CompareOp::NotEqual: return a != b;
+        case CompareOp::Less: return a < b;
+        case CompareOp::Greater: return a > b;
+        case CompareOp::LessEqual: return a <= b;
+        case CompareOp::GreaterEqual: return a >= b;
+        default: return false;
+    }
+}
+
+// A WHERE clause compiled against the statement's columns. Comparisons of a
+// column with a constant get a column kernel; anything else is RowByRow and
+// goes through the compiled expression one row at a time.
+struct Predicate {
+    enum class Kind { And, Or, Compare, Between, RowByRow };
+
+    Kind kind = Kind::RowByRow;
+    std::optional<CompiledExpression> row; // The whole predicate, for rows without a kernel
+    std::unique_ptr<Predicate> left;  // And, Or
+    std::unique_ptr<Predicate> right;
+
+    // Compare: `column op constant`. Between: `column [NOT] BETWEEN constant AND upper`.
+    size_t column = 0;
+    CompareOp op = CompareOp::Other;
+    bool negated = false;
+    bool when_missing = false; // The result for a row without the field
+    Value constant;
+    Value upper;
+    std::optional<double> number; // The constants as the row executor coerces them
+    std::optional<double> upper_number;
+    std::optional<std::string> text;
+    std::optional<std::regex> pattern; // LIKE; unset when the pattern is not a valid regex
+};
+
+// Keeps the rows of `in` for which keep(row) holds. `out` must not be `in`.
+template <typename Keep>
+void select_rows(const SelectionVector& in, SelectionVector& out, Keep keep) {
+    out.resize(in.size());
+    size_t kept = 0;
+    for (uint32_t row : in) {
+        out[kept] = row;
+        kept += keep(row) ? 1 : 0;
+    }
+    out.resize(kept);
+}
+
+// Keeps the rows whose value, get(row), compares true against `constant`.
+// The operator is dispatched once per batch rather than once per row.
+template <typename T, typename Get>
+void select_compare(const ColumnVector& column, CompareOp op, const T& constant, bool when_missing,
+                    const SelectionVector& in, SelectionVector& out, Get get) {
+    auto run = [&](auto cmp) {
+        if (column.all_present) {
+            select_rows(in, out, [&](uint32_t row) { return cmp(get(row), constant); });
+        } else {
+            select_rows(in, out, [&](uint32_t row) {
+                return column.is_present(row) ? cmp(get(row), constant) : when_missing;
+            });
+        }
+    };
+    switch (op) {
+        case CompareOp::Equal: run(std::equal_to<>()); break;
+        case CompareOp::NotEqual: run(std::not_equal_to<>()); break;
+        case CompareOp::Less: run(std::less<>()); break;
+        case CompareOp::Greater: run(std::greater<>()); break;
+        case CompareOp::LessEqual: run(std::less_equal<>()); break;
+        case CompareOp::GreaterEqual: run(std::greater_equal<>()); break;
+        default: out.clear(); break;
+    }
+}
+
+// Calls fn(i, row) for each selected row that has the field.
+template <typename Fn>
+void for_each_present(const ColumnVector& column, const SelectionVector& rows, Fn fn) {
+    for (size_t i = 0; i < rows.size(); ++i) {
+        if (column.is_present(rows[i])) fn(i, rows[i]);
+    }
+}
+
+bool selects_all(const SelectStatement& select_stmt) {
+    const auto& fields = select_stmt.fields;
+    return !fields.empty() && std::holds_alternative<std::string>(fields[0]) && std::get<std::string>(fields[0]) == "*";
+}
+
+// Rows a worker claims at a time.
+constexpr size_t MORSEL_ROWS = 8 * BATCH_ROWS;
+
+// A statement compiled for vectorized execution, shared read-only by the
+// workers running it.
+struct SelectPlan {
+    struct AggregateSlot {
+        AggregateType type = AggregateType::COUNT;
+        bool counts_rows = false;        // COUNT(*)
+        std::optional<size_t> column{};  // The aggregated field
+    };
+
+    SelectPlan(const SelectStatement& select_stmt, const std::vector<Literal>& params);
+    size_t column_slot(const std::string& field);
+    std::unique_ptr<Predicate> compile(const Expression& expr);
+
+    const SelectStatement& select_stmt;
+    const std::vector<Literal>& params;
+    const Document empty_doc;
+    // Every field the statement reads, by slot.
+    std::vector<std::string> column_names;
+    std::unique_ptr<Predicate> where;
+    bool aggregating = false;
+    std::vector<AggregateSlot> aggregates;
+    std::vector<size_t> group_columns;
+    // Without aggregation or ORDER BY, workers project the rows they match.
+    bool project_in_workers = false;
+};
+
+// One worker's Scan -> Filter -> Aggregate or Project pipeline, run over
+// the morsels it claims. Each worker decodes its own columns and keeps its
+// own partial aggregate, so workers share nothing but the plan.
+class Pipeline {
+public:
+    Pipeline(const SelectPlan& plan, const DocumentRows& docs);
+
+    // Runs docs[begin, end). Matching rows are added to `aggregator`, or
+    // appended to `rows`, or, when the plan projects in workers, to `out`.
+    void run(size_t begin, size_t end, std::vector<uint32_t>& rows, QueryResult& out);
+
+    HashAggregator aggregator;
+
+private:
+    const ColumnVector& column(size_t slot);
+
+    void filter(const Predicate& predicate, const SelectionVector& in, SelectionVector& out);
+    void filter_compare(const Predicate& predicate, const SelectionVector& in, SelectionVector& out);
+    void filter_between(const Predicate& predicate, const SelectionVector& in, SelectionVector& out);
+    void filter_row_by_row(const Predicate& predicate, const SelectionVector& in, SelectionVector& out);
+
+    void assign_groups(const SelectionVector& rows);
+    void aggregate(const SelectionVector& rows);
+
+    const SelectPlan& plan_;
+    const DocumentRows& docs_;
+
+    // The plan's columns, decoded per batch on first use.
+    std::vector<ColumnVector> columns_;
+    std::vector<uint8_t> decoded_;
+    size_t batch_begin_ = 0;
+    size_t batch_size_ = 0;
+
+    std::vector<uint32_t> group_of_;        // Group of each selected row of the batch
+    std::string key_;
+};
+
+// Splits the documents into morsels, runs them through one Pipeline per
+// worker, and merges the workers' output.
+class VectorizedSelect {
+public:
+    VectorizedSelect(const SelectStatement& select_stmt, const DocumentRows& docs,
+                     const std::vector<Literal>& params, size_t parallelism);
+    QueryResult run();
+
+private:
+    QueryResult finish_aggregation(const HashAggregator& aggregator);
+    QueryResult finish_rows(std::vector<uint32_t> selected);
+
+    const SelectStatement& select_stmt_;
+    const DocumentRows& docs_;
+    const SelectPlan plan_;
+    const size_t limit_;                    // Rows the LIMIT keeps; SIZE_MAX without one
+    const size_t parallelism_;
+};
+
+SelectPlan::SelectPlan(const SelectStatement& select_stmt, const std::vector<Literal>& params)
+    : select_stmt(select_stmt), params(params) {
+    if (select_stmt.where_clause) {
+        where = compile(*select_stmt.where_clause);
+    }
+    for (const auto& field : select_stmt.fields) {
+        if (const auto* agg_func = std::get_if<AggregateFunction>(&field)) {
+            AggregateSlot slot{agg_func->type};
+            slot.counts_rows = agg_func->type == AggregateType::COUNT && !agg_func->field_name.has_value();
+            if (agg_func->field_name) slot.column = column_slot(*agg_func->field_name);
+            aggregates.push_back(slot);
+        }
+    }
+    for (const auto& field : select_stmt.group_by_clause) {
+        group_columns.push_back(column_slot(field));
+    }
+    aggregating = !aggregates.empty() || !group_columns.empty();
+    project_in_workers = !aggregating && select_stmt.order_by_clause.empty();
+}
+
+size_t SelectPlan::column_slot(const std::string& field) {
+    auto it = std::find(column_names.begin(), column_names.end(), field);
+    if (it != column_names.end()) return static_cast<size_t>(it - column_names.begin());
+    column_names.push_back(field);
+    return column_names.size() - 1;
+}
+
+std::unique_ptr<Predicate> SelectPlan::compile(const Expression& expr) {
+    auto predicate = std::make_unique<Predicate>();
+    predicate->row = CompiledExpression::predicate(expr, params);
+    if (const auto* logical_ptr = std::get_if<std::shared_ptr<LogicalExpression>>(&expr)) {
+        const auto& logical = *logical_ptr;
+        if (logical->op == "AND" || logical->op == "OR") {
+            predicate->kind = logical->op == "AND" ? Predicate::Kind::And : Predicate::Kind::Or;
+            predicate->left = compile(logical->left);
+            predicate->right = compile(logical->right);
+        }
+    } else if (const auto* between_ptr = std::get_if<std::shared_ptr<BetweenExpression>>(&expr)) {
+        const auto& between = *between_ptr;
+        const auto* ident = std::get_if<Identifier>(&between->value);
+        const auto lower = CompiledExpression::value(between->lower, params);
+        const auto upper = CompiledExpression::value(between->upper, params);
+        // Bounds that are not constant, or that raise an error, such as a
+        // parameter that is not bound, are left to the row evaluation.
+        if (ident && lower.is_constant() && upper.is_constant()) {
+            predicate->constant = lower.evaluate(empty_doc);
+            predicate->upper = upper.evaluate(empty_doc);
+            predicate->number = get_as_numeric(predicate->constant);
+            predicate->upper_number = get_as_numeric(predicate->upper);
+            predicate->negated = between->negated;
+            predicate->when_missing = predicate->row->matches(empty_doc);
+            predicate->column = column_slot(ident->name);
+            predicate->kind = Predicate::Kind::Between;
+        }
+    } else if (const auto* binary_ptr = std::get_if<std::shared_ptr<BinaryExpression>>(&expr)) {
+        const auto& binary = *binary_ptr;
+        const auto* ident = std::get_if<Identifier>(&binary->left);
+        const auto right = CompiledExpression::value(binary->right, params);
+        if (ident && right.is_constant()) {
+            predicate->op = parse_compare_op(binary->op);
+            predicate->constant = right.evaluate(empty_doc);
+            predicate->number = get_as_numeric(predicate->constant);
+            predicate->text = get_as_string(predicate->constant);
+            if (predicate->op == CompareOp::Like && predicate->text) {
+                try {
+                    predicate->pattern.emplace(like_to_regex(*predicate->text));
+                } catch (const std::regex_error&) {
+                    // Matches nothing, as in the row executor.
+                }
+            }
+            predicate->when_missing = predicate->row->matches(empty_doc);
+            predicate->column = column_slot(ident->name);
+            predicate->kind = Predicate::Kind::Compare;
+        }
+    }
+    return predicate;
+}
+
+Pipeline::Pipeline(const SelectPlan& plan, const DocumentRows& docs)
+    : aggregator(plan.select_stmt), plan_(plan), docs_(docs),
+      columns_(plan.column_names.size()), decoded_(plan.column_names.size()) {}
+
+const ColumnVector& Pipeline::column(size_t slot) {
+    if (!decoded_[slot]) {
+        decode_column(columns_[slot], plan_.column_names[slot], docs_, batch_begin_, batch_size_);
+        decoded_[slot] = 1;
+    }
+    return columns_[slot];
+}
+
+void Pipeline::filter(const Predicate& predicate, const SelectionVector& in, SelectionVector& out) {
+    switch (predicate.kind) {
+        case Predicate::Kind::And: {
+            SelectionVector matched;
+            filter(*predicate.left, in, matched);
+            filter(*predicate.right, matched, out);
+            return;
+        }
+        case Predicate::Kind::Or: {
+            // The right side only sees the rows the left side rejected.
+            SelectionVector matched, rest, more;
+            filter(*predicate.left, in, matched);
+            std::set_difference(in.begin(), in.end(), matched.begin(), matched.end(), std::back_inserter(rest));
+            filter(*predicate.right, rest, more);
+            out.clear();
+            std::merge(matched.begin(), matched.end(), more.begin(), more.end(), std::back_inserter(out));
+            return;
+        }
+        case Predicate::Kind::Compare:
+            filter_compare(predicate, in, out);
+            return;
+        case Predicate::Kind::Between:
+            filter_between(predicate, in, out);
+            return;
+        case Predicate::Kind::RowByRow:
+            filter_row_by_row(predicate, in, out);
+            return;
+    }
+}
+
+void Pipeline::filter_compare(const Predicate& predicate, const SelectionVector& in, SelectionVector& out) {
+    const ColumnVector& col = column(predicate.column);
+    const CompareOp op = predicate.op;
+    const bool when_missing = predicate.when_missing;
+    switch (col.type) {
+        case ColumnVector::Type::Missing:
+            if (when_missing) out = in; else out.clear();
+            return;
+        case ColumnVector::Type::Number:
+            if (predicate.number && is_ordering(op)) {
+                select_compare(col, op, *predicate.number, when_missing, in, out,
+                               [&](uint32_t row) { return col.numbers[row]; });
+                return;
+            }
+            break;
+        case ColumnVector::Type::String:
+            if (op == CompareOp::Like) {
+                const std::regex* pattern = predicate.pattern ? &*predicate.pattern : nullptr;
+                select_rows(in, out, [&](uint32_t row) {
+                    if (!col.is_present(row)) return when_missing;
+                    return pattern && std::regex_match(col.strings[row].begin(), col.strings[row].end(), *pattern);
+                });
+                return;
+            }
+            if (is_ordering(op) && predicate.text) {
+                const std::string_view text = *predicate.text;
+                if (!predicate.number) {
+                    select_compare(col, op, text, when_missing, in, out,
+                                   [&](uint32_t row) { return col.strings[row]; });
+                    return;
+                }
+                // Against a numeric constant, strings that parse as numbers
+                // compare as numbers and the rest as text.
+                const double number = *predicate.number;
+                select_rows(in, out, [&](uint32_t row) {
+                    if (!col.is_present(row)) return when_missing;
+                    double value;
+                    if (parse_number(col.strings[row].data(), value)) return compare(op, value, number);
+                    return compare(op, col.strings[row], text);
+                });
+                return;
+            }
+            break;
+        case ColumnVector::Type::Boolean:
+            if (const auto* boolean = std::get_if<bool>(&predicate.constant); boolean && is_ordering(op)) {
+                select_compare(col, op, static_cast<uint8_t>(*boolean), when_missing, in, out,
+                               [&](uint32_t row) { return col.booleans[row]; });
+                return;
+            }
+            break;
+        case ColumnVector::Type::Timestamp:
+            if (const auto* ts = std::get_if<Timestamp>(&predicate.constant); ts && is_ordering(op)) {
+                select_compare(col, op, ts->microseconds_since_epoch_utc, when_missing, in, out,
+                               [&](uint32_t row) { return col.timestamps[row]; });
+                return;
+            }
+            break;
+        case ColumnVector::Type::Mixed:
+            break;
+    }
+    filter_row_by_row(predicate, in, out);
+}
+
+void Pipeline::filter_between(const Predicate& predicate, const SelectionVector& in, SelectionVector& out) {
+    const ColumnVector& col = column(predicate.column);
+    auto keep_in_range = [&](auto in_range) {
+        select_rows(in, out, [&](uint32_t row) {
+            if (!col.is_present(row)) return predicate.when_missing;
+            return in_range(row) != predicate.negated;
+        });
+    };
+    switch (col.type) {
+        case ColumnVector::Type::Missing:
+            if (predicate.when_missing) out = in; else out.clear();
+            return;
+        case ColumnVector::Type::Number:
+            if (predicate.number && predicate.upper_number) {
+                const double lower = *predicate.number;
+                const double upper = *predicate.upper_number;
+                keep_in_range([&](uint32_t row) { return col.numbers[row] >= lower && col.numbers[row] <= upper; });
+                return;
+            }
+            break;
+        case ColumnVector::Type::Timestamp: {
+            const auto* lower = std::get_if<Timestamp>(&predicate.constant);
+            const auto* upper = std::get_if<Timestamp>(&predicate.upper);
+            if (lower && upper) {
+                const int64_t low = lower->microseconds_since_epoch_utc;
+                const int64_t high = upper->microseconds_since_epoch_utc;
+                keep_in_range([&](uint32_t row) { return col.timestamps[row] >= low && col.timestamps[row] <= high; });
+                return;
+            }
+            break;
+        }
+        default:
+            break;
+    }
+    filter_row_by_row(predicate, in, out);
+}
+
+void Pipeline::filter_row_by_row(const Predicate& predicate, const SelectionVector& in, SelectionVector& out) {
+    select_rows(in, out, [&](uint32_t row) {
+        return predicate.row->matches(*docs_[batch_begin_ + row]);
+    });
+}
+
+void Pipeline::assign_groups(const SelectionVector& rows) {
+    group_of_.resize(rows.size());
+    if (plan_.group_columns.empty()) {
+        std::fill(group_of_.begin(), group_of_.end(), 0);
+        return;
+    }
+    std::vector<const ColumnVector*> keys;
+    for (size_t slot : plan_.group_columns) keys.push_back(&column(slot));
+
+    for (size_t i = 0; i < rows.size(); ++i) {
+        const uint32_t row = rows[i];
+        key_.clear();
+        for (const ColumnVector* key : keys) {
+            if (!key->is_present(row)) {
+                append_group_missing(key_);
+                continue;
+            }
+            switch (key->type) {
+                case ColumnVector::Type::Number: append_group_number(key_, key->numbers[row]); break;
+                case ColumnVector::Type::String: append_group_string(key_, key->strings[row]); break;
+                case ColumnVector::Type::Boolean: append_group_boolean(key_, key->booleans[row]); break;
+                case ColumnVector::Type::Timestamp: append_group_timestamp(key_, key->timestamps[row]); break;
+                default: append_group_value(key_, *key->values[row]); break;
+            }
+        }
+        group_of_[i] = aggregator.group(key_, *docs_[batch_begin_ + row]);
+    }
+}
+
+void Pipeline::aggregate(const SelectionVector& rows) {
+    assign_groups(rows);
+    const size_t width = plan_.aggregates.size();
+    for (size_t s = 0; s < width; ++s) {
+        const SelectPlan::AggregateSlot& slot = plan_.aggregates[s];
+        auto result_at = [&](size_t i) -> AggregateResult& { return aggregator.results(group_of_[i])[s]; };
+        if (slot.counts_rows) {
+            for (size_t i = 0; i < rows.size(); ++i) result_at(i).count++;
+            continue;
+        }
+        if (!slot.column) continue;
+
+        const ColumnVector& col = column(*slot.column);
+        switch (col.type) {
+            case ColumnVector::Type::Missing:
+                break;
+            case ColumnVector::Type::Number:
+                switch (slot.type) {
+                    case AggregateType::COUNT:
+                        for_each_present(col, rows, [&](size_t i, uint32_t) { result_at(i).count++; });
+                        break;
+                    case AggregateType::SUM:
+                        for_each_present(col, rows, [&](size_t i, uint32_t row) { result_at(i).sum += col.numbers[row]; });
+                        break;
+                    default:
+                        for_each_present(col, rows, [&](size_t i, uint32_t row) {
+                            accumulate_number(result_at(i), slot.type, col.numbers[row]);
+                        });
+                        break;
+                }
+                break;
+            case ColumnVector::Type::String:
+                for_each_present(col, rows, [&](size_t i, uint32_t row) {
+                    AggregateResult& result = result_at(i);
+                    if (slot.type == AggregateType::COUNT) {
+                        result.count++;
+                        return;
+                    }
+                    double value;
+                    if (parse_number(col.strings[row].data(), value)) {
+                        accumulate_number(result, slot.type, value);
+                    } else {
+                        accumulate_string(result, slot.type, col.strings[row]);
+                    }
+                });
+                break;
+            default:
+                for_each_present(col, rows, [&](size_t i, uint32_t row) {
+                    accumulate_aggregate(result_at(i), *col.values[row], slot.type);
+                });
+                break;
+        }
+    }
+}
+
+void Pipeline::run(size_t begin, size_t end, std::vector<uint32_t>& rows, QueryResult& out) {
+    const auto& fields = plan_.select_stmt.fields;
+    const bool select_all = selects_all(plan_.select_stmt);
+    SelectionVector all_rows;
+    SelectionVector matched;
+    for (batch_begin_ = begin; batch_begin_ < end; batch_begin_ += BATCH_ROWS) {
+        batch_size_ = std::min(BATCH_ROWS, end - batch_begin_);
+        std::fill(decoded_.begin(), decoded_.end(), 0);
+        all_rows.resize(batch_size_);
+        std::iota(all_rows.begin(), all_rows.end(), 0);
+
+        const SelectionVector* selected = &all_rows;
+        if (plan_.where) {
+            filter(*plan_.where, all_rows, matched);
+            selected = &matched;
+        }
+        if (plan_.aggregating) {
+            aggregate(*selected);
+        } else if (plan_.project_in_workers) {
+            for (uint32_t row : *selected) {
+                const Document& doc = *docs_[batch_begin_ + row];
+                out.push_back(select_all ? doc : project_fields(doc, fields));
+            }
+        } else {
+            for (uint32_t row : *selected) rows.push_back(static_cast<uint32_t>(batch_begin_ + row));
+        }
+    }
+}
+
+VectorizedSelect::VectorizedSelect(const SelectStatement& select_stmt, const DocumentRows& docs,
+                                   const std::vector<Literal>& params, size_t parallelism)
+    : select_stmt_(select_stmt), docs_(docs), plan_(select_stmt, params),
+      limit_(select_stmt.limit_clause ? limit_rows(*select_stmt.limit_clause) : SIZE_MAX),
+      parallelism_(parallelism) {}
+
+QueryResult VectorizedSelect::finish_aggregation(const HashAggregator& aggregator) {
+    std::vector<Document> aggregated_docs = aggregator.finish();
+
+    if (!select_stmt_.order_by_clause.empty()) {
+        std::vector<uint32_t> rows(aggregated_docs.size());
+        std::iota(rows.begin(), rows.end(), 0);
+        sort_rows(aggregated_docs, rows, select_stmt_.order_by_clause, limit_, parallelism_);
+        std::vector<Document> sorted;
+        sorted.reserve(rows.size());
+        for (uint32_t row : rows) sorted.push_back(std::move(aggregated_docs[row]));
+        aggregated_docs = std::move(sorted);
+    }
+    apply_limit(aggregated_docs, select_stmt_.limit_clause);
+
+    if (selects_all(select_stmt_)) {
+        return aggregated_docs;
+    }
+    QueryResult projected_docs;
+    projected_docs.reserve(aggregated_docs.size());
+    for (const auto& doc : aggregated_docs) {
+        projected_docs.push_back(project_aggregate_fields(doc, select_stmt_.fields));
+    }
+    return projected_docs;
+}
+
+QueryResult VectorizedSelect::finish_rows(std::vector<uint32_t> selected) {
+    sort_rows(docs_, selected, select_stmt_.order_by_clause, limit_, parallelism_);
+
+    QueryResult result_docs;
+    result_docs.reserve(selected.size());
+    if (selects_all(select_stmt_)) {
+        for (uint32_t row : selected) result_docs.push_back(*docs_[row]);
+    } else {
+        for (uint32_t row : selected) result_docs.push_back(project_fields(*docs_[row], select_stmt_.fields));
+    }
+    return result_docs;
+}
+
+QueryResult VectorizedSelect::run() {
+    const size_t morsels = (docs_.size() + MORSEL_ROWS - 1) / MORSEL_ROWS;
+    const size_t workers = parallel_task_count(docs_.size(), parallelism_);
+    std::vector<Pipeline> pipelines;
+    pipelines.reserve(workers);
+    for (size_t w = 0; w < workers; ++w) pipelines.emplace_back(plan_, docs_);
+
+    // Output is kept per morsel, so it can be put back in document order.
+    std::vector<std::vector<uint32_t>> rows(morsels);
+    std::vector<QueryResult> out(morsels);
+    run_morsels(workers, morsels, [&](size_t worker, size_t m) {
+        const size_t begin = m * MORSEL_ROWS;
+        pipelines[worker].run(begin, std::min(docs_.size(), begin + MORSEL_ROWS), rows[m], out[m]);
+    });
+
+    if (plan_.aggregating) {
+        for (size_t w = 1; w < workers; ++w) {
+            pipelines[0].aggregator.merge(std::move(pipelines[w].aggregator));
+        }
+        return finish_aggregation(pipelines[0].aggregator);
+    }
+    if (plan_.project_in_workers) {
+        QueryResult result_docs;
+        for (auto& morsel : out) {
+            if (result_docs.size() >= limit_) break;
+            std::move(morsel.begin(), morsel.end(), std::back_inserter(result_docs));
+        }
+        if (result_docs.size() > limit_) result_docs.resize(limit_);
+        return result_docs;
+    }
+    std::vector<uint32_t> selected;
+    for (const auto& morsel : rows) selected.insert(selected.end(), morsel.begin(), morsel.end());
+    return finish_rows(std::move(selected));
+}
+
+} // anonymous namespace
+
+void set_vectorized_execution(bool enabled) {
+    vectorized_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool vectorized_execution_enabled() {
+    return vectorized_enabled.load(std::memory_order_relaxed);
+}
+
+bool can_execute_vectorized(const SelectStatement& select_stmt, size_t row_count) {
+    if (select_stmt.join_clause || select_stmt.union_clause) return false;
+    return row_count <= UINT32_MAX; // Rows are addressed by 32-bit positions
+}
+
+QueryResult execute_select_vectorized(const SelectStatement& select_stmt, const DocumentRows& docs,
+                                      const std::vector<Literal>& params, size_t parallelism) {
+    return VectorizedSelect(select_stmt, docs, params, parallelism).run();
+}
+
+} // namespace Query
+} // namespace TissDB
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include "ast.h"
+#include "column_batch.h"
+#include "executor.h"
+
+namespace TissDB {
+namespace Query {
+
+// Vectorized SELECT over one collection. Documents are processed
+// BATCH_ROWS at a time: the fields the statement names are decoded into
+// typed column vectors, and WHERE, aggregation and ORDER BY run over whole
+// columns and selection vectors instead of walking the expression tree once
+// per document. Predicates without a column kernel (functions, arithmetic,
+// columns of mixed types) are evaluated row by row within the batch, so the
+// result is always the one the row-at-a-time executor gives.
+
+// On by default; turned off to compare against the row-at-a-time path.
+void set_vectorized_execution(bool enabled);
+bool vectorized_execution_enabled();
+
+// Whether `select_stmt`, over `row_count` documents, can run on the
+// vectorized path: no JOIN or UNION.
+bool can_execute_vectorized(const SelectStatement& select_stmt, size_t row_count);
+
+// Runs the WHERE, aggregation, ORDER BY, LIMIT and projection of
+// `select_stmt` over `docs`, the collection's rows. Only the documents in
+// the result are copied.
+//
+// The rows are split into morsels of a few batches, which up to
+// `parallelism` threads (see parallel_task_count) claim one at a time. Each
+// thread filters its morsels and aggregates them into its own partial
+// groups, or projects them; the partial groups are then merged, and
+// projected rows are put back in document order.
+QueryResult execute_select_vectorized(const SelectStatement& select_stmt, const DocumentRows& docs,
+                                      const std::vector<Literal>& params, size_t parallelism = 0);
+
+} // namespace Query
+} // namespace TissDB
@@ -0,0 +1,80 @@
+#include "explain.h"
+#include "executor_common.h"
+
+#include <memory>
+#include <utility>
+
+namespace TissDB {
+namespace Query {
+
+namespace {
+
+double milliseconds(std::chrono::steady_clock::duration duration) {
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+} // anonymous namespace
+
+Value PlanNode::to_value() const {
+    auto object = std::make_shared<Object>();
+    object->values = details;
+    object->values["operator"] = op;
+    if (estimated_rows) object->values["estimated_rows"] = *estimated_rows;
+    if (analyzed) {
+        object->values["actual_rows"] = static_cast<double>(rows);
+        object->values["time_ms"] = time_ms;
+        object->values["bytes"] = static_cast<double>(bytes);
+        object->values["memory_bytes"] = static_cast<double>(memory_bytes);
+    }
+    if (!children.empty()) {
+        auto inputs = std::make_shared<Array>();
+        for (const auto& child : children) inputs->values.push_back(child.to_value());
+        object->values["inputs"] = std::move(inputs);
+    }
+    return object;
+}
+
+void ExplainContext::push(PlanNode node) {
+    if (!plan.op.empty()) node.children.insert(node.children.begin(), std::move(plan));
+    plan = std::move(node);
+}
+
+void ExplainContext::measure(PlanNode& node, size_t rows, size_t bytes, size_t memory_bytes) const {
+    node.analyzed = true;
+    node.rows = rows;
+    node.bytes = bytes;
+    node.memory_bytes = memory_bytes;
+    node.time_ms = milliseconds(std::chrono::steady_clock::now() - start);
+}
+
+const Document* ProfileStream::next() {
+    const Document* row = input_.next();
+    if (row) {
+        rows_++;
+        bytes_ += estimate_document_memory(*row);
+    }
+    finished_ = std::chrono::steady_clock::now();
+    return row;
+}
+
+void ProfileStream::measure(PlanNode& node, size_t memory_bytes) const {
+    node.analyzed = true;
+    node.rows = rows_;
+    node.bytes = bytes_;
+    node.memory_bytes = memory_bytes;
+    node.time_ms = milliseconds(finished_ - context_.start);
+}
+
+QueryResult explain_result(const ExplainContext& context, size_t result_rows) {
+    Document doc;
+    doc.id = "explain";
+    doc.elements.push_back({"plan", context.plan.to_value()});
+    if (context.analyze) {
+        doc.elements.push_back({"rows", static_cast<double>(result_rows)});
+        doc.elements.push_back({"execution_ms", milliseconds(std::chrono::steady_clock::now() - context.start)});
+    }
+    return {doc};
+}
+
+} // namespace Query
+} // namespace TissDB
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "executor.h"
+#include "row_stream.h"
+#include "../common/document.h"
+
+namespace TissDB {
+namespace Query {
+
+// One operator of a SELECT plan, e.g. "IndexScan" or "Join"; `children` are
+// its inputs.
+struct PlanNode {
+    std::string op;
+    std::map<std::string, Value> details; // Collection, index, join strategy...
+    std::optional<double> estimated_rows;
+
+    // Measured by EXPLAIN ANALYZE. Time runs from the start of the statement
+    // until the operator produced its last row, so it includes its inputs.
+    // Bytes approximate the rows it produced; memory is the working memory
+    // the statement had reserved by then.
+    bool analyzed = false;
+    uint64_t rows = 0;
+    double time_ms = 0;
+    uint64_t bytes = 0;
+    uint64_t memory_bytes = 0;
+
+    std::vector<PlanNode> children;
+
+    // The node as an object value, with its inputs under "inputs".
+    Value to_value() const;
+};
+
+// Filled in by execute_select_statement for EXPLAIN: the plan it chose and,
+// with `analyze`, what running it did. Without `analyze` the statement is
+// planned but not run.
+struct ExplainContext {
+    bool analyze = false;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    PlanNode plan; // The operator producing the result
+
+    // Makes `node` the root, with the current root as its input.
+    void push(PlanNode node);
+    // Marks `node` as having produced `rows` rows of `bytes` bytes by now.
+    void measure(PlanNode& node, size_t rows, size_t bytes, size_t memory_bytes) const;
+};
+
+// Passes the rows of `input` through, counting them and noting when the
+// last one came, for EXPLAIN ANALYZE of a streamed pipeline.
+class ProfileStream : public RowStream {
+public:
+    ProfileStream(RowStream& input, const ExplainContext& context) : input_(input), context_(context) {}
+    const Document* next() override;
+
+    // Records what passed through in the node of the operator below.
+    void measure(PlanNode& node, size_t memory_bytes) const;
+
+private:
+    RowStream& input_;
+    const ExplainContext& context_;
+    uint64_t rows_ = 0;
+    uint64_t bytes_ = 0;
+    std::chrono::steady_clock::time_point finished_ = std::chrono::steady_clock::now();
+};
+
+// The result of EXPLAIN: one document with the plan tree under "plan" and,
+// for EXPLAIN ANALYZE, the rows returned and the total time.
+QueryResult explain_result(const ExplainContext& context, size_t result_rows);
+
+} // namespace Query
+} // namespace TissDB
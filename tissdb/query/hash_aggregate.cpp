@@ -0,0 +1,173 @@
+#include "hash_aggregate.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace TissDB {
+namespace Query {
+
+namespace {
+
+// The type of each value in a group key.
+enum GroupKeyTag : char {
+    KEY_MISSING,
+    KEY_NUMBER,
+    KEY_STRING,
+    KEY_BOOLEAN,
+    KEY_TIMESTAMP,
+    KEY_OTHER,
+};
+
+void append_raw(std::string& key, const void* bytes, size_t size) {
+    key.append(static_cast<const char*>(bytes), size);
+}
+
+// Length-prefixed, so that a key of several values has one reading.
+void append_text(std::string& key, std::string_view text) {
+    const uint32_t size = static_cast<uint32_t>(text.size());
+    append_raw(key, &size, sizeof(size));
+    key.append(text);
+}
+
+} // anonymous namespace
+
+void append_group_missing(std::string& key) {
+    key.push_back(KEY_MISSING);
+}
+
+void append_group_number(std::string& key, double value) {
+    if (value == 0) value = 0; // -0 groups with 0
+    key.push_back(KEY_NUMBER);
+    append_raw(key, &value, sizeof(value));
+}
+
+void append_group_string(std::string& key, std::string_view value) {
+    key.push_back(KEY_STRING);
+    append_text(key, value);
+}
+
+void append_group_boolean(std::string& key, bool value) {
+    key.push_back(KEY_BOOLEAN);
+    key.push_back(value ? 1 : 0);
+}
+
+void append_group_timestamp(std::string& key, int64_t microseconds) {
+    key.push_back(KEY_TIMESTAMP);
+    append_raw(key, &microseconds, sizeof(microseconds));
+}
+
+void append_group_value(std::string& key, const Value& value) {
+    if (const auto* number = std::get_if<double>(&value)) {
+        append_group_number(key, *number);
+    } else if (const auto* text = std::get_if<std::string>(&value)) {
+        append_group_string(key, *text);
+    } else if (const auto* boolean = std::get_if<bool>(&value)) {
+        append_group_boolean(key, *boolean);
+    } else if (const auto* ts = std::get_if<Timestamp>(&value)) {
+        append_group_timestamp(key, ts->microseconds_since_epoch_utc);
+    } else {
+        // Rare as group values: keyed by their type and text.
+        key.push_back(KEY_OTHER);
+        key.push_back(static_cast<char>(value.index()));
+        std::string text;
+        append_group_key(text, value);
+        append_text(key, text);
+    }
+}
+
+HashAggregator::HashAggregator(const SelectStatement& select_stmt) : select_stmt_(select_stmt) {
+    for (const auto& field : select_stmt.fields) {
+        if (const auto* agg_func = std::get_if<AggregateFunction>(&field)) {
+            aggregates_.push_back(*agg_func);
+        }
+    }
+    if (select_stmt.group_by_clause.empty()) {
+        // Without GROUP BY there is one result, even over no rows.
+        groups_.push_back({"aggregate", {}});
+        index_.emplace(std::string(), 0);
+        results_.resize(aggregates_.size());
+    }
+}
+
+void HashAggregator::add(const Document& doc) {
+    key_.clear();
+    for (const auto& field_name : select_stmt_.group_by_clause) {
+        if (const Value* value = get_value_from_doc(doc, field_name)) {
+            append_group_value(key_, *value);
+        } else {
+            append_group_missing(key_);
+        }
+    }
+    AggregateResult* result = results(group(key_, doc));
+    for (const auto& agg_func : aggregates_) {
+        if (agg_func.type == AggregateType::COUNT && !agg_func.field_name) {
+            result->count++;
+        } else if (agg_func.field_name) {
+            if (const Value* value = get_value_from_doc(doc, *agg_func.field_name)) {
+                accumulate_aggregate(*result, *value, agg_func.type);
+            }
+        }
+        ++result;
+    }
+}
+
+uint32_t HashAggregator::group(const std::string& key, const Document& doc) {
+    if (auto it = index_.find(key); it != index_.end()) return it->second;
+
+    Group group;
+    const auto& group_by = select_stmt_.group_by_clause;
+    for (size_t i = 0; i < group_by.size(); ++i) {
+        if (i > 0) group.id += "::";
+        if (const Value* value = get_value_from_doc(doc, group_by[i])) {
+            append_group_key(group.id, *value);
+            group.values.push_back({group_by[i], *value});
+        } else {
+            group.id += "NULL";
+        }
+    }
+    const uint32_t g = static_cast<uint32_t>(groups_.size());
+    groups_.push_back(std::move(group));
+    index_.emplace(key, g);
+    results_.resize(results_.size() + aggregates_.size());
+    return g;
+}
+
+void HashAggregator::merge(HashAggregator&& other) {
+    const size_t width = aggregates_.size();
+    for (auto& [key, other_g] : other.index_) {
+        auto [it, inserted] = index_.emplace(key, static_cast<uint32_t>(groups_.size()));
+        const AggregateResult* from = other.results(other_g);
+        if (inserted) {
+            groups_.push_back(std::move(other.groups_[other_g]));
+            results_.insert(results_.end(), from, from + width);
+            continue;
+        }
+        AggregateResult* into = results(it->second);
+        for (size_t s = 0; s < width; ++s) merge_aggregate(into[s], from[s]);
+    }
+}
+
+std::vector<Document> HashAggregator::finish() const {
+    std::vector<uint32_t> order(groups_.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(),
+                     [&](uint32_t a, uint32_t b) { return groups_[a].id < groups_[b].id; });
+
+    const size_t width = aggregates_.size();
+    std::vector<Document> docs;
+    docs.reserve(order.size());
+    for (uint32_t g : order) {
+        Document doc;
+        doc.id = groups_[g].id;
+        doc.elements = groups_[g].values;
+        for (size_t s = 0; s < width; ++s) {
+            doc.elements.push_back({get_aggregate_result_key(aggregates_[s]),
+                                    finalize_aggregate(results_[g * width + s], aggregates_[s].type)});
+        }
+        docs.push_back(std::move(doc));
+    }
+    return docs;
+}
+
+} // namespace Query
+} // namespace TissDB
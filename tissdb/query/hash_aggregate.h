@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "ast.h"
+#include "executor_common.h"
+#include "../common/document.h"
+
+namespace TissDB {
+namespace Query {
+
+// The GROUP BY and aggregates of a SELECT, computed in one pass over its
+// rows. Each row is folded into the running AggregateResults of its group as
+// it arrives, and is not kept: a group holds only its GROUP BY values and
+// one result per aggregate in the SELECT list.
+//
+// Groups are found in a hash table keyed by their GROUP BY values in binary
+// form, each value's type followed by its bytes (see the append_group_*
+// functions). So values group as they compare: 1 and "1" are different
+// groups, and numbers are not rounded as they would be printed.
+//
+// An aggregator can hold a partial result over part of the input; merge()
+// folds another's groups into it, and the merged aggregator finishes with
+// the same result as one that saw every row.
+class HashAggregator {
+public:
+    explicit HashAggregator(const SelectStatement& select_stmt);
+
+    // Folds one row into its group.
+    void add(const Document& doc);
+
+    // The group whose key is `key`, created from `doc`, a row of the group,
+    // if there is none yet.
+    uint32_t group(const std::string& key, const Document& doc);
+    // The results of group `g`, one per aggregate in SELECT list order. Valid
+    // until the next group is created.
+    AggregateResult* results(uint32_t g) { return &results_[g * aggregates_.size()]; }
+
+    // Folds the groups of `other`, an aggregator of the same statement, into
+    // this one.
+    void merge(HashAggregator&& other);
+
+    // One document per group, ordered by its id: the text of its GROUP BY
+    // values, or "aggregate" without a GROUP BY. Each holds the group's
+    // values and each aggregate's final value.
+    std::vector<Document> finish() const;
+
+    size_t group_count() const { return groups_.size(); }
+
+private:
+    struct Group {
+        std::string id;
+        std::vector<Element> values; // The GROUP BY fields the group's rows have
+    };
+
+    const SelectStatement& select_stmt_;
+    std::vector<AggregateFunction> aggregates_;
+    std::vector<Group> groups_;
+    std::unordered_map<std::string, uint32_t> index_;
+    std::vector<AggregateResult> results_; // aggregates_.size() per group
+    std::string key_;
+};
+
+// Append one GROUP BY value to a group key.
+void append_group_missing(std::string& key);
+void append_group_number(std::string& key, double value);
+void append_group_string(std::string& key, std::string_view value);
+void append_group_boolean(std::string& key, bool value);
+void append_group_timestamp(std::string& key, int64_t microseconds);
+// Any value, keyed the same way as by the typed functions above.
+void append_group_value(std::string& key, const Value& value);
+
+} // namespace Query
+} // namespace TissDB
@@ -1,133 +1,374 @@
-
 #include "join_algorithms.h"
 #include "executor_common.h" // For combine_documents
-#include <iostream>
+#include "../common/binary_stream_buffer.h"
+#include "../common/log.h"
+#include "../common/metrics.h"
+#include "../common/serialization.h"
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
 #include <unordered_map>
-#include <optional>
 
 namespace TissDB {
 namespace Query {
 
-// Helper to get a value from a document by key
-static std::optional<Value> get_value_by_key(const Document& doc, const std::string& key) {
-    for (const auto& elem : doc.elements) {
-        if (elem.key == key) {
-            return elem.value;
-        }
+namespace {
+
+constexpr size_t DEFAULT_JOIN_MEMORY_LIMIT = 64 * 1024 * 1024;
+constexpr size_t MAX_SPILL_PARTITIONS = 256;
+
+std::atomic<size_t> memory_limit_setting{DEFAULT_JOIN_MEMORY_LIMIT};
+std::mutex spill_directory_mutex;
+std::string spill_directory_setting;
+
+std::string number_key(double number) {
+    if (number == 0) number = 0; // -0 equals 0
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "#%.17g", number);
+    return buffer;
+}
+
+// Strings that read as numbers compare as numbers, and as text otherwise.
+std::string string_key(const std::string& text) {
+    double number;
+    if (parse_number(text.c_str(), number)) return number_key(number);
+    return "$" + text;
+}
+
+std::optional<std::string> value_key(const Value& value) {
+    if (const auto* str_val = std::get_if<std::string>(&value)) return string_key(*str_val);
+    if (const auto* num_val = std::get_if<double>(&value)) return number_key(*num_val);
+    if (const auto* bool_val = std::get_if<bool>(&value)) return std::string(*bool_val ? "$true" : "$false");
+    if (std::holds_alternative<std::nullptr_t>(value)) return std::string("$null");
+    // A timestamp compares as its text, which is also how a numeric string
+    // with the same digits is keyed.
+    if (const auto* ts_val = std::get_if<Timestamp>(&value)) {
+        return number_key(static_cast<double>(ts_val->microseconds_since_epoch_utc));
+    }
+    if (const auto* date_val = std::get_if<Date>(&value)) {
+        return "d" + std::to_string(date_val->year) + "-" + std::to_string(date_val->month) + "-" +
+               std::to_string(date_val->day);
+    }
+    if (const auto* time_val = std::get_if<Time>(&value)) {
+        return "t" + std::to_string(time_val->hour) + ":" + std::to_string(time_val->minute) + ":" +
+               std::to_string(time_val->second);
+    }
+    if (const auto* dt_val = std::get_if<DateTime>(&value)) {
+        return "T" + std::to_string(dt_val->time_since_epoch().count());
     }
     return std::nullopt;
 }
 
+bool keeps_left(JoinType type) { return type == JoinType::LEFT || type == JoinType::FULL; }
+bool keeps_right(JoinType type) { return type == JoinType::RIGHT || type == JoinType::FULL; }
 
-// Implementation for Nested Loop Join
-std::vector<Document> JoinAlgorithms::nestedLoopJoin(
-    const std::vector<Document>& left_table,
-    const std::string& left_collection_name,
-    const std::vector<Document>& right_table,
-    const std::string& right_collection_name,
-    const std::string& left_join_key,
-    const std::string& right_join_key
-) {
-    std::vector<Document> result;
-    for (const auto& left_doc : left_table) {
-        auto left_value_opt = get_value_by_key(left_doc, left_join_key);
-        if (!left_value_opt) continue;
+// Appends the combined row if the ON clause holds for it.
+bool join_pair(const Document& left, const Document& right, const JoinSpec& spec, std::vector<Document>& result) {
+    Document combined = combine_documents(left, spec.left_alias, right, spec.right_alias);
+    if (spec.on_condition && !spec.on_condition->matches(combined)) return false;
+    result.push_back(std::move(combined));
+    return true;
+}
 
-        for (const auto& right_doc : right_table) {
-            auto right_value_opt = get_value_by_key(right_doc, right_join_key);
-            if (!right_value_opt) continue;
+void append_unmatched(const SharedDocuments& rows, const std::vector<bool>& matched, const std::string& alias,
+                      std::vector<Document>& result) {
+    for (size_t i = 0; i < rows.size(); ++i) {
+        if (!matched[i]) result.push_back(outer_join_row(*rows[i], alias));
+    }
+}
 
-            if (*left_value_opt == *right_value_opt) {
-                result.push_back(combine_documents(left_doc, left_collection_name, right_doc, right_collection_name));
+// A hash table over the build side, probed one row at a time. Build rows
+// must outlive the table.
+class JoinHashTable {
+public:
+    JoinHashTable(const JoinSpec& spec, bool build_is_left) : spec_(spec), build_is_left_(build_is_left) {}
+
+    void insert(const Document& row) {
+        auto key = join_key(row, build_is_left_ ? spec_.left_key : spec_.right_key);
+        if (key) table_[std::move(*key)].push_back(rows_.size());
+        rows_.push_back(&row);
+        matched_.push_back(false);
+    }
+
+    // Appends the matches of `row`, or `row` alone if it has none and its
+    // side is kept.
+    void probe(const Document& row, std::vector<Document>& result) {
+        bool matched = false;
+        if (auto key = join_key(row, build_is_left_ ? spec_.right_key : spec_.left_key)) {
+            auto it = table_.find(*key);
+            if (it != table_.end()) {
+                for (size_t i : it->second) {
+                    const bool joined = build_is_left_ ? join_pair(*rows_[i], row, spec_, result)
+                                                       : join_pair(row, *rows_[i], spec_, result);
+                    if (joined) {
+                        matched = true;
+                        matched_[i] = true;
+                    }
+                }
             }
         }
+        if (!matched && (build_is_left_ ? keeps_right(spec_.type) : keeps_left(spec_.type))) {
+            result.push_back(outer_join_row(row, build_is_left_ ? spec_.right_alias : spec_.left_alias));
+        }
     }
-    return result;
-}
 
+    // Appends the build rows nothing matched, if their side is kept.
+    void finish(std::vector<Document>& result) const {
+        if (!(build_is_left_ ? keeps_left(spec_.type) : keeps_right(spec_.type))) return;
+        const std::string& alias = build_is_left_ ? spec_.left_alias : spec_.right_alias;
+        for (size_t i = 0; i < rows_.size(); ++i) {
+            if (!matched_[i]) result.push_back(outer_join_row(*rows_[i], alias));
+        }
+    }
 
+private:
+    const JoinSpec& spec_;
+    const bool build_is_left_;
+    std::vector<const Document*> rows_;
+    std::vector<bool> matched_;
+    std::unordered_map<std::string, std::vector<size_t>> table_;
+};
 
-// Implementation for Hash Join
-std::vector<Document> JoinAlgorithms::hashJoin(
-    const std::vector<Document>& left_table,
-    const std::string& left_collection_name,
-    const std::vector<Document>& right_table,
-    const std::string& right_collection_name,
-    const std::string& left_join_key,
-    const std::string& right_join_key
-) {
-    std::vector<Document> result;
-    std::unordered_map<std::string, std::vector<Document>> hash_table;
+// A private directory for the spill files of one join, removed with them.
+class SpillDirectory {
+public:
+    SpillDirectory() {
+        static std::atomic<uint64_t> next_id{0};
+        std::filesystem::path base;
+        {
+            std::lock_guard<std::mutex> lock(spill_directory_mutex);
+            base = spill_directory_setting;
+        }
+        if (base.empty()) base = std::filesystem::temp_directory_path();
+        const auto now = std::chrono::system_clock::now().time_since_epoch().count();
+        path_ = base / ("tissdb_join_" + std::to_string(now) + "_" + std::to_string(next_id++));
+        std::filesystem::create_directories(path_);
+    }
+    ~SpillDirectory() {
+        std::error_code ec;
+        std::filesystem::remove_all(path_, ec);
+    }
+    SpillDirectory(const SpillDirectory&) = delete;
+    SpillDirectory& operator=(const SpillDirectory&) = delete;
+
+    std::filesystem::path file(const char* side, size_t partition) const {
+        return path_ / (std::string(side) + "_" + std::to_string(partition));
+    }
+
+private:
+    std::filesystem::path path_;
+};
 
-    // Build phase
-    for (const auto& right_doc : right_table) {
-        auto right_value_opt = get_value_by_key(right_doc, right_join_key);
-        if (right_value_opt) {
-            hash_table[value_to_string(*right_value_opt)].push_back(right_doc);
+// Writes each row to the partition its key hashes to. Rows without a key
+// match nothing; they are appended to `result` if their side is kept.
+void partition_rows(const SharedDocuments& rows, const std::string& key_field, bool keep, const std::string& alias,
+                    const SpillDirectory& dir, const char* side, size_t partitions, std::vector<Document>& result) {
+    std::vector<std::ofstream> files(partitions);
+    for (size_t p = 0; p < partitions; ++p) {
+        files[p].open(dir.file(side, p), std::ios::binary);
+        if (!files[p]) {
+            throw std::runtime_error("Failed to create join spill file: " + dir.file(side, p).string());
         }
     }
+    for (const auto& row : rows) {
+        auto key = join_key(*row, key_field);
+        if (!key) {
+            if (keep) result.push_back(outer_join_row(*row, alias));
+            continue;
+        }
+        BinaryStreamBuffer out(files[std::hash<std::string>{}(*key) % partitions]);
+        out.write_bytes(serialize(*row));
+    }
+    for (auto& file : files) {
+        file.close();
+        if (!file) throw std::runtime_error("Failed to write join spill file.");
+    }
+}
 
-    // Probe phase
+// Calls `visit` with each document of a spill file, in order.
+template <typename Visit>
+void read_partition(const std::filesystem::path& path, Visit visit) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) throw std::runtime_error("Failed to open join spill file: " + path.string());
+    BinaryStreamBuffer in(file);
+    while (file.peek() != std::ifstream::traits_type::eof()) {
+        visit(deserialize(in.read_bytes()));
+    }
+}
+
+struct KeyedRow {
+    std::string key;
+    size_t row;
+};
+
+// The keyed rows of one side in key order; rows without a key are left out.
+std::vector<KeyedRow> sorted_keys(const SharedDocuments& rows, const std::string& field) {
+    std::vector<KeyedRow> keyed;
+    keyed.reserve(rows.size());
+    for (size_t i = 0; i < rows.size(); ++i) {
+        if (auto key = join_key(*rows[i], field)) keyed.push_back({std::move(*key), i});
+    }
+    auto by_key = [](const KeyedRow& a, const KeyedRow& b) { return a.key < b.key; };
+    if (!std::is_sorted(keyed.begin(), keyed.end(), by_key)) {
+        std::stable_sort(keyed.begin(), keyed.end(), by_key);
+    }
+    return keyed;
+}
+
+} // anonymous namespace
+
+std::optional<std::string> join_key(const Document& doc, const std::string& field) {
+    // As in the combined document the ON clause sees, `_id` is the only name
+    // of the document's key.
+    if (field == "_id") return string_key(doc.id);
+    for (const auto& elem : doc.elements) {
+        if (elem.key == field) return value_key(elem.value);
+    }
+    return std::string("$null");
+}
+
+Document outer_join_row(const Document& doc, const std::string& alias) {
+    Document row;
+    row.id = doc.id;
+    row.elements.reserve(doc.elements.size() + 1);
+    row.elements.push_back({alias + "._id", doc.id});
+    for (const auto& elem : doc.elements) {
+        row.elements.push_back({alias + "." + elem.key, elem.value});
+    }
+    return row;
+}
+
+void set_join_memory_limit(size_t bytes) {
+    memory_limit_setting.store(bytes, std::memory_order_relaxed);
+}
+
+size_t join_memory_limit() {
+    return memory_limit_setting.load(std::memory_order_relaxed);
+}
+
+void set_join_spill_directory(const std::string& path) {
+    std::lock_guard<std::mutex> lock(spill_directory_mutex);
+    spill_directory_setting = path;
+}
+
+std::vector<Document> JoinAlgorithms::nestedLoopJoin(
+    const SharedDocuments& left_table,
+    const SharedDocuments& right_table,
+    const JoinSpec& spec
+) {
+    std::vector<Document> result;
+    std::vector<bool> right_matched(right_table.size(), false);
     for (const auto& left_doc : left_table) {
-        auto left_value_opt = get_value_by_key(left_doc, left_join_key);
-        if (left_value_opt) {
-            auto it = hash_table.find(value_to_string(*left_value_opt));
-            if (it != hash_table.end()) {
-                for (const auto& right_doc : it->second) {
-                    result.push_back(combine_documents(left_doc, left_collection_name, right_doc, right_collection_name));
-                }
+        bool left_matched = false;
+        for (size_t j = 0; j < right_table.size(); ++j) {
+            if (join_pair(*left_doc, *right_table[j], spec, result)) {
+                left_matched = true;
+                right_matched[j] = true;
             }
         }
+        if (!left_matched && keeps_left(spec.type)) {
+            result.push_back(outer_join_row(*left_doc, spec.left_alias));
+        }
     }
+    if (keeps_right(spec.type)) {
+        append_unmatched(right_table, right_matched, spec.right_alias, result);
+    }
+    return result;
+}
 
+std::vector<Document> JoinAlgorithms::hashJoin(
+    SharedDocuments left_table,
+    SharedDocuments right_table,
+    const JoinSpec& spec,
+    size_t memory_limit
+) {
+    const bool build_is_left = left_table.size() < right_table.size();
+    const SharedDocuments& build = build_is_left ? left_table : right_table;
+    const SharedDocuments& probe = build_is_left ? right_table : left_table;
+    size_t build_bytes = 0;
+    for (const auto& doc : build) {
+        build_bytes += estimate_document_memory(*doc);
+    }
+
+    std::vector<Document> result;
+    if (memory_limit == 0 || build_bytes <= memory_limit) {
+        JoinHashTable table(spec, build_is_left);
+        for (const auto& doc : build) table.insert(*doc);
+        for (const auto& doc : probe) table.probe(*doc, result);
+        table.finish(result);
+        return result;
+    }
+
+    // Grace hash join. Partitions are sized to half the limit, leaving room
+    // for skew; a partition holding one very common key can still exceed it.
+    static Common::Counter& spilled_joins = Common::Metrics::instance().counter(
+        "tissdb_join_spills_total", "Hash joins whose build side was partitioned to disk.");
+    spilled_joins.add();
+    const size_t partitions = std::clamp<size_t>(2 * build_bytes / memory_limit + 1, 2, MAX_SPILL_PARTITIONS);
+    LOG_DEBUG("Hash join build side of " << build_bytes << " bytes spills into " << partitions << " partitions.");
+
+    SpillDirectory dir;
+    partition_rows(left_table, spec.left_key, keeps_left(spec.type), spec.left_alias, dir, "left", partitions, result);
+    partition_rows(right_table, spec.right_key, keeps_right(spec.type), spec.right_alias, dir, "right", partitions, result);
+    // Documents only the join still referenced are freed here.
+    SharedDocuments().swap(left_table);
+    SharedDocuments().swap(right_table);
+
+    const char* build_side = build_is_left ? "left" : "right";
+    const char* probe_side = build_is_left ? "right" : "left";
+    for (size_t p = 0; p < partitions; ++p) {
+        std::vector<Document> build_rows;
+        read_partition(dir.file(build_side, p), [&](Document doc) { build_rows.push_back(std::move(doc)); });
+        JoinHashTable table(spec, build_is_left);
+        for (const auto& doc : build_rows) table.insert(doc);
+        read_partition(dir.file(probe_side, p), [&](const Document& doc) { table.probe(doc, result); });
+        table.finish(result);
+    }
     return result;
 }
 
-// Implementation for Sort-Merge Join
 std::vector<Document> JoinAlgorithms::sortMergeJoin(
-    std::vector<Document> left_table,
-    const std::string& left_collection_name,
-    std::vector<Document> right_table,
-    const std::string& right_collection_name,
-    const std::string& left_join_key,
-    const std::string& right_join_key
+    const SharedDocuments& left_table,
+    const SharedDocuments& right_table,
+    const JoinSpec& spec
 ) {
-    auto sort_comparator = [&](const std::string& key) {
-        return [&](const Document& a, const Document& b) {
-            auto val_a_opt = get_value_by_key(a, key);
-            auto val_b_opt = get_value_by_key(b, key);
-            if (!val_a_opt.has_value()) return true;
-            if (!val_b_opt.has_value()) return false;
-            return value_to_string(*val_a_opt) < value_to_string(*val_b_opt);
-        };
-    };
-
-    std::sort(left_table.begin(), left_table.end(), sort_comparator(left_join_key));
-    std::sort(right_table.begin(), right_table.end(), sort_comparator(right_join_key));
+    const std::vector<KeyedRow> left_keys = sorted_keys(left_table, spec.left_key);
+    const std::vector<KeyedRow> right_keys = sorted_keys(right_table, spec.right_key);
 
     std::vector<Document> result;
+    std::vector<bool> left_matched(left_table.size(), false);
+    std::vector<bool> right_matched(right_table.size(), false);
     size_t i = 0, j = 0;
-    while (i < left_table.size() && j < right_table.size()) {
-        auto left_key = value_to_string(get_value_by_key(left_table[i], left_join_key).value_or(""));
-        auto right_key = value_to_string(get_value_by_key(right_table[j], right_join_key).value_or(""));
-
-        if (left_key < right_key) {
-            i++;
-        } else if (right_key < left_key) {
-            j++;
+    while (i < left_keys.size() && j < right_keys.size()) {
+        if (left_keys[i].key < right_keys[j].key) {
+            ++i;
+        } else if (right_keys[j].key < left_keys[i].key) {
+            ++j;
         } else {
-            size_t j_start = j;
-            while (j < right_table.size() && value_to_string(get_value_by_key(right_table[j], right_join_key).value_or("")) == left_key) {
-                result.push_back(combine_documents(left_table[i], left_collection_name, right_table[j], right_collection_name));
-                j++;
-            }
-            i++;
-            if (i < left_table.size() && value_to_string(get_value_by_key(left_table[i], left_join_key).value_or("")) == left_key) {
-                 j = j_start;
+            // Join the runs of equal keys on both sides.
+            size_t i_end = i, j_end = j;
+            while (i_end < left_keys.size() && left_keys[i_end].key == left_keys[i].key) ++i_end;
+            while (j_end < right_keys.size() && right_keys[j_end].key == right_keys[j].key) ++j_end;
+            for (size_t a = i; a < i_end; ++a) {
+                for (size_t b = j; b < j_end; ++b) {
+                    const size_t left_row = left_keys[a].row, right_row = right_keys[b].row;
+                    if (join_pair(*left_table[left_row], *right_table[right_row], spec, result)) {
+                        left_matched[left_row] = true;
+                        right_matched[right_row] = true;
+                    }
+                }
             }
+            i = i_end;
+            j = j_end;
         }
     }
+    if (keeps_left(spec.type)) append_unmatched(left_table, left_matched, spec.left_alias, result);
+    if (keeps_right(spec.type)) append_unmatched(right_table, right_matched, spec.right_alias, result);
     return result;
 }
 
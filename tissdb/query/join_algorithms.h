@@ -2,52 +2,79 @@
 #ifndef TISSDB_JOIN_ALGORITHMS_H
 #define TISSDB_JOIN_ALGORITHMS_H
 
-#include <vector>
+#include <cstddef>
+#include <memory>
+#include <optional>
 #include <string>
+#include <vector>
+#include "ast.h"
+#include "compiled_expression.h"
 #include "../common/document.h"
 
 namespace TissDB {
 namespace Query {
 
-// Forward declarations for potential data structures
-// struct TableData; // Represents data from a table/collection
+using SharedDocuments = std::vector<std::shared_ptr<const Document>>;
+
+// A join of two document sets. Rows pair up when `on_condition`, the whole
+// ON clause, holds for their combined document, whose fields are qualified
+// by the side's alias (see combine_documents). For an equi-join, the key
+// fields name the unqualified field each side is matched on; they let the
+// hash and sort-merge joins test only the pairs whose keys are equal.
+//
+// Rows an outer join keeps without a match are qualified the same way and
+// hold only their own side's fields.
+struct JoinSpec {
+    JoinType type = JoinType::INNER;
+    std::string left_alias;
+    std::string right_alias;
+    std::string left_key;
+    std::string right_key;
+    const CompiledExpression* on_condition = nullptr;
+};
 
 class JoinAlgorithms {
 public:
-    // Placeholder for Nested Loop Join
-    static std::vector<Document> nestedLoopJoin(
-        const std::vector<Document>& left_table,
-        const std::string& left_collection_name,
-        const std::vector<Document>& right_table,
-        const std::string& right_collection_name,
-        const std::string& left_join_key,
-        const std::string& right_join_key
-    );
-
-    // Placeholder for Hash Join
-    static std::vector<Document> hashJoin(
-        const std::vector<Document>& left_table,
-        const std::string& left_collection_name,
-        const std::vector<Document>& right_table,
-        const std::string& right_collection_name,
-        const std::string& left_join_key,
-        const std::string& right_join_key
-    );
-
-    // Placeholder for Sort-Merge Join
-    static std::vector<Document> sortMergeJoin(
-        std::vector<Document> left_table,
-        const std::string& left_collection_name,
-        std::vector<Document> right_table,
-        const std::string& right_collection_name,
-        const std::string& left_join_key,
-        const std::string& right_join_key
-    );
-
-private:
-    // Helper methods for joining, if any
+    // Tests every pair; the only algorithm that needs no key. Left rows come
+    // out in order, each followed by its matches.
+    static std::vector<Document> nestedLoopJoin(const SharedDocuments& left_table,
+                                                const SharedDocuments& right_table,
+                                                const JoinSpec& spec);
+
+    // Builds a hash table on the smaller side and probes it with the other.
+    // If the build side takes more than `memory_limit` bytes, both sides are
+    // first partitioned by key hash into spill files, and the partitions are
+    // joined one at a time (a grace hash join). The inputs are released once
+    // partitioned, so only one partition's build rows are in memory at once.
+    static std::vector<Document> hashJoin(SharedDocuments left_table,
+                                          SharedDocuments right_table,
+                                          const JoinSpec& spec,
+                                          size_t memory_limit);
+
+    // Sorts both sides on the key, skipping a side that already is in key
+    // order, and merges them. Matches come out in key order.
+    static std::vector<Document> sortMergeJoin(const SharedDocuments& left_table,
+                                               const SharedDocuments& right_table,
+                                               const JoinSpec& spec);
 };
 
+// The key the hash and sort-merge joins match `field` of `doc` on. Values the
+// `=` of an ON clause holds equal have equal keys: numbers and strings that
+// read as numbers are keyed by their number, other values by the text they
+// compare as. Values `=` holds equal to nothing (binary data, arrays and
+// objects) have no key. A missing field is keyed as null.
+std::optional<std::string> join_key(const Document& doc, const std::string& field);
+
+// A row an outer join keeps without a match.
+Document outer_join_row(const Document& doc, const std::string& alias);
+
+// Build-side bytes past which a hash join spills; 64 MiB by default.
+void set_join_memory_limit(size_t bytes);
+size_t join_memory_limit();
+
+// Where spill files are written; the system temporary directory by default.
+void set_join_spill_directory(const std::string& path);
+
 } // namespace Query
 } // namespace TissDB
 
@@ -0,0 +1,39 @@
+#include "parallel.h"
+
+#include <algorithm>
+#include <thread>
+
+namespace TissDB {
+namespace Query {
+
+namespace {
+
+std::atomic<size_t> max_parallelism{0}; // 0: every core
+
+} // anonymous namespace
+
+Common::ThreadPool& query_thread_pool() {
+    // One thread fewer than there are cores: the calling thread is the last.
+    static Common::ThreadPool pool(std::max(2u, std::thread::hardware_concurrency()) - 1);
+    return pool;
+}
+
+void set_max_query_parallelism(size_t threads) {
+    max_parallelism.store(threads, std::memory_order_relaxed);
+}
+
+size_t max_query_parallelism() {
+    const size_t cores = query_thread_pool().size() + 1;
+    const size_t limit = max_parallelism.load(std::memory_order_relaxed);
+    return limit == 0 ? cores : std::min(limit, cores);
+}
+
+size_t parallel_task_count(size_t rows, size_t parallelism) {
+    size_t threads = max_query_parallelism();
+    if (parallelism != 0) threads = std::min(threads, parallelism);
+    const size_t by_rows = rows / PARALLEL_MIN_ROWS_PER_TASK;
+    return std::max<size_t>(1, std::min(by_rows, threads));
+}
+
+} // namespace Query
+} // namespace TissDB
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <future>
+#include <vector>
+#include "../common/thread_pool.h"
+
+namespace TissDB {
+namespace Query {
+
+// Worker threads shared by all queries for work split within one statement.
+// The thread running the statement takes a share of the work itself and
+// waits for the rest, so tasks must not wait on other pool tasks.
+Common::ThreadPool& query_thread_pool();
+
+// The most threads one statement may use, counting its own; every core by
+// default. Lower it to leave cores for other requests.
+void set_max_query_parallelism(size_t threads);
+size_t max_query_parallelism();
+
+// Rows below which splitting work across threads does not pay off.
+constexpr size_t PARALLEL_MIN_ROWS_PER_TASK = 16384;
+
+// How many threads to split `rows` rows across: each gets at least
+// PARALLEL_MIN_ROWS_PER_TASK rows, and there are no more than
+// `parallelism`, the statement's own limit if not 0, or the server's.
+size_t parallel_task_count(size_t rows, size_t parallelism = 0);
+
+// Runs fn(worker, morsel) for each morsel in [0, morsels) on `workers`
+// threads: the calling thread, as worker 0, and workers - 1 pool tasks.
+// Threads claim the next morsel until none are left, so one that is slowed,
+// or starts late because the pool is busy with other statements, simply
+// runs fewer. Returns once every morsel has run; if any threw, the first
+// exception is rethrown.
+template <typename Fn>
+void run_morsels(size_t workers, size_t morsels, Fn fn) {
+    std::atomic<size_t> next{0};
+    std::atomic<bool> failed{false};
+    auto work = [&](size_t worker) {
+        for (size_t m = next++; m < morsels && !failed; m = next++) {
+            try {
+                fn(worker, m);
+            } catch (...) {
+                failed = true;
+                throw;
+            }
+        }
+    };
+
+    std::vector<std::future<void>> helpers;
+    std::exception_ptr error;
+    try {
+        for (size_t w = 1; w < workers && w < morsels; ++w) {
+            helpers.push_back(query_thread_pool().submit([&work, w] { work(w); }));
+        }
+        work(0);
+    } catch (...) {
+        failed = true;
+        error = std::current_exception();
+    }
+    // Every helper is waited for before returning, as they use this frame.
+    for (auto& helper : helpers) {
+        try {
+            helper.get();
+        } catch (...) {
+            if (!error) error = std::current_exception();
+        }
+    }
+    if (error) std::rethrow_exception(error);
+}
+
+} // namespace Query
+} // namespace TissDB
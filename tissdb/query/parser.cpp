@@ -1,4 +1,5 @@
 #include "parser.h"
+#include "query_metrics.h"
 #include "../common/log.h"
 #include <stdexcept>
 #include <cctype>
@@ -196,7 +197,7 @@ std::vector<Token> Parser::tokenize(const std::string& query_string) {
             std::string upper_value = value;
             std::transform(upper_value.begin(), upper_value.end(), upper_value.begin(), ::toupper);
 
-            if (upper_value == "SELECT" || upper_value == "FROM" || upper_value == "WHERE" || upper_value == "AND" || upper_value == "OR" || upper_value == "UPDATE" || upper_value == "DELETE" || upper_value == "SET" || upper_value == "GROUP" || upper_value == "BY" || upper_value == "COUNT" || upper_value == "AVG" || upper_value == "SUM" || upper_value == "MIN" || upper_value == "MAX" || upper_value == "INSERT" || upper_value == "INTO" || upper_value == "VALUES" || upper_value == "STDDEV" || upper_value == "LIKE" || upper_value == "ORDER" || upper_value == "LIMIT" || upper_value == "JOIN" || upper_value == "ON" || upper_value == "UNION" || upper_value == "ALL" || upper_value == "ASC" || upper_value == "DESC" || upper_value == "WITH" || upper_value == "DRILLDOWN" || upper_value == "TRUE" || upper_value == "FALSE" || upper_value == "NULL" || upper_value == "DATE" || upper_value == "TIME" || upper_value == "DATETIME" || upper_value == "TIMESTAMP" || upper_value == "AS" || upper_value == "INNER" || upper_value == "LEFT" || upper_value == "RIGHT" || upper_value == "FULL" || upper_value == "CROSS" || upper_value == "BETWEEN" || upper_value == "NOT" || upper_value == "INTERVAL" || upper_value == "EXTRACT" || upper_value == "NOW") {
+            if (upper_value == "SELECT" || upper_value == "FROM" || upper_value == "WHERE" || upper_value == "AND" || upper_value == "OR" || upper_value == "UPDATE" || upper_value == "DELETE" || upper_value == "SET" || upper_value == "GROUP" || upper_value == "BY" || upper_value == "COUNT" || upper_value == "AVG" || upper_value == "SUM" || upper_value == "MIN" || upper_value == "MAX" || upper_value == "INSERT" || upper_value == "INTO" || upper_value == "VALUES" || upper_value == "STDDEV" || upper_value == "LIKE" || upper_value == "ORDER" || upper_value == "LIMIT" || upper_value == "JOIN" || upper_value == "ON" || upper_value == "UNION" || upper_value == "ALL" || upper_value == "ASC" || upper_value == "DESC" || upper_value == "WITH" || upper_value == "DRILLDOWN" || upper_value == "TRUE" || upper_value == "FALSE" || upper_value == "NULL" || upper_value == "DATE" || upper_value == "TIME" || upper_value == "DATETIME" || upper_value == "TIMESTAMP" || upper_value == "AS" || upper_value == "INNER" || upper_value == "LEFT" || upper_value == "RIGHT" || upper_value == "FULL" || upper_value == "CROSS" || upper_value == "BETWEEN" || upper_value == "NOT" || upper_value == "INTERVAL" || upper_value == "EXTRACT" || upper_value == "NOW" || upper_value == "ANALYZE" || upper_value == "EXPLAIN") {
                 new_tokens.push_back(Token{Token::Type::KEYWORD, upper_value});
             } else {
                 new_tokens.push_back(Token{Token::Type::IDENTIFIER, value});
@@ -252,11 +253,18 @@ std::vector<Token> Parser::tokenize(const std::string& query_string) {
 Parser::Parser() = default;
 
 AST Parser::parse(const std::string& query_string) {
-    LOG_INFO("Parsing query: " + query_string);
+    LOG_DEBUG("Parsing query: " << query_string);
+    const auto start = std::chrono::steady_clock::now();
     tokens = tokenize(query_string);
     pos = 0;
     param_index = 0;
 
+    AST ast = parse_statement();
+    stage_latency(QueryStage::Parse, ast).record(std::chrono::steady_clock::now() - start);
+    return ast;
+}
+
+AST Parser::parse_statement() {
     if (peek().type == Token::Type::KEYWORD) {
         if (peek().value == "SELECT") {
             auto ast = parse_select_statement();
@@ -274,10 +282,18 @@ AST Parser::parse(const std::string& query_string) {
             auto ast = parse_insert_statement();
             LOG_DEBUG("Successfully parsed INSERT statement.");
             return ast;
+        } else if (peek().value == "ANALYZE") {
+            auto ast = parse_analyze_statement();
+            LOG_DEBUG("Successfully parsed ANALYZE statement.");
+            return ast;
+        } else if (peek().value == "EXPLAIN") {
+            auto ast = parse_explain_statement();
+            LOG_DEBUG("Successfully parsed EXPLAIN statement.");
+            return ast;
         }
     }
 
-    LOG_ERROR("Unsupported statement type at start of query.");
+    LOG_DEBUG("Unsupported statement type at start of query.");
     throw std::runtime_error("Unsupported statement type");
 }
 
@@ -352,6 +368,25 @@ DeleteStatement Parser::parse_delete_statement() {
     return {table, std::move(where)};
 }
 
+AnalyzeStatement Parser::parse_analyze_statement() {
+    expect(Token::Type::KEYWORD, "ANALYZE");
+    return {parse_table_name()};
+}
+
+ExplainStatement Parser::parse_explain_statement() {
+    expect(Token::Type::KEYWORD, "EXPLAIN");
+    ExplainStatement explain;
+    if (peek().type == Token::Type::KEYWORD && peek().value == "ANALYZE") {
+        consume();
+        explain.analyze = true;
+    }
+    if (peek().type != Token::Type::KEYWORD || peek().value != "SELECT") {
+        throw std::runtime_error("EXPLAIN supports SELECT statements only");
+    }
+    explain.select = parse_select_statement();
+    return explain;
+}
+
 InsertStatement Parser::parse_insert_statement() {
     expect(Token::Type::KEYWORD, "INSERT");
     expect(Token::Type::KEYWORD, "INTO");
@@ -379,7 +414,7 @@ std::vector<std::variant<std::string, AggregateFunction>> Parser::parse_select_l
     }
 
     do {
-        if (peek().type == Token::Type::KEYWORD && (peek().value == "COUNT" || peek().value == "AVG" || peek().value == "SUM" || peek().value == "MIN" || peek().value == "MAX")) {
+        if (peek().type == Token::Type::KEYWORD && (peek().value == "COUNT" || peek().value == "AVG" || peek().value == "SUM" || peek().value == "MIN" || peek().value == "MAX" || peek().value == "STDDEV")) {
             fields.push_back(parse_aggregate_function());
         } else {
             // It's a regular column name, possibly qualified (e.g., table.column)
@@ -410,6 +445,7 @@ AggregateFunction Parser::parse_aggregate_function() {
     else if (func_name == "SUM") type = AggregateType::SUM;
     else if (func_name == "MIN") type = AggregateType::MIN;
     else if (func_name == "MAX") type = AggregateType::MAX;
+    else if (func_name == "STDDEV") type = AggregateType::STDDEV;
     else {
         throw std::runtime_error("Unknown aggregate function: " + func_name);
     }
@@ -779,7 +815,7 @@ Expression Parser::parse_primary_expression() {
         expect(Token::Type::OPERATOR, ")");
         return expr;
     }
-    LOG_ERROR("Parse error: Unexpected token in expression: " + token.value);
+    LOG_DEBUG("Parse error: Unexpected token in expression: " << token.value);
     throw std::runtime_error("Unexpected token in expression");
 }
 
@@ -797,7 +833,7 @@ void Parser::expect(Token::Type type, const std::string& value) {
     auto token = consume();
     if (token.type != type || (!value.empty() && token.value != value)) {
         std::string error_msg = "Expected token " + value + " but got " + token.value;
-        LOG_ERROR("Parse error: " + error_msg);
+        LOG_DEBUG("Parse error: " << error_msg);
         throw std::runtime_error(error_msg);
     }
 }
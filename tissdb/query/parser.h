@@ -22,6 +22,8 @@ class Parser {
 public:
     Parser();
     AST parse(const std::string& query_string);
+    // `?` placeholders in the statement parsed last.
+    size_t parameter_count() const { return param_index; }
 
 private:
     std::vector<Token> tokens;
@@ -32,10 +34,13 @@ private:
     std::vector<Token> tokenize(const std::string& query_string);
 
     // Parser methods
+    AST parse_statement();
     SelectStatement parse_select_statement();
     UpdateStatement parse_update_statement();
     DeleteStatement parse_delete_statement();
     InsertStatement parse_insert_statement();
+    AnalyzeStatement parse_analyze_statement();
+    ExplainStatement parse_explain_statement();
     std::vector<std::variant<std::string, AggregateFunction>> parse_select_list();
     std::string parse_table_name();
     std::vector<std::string> parse_column_list();
@@ -0,0 +1,42 @@
+#include "query_metrics.h"
+
+#include <array>
+#include <iterator>
+#include <string>
+
+namespace TissDB {
+namespace Query {
+
+const char* const QUERY_SECONDS_HELP = "Time spent in each stage of a query, by statement kind.";
+
+namespace {
+constexpr const char* STAGE_NAMES[] = {"parse", "execute"};
+constexpr const char* STATEMENT_NAMES[] = {"select", "update", "delete", "insert", "create_table", "analyze", "explain"};
+static_assert(std::size(STATEMENT_NAMES) == std::variant_size_v<AST>, "a statement kind has no name");
+
+constexpr size_t STAGES = std::size(STAGE_NAMES);
+constexpr size_t STATEMENTS = std::size(STATEMENT_NAMES);
+} // anonymous namespace
+
+const char* statement_name(const AST& ast) {
+    return STATEMENT_NAMES[ast.index()];
+}
+
+Common::Histogram& stage_latency(QueryStage stage, const AST& ast) {
+    // Looked up once; recording then touches no lock.
+    static const auto histograms = [] {
+        std::array<std::array<Common::Histogram*, STATEMENTS>, STAGES> table{};
+        for (size_t s = 0; s < STAGES; ++s) {
+            for (size_t k = 0; k < STATEMENTS; ++k) {
+                table[s][k] = &Common::Metrics::instance().histogram(
+                    "tissdb_query_seconds", QUERY_SECONDS_HELP,
+                    std::string("stage=\"") + STAGE_NAMES[s] + "\",statement=\"" + STATEMENT_NAMES[k] + "\"");
+            }
+        }
+        return table;
+    }();
+    return *histograms[static_cast<size_t>(stage)][ast.index()];
+}
+
+} // namespace Query
+} // namespace TissDB
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "ast.h"
+#include "../common/metrics.h"
+
+namespace TissDB {
+namespace Query {
+
+// Help text of the tissdb_query_seconds histograms. SELECT also records a
+// stage="plan" histogram: the part of execution spent choosing access paths
+// and join strategies.
+extern const char* const QUERY_SECONDS_HELP;
+
+enum class QueryStage {
+    Parse,   // Query text to AST
+    Execute, // Running the statement, planning included
+};
+
+// Lower-case name of the statement kind, e.g. "select".
+const char* statement_name(const AST& ast);
+
+// Latency of one stage of one kind of statement, exported as
+// tissdb_query_seconds{stage=...,statement=...}.
+Common::Histogram& stage_latency(QueryStage stage, const AST& ast);
+
+} // namespace Query
+} // namespace TissDB
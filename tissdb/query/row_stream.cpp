@@ -0,0 +1,62 @@
+#include "row_stream.h"
+#include "executor_common.h"
+#include <cmath>
+#include <limits>
+
+namespace TissDB {
+namespace Query {
+
+const Document* ScanStream::next() {
+    if (position_ == rows_.size()) return nullptr;
+    return rows_[position_++];
+}
+
+const Document* FilterStream::next() {
+    while (const Document* row = input_.next()) {
+        if (predicate_.matches(*row)) return row;
+    }
+    return nullptr;
+}
+
+const Document* LimitStream::next() {
+    if (remaining_ == 0) return nullptr;
+    const Document* row = input_.next();
+    if (row) --remaining_;
+    return row;
+}
+
+ProjectStream::ProjectStream(RowStream& input, const std::vector<std::variant<std::string, AggregateFunction>>& fields)
+    : input_(input), fields_(fields) {
+    select_all_ = !fields.empty() && std::holds_alternative<std::string>(fields[0]) &&
+                  std::get<std::string>(fields[0]) == "*";
+}
+
+const Document* ProjectStream::next() {
+    const Document* row = input_.next();
+    if (!row || select_all_) return row;
+    current_ = project_fields(*row, fields_);
+    return &current_;
+}
+
+std::vector<Document> drain(RowStream& input) {
+    std::vector<Document> rows;
+    while (const Document* row = input.next()) {
+        rows.push_back(*row);
+    }
+    return rows;
+}
+
+size_t limit_rows(double limit) {
+    if (!(limit > 0)) return 0;
+    if (limit >= static_cast<double>(std::numeric_limits<size_t>::max())) return std::numeric_limits<size_t>::max();
+    return static_cast<size_t>(std::floor(limit));
+}
+
+void apply_limit(std::vector<Document>& docs, const std::optional<double>& limit) {
+    if (limit && docs.size() > limit_rows(*limit)) {
+        docs.resize(limit_rows(*limit));
+    }
+}
+
+} // namespace Query
+} // namespace TissDB
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <variant>
+#include <vector>
+#include "ast.h"
+#include "column_batch.h"
+#include "compiled_expression.h"
+#include "../common/document.h"
+
+namespace TissDB {
+namespace Query {
+
+// Pull-based operators of a single-collection SELECT: Scan -> Filter ->
+// Limit -> Project. next() returns the next row, or null at the end of the
+// stream; the row stays valid until the following call. Rows are passed by
+// pointer and only copied where the result is built, so a document the
+// filter rejects is never copied, and a satisfied LIMIT stops the scan.
+class RowStream {
+public:
+    virtual ~RowStream() = default;
+    virtual const Document* next() = 0;
+};
+
+// The documents of `rows`, which must outlive the stream.
+class ScanStream : public RowStream {
+public:
+    explicit ScanStream(const DocumentRows& rows) : rows_(rows) {}
+    const Document* next() override;
+
+private:
+    const DocumentRows& rows_;
+    size_t position_ = 0;
+};
+
+// The rows of `input` that satisfy `predicate`.
+class FilterStream : public RowStream {
+public:
+    FilterStream(RowStream& input, CompiledExpression predicate)
+        : input_(input), predicate_(std::move(predicate)) {}
+    const Document* next() override;
+
+private:
+    RowStream& input_;
+    CompiledExpression predicate_;
+};
+
+// The first `limit` rows of `input`; `input` is not pulled from after that.
+class LimitStream : public RowStream {
+public:
+    LimitStream(RowStream& input, size_t limit) : input_(input), remaining_(limit) {}
+    const Document* next() override;
+
+private:
+    RowStream& input_;
+    size_t remaining_;
+};
+
+// The SELECT list of each row of `input`; see project_fields.
+class ProjectStream : public RowStream {
+public:
+    ProjectStream(RowStream& input, const std::vector<std::variant<std::string, AggregateFunction>>& fields);
+    const Document* next() override;
+
+private:
+    RowStream& input_;
+    const std::vector<std::variant<std::string, AggregateFunction>>& fields_;
+    bool select_all_;
+    Document current_;
+};
+
+// Copies the remaining rows of `input`.
+std::vector<Document> drain(RowStream& input);
+
+// The number of rows a LIMIT clause keeps.
+size_t limit_rows(double limit);
+// Drops the rows past `limit`, if there is one.
+void apply_limit(std::vector<Document>& docs, const std::optional<double>& limit);
+
+} // namespace Query
+} // namespace TissDB
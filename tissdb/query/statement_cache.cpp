@@ -0,0 +1,168 @@
+#include "statement_cache.h"
+#include "parser.h"
+#include "../common/metrics.h"
+
+#include <cctype>
+#include <stdexcept>
+
+namespace TissDB {
+namespace Query {
+
+namespace {
+
+const char* const CACHE_HELP = "Statement lookups in the parsed-statement cache.";
+
+std::string cache_key(const std::string& db, const std::string& text) {
+    std::string key = db;
+    key += '\0';
+    key += text;
+    return key;
+}
+
+std::vector<std::string> condition_fields(const std::map<std::string, std::string>& conditions) {
+    std::vector<std::string> fields;
+    fields.reserve(conditions.size());
+    for (const auto& [field, value] : conditions) fields.push_back(field);
+    return fields;
+}
+
+bool same_fields(const std::vector<std::string>& fields, const std::map<std::string, std::string>& conditions) {
+    if (fields.size() != conditions.size()) return false;
+    size_t i = 0;
+    for (const auto& [field, value] : conditions) {
+        if (fields[i++] != field) return false;
+    }
+    return true;
+}
+
+} // anonymous namespace
+
+bool CachedAccessPath::get(uint64_t catalog_version, const std::map<std::string, std::string>& conditions,
+                           AccessPath& access) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!valid_ || catalog_version_ != catalog_version || !same_fields(fields_, conditions)) return false;
+    access = access_;
+    return true;
+}
+
+void CachedAccessPath::set(uint64_t catalog_version, const std::map<std::string, std::string>& conditions,
+                           const AccessPath& access) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    valid_ = true;
+    catalog_version_ = catalog_version;
+    fields_ = condition_fields(conditions);
+    access_ = access;
+}
+
+std::string normalize_query(const std::string& query) {
+    std::string text;
+    text.reserve(query.size());
+    char quote = 0;
+    bool space = false;
+    for (char c : query) {
+        if (quote == 0 && std::isspace(static_cast<unsigned char>(c))) {
+            space = !text.empty();
+            continue;
+        }
+        if (space) text += ' ';
+        space = false;
+        text += c;
+        if (quote == 0 && (c == '\'' || c == '"')) {
+            quote = c;
+        } else if (c == quote) {
+            quote = 0;
+        }
+    }
+    while (!text.empty() && (text.back() == ';' || text.back() == ' ')) text.pop_back();
+    return text;
+}
+
+StatementCache::StatementCache(size_t capacity) : capacity_(capacity) {}
+
+std::shared_ptr<PreparedStatement> StatementCache::get(const std::string& db, const std::string& query) {
+    static Common::Counter& hits = Common::Metrics::instance().counter(
+        "tissdb_statement_cache_total", CACHE_HELP, "result=\"hit\"");
+    static Common::Counter& misses = Common::Metrics::instance().counter(
+        "tissdb_statement_cache_total", CACHE_HELP, "result=\"miss\"");
+    const std::string key = cache_key(db, normalize_query(query));
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (auto it = entries_.find(key); it != entries_.end()) {
+            lru_.splice(lru_.begin(), lru_, it->second);
+            hits.add();
+            return it->second->second;
+        }
+    }
+    misses.add();
+
+    // Parsed without the lock, so other lookups do not wait for it.
+    auto statement = std::make_shared<PreparedStatement>();
+    Parser parser;
+    statement->ast = parser.parse(query);
+    statement->param_count = parser.parameter_count();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (auto it = entries_.find(key); it != entries_.end()) {
+        lru_.splice(lru_.begin(), lru_, it->second);
+        return it->second->second; // Parsed by another request meanwhile
+    }
+    if (capacity_ == 0) return statement;
+    lru_.emplace_front(key, statement);
+    entries_[key] = lru_.begin();
+    while (lru_.size() > capacity_) {
+        entries_.erase(lru_.back().first);
+        lru_.pop_back();
+    }
+    return statement;
+}
+
+std::string StatementCache::prepare(const std::string& db, const std::string& query) {
+    auto statement = get(db, query);
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (prepared_.size() >= MAX_PREPARED) {
+        throw std::runtime_error("Too many prepared statements (" + std::to_string(MAX_PREPARED) + ").");
+    }
+    std::string handle = "stmt" + std::to_string(next_handle_++);
+    prepared_[cache_key(db, handle)] = std::move(statement);
+    return handle;
+}
+
+std::shared_ptr<PreparedStatement> StatementCache::find(const std::string& db, const std::string& handle) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = prepared_.find(cache_key(db, handle));
+    return it == prepared_.end() ? nullptr : it->second;
+}
+
+bool StatementCache::deallocate(const std::string& db, const std::string& handle) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return prepared_.erase(cache_key(db, handle)) > 0;
+}
+
+void StatementCache::forget_database(const std::string& db) {
+    const std::string prefix = cache_key(db, "");
+    auto in_db = [&](const std::string& key) { return key.compare(0, prefix.size(), prefix) == 0; };
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto it = lru_.begin(); it != lru_.end();) {
+        if (in_db(it->first)) {
+            entries_.erase(it->first);
+            it = lru_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    auto it = prepared_.lower_bound(prefix);
+    while (it != prepared_.end() && in_db(it->first)) it = prepared_.erase(it);
+}
+
+size_t StatementCache::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return lru_.size();
+}
+
+size_t StatementCache::prepared_count() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return prepared_.size();
+}
+
+} // namespace Query
+} // namespace TissDB
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ast.h"
+#include "cost_model.h"
+
+namespace TissDB {
+namespace Query {
+
+// The access path last chosen for the collection a statement reads or
+// writes. It is reused while the database's catalog version (see
+// LSMTree::catalog_version) and the fields bound by equality conditions are
+// the same.
+class CachedAccessPath {
+public:
+    bool get(uint64_t catalog_version, const std::map<std::string, std::string>& conditions, AccessPath& access) const;
+    void set(uint64_t catalog_version, const std::map<std::string, std::string>& conditions, const AccessPath& access);
+
+private:
+    mutable std::mutex mutex_;
+    bool valid_ = false;
+    uint64_t catalog_version_ = 0;
+    std::vector<std::string> fields_;
+    AccessPath access_;
+};
+
+// A parsed statement, shared by every execution of the same query text on
+// one database. Only its cached plan changes after parsing.
+struct PreparedStatement {
+    AST ast;
+    size_t param_count = 0; // `?` placeholders
+    CachedAccessPath access_path;
+};
+
+// The cache key of a query: its text with runs of whitespace outside string
+// literals collapsed to one space and trailing semicolons dropped.
+std::string normalize_query(const std::string& query);
+
+// Parsed statements by database and normalized query text, so a query sent
+// again is not parsed again. Statements used least recently are dropped
+// first, except those prepared under a handle, which stay until
+// deallocated. Thread-safe.
+class StatementCache {
+public:
+    static constexpr size_t DEFAULT_CAPACITY = 1024;
+    static constexpr size_t MAX_PREPARED = 4096;
+
+    explicit StatementCache(size_t capacity = DEFAULT_CAPACITY);
+
+    // The statement for `query` on database `db`, parsed on a miss. Parse
+    // errors are thrown and nothing is cached.
+    std::shared_ptr<PreparedStatement> get(const std::string& db, const std::string& query);
+
+    // Parses `query` (or finds it) and keeps it under a new handle. Throws if
+    // MAX_PREPARED statements are prepared already.
+    std::string prepare(const std::string& db, const std::string& query);
+    // The statement prepared under `handle` on `db`; null if there is none.
+    std::shared_ptr<PreparedStatement> find(const std::string& db, const std::string& handle) const;
+    // Drops a handle; false if there was none.
+    bool deallocate(const std::string& db, const std::string& handle);
+
+    // Drops every statement and handle of `db`, which was deleted.
+    void forget_database(const std::string& db);
+
+    size_t size() const;
+    size_t prepared_count() const;
+
+private:
+    using Entry = std::pair<std::string, std::shared_ptr<PreparedStatement>>; // Key, statement
+
+    mutable std::mutex mutex_;
+    size_t capacity_;
+    std::list<Entry> lru_; // Most recently used first
+    std::unordered_map<std::string, std::list<Entry>::iterator> entries_;
+    std::map<std::string, std::shared_ptr<PreparedStatement>> prepared_; // "db\0handle" -> statement
+    uint64_t next_handle_ = 1;
+};
+
+} // namespace Query
+} // namespace TissDB
@@ -0,0 +1,77 @@
+#include "change_codec.h"
+#include "../common/serialization.h"
+
+#include <stdexcept>
+#include <variant>
+
+namespace TissDB {
+namespace Replication {
+
+namespace {
+std::string to_hex(const std::vector<uint8_t>& bytes) {
+    static const char digits[] = "0123456789abcdef";
+    std::string hex;
+    hex.reserve(bytes.size() * 2);
+    for (uint8_t byte : bytes) {
+        hex += digits[byte >> 4];
+        hex += digits[byte & 0x0F];
+    }
+    return hex;
+}
+
+int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    throw std::runtime_error("Invalid hex digit in change record.");
+}
+
+std::vector<uint8_t> from_hex(const std::string& hex) {
+    if (hex.size() % 2 != 0) {
+        throw std::runtime_error("Odd-length hex string in change record.");
+    }
+    std::vector<uint8_t> bytes(hex.size() / 2);
+    for (size_t i = 0; i < bytes.size(); ++i) {
+        bytes[i] = static_cast<uint8_t>(hex_value(hex[2 * i]) << 4 | hex_value(hex[2 * i + 1]));
+    }
+    return bytes;
+}
+} // anonymous namespace
+
+Json::JsonObject encode_change(const Storage::ChangeEvent& change) {
+    Json::JsonObject obj;
+    obj["lsn"] = Json::JsonValue(static_cast<double>(change.lsn));
+    obj["op"] = Json::JsonValue(change.type == Storage::LogEntryType::PUT ? "put" : "delete");
+    obj["collection"] = Json::JsonValue(change.collection_name);
+    obj["id"] = Json::JsonValue(change.document_id);
+    if (change.type == Storage::LogEntryType::PUT) {
+        obj["doc_bin"] = Json::JsonValue(to_hex(TissDB::serialize(change.doc)));
+    }
+    return obj;
+}
+
+Storage::ChangeEvent decode_change(const Json::JsonObject& obj) {
+    try {
+        Storage::ChangeEvent change;
+        change.lsn = static_cast<uint64_t>(obj.at("lsn").as_number());
+        const std::string& op = obj.at("op").as_string();
+        if (op == "put") {
+            change.type = Storage::LogEntryType::PUT;
+            change.doc = TissDB::deserialize(from_hex(obj.at("doc_bin").as_string()));
+        } else if (op == "delete") {
+            change.type = Storage::LogEntryType::DELETE;
+        } else {
+            throw std::runtime_error("Unknown change operation: " + op);
+        }
+        change.collection_name = obj.at("collection").as_string();
+        change.document_id = obj.at("id").as_string();
+        return change;
+    } catch (const std::out_of_range&) {
+        throw std::runtime_error("Change record is missing a field.");
+    } catch (const std::bad_variant_access&) {
+        throw std::runtime_error("Change record has a field of the wrong type.");
+    }
+}
+
+} // namespace Replication
+} // namespace TissDB
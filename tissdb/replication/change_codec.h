@@ -0,0 +1,17 @@
+#pragma once
+
+#include "../json/json.h"
+#include "../storage/change_feed.h"
+
+namespace TissDB {
+namespace Replication {
+
+// Wire form of a change for replicas: the document travels in its binary
+// serialization (hex encoded), so every value type survives the round trip.
+Json::JsonObject encode_change(const Storage::ChangeEvent& change);
+
+// Inverse of encode_change. Throws std::runtime_error on malformed input.
+Storage::ChangeEvent decode_change(const Json::JsonObject& obj);
+
+} // namespace Replication
+} // namespace TissDB
@@ -0,0 +1,163 @@
+#include "follower.h"
+#include "change_codec.h"
+#include "../common/log.h"
+#include "../storage/database_manager.h"
+
+#include <stdexcept>
+
+namespace TissDB {
+namespace Replication {
+
+namespace {
+// Extra time allowed for a long-poll reply beyond the leader-side wait.
+constexpr std::chrono::milliseconds REPLY_GRACE{5000};
+} // anonymous namespace
+
+const char* to_string(ReplicaState state) {
+    switch (state) {
+        case ReplicaState::Connecting: return "connecting";
+        case ReplicaState::Streaming: return "streaming";
+        case ReplicaState::ResyncRequired: return "resync_required";
+        case ReplicaState::Error: return "error";
+    }
+    return "unknown";
+}
+
+Follower::Follower(Storage::DatabaseManager& db_manager, const FollowerOptions& options)
+    : db_manager_(db_manager), options_(options),
+      client_(options.leader_host, options.leader_port, options.token) {}
+
+Follower::~Follower() {
+    stop();
+}
+
+void Follower::start() {
+    stopping_.store(false);
+    discovery_thread_ = std::thread([this] { discovery_loop(); });
+}
+
+void Follower::stop() {
+    {
+        std::lock_guard<std::mutex> lock(stop_mutex_);
+        stopping_.store(true);
+    }
+    stop_cv_.notify_all();
+    if (discovery_thread_.joinable()) {
+        discovery_thread_.join();
+    }
+}
+
+bool Follower::pause(std::chrono::milliseconds duration) {
+    std::unique_lock<std::mutex> lock(stop_mutex_);
+    return !stop_cv_.wait_for(lock, duration, [this] { return stopping_.load(); });
+}
+
+void Follower::discovery_loop() {
+    LOG_INFO("Replicating from leader at " + client_.endpoint());
+    do {
+        try {
+            discover();
+        } catch (const std::exception& e) {
+            LOG_EVERY_N_SEC(LogLevel::WARNING, 60, "Replication: could not list databases on " << client_.endpoint() << ": " << e.what());
+        }
+    } while (pause(options_.discovery_interval));
+
+    for (auto& [name, thread] : tail_threads_) {
+        thread.join();
+    }
+    tail_threads_.clear();
+}
+
+void Follower::discover() {
+    LeaderResponse reply = client_.get("/_databases", options_.poll_timeout + REPLY_GRACE);
+    if (reply.status != 200) {
+        throw std::runtime_error("HTTP " + std::to_string(reply.status));
+    }
+    const Json::JsonValue names = Json::JsonValue::parse(reply.body);
+    for (const auto& name_value : names.as_array()) {
+        const std::string& name = name_value.as_string();
+        if (tail_threads_.count(name)) continue;
+        if (!db_manager_.database_exists(name)) {
+            db_manager_.create_database(name);
+        }
+        {
+            std::lock_guard<std::mutex> lock(status_mutex_);
+            tracked_[name].status.applied_lsn = db_manager_.get_database(name).last_sequence();
+        }
+        tail_threads_[name] = std::thread([this, name] { tail(name); });
+    }
+}
+
+void Follower::tail(const std::string& db_name) {
+    Storage::LSMTree& db = db_manager_.get_database(db_name);
+    while (!stopping_.load()) {
+        try {
+            const uint64_t since = db.last_sequence();
+            const std::string target = "/" + db_name + "/_changes?since=" + std::to_string(since) +
+                "&limit=" + std::to_string(options_.batch_size) +
+                "&timeout_ms=" + std::to_string(options_.poll_timeout.count()) +
+                "&format=binary&consumer=" + options_.replica_id;
+            LeaderResponse reply = client_.get(target, options_.poll_timeout + REPLY_GRACE);
+            if (reply.status == 410) {
+                record_error(db_name, ReplicaState::ResyncRequired,
+                             "Leader no longer has the changes after " + std::to_string(since) +
+                             "; seed this replica from a backup of the leader.");
+                pause(options_.retry_interval * 10);
+                continue;
+            }
+            if (reply.status != 200) {
+                throw std::runtime_error("HTTP " + std::to_string(reply.status) + ": " + reply.body);
+            }
+
+            uint64_t leader_lsn = apply_batch(db, Json::JsonValue::parse(reply.body));
+            std::lock_guard<std::mutex> lock(status_mutex_);
+            Tracked& tracked = tracked_[db_name];
+            tracked.status.state = ReplicaState::Streaming;
+            tracked.status.applied_lsn = db.last_sequence();
+            tracked.status.leader_lsn = leader_lsn;
+            tracked.status.last_error.clear();
+            if (tracked.status.applied_lsn >= leader_lsn) {
+                tracked.caught_up_at = std::chrono::steady_clock::now();
+            }
+        } catch (const std::exception& e) {
+            record_error(db_name, ReplicaState::Error, e.what());
+            pause(options_.retry_interval);
+        }
+    }
+}
+
+void Follower::record_error(const std::string& db_name, ReplicaState state, const std::string& message) {
+    std::lock_guard<std::mutex> lock(status_mutex_);
+    Tracked& tracked = tracked_[db_name];
+    if (tracked.status.state != state || tracked.status.last_error != message) {
+        LOG_WARNING("Replication of '" + db_name + "': " + message);
+    }
+    tracked.status.state = state;
+    tracked.status.last_error = message;
+}
+
+uint64_t Follower::apply_batch(Storage::LSMTree& db, const Json::JsonValue& reply) {
+    const Json::JsonObject& reply_obj = reply.as_object();
+    for (const auto& change_value : reply_obj.at("changes").as_array()) {
+        db.apply_change(decode_change(change_value.as_object()));
+    }
+    return static_cast<uint64_t>(reply_obj.at("last_lsn").as_number());
+}
+
+std::map<std::string, ReplicaStatus> Follower::status() const {
+    const auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(status_mutex_);
+    std::map<std::string, ReplicaStatus> result;
+    for (const auto& [name, tracked] : tracked_) {
+        ReplicaStatus status = tracked.status;
+        if (status.applied_lsn < status.leader_lsn) {
+            status.lag_ms = static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::milliseconds>(now - tracked.caught_up_at).count());
+        }
+        result[name] = status;
+    }
+    return result;
+}
+
+} // namespace Replication
+} // namespace TissDB
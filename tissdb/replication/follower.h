@@ -0,0 +1,107 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "leader_client.h"
+#include "../json/json.h"
+
+namespace TissDB {
+namespace Storage { class DatabaseManager; class LSMTree; }
+
+namespace Replication {
+
+struct FollowerOptions {
+    std::string leader_host = "localhost";
+    int leader_port = 9876;
+    std::string token;
+    // Name the leader keeps unread changes for; unique per replica.
+    std::string replica_id = "replica";
+    size_t batch_size = 1000;
+    // How long each `_changes` request waits on the leader for new writes.
+    std::chrono::milliseconds poll_timeout{5000};
+    // Pause before retrying after an error.
+    std::chrono::milliseconds retry_interval{1000};
+    // How often the leader is asked for new databases.
+    std::chrono::milliseconds discovery_interval{5000};
+};
+
+enum class ReplicaState {
+    Connecting,
+    Streaming,
+    ResyncRequired, // The leader no longer has the changes this replica needs
+    Error
+};
+
+const char* to_string(ReplicaState state);
+
+// Replication progress of one database.
+struct ReplicaStatus {
+    ReplicaState state = ReplicaState::Connecting;
+    uint64_t applied_lsn = 0;
+    uint64_t leader_lsn = 0;
+    // How long the replica has been behind the leader; 0 when caught up.
+    uint64_t lag_ms = 0;
+    std::string last_error;
+};
+
+// Read replica: mirrors every database of a leader by tailing its change feed
+// (`GET /<db>/_changes`) and applying the changes locally under the leader's
+// sequence numbers, so a restarted replica resumes where it stopped. One
+// thread tails each database. Collections are created as changes arrive;
+// schemas and indexes are not replicated.
+//
+// A replica starting from scratch needs the leader's full history. If the
+// leader has already dropped part of it, the database reports ResyncRequired
+// and must be seeded from a backup of the leader.
+class Follower {
+public:
+    Follower(Storage::DatabaseManager& db_manager, const FollowerOptions& options);
+    ~Follower();
+
+    void start();
+    void stop();
+
+    std::map<std::string, ReplicaStatus> status() const;
+    std::string leader_endpoint() const { return client_.endpoint(); }
+
+    // Applies a `_changes` reply (requested with format=binary) to `db`.
+    // Returns the leader's latest sequence number from the reply.
+    static uint64_t apply_batch(Storage::LSMTree& db, const Json::JsonValue& reply);
+
+private:
+    struct Tracked {
+        ReplicaStatus status;
+        std::chrono::steady_clock::time_point caught_up_at = std::chrono::steady_clock::now();
+    };
+
+    void discovery_loop();
+    void tail(const std::string& db_name);
+    void discover();
+    void record_error(const std::string& db_name, ReplicaState state, const std::string& message);
+    // Sleeps for `duration` unless stopped first; returns false once stopping.
+    bool pause(std::chrono::milliseconds duration);
+
+    Storage::DatabaseManager& db_manager_;
+    FollowerOptions options_;
+    LeaderClient client_;
+
+    std::atomic<bool> stopping_{false};
+    std::mutex stop_mutex_;
+    std::condition_variable stop_cv_;
+    std::thread discovery_thread_;
+    std::map<std::string, std::thread> tail_threads_; // Owned by the discovery thread
+
+    mutable std::mutex status_mutex_;
+    std::map<std::string, Tracked> tracked_;
+};
+
+} // namespace Replication
+} // namespace TissDB
@@ -0,0 +1,103 @@
+#include "leader_client.h"
+
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+#ifdef _WIN32
+    #include <winsock2.h>
+    #include <ws2tcpip.h>
+    #define close(s) closesocket(s)
+#else
+    #include <netdb.h>
+    #include <sys/socket.h>
+    #include <sys/time.h>
+    #include <unistd.h>
+#endif
+
+namespace TissDB {
+namespace Replication {
+
+LeaderClient::LeaderClient(const std::string& host, int port, const std::string& token)
+    : host_(host), port_(port), token_(token) {}
+
+LeaderResponse LeaderClient::get(const std::string& target, std::chrono::milliseconds timeout) const {
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* addresses = nullptr;
+    if (getaddrinfo(host_.c_str(), std::to_string(port_).c_str(), &hints, &addresses) != 0 || !addresses) {
+        throw std::runtime_error("Cannot resolve leader host " + host_);
+    }
+    int sock = -1;
+    for (addrinfo* addr = addresses; addr; addr = addr->ai_next) {
+        sock = socket(addr->ai_family, addr->ai_socktype, addr->ai_protocol);
+        if (sock < 0) continue;
+        if (connect(sock, addr->ai_addr, addr->ai_addrlen) == 0) break;
+        close(sock);
+        sock = -1;
+    }
+    freeaddrinfo(addresses);
+    if (sock < 0) {
+        throw std::runtime_error("Cannot connect to leader at " + endpoint());
+    }
+
+#ifdef _WIN32
+    DWORD recv_timeout = static_cast<DWORD>(timeout.count());
+#else
+    timeval recv_timeout{};
+    recv_timeout.tv_sec = static_cast<long>(timeout.count() / 1000);
+    recv_timeout.tv_usec = static_cast<long>(timeout.count() % 1000) * 1000;
+#endif
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char*>(&recv_timeout), sizeof(recv_timeout));
+
+    std::string request = "GET " + target + " HTTP/1.1\r\n"
+                          "Host: " + endpoint() + "\r\n"
+                          "Authorization: Bearer " + token_ + "\r\n"
+                          "Connection: close\r\n\r\n";
+    size_t sent = 0;
+    while (sent < request.size()) {
+        auto n = send(sock, request.data() + sent, request.size() - sent, 0);
+        if (n <= 0) {
+            close(sock);
+            throw std::runtime_error("Failed to send request to leader at " + endpoint());
+        }
+        sent += static_cast<size_t>(n);
+    }
+
+    // The server closes the connection after the reply.
+    std::string raw;
+    char buffer[8192];
+    while (true) {
+        auto n = recv(sock, buffer, sizeof(buffer), 0);
+        if (n < 0) {
+            close(sock);
+            throw std::runtime_error("Timed out waiting for leader at " + endpoint());
+        }
+        if (n == 0) break;
+        raw.append(buffer, static_cast<size_t>(n));
+    }
+    close(sock);
+
+    size_t header_end = raw.find("\r\n\r\n");
+    if (header_end == std::string::npos) {
+        throw std::runtime_error("Malformed reply from leader at " + endpoint());
+    }
+    LeaderResponse response;
+    std::istringstream status_line(raw.substr(0, raw.find("\r\n")));
+    std::string http_version;
+    status_line >> http_version >> response.status;
+    response.body = raw.substr(header_end + 4);
+
+    // Reject a reply that was cut short.
+    const std::string headers = raw.substr(0, header_end);
+    size_t length_pos = headers.find("Content-Length:");
+    if (length_pos != std::string::npos &&
+        std::stoul(headers.substr(length_pos + std::strlen("Content-Length:"))) != response.body.size()) {
+        throw std::runtime_error("Truncated reply from leader at " + endpoint());
+    }
+    return response;
+}
+
+} // namespace Replication
+} // namespace TissDB
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+
+namespace TissDB {
+namespace Replication {
+
+struct LeaderResponse {
+    int status = 0;
+    std::string body;
+};
+
+// Minimal HTTP/1.1 client for the leader's API: one GET per connection,
+// authenticated with a bearer token.
+class LeaderClient {
+public:
+    LeaderClient(const std::string& host, int port, const std::string& token);
+
+    // Sends GET `target` (path and query string) and waits up to `timeout` for
+    // the complete reply. Throws std::runtime_error if the leader cannot be
+    // reached or the reply is cut short.
+    LeaderResponse get(const std::string& target, std::chrono::milliseconds timeout) const;
+
+    std::string endpoint() const { return host_ + ":" + std::to_string(port_); }
+
+private:
+    std::string host_;
+    int port_;
+    std::string token_;
+};
+
+} // namespace Replication
+} // namespace TissDB
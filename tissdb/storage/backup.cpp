@@ -0,0 +1,205 @@
+#include "backup.h"
+#include "../json/json.h"
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <system_error>
+
+namespace TissDB {
+namespace Storage {
+
+namespace fs = std::filesystem;
+
+const char* const BACKUP_MANIFEST_FILE = "backup_manifest.json";
+
+namespace {
+
+long long now_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// Cheap identity for an immutable file: its size plus the trailing footer bytes,
+// which for SSTables include the checksum over the whole table.
+std::string file_fingerprint(const std::string& path, uint64_t size) {
+    const uint64_t tail_size = std::min<uint64_t>(size, 24);
+    std::ifstream in(path, std::ios::binary);
+    in.seekg(static_cast<std::streamoff>(size - tail_size));
+    std::vector<unsigned char> tail(tail_size);
+    in.read(reinterpret_cast<char*>(tail.data()), tail_size);
+
+    std::ostringstream out;
+    out << size << ':' << std::hex << std::setfill('0');
+    for (unsigned char b : tail) {
+        out << std::setw(2) << static_cast<int>(b);
+    }
+    return out.str();
+}
+
+// Hard-links `from` to `to`, falling back to a copy (e.g. across filesystems).
+// Returns true if a link was created.
+bool link_or_copy(const fs::path& from, const fs::path& to) {
+    std::error_code ec;
+    fs::create_hard_link(from, to, ec);
+    if (!ec) {
+        return true;
+    }
+    fs::copy_file(from, to, fs::copy_options::overwrite_existing);
+    return false;
+}
+
+Json::JsonObject read_manifest(const fs::path& backup_dir) {
+    std::ifstream in(backup_dir / BACKUP_MANIFEST_FILE);
+    if (!in.is_open()) {
+        throw std::runtime_error("Backup manifest not found in " + backup_dir.string());
+    }
+    std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    return Json::JsonValue::parse(content).as_object();
+}
+
+} // anonymous namespace
+
+BackupWriter::BackupWriter(const std::string& destination_root) : root_(destination_root) {
+    fs::create_directories(root_);
+
+    // The newest complete backup in the root is the parent of this one.
+    long long latest_created = -1;
+    for (const auto& entry : fs::directory_iterator(root_)) {
+        if (!entry.is_directory() || !fs::exists(entry.path() / BACKUP_MANIFEST_FILE)) continue;
+        try {
+            auto manifest = read_manifest(entry.path());
+            long long created = static_cast<long long>(manifest.at("created_at_ms").as_number());
+            if (created > latest_created) {
+                latest_created = created;
+                previous_path_ = entry.path().string();
+                result_.parent_backup_id = manifest.at("backup_id").as_string();
+                previous_files_.clear();
+                for (const auto& file_val : manifest.at("files").as_array()) {
+                    const auto& file_obj = file_val.as_object();
+                    if (!file_obj.at("immutable").as_bool()) continue;
+                    FileEntry file;
+                    file.relative_path = file_obj.at("path").as_string();
+                    file.fingerprint = file_obj.at("fingerprint").as_string();
+                    file.immutable = true;
+                    previous_files_[file.relative_path] = file;
+                }
+            }
+        } catch (const std::exception&) {
+            // Ignore unreadable or partial backups.
+        }
+    }
+
+    long long created = std::max(now_ms(), latest_created + 1);
+    result_.backup_id = "backup_" + std::to_string(created);
+    result_.backup_path = (fs::path(root_) / result_.backup_id).string();
+    if (fs::exists(result_.backup_path)) {
+        throw std::runtime_error("Backup directory already exists: " + result_.backup_path);
+    }
+    fs::create_directories(result_.backup_path);
+}
+
+std::string BackupWriter::prepare_target(const std::string& relative_path) {
+    fs::path target = fs::path(result_.backup_path) / relative_path;
+    fs::create_directories(target.parent_path());
+    return target.string();
+}
+
+void BackupWriter::add_immutable_file(const std::string& source_path, const std::string& relative_path) {
+    FileEntry file;
+    file.relative_path = relative_path;
+    file.size = fs::file_size(source_path);
+    file.fingerprint = file_fingerprint(source_path, file.size);
+    file.immutable = true;
+
+    std::string target = prepare_target(relative_path);
+    auto prev = previous_files_.find(relative_path);
+    if (prev != previous_files_.end() && prev->second.fingerprint == file.fingerprint) {
+        fs::path prev_file = fs::path(previous_path_) / relative_path;
+        if (fs::exists(prev_file) && link_or_copy(prev_file, target)) {
+            result_.files_reused++;
+            files_.push_back(file);
+            return;
+        }
+    }
+
+    if (link_or_copy(source_path, target)) {
+        result_.files_linked++;
+    } else {
+        result_.files_copied++;
+        result_.bytes_copied += file.size;
+    }
+    files_.push_back(file);
+}
+
+void BackupWriter::add_mutable_file(const std::string& source_path, const std::string& relative_path) {
+    FileEntry file;
+    file.relative_path = relative_path;
+    fs::copy_file(source_path, prepare_target(relative_path), fs::copy_options::overwrite_existing);
+    file.size = fs::file_size(source_path);
+    result_.files_copied++;
+    result_.bytes_copied += file.size;
+    files_.push_back(file);
+}
+
+BackupResult BackupWriter::finish() {
+    Json::JsonArray files;
+    for (const auto& file : files_) {
+        Json::JsonObject file_obj;
+        file_obj["path"] = Json::JsonValue(file.relative_path);
+        file_obj["size"] = Json::JsonValue(static_cast<double>(file.size));
+        file_obj["immutable"] = Json::JsonValue(file.immutable);
+        if (file.immutable) {
+            file_obj["fingerprint"] = Json::JsonValue(file.fingerprint);
+        }
+        files.push_back(Json::JsonValue(file_obj));
+    }
+
+    Json::JsonObject manifest;
+    manifest["backup_id"] = Json::JsonValue(result_.backup_id);
+    manifest["parent_backup_id"] = Json::JsonValue(result_.parent_backup_id);
+    manifest["created_at_ms"] = Json::JsonValue(static_cast<double>(std::stoll(result_.backup_id.substr(7))));
+    manifest["files"] = Json::JsonValue(files);
+
+    fs::path manifest_path = fs::path(result_.backup_path) / BACKUP_MANIFEST_FILE;
+    std::ofstream out(manifest_path, std::ios::trunc);
+    if (!out.is_open()) {
+        throw std::runtime_error("Could not write backup manifest: " + manifest_path.string());
+    }
+    out << Json::JsonValue(manifest).serialize();
+    return result_;
+}
+
+void restore_backup(const std::string& backup_path, const std::string& data_dir) {
+    auto manifest = read_manifest(backup_path);
+
+    fs::path target(data_dir);
+    fs::path staging = target.string() + ".restore_tmp";
+    fs::remove_all(staging);
+    fs::create_directories(staging);
+
+    for (const auto& file_val : manifest.at("files").as_array()) {
+        const auto& file_obj = file_val.as_object();
+        fs::path rel = file_obj.at("path").as_string();
+        fs::path from = fs::path(backup_path) / rel;
+        fs::path to = staging / rel;
+        fs::create_directories(to.parent_path());
+        if (file_obj.at("immutable").as_bool()) {
+            link_or_copy(from, to);
+        } else {
+            // The restored database appends to these, so it must not share them with the backup.
+            fs::copy_file(from, to, fs::copy_options::overwrite_existing);
+        }
+    }
+
+    if (fs::exists(target)) {
+        fs::path previous = target.string() + ".pre_restore_" + std::to_string(now_ms());
+        fs::rename(target, previous);
+    }
+    fs::rename(staging, target);
+}
+
+} // namespace Storage
+} // namespace TissDB
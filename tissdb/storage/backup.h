@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace TissDB {
+namespace Storage {
+
+// Summary of a completed backup.
+struct BackupResult {
+    std::string backup_id;
+    std::string backup_path;
+    std::string parent_backup_id; // Empty for a full backup
+    size_t files_linked = 0;      // Hard-linked from the live data directory
+    size_t files_reused = 0;      // Hard-linked from the previous backup
+    size_t files_copied = 0;      // Mutable files, or links that crossed filesystems
+    uint64_t bytes_copied = 0;
+};
+
+// Builds a backup directory under `destination_root`.
+//
+// Immutable files (SSTables) are hard-linked, so a backup costs no extra disk
+// space on the same filesystem. If the previous backup in the same root already
+// holds an identical immutable file, the new backup links to that copy instead,
+// which keeps later backups incremental even across filesystems. Mutable files
+// (WAL, manifests, index files) are always copied.
+//
+// Each backup writes `backup_manifest.json`, which lists every file and is used
+// both by the next backup and by restore_backup().
+class BackupWriter {
+public:
+    explicit BackupWriter(const std::string& destination_root);
+
+    void add_immutable_file(const std::string& source_path, const std::string& relative_path);
+    void add_mutable_file(const std::string& source_path, const std::string& relative_path);
+
+    // Writes the manifest and returns the summary. The backup is only
+    // considered complete once the manifest exists.
+    BackupResult finish();
+
+private:
+    struct FileEntry {
+        std::string relative_path;
+        uint64_t size = 0;
+        std::string fingerprint; // Immutable files only
+        bool immutable = false;
+    };
+
+    std::string prepare_target(const std::string& relative_path);
+
+    std::string root_;
+    std::string previous_path_;
+    std::map<std::string, FileEntry> previous_files_;
+    std::vector<FileEntry> files_;
+    BackupResult result_;
+};
+
+// Name of the manifest written into every backup directory.
+extern const char* const BACKUP_MANIFEST_FILE;
+
+// Restores a backup into `data_dir` by staging a directory next to it
+// (immutable files are hard-linked, not copied) and renaming it into place.
+// An existing `data_dir` is kept as `<data_dir>.pre_restore_<timestamp>`.
+// The database must not be open while this runs.
+void restore_backup(const std::string& backup_path, const std::string& data_dir);
+
+} // namespace Storage
+} // namespace TissDB
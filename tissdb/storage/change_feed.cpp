@@ -0,0 +1,304 @@
+#include "change_feed.h"
+#include "../common/log.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+
+namespace TissDB {
+namespace Storage {
+
+namespace {
+const char* const SEGMENT_PREFIX = "wal_";
+const char* const SEGMENT_SUFFIX = ".log";
+
+std::string segment_name(uint64_t first_lsn) {
+    char digits[21];
+    std::snprintf(digits, sizeof(digits), "%020llu", static_cast<unsigned long long>(first_lsn));
+    return SEGMENT_PREFIX + std::string(digits) + SEGMENT_SUFFIX;
+}
+} // anonymous namespace
+
+ChangeFeed::ChangeFeed(const std::string& archive_dir, const std::string& active_log_path,
+                       const ChangeFeedOptions& options)
+    : archive_dir_(archive_dir), active_log_path_(active_log_path), options_(options) {
+    std::filesystem::create_directories(archive_dir_);
+    load_segments();
+}
+
+void ChangeFeed::load_segments() {
+    namespace fs = std::filesystem;
+    const std::string prefix = SEGMENT_PREFIX;
+    const std::string suffix = SEGMENT_SUFFIX;
+    for (const auto& entry : fs::directory_iterator(archive_dir_)) {
+        std::string name = entry.path().filename().string();
+        if (!entry.is_regular_file() || name.size() <= prefix.size() + suffix.size() ||
+            name.compare(0, prefix.size(), prefix) != 0 ||
+            name.compare(name.size() - suffix.size(), suffix.size(), suffix) != 0) {
+            continue;
+        }
+        try {
+            uint64_t first_lsn = std::stoull(name.substr(prefix.size(), name.size() - prefix.size() - suffix.size()));
+            segments_.push_back({first_lsn, entry.path().string(), static_cast<uint64_t>(entry.file_size())});
+        } catch (const std::exception&) {
+            LOG_WARNING("Ignoring unrecognised file in WAL archive: " + entry.path().string());
+        }
+    }
+    std::sort(segments_.begin(), segments_.end(),
+              [](const Segment& a, const Segment& b) { return a.first_lsn < b.first_lsn; });
+    prune_locked();
+}
+
+void ChangeFeed::start(uint64_t active_first_lsn, uint64_t last_lsn) {
+    active_first_lsn_.store(active_first_lsn);
+    std::lock_guard<std::mutex> lock(publish_mutex_);
+    published_ = last_lsn;
+    completed_ahead_.clear();
+}
+
+void ChangeFeed::add_stream(const std::string& log_path) {
+    std::lock_guard<std::mutex> lock(segments_mutex_);
+    streams_.push_back(log_path);
+}
+
+void ChangeFeed::remove_stream(const std::string& log_path) {
+    std::lock_guard<std::mutex> lock(segments_mutex_);
+    streams_.erase(std::remove(streams_.begin(), streams_.end(), log_path), streams_.end());
+}
+
+void ChangeFeed::seal(const std::vector<WriteAheadLog*>& wals) {
+    std::lock_guard<std::mutex> lock(segments_mutex_);
+    std::vector<WriteAheadLog*> written;
+    uint64_t first_lsn = 0;
+    for (WriteAheadLog* wal : wals) {
+        if (wal->first_lsn() == 0) {
+            // Nothing a reader could ask for; just start over.
+            wal->clear();
+            continue;
+        }
+        written.push_back(wal);
+        first_lsn = first_lsn == 0 ? wal->first_lsn() : std::min(first_lsn, wal->first_lsn());
+    }
+
+    if (!written.empty()) {
+        std::string path = (std::filesystem::path(archive_dir_) / segment_name(first_lsn)).string();
+        if (written.size() == 1) {
+            uint64_t bytes = std::filesystem::file_size(written[0]->get_path());
+            written[0]->archive_to(path);
+            segments_.push_back({first_lsn, path, bytes});
+        } else {
+            // The logs interleave their sequence numbers; the segment holds
+            // their changes in order, as readers expect.
+            std::vector<LogEntry> entries;
+            for (WriteAheadLog* wal : written) {
+                std::ifstream in(wal->get_path(), std::ios::binary);
+                WriteAheadLog::read_entries(in, [&entries](LogEntry& entry) {
+                    if (entry.lsn != 0) entries.push_back(std::move(entry));
+                    return true;
+                });
+            }
+            std::stable_sort(entries.begin(), entries.end(),
+                             [](const LogEntry& a, const LogEntry& b) { return a.lsn < b.lsn; });
+            const std::string tmp_path = path + ".tmp";
+            std::filesystem::remove(tmp_path);
+            {
+                WriteAheadLog segment(tmp_path);
+                for (const auto& entry : entries) {
+                    segment.append(entry);
+                }
+                segment.shutdown();
+            }
+            std::filesystem::rename(tmp_path, path);
+            for (WriteAheadLog* wal : written) {
+                wal->clear();
+            }
+            segments_.push_back({first_lsn, path, static_cast<uint64_t>(std::filesystem::file_size(path))});
+        }
+    }
+    active_first_lsn_.store(0);
+    prune_locked();
+}
+
+void ChangeFeed::prune_locked() {
+    // Oldest cursor among the consumers still polling; their unread changes stay.
+    const auto now = std::chrono::steady_clock::now();
+    uint64_t held_from = UINT64_MAX;
+    for (auto it = holds_.begin(); it != holds_.end();) {
+        if (now - it->second.last_seen > options_.consumer_hold_timeout) {
+            LOG_WARNING("Change feed consumer '" + it->first + "' timed out; releasing its hold.");
+            it = holds_.erase(it);
+        } else {
+            held_from = std::min(held_from, it->second.lsn);
+            ++it;
+        }
+    }
+
+    uint64_t total_bytes = 0;
+    for (const auto& segment : segments_) {
+        total_bytes += segment.bytes;
+    }
+    size_t drop = 0;
+    while (drop < segments_.size() &&
+           (segments_.size() - drop > options_.retained_segments || total_bytes > options_.retained_bytes)) {
+        uint64_t next_first = drop + 1 < segments_.size() ? segments_[drop + 1].first_lsn : active_first_lsn_.load();
+        if (next_first == 0) {
+            next_first = published() + 1;
+        }
+        if (held_from != UINT64_MAX && next_first > held_from + 1) {
+            break; // Holds changes a consumer has not read
+        }
+        std::error_code ec;
+        std::filesystem::remove(segments_[drop].path, ec);
+        if (ec) {
+            LOG_WARNING("Could not remove WAL segment " + segments_[drop].path + ": " + ec.message());
+        }
+        total_bytes -= segments_[drop].bytes;
+        ++drop;
+    }
+    segments_.erase(segments_.begin(), segments_.begin() + drop);
+}
+
+void ChangeFeed::hold(const std::string& consumer, uint64_t lsn) {
+    std::lock_guard<std::mutex> lock(segments_mutex_);
+    holds_[consumer] = {lsn, std::chrono::steady_clock::now()};
+}
+
+void ChangeFeed::publish(uint64_t lsn) {
+    uint64_t first = active_first_lsn_.load();
+    while ((first == 0 || lsn < first) && !active_first_lsn_.compare_exchange_weak(first, lsn)) {
+    }
+    complete(lsn);
+}
+
+void ChangeFeed::skip(uint64_t lsn) {
+    complete(lsn);
+}
+
+void ChangeFeed::complete(uint64_t lsn) {
+    bool advanced = false;
+    {
+        std::lock_guard<std::mutex> lock(publish_mutex_);
+        if (lsn == published_ + 1) {
+            published_ = lsn;
+            while (!completed_ahead_.empty() && *completed_ahead_.begin() == published_ + 1) {
+                published_ = *completed_ahead_.begin();
+                completed_ahead_.erase(completed_ahead_.begin());
+            }
+            advanced = true;
+        } else if (lsn > published_) {
+            completed_ahead_.insert(lsn);
+        }
+    }
+    if (advanced) {
+        published_cv_.notify_all();
+    }
+}
+
+void ChangeFeed::publish_through(uint64_t lsn) {
+    uint64_t first = active_first_lsn_.load();
+    while ((first == 0 || lsn < first) && !active_first_lsn_.compare_exchange_weak(first, lsn)) {
+    }
+    {
+        std::lock_guard<std::mutex> lock(publish_mutex_);
+        published_ = std::max(published_, lsn);
+        completed_ahead_.erase(completed_ahead_.begin(), completed_ahead_.upper_bound(published_));
+    }
+    published_cv_.notify_all();
+}
+
+uint64_t ChangeFeed::published() const {
+    std::lock_guard<std::mutex> lock(publish_mutex_);
+    return published_;
+}
+
+uint64_t ChangeFeed::earliest_lsn() const {
+    std::lock_guard<std::mutex> lock(segments_mutex_);
+    if (!segments_.empty()) {
+        return segments_.front().first_lsn;
+    }
+    uint64_t active_first = active_first_lsn_.load();
+    return active_first != 0 ? active_first : published() + 1;
+}
+
+ChangeBatch ChangeFeed::read(uint64_t since, size_t limit, const std::string& collection_name) const {
+    ChangeBatch batch;
+    batch.next_since = since;
+
+    // Open every file that may hold changes after `since` while the segment
+    // list cannot change. A segment deleted or renamed afterwards stays
+    // readable through its open stream. Segments are read one at a time; the
+    // active logs together, as they interleave.
+    std::vector<std::vector<std::unique_ptr<std::ifstream>>> groups;
+    {
+        std::lock_guard<std::mutex> lock(segments_mutex_);
+        batch.last_lsn = published();
+        for (size_t i = 0; i < segments_.size(); ++i) {
+            uint64_t next_first = i + 1 < segments_.size() ? segments_[i + 1].first_lsn : active_first_lsn_.load();
+            if (next_first != 0 && next_first <= since + 1) {
+                continue; // Everything in it is at or before `since`
+            }
+            groups.emplace_back();
+            groups.back().push_back(std::make_unique<std::ifstream>(segments_[i].path, std::ios::binary));
+        }
+        groups.emplace_back();
+        groups.back().push_back(std::make_unique<std::ifstream>(active_log_path_, std::ios::binary));
+        for (const auto& stream_path : streams_) {
+            groups.back().push_back(std::make_unique<std::ifstream>(stream_path, std::ios::binary));
+        }
+    }
+    if (since >= batch.last_lsn || limit == 0) {
+        return batch;
+    }
+
+    for (auto& group : groups) {
+        std::vector<LogEntry> entries;
+        for (auto& stream : group) {
+            if (!stream->is_open()) continue;
+            WriteAheadLog::read_entries(*stream, [&](LogEntry& entry) {
+                // Past last_lsn: appended after the read began, or behind a
+                // change that is not complete yet.
+                if (entry.lsn != 0 && entry.lsn > since && entry.lsn <= batch.last_lsn) {
+                    entries.push_back(std::move(entry));
+                }
+                return true;
+            });
+        }
+        if (group.size() > 1) {
+            std::sort(entries.begin(), entries.end(),
+                      [](const LogEntry& a, const LogEntry& b) { return a.lsn < b.lsn; });
+        }
+
+        for (auto& entry : entries) {
+            batch.next_since = entry.lsn;
+            if (!collection_name.empty() && entry.collection_name != collection_name) continue;
+            if (entry.type != LogEntryType::PUT && entry.type != LogEntryType::DELETE) continue;
+
+            ChangeEvent event;
+            event.lsn = entry.lsn;
+            event.type = entry.type;
+            event.collection_name = std::move(entry.collection_name);
+            event.document_id = std::move(entry.document_id);
+            event.doc = std::move(entry.doc);
+            batch.events.push_back(std::move(event));
+            if (batch.events.size() >= limit) {
+                return batch;
+            }
+        }
+    }
+    return batch;
+}
+
+bool ChangeFeed::wait_for(uint64_t since, std::chrono::milliseconds timeout) const {
+    std::unique_lock<std::mutex> lock(publish_mutex_);
+    return published_cv_.wait_for(lock, timeout, [&] { return published_ > since; });
+}
+
+size_t ChangeFeed::segment_count() const {
+    std::lock_guard<std::mutex> lock(segments_mutex_);
+    return segments_.size();
+}
+
+} // namespace Storage
+} // namespace TissDB
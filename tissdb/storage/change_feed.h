@@ -0,0 +1,137 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "wal.h"
+
+namespace TissDB {
+namespace Storage {
+
+struct ChangeFeedOptions {
+    // Sealed WAL segments kept for change readers once a checkpoint has made
+    // them redundant for recovery. The oldest are deleted past either limit;
+    // 0 segments keeps only the active log.
+    size_t retained_segments = 16;
+    uint64_t retained_bytes = 256ull * 1024 * 1024;
+    // A named consumer (e.g. a replica) keeps the segments it has not read yet
+    // past these limits, until it has not been heard from for this long.
+    std::chrono::seconds consumer_hold_timeout{600};
+};
+
+// One committed write, in sequence order.
+struct ChangeEvent {
+    uint64_t lsn = 0;
+    LogEntryType type = LogEntryType::PUT; // PUT or DELETE
+    std::string collection_name;
+    std::string document_id;
+    Document doc; // Empty for a DELETE
+};
+
+struct ChangeBatch {
+    std::vector<ChangeEvent> events;
+    // Cursor to resume from: every change up to it has been examined.
+    uint64_t next_since = 0;
+    // Most recent sequence number at the time of the read.
+    uint64_t last_lsn = 0;
+};
+
+// Ordered stream of the puts and deletes of one database, read back from the
+// active WAL and the segments sealed at earlier checkpoints. Readers only hold
+// the segment lock while they open files, so they never block writers; a
+// record that is still being appended fails its checksum and is picked up by
+// the next read.
+//
+// Sharded collections log to WALs of their own, appended to side by side, so
+// the active logs interleave their sequence numbers and may complete them out
+// of order. Readers only see changes up to the point where every earlier one
+// is complete, and a checkpoint merges the logs into one ordered segment.
+class ChangeFeed {
+public:
+    // `archive_dir` holds the sealed segments, named after their first
+    // sequence number; `active_log_path` is the WAL being appended to.
+    ChangeFeed(const std::string& archive_dir, const std::string& active_log_path,
+               const ChangeFeedOptions& options = ChangeFeedOptions());
+
+    // Called once the WAL has been recovered: `active_first_lsn` is the first
+    // sequence number in the active log (0 if none), `last_lsn` the latest one.
+    void start(uint64_t active_first_lsn, uint64_t last_lsn);
+
+    // Another active log read along with the main one (a shard's WAL).
+    void add_stream(const std::string& log_path);
+    void remove_stream(const std::string& log_path);
+
+    // Moves the contents of `wals` (the main WAL and every added stream) into
+    // a sealed segment and drops segments past the retention limits. Called at
+    // checkpoint with writes blocked.
+    void seal(const std::vector<WriteAheadLog*>& wals);
+
+    // Records that change `lsn` is in its log, waking waiting readers once
+    // every change up to it is. Called by the writer right after the append.
+    void publish(uint64_t lsn);
+    // Completes a sequence number whose write failed before it was logged.
+    void skip(uint64_t lsn);
+    // Records that every change up to `lsn` is logged; for changes applied
+    // from another database's feed, whose numbering has gaps.
+    void publish_through(uint64_t lsn);
+    // Every change up to this one is readable.
+    uint64_t published() const;
+
+    // Oldest sequence number still readable. A reader whose cursor is older
+    // than this has missed changes and must resynchronise.
+    uint64_t earliest_lsn() const;
+
+    // Records that `consumer` has read everything up to `lsn`, keeping the
+    // changes after it (see ChangeFeedOptions::consumer_hold_timeout).
+    void hold(const std::string& consumer, uint64_t lsn);
+
+    // Up to `limit` changes after `since`, optionally for one collection.
+    ChangeBatch read(uint64_t since, size_t limit, const std::string& collection_name = "") const;
+
+    // Blocks until a change after `since` is published or `timeout` elapses.
+    // Returns true if one is available.
+    bool wait_for(uint64_t since, std::chrono::milliseconds timeout) const;
+
+    size_t segment_count() const;
+
+private:
+    struct Segment {
+        uint64_t first_lsn;
+        std::string path;
+        uint64_t bytes;
+    };
+    struct ConsumerHold {
+        uint64_t lsn;
+        std::chrono::steady_clock::time_point last_seen;
+    };
+
+    void load_segments();
+    void prune_locked();
+    void complete(uint64_t lsn);
+
+    std::string archive_dir_;
+    std::string active_log_path_;
+    ChangeFeedOptions options_;
+    mutable std::mutex segments_mutex_;
+    std::vector<Segment> segments_; // Oldest first
+    std::vector<std::string> streams_; // Active logs besides active_log_path_
+    std::map<std::string, ConsumerHold> holds_;
+    // First sequence number in the active logs, 0 while they have none. Set
+    // by the writers; reset by seal() under segments_mutex_.
+    std::atomic<uint64_t> active_first_lsn_{0};
+
+    mutable std::mutex publish_mutex_;
+    mutable std::condition_variable published_cv_;
+    uint64_t published_ = 0;
+    std::set<uint64_t> completed_ahead_; // Completed past a gap in published_
+};
+
+} // namespace Storage
+} // namespace TissDB
@@ -7,6 +7,12 @@
 #include "lsm_tree.h" // For LSMTree pointer
 #include <filesystem>
 #include "../query/executor_common.h" // For value_to_string
+#include "../json/json.h"
+#include "../common/memory_governor.h"
+#include "../common/metrics.h"
+#include <fstream>
+#include <iomanip>
+#include <sstream>
 
 // Helper function to get a value from a document
 const TissDB::Value* get_value(const TissDB::Document& doc, const std::string& key) {
@@ -21,17 +27,197 @@ const TissDB::Value* get_value(const TissDB::Document& doc, const std::string& k
 namespace TissDB {
 namespace Storage {
 
+namespace {
+// The name a collection's directory has in its database, such as "orders" or
+// "events/shard_0". A collection outside its database's directory (or without
+// one) goes by its directory name.
+std::string collection_name_from_path(const LSMTree* parent_db, const std::string& path) {
+    const std::filesystem::path dir = std::filesystem::path(path).lexically_normal();
+    if (parent_db) {
+        const std::filesystem::path relative =
+            dir.lexically_relative(std::filesystem::path(parent_db->get_path()).lexically_normal());
+        if (!relative.empty() && *relative.begin() != "..") return relative.generic_string();
+    }
+    return dir.filename().string();
+}
+} // anonymous namespace
+
 Collection::Collection(LSMTree* parent_db, const std::string& path)
-    : Memtable(), parent_db_(parent_db), path_(path), indexer_(std::make_unique<Indexer>()) {
+    : Memtable(), name_(collection_name_from_path(parent_db, path)), parent_db_(parent_db), path_(path),
+      indexer_(std::make_unique<Indexer>()) {
     if (!path_.empty()) {
+        load_sstables();
         load_indexes();
+        load_ttl();
+        load_statistics();
     }
+    account_memory();
 }
 
 // This constructor is redundant but kept for compatibility just in case.
 Collection::Collection(const std::string& path, LSMTree* parent_db)
-    : Memtable(), parent_db_(parent_db), path_(path), indexer_(std::make_unique<Indexer>()) {
+    : Memtable(), name_(collection_name_from_path(parent_db, path)), parent_db_(parent_db), path_(path),
+      indexer_(std::make_unique<Indexer>()) {
+    load_sstables();
     load_indexes();
+    load_ttl();
+    load_statistics();
+    account_memory();
+}
+
+Collection::~Collection() {
+    auto& governor = Common::MemoryGovernor::instance();
+    governor.adjust(Common::MemorySubsystem::Memtable, -static_cast<int64_t>(accounted_memtable_bytes_));
+    governor.adjust(Common::MemorySubsystem::Index, -static_cast<int64_t>(accounted_index_bytes_));
+}
+
+void Collection::account_memory() {
+    auto& governor = Common::MemoryGovernor::instance();
+    const size_t memtable_bytes = approximate_size();
+    const size_t index_bytes = indexer_->approximate_memory_usage();
+    governor.adjust(Common::MemorySubsystem::Memtable,
+                    static_cast<int64_t>(memtable_bytes) - static_cast<int64_t>(accounted_memtable_bytes_));
+    governor.adjust(Common::MemorySubsystem::Index,
+                    static_cast<int64_t>(index_bytes) - static_cast<int64_t>(accounted_index_bytes_));
+    accounted_memtable_bytes_ = memtable_bytes;
+    accounted_index_bytes_ = index_bytes;
+}
+
+namespace {
+const char* const SSTABLE_MANIFEST_FILE = "sstables.json";
+const char* const STATISTICS_FILE = "statistics.json";
+} // anonymous namespace
+
+void Collection::load_sstables() {
+    if (path_.empty()) return;
+    std::filesystem::path manifest_path = std::filesystem::path(path_) / SSTABLE_MANIFEST_FILE;
+    if (!std::filesystem::exists(manifest_path)) return;
+
+    std::ifstream manifest_file(manifest_path);
+    std::string content((std::istreambuf_iterator<char>(manifest_file)), std::istreambuf_iterator<char>());
+    try {
+        Json::JsonValue parsed = Json::JsonValue::parse(content);
+        const auto& obj = parsed.as_object();
+        next_sstable_id_ = static_cast<uint64_t>(obj.at("next_id").as_number());
+        for (const auto& file_val : obj.at("sstables").as_array()) {
+            std::string file_path = (std::filesystem::path(path_) / file_val.as_string()).string();
+            auto sstable = std::make_shared<SSTable>(file_path, name_);
+            if (!sstable->is_valid()) {
+                LOG_ERROR("SSTable listed in manifest could not be loaded: " + file_path);
+                continue;
+            }
+            sstables_.push_back(std::move(sstable));
+        }
+    } catch (const std::exception& e) {
+        LOG_ERROR("Failed to load SSTable manifest for collection at " + path_ + ": " + e.what());
+        return;
+    }
+
+    // SSTables missing from the manifest were left by an interrupted flush or
+    // compaction. Their contents are still in the WAL or in the inputs.
+    std::vector<std::string> live_files = get_sstable_files();
+    for (const auto& entry : std::filesystem::directory_iterator(path_)) {
+        std::string file = entry.path().filename().string();
+        if (file.rfind("sstable_", 0) != 0 || entry.path().extension() != ".db") continue;
+        if (std::find(live_files.begin(), live_files.end(), file) == live_files.end()) {
+            LOG_WARNING("Removing SSTable not listed in manifest: " + entry.path().string());
+            std::error_code ec;
+            std::filesystem::remove(entry.path(), ec);
+        }
+    }
+}
+
+void Collection::save_sstable_manifest() const {
+    Json::JsonObject manifest_obj;
+    Json::JsonArray files;
+    for (const auto& name : get_sstable_files()) {
+        files.push_back(Json::JsonValue(name));
+    }
+    manifest_obj["next_id"] = Json::JsonValue(static_cast<double>(next_sstable_id_));
+    manifest_obj["sstables"] = Json::JsonValue(files);
+
+    // Write to a temporary file and rename so the manifest is replaced atomically.
+    std::filesystem::path manifest_path = std::filesystem::path(path_) / SSTABLE_MANIFEST_FILE;
+    std::filesystem::path tmp_path = manifest_path.string() + ".tmp";
+    {
+        std::ofstream manifest_file(tmp_path, std::ios::trunc);
+        if (!manifest_file.is_open()) {
+            throw std::runtime_error("Could not open SSTable manifest for writing: " + tmp_path.string());
+        }
+        manifest_file << Json::JsonValue(manifest_obj).serialize();
+    }
+    std::filesystem::rename(tmp_path, manifest_path);
+}
+
+std::vector<std::string> Collection::get_sstable_files() const {
+    std::vector<std::string> names;
+    names.reserve(sstables_.size());
+    for (const auto& sstable : sstables_) {
+        names.push_back(std::filesystem::path(sstable->get_path()).filename().string());
+    }
+    return names;
+}
+
+std::string Collection::allocate_sstable_path() {
+    std::ostringstream name;
+    name << "sstable_" << std::setw(6) << std::setfill('0') << next_sstable_id_++ << ".db";
+    return (std::filesystem::path(path_) / name.str()).string();
+}
+
+void Collection::flush() {
+    if (path_.empty() || data.empty()) return;
+
+    std::string file_path = allocate_sstable_path();
+    SSTable::write(file_path, name_, data, &tombstone_seqs_);
+    auto sstable = std::make_shared<SSTable>(file_path, name_);
+    if (!sstable->is_valid()) {
+        throw std::runtime_error("Failed to verify flushed SSTable: " + file_path);
+    }
+    sstables_.push_back(std::move(sstable));
+    save_sstable_manifest();
+
+    LOG_INFO("Flushed " + std::to_string(data.size()) + " entries to " + file_path);
+    Memtable::clear();
+    tombstone_seqs_.clear();
+    account_memory();
+}
+
+std::vector<std::string> Collection::replace_oldest_sstables(size_t count, const std::string& merged_path) {
+    if (count > sstables_.size()) {
+        throw std::runtime_error("Cannot replace " + std::to_string(count) + " SSTables in collection at " + path_);
+    }
+    std::shared_ptr<SSTable> merged;
+    if (!merged_path.empty()) {
+        merged = std::make_shared<SSTable>(merged_path, name_);
+        if (!merged->is_valid()) {
+            throw std::runtime_error("Failed to verify compacted SSTable: " + merged_path);
+        }
+    }
+
+    std::vector<std::string> replaced;
+    for (size_t i = 0; i < count; ++i) {
+        replaced.push_back(sstables_[i]->get_path());
+    }
+    sstables_.erase(sstables_.begin(), sstables_.begin() + count);
+    if (merged) {
+        sstables_.insert(sstables_.begin(), std::move(merged));
+    }
+    save_sstable_manifest();
+    return replaced;
+}
+
+std::optional<std::shared_ptr<Document>> Collection::find_in_sstables(const std::string& key) const {
+    for (auto it = sstables_.rbegin(); it != sstables_.rend(); ++it) {
+        auto bytes = (*it)->find(key);
+        if (!bytes) continue;
+        if (bytes->empty()) {
+            return std::shared_ptr<Document>(); // Tombstone
+        }
+        auto doc = std::make_shared<Document>(TissDB::deserialize(*bytes));
+        doc->id = key;
+        return doc;
+    }
+    return std::nullopt;
 }
 
 void Collection::load_indexes() {
@@ -54,6 +240,67 @@ void Collection::save_indexes() {
     }
 }
 
+void Collection::load_ttl() {
+    if (path_.empty()) return;
+    try {
+        ttl_policy_ = load_ttl_policy(path_);
+    } catch (const std::exception& e) {
+        LOG_ERROR("Failed to load TTL policy for collection at " + path_ + ": " + e.what());
+    }
+}
+
+void Collection::load_statistics() {
+    std::filesystem::path stats_path = std::filesystem::path(path_) / STATISTICS_FILE;
+    if (!std::filesystem::exists(stats_path)) return;
+    try {
+        std::ifstream stats_file(stats_path);
+        std::string content((std::istreambuf_iterator<char>(stats_file)), std::istreambuf_iterator<char>());
+        statistics_ = CollectionStatistics::from_json(Json::JsonValue::parse(content));
+    } catch (const std::exception& e) {
+        // Statistics only guide the planner; start over rather than fail.
+        LOG_WARNING("Ignoring unreadable statistics for collection at " + path_ + ": " + e.what());
+        statistics_ = CollectionStatistics();
+    }
+}
+
+void Collection::save_statistics() const {
+    if (path_.empty()) return;
+    std::filesystem::path stats_path = std::filesystem::path(path_) / STATISTICS_FILE;
+    std::filesystem::path tmp_path = stats_path.string() + ".tmp";
+    try {
+        {
+            std::ofstream stats_file(tmp_path, std::ios::trunc);
+            if (!stats_file.is_open()) {
+                throw std::runtime_error("Could not open " + tmp_path.string());
+            }
+            stats_file << statistics_.to_json().serialize();
+        }
+        std::filesystem::rename(tmp_path, stats_path);
+    } catch (const std::exception& e) {
+        LOG_ERROR("Failed to save statistics for collection at " + path_ + ": " + e.what());
+    }
+}
+
+const CollectionStatistics& Collection::analyze() {
+    statistics_ = CollectionStatistics::analyze(scan());
+    save_statistics();
+    return statistics_;
+}
+
+void Collection::set_ttl_policy(const TtlPolicy& policy) {
+    if (!path_.empty()) {
+        save_ttl_policy(path_, policy);
+    }
+    ttl_policy_ = policy;
+}
+
+void Collection::forget_expired(const std::string& key, const Document& doc) {
+    if (data.count(key)) return;
+    indexer_->remove_from_indexes(key, doc);
+    statistics_.record_delete();
+    account_memory();
+}
+
 void Collection::set_schema(const TissDB::Schema& schema) {
     schema_ = schema;
 }
@@ -61,17 +308,16 @@ void Collection::set_schema(const TissDB::Schema& schema) {
 void Collection::create_index(const std::vector<std::string>& field_names, bool is_unique) {
     // Correctly call the Indexer's create_index with the default type (String)
     indexer_->create_index(field_names, is_unique, IndexType::String);
-    // Bulk-load existing data into the new index
-    for (const auto& pair : data) {
-        if (pair.second) { // If it's a document, not a tombstone
-            try {
-                indexer_->update_indexes(pair.first, *pair.second);
-            } catch (const std::runtime_error& e) {
-                LOG_ERROR("Error bulk-loading data for key " + pair.first + " into new index: " + e.what());
-            }
+    // Bulk-load existing data (in memory and on disk) into the new index
+    for (const auto& doc : scan()) {
+        try {
+            indexer_->update_indexes(doc.id, doc);
+        } catch (const std::runtime_error& e) {
+            LOG_ERROR("Error bulk-loading data for key " + doc.id + " into new index: " + e.what());
         }
     }
     save_indexes();
+    account_memory();
 }
 
 bool Collection::has_index(const std::vector<std::string>& field_names) const {
@@ -83,6 +329,9 @@ std::vector<std::vector<std::string>> Collection::get_available_indexes() const
 }
 
 std::vector<std::string> Collection::find_by_index(const std::vector<std::string>& field_names, const std::vector<std::string>& values) const {
+    static Common::Histogram& lookup_latency = Common::Metrics::instance().histogram(
+        "tissdb_index_lookup_seconds", "Time to look up one value in a secondary index.");
+    Common::ScopedTimer timer(lookup_latency);
     std::vector<Value> value_variants;
     for(const auto& v : values) {
         value_variants.push_back(v);
@@ -91,6 +340,9 @@ std::vector<std::string> Collection::find_by_index(const std::vector<std::string
 }
 
 void Collection::put(const std::string& key, const Document& doc) {
+    static Common::Histogram& put_latency = Common::Metrics::instance().histogram(
+        "tissdb_memtable_put_seconds", "Time to apply one write to a collection's memtable, index updates included.");
+    Common::ScopedTimer timer(put_latency);
     const std::string& pk_field = schema_.get_primary_key();
     if (!pk_field.empty()) {
         if (get_value(doc, pk_field) == nullptr) {
@@ -104,9 +356,14 @@ void Collection::put(const std::string& key, const Document& doc) {
             if (fk_value_ptr) {
                 try {
                     std::string fk_value_str = TissDB::Query::value_to_string(*fk_value_ptr);
-                    std::vector<Value> search_values;
-                    search_values.push_back(fk_value_str);
-                    auto results = parent_db_->find_by_index(fk.referenced_collection, {fk.referenced_field}, search_values);
+                    // Go to the referenced collection directly: the caller already
+                    // holds the database lock.
+                    std::vector<std::string> results;
+                    try {
+                        results = parent_db_->get_collection(fk.referenced_collection).find_by_index({fk.referenced_field}, {fk_value_str});
+                    } catch (const std::runtime_error&) {
+                        // Referenced collection does not exist.
+                    }
                     if (results.empty()) {
                         throw std::runtime_error("Foreign key constraint violated on field '" + fk.field_name + "'. No matching document in referenced collection '" + fk.referenced_collection + "'.");
                     }
@@ -120,15 +377,36 @@ void Collection::put(const std::string& key, const Document& doc) {
     auto it = data.find(key);
     size_t old_value_size = 0;
 
+    if (it != data.end() && !it->second && tombstone_seqs_.erase(key)) {
+        estimated_size -= sizeof(uint64_t);
+    }
+
+    std::shared_ptr<Document> previous;
     if (it != data.end() && it->second) {
-        indexer_->remove_from_indexes(key, *it->second);
-        old_value_size = TissDB::serialize(*(it->second)).size();
+        previous = it->second;
+        old_value_size = TissDB::serialize(*previous).size();
     } else {
-        estimated_size += key.size();
+        if (it == data.end() && !sstables_.empty()) {
+            // The previous version may be on disk; its index entries still need
+            // replacing, and the row count must not grow.
+            auto old_doc = find_in_sstables(key);
+            if (old_doc && *old_doc) {
+                previous = *old_doc;
+            }
+        }
+        if (it == data.end()) {
+            estimated_size += key.size();
+        }
     }
+    const bool replaces_existing = previous != nullptr;
 
     auto new_doc_ptr = std::make_shared<Document>(doc);
-    indexer_->update_indexes(key, *new_doc_ptr);
+    ttl_policy_.apply_default(*new_doc_ptr, now_us());
+    // An update that leaves every indexed field alone does not touch the indexes.
+    if (!previous || !indexer_->same_index_keys(*previous, *new_doc_ptr)) {
+        if (previous) indexer_->remove_from_indexes(key, *previous);
+        indexer_->update_indexes(key, *new_doc_ptr);
+    }
 
     size_t new_value_size = TissDB::serialize(*new_doc_ptr).size();
 
@@ -136,49 +414,185 @@ void Collection::put(const std::string& key, const Document& doc) {
     estimated_size += new_value_size;
 
     data[key] = new_doc_ptr;
+    if (replaces_existing) {
+        statistics_.record_update(*new_doc_ptr);
+    } else {
+        statistics_.record_insert(*new_doc_ptr);
+    }
+    account_memory();
 }
 
-bool Collection::del(const std::string& key) {
-    LOG_DEBUG("DELETE key: " + key);
+bool Collection::del(const std::string& key, uint64_t seq) {
+    LOG_DEBUG("DELETE key: " << key);
     auto it = data.find(key);
-    if (it == data.end() || !it->second) {
-        return false;
-    }
+    if (it != data.end()) {
+        if (!it->second) {
+            return false;
+        }
 
-    size_t old_value_size = TissDB::serialize(*(it->second)).size();
-    estimated_size -= old_value_size;
+        size_t old_value_size = TissDB::serialize(*(it->second)).size();
+        estimated_size -= old_value_size;
+        estimated_size += sizeof(uint64_t); // The tombstone's sequence number
 
-    indexer_->remove_from_indexes(key, *it->second);
+        indexer_->remove_from_indexes(key, *it->second);
+
+        it->second = nullptr;
+        tombstone_seqs_[key] = seq;
+        statistics_.record_delete();
+        account_memory();
+        return true;
+    }
 
-    it->second = nullptr;
+    // Not in memory: the document may live in an SSTable, in which case a
+    // tombstone is needed to shadow it.
+    auto old_doc = find_in_sstables(key);
+    if (!old_doc || !*old_doc) {
+        return false;
+    }
+    indexer_->remove_from_indexes(key, **old_doc);
+    data[key] = nullptr;
+    tombstone_seqs_[key] = seq;
+    estimated_size += key.size() + sizeof(uint64_t);
+    statistics_.record_delete();
+    account_memory();
     return true;
 }
 
 std::optional<std::shared_ptr<Document>> Collection::get(const std::string& key) {
-    LOG_DEBUG("GET key: " + key);
+    static Common::Histogram& get_latency = Common::Metrics::instance().histogram(
+        "tissdb_memtable_get_seconds", "Time for one point read, from the memtable or, failing that, the SSTables.");
+    static Common::Counter& memtable_hits = Common::Metrics::instance().counter(
+        "tissdb_memtable_reads_total", "Point reads by whether the memtable answered them.", "result=\"hit\"");
+    static Common::Counter& memtable_misses = Common::Metrics::instance().counter(
+        "tissdb_memtable_reads_total", "Point reads by whether the memtable answered them.", "result=\"miss\"");
+    Common::ScopedTimer timer(get_latency);
+    LOG_DEBUG("GET key: " << key);
     auto it = data.find(key);
+    (it == data.end() ? memtable_misses : memtable_hits).add();
     if (it == data.end()) {
-        return std::nullopt;
+        auto found = find_in_sstables(key);
+        if (found && *found && ttl_policy_.enabled() && ttl_policy_.is_expired(**found, now_us())) {
+            return std::nullopt;
+        }
+        return found;
     }
 
     if (!it->second) {
         return it->second;
     }
+    if (ttl_policy_.enabled() && ttl_policy_.is_expired(*it->second, now_us())) {
+        return std::nullopt;
+    }
 
     auto doc_copy = std::make_shared<Document>(*it->second);
     doc_copy->id = key;
     return doc_copy;
 }
 
+std::vector<Document> Collection::multi_get(const std::vector<std::string>& keys) const {
+    std::vector<std::string> sorted_keys(keys);
+    std::sort(sorted_keys.begin(), sorted_keys.end());
+    sorted_keys.erase(std::unique(sorted_keys.begin(), sorted_keys.end()), sorted_keys.end());
+
+    std::vector<std::shared_ptr<Document>> found(sorted_keys.size());
+    std::vector<size_t> pending; // Positions not resolved by a newer source
+
+    // Walk the in-memory table alongside the keys; for a few keys in a large
+    // table, jumping with lower_bound beats stepping through every entry.
+    const bool walk = sorted_keys.size() * 16 >= data.size();
+    auto mem_it = data.begin();
+    for (size_t i = 0; i < sorted_keys.size(); ++i) {
+        const std::string& key = sorted_keys[i];
+        if (walk) {
+            while (mem_it != data.end() && mem_it->first < key) ++mem_it;
+        } else {
+            mem_it = data.lower_bound(key);
+        }
+        if (mem_it != data.end() && mem_it->first == key) {
+            found[i] = mem_it->second; // nullptr for a tombstone
+        } else {
+            pending.push_back(i);
+        }
+    }
+
+    // Newest SSTable first; each resolves what the newer ones did not have.
+    for (auto it = sstables_.rbegin(); it != sstables_.rend() && !pending.empty(); ++it) {
+        std::vector<std::string> lookup;
+        lookup.reserve(pending.size());
+        for (size_t pos : pending) lookup.push_back(sorted_keys[pos]);
+
+        auto results = (*it)->find_many(lookup);
+        std::vector<size_t> still_pending;
+        for (size_t j = 0; j < results.size(); ++j) {
+            if (!results[j]) {
+                still_pending.push_back(pending[j]);
+            } else if (!results[j]->empty()) {
+                found[pending[j]] = std::make_shared<Document>(TissDB::deserialize(*results[j]));
+            }
+        }
+        pending = std::move(still_pending);
+    }
+
+    const bool check_expiry = ttl_policy_.enabled();
+    const int64_t now = check_expiry ? now_us() : 0;
+    std::vector<Document> documents;
+    documents.reserve(keys.size());
+    for (const auto& key : keys) {
+        size_t pos = std::lower_bound(sorted_keys.begin(), sorted_keys.end(), key) - sorted_keys.begin();
+        const auto& doc = found[pos];
+        if (!doc || (check_expiry && ttl_policy_.is_expired(*doc, now))) continue;
+        documents.push_back(*doc);
+        documents.back().id = key;
+    }
+    return documents;
+}
+
 std::vector<Document> Collection::scan() const {
-    LOG_DEBUG("SCAN collection");
     std::vector<Document> documents;
-    for (const auto& pair : data) {
-        if (pair.second) { // Only include documents that are not tombstones
-            Document doc_with_id = *pair.second;
-            doc_with_id.id = pair.first;
-            documents.push_back(doc_with_id);
+    for (const auto& doc : scan_shared()) {
+        documents.push_back(*doc);
+    }
+    return documents;
+}
+
+std::vector<std::shared_ptr<const Document>> Collection::scan_shared() const {
+    LOG_DEBUG("SCAN collection");
+    std::vector<std::shared_ptr<const Document>> documents;
+    const bool check_expiry = ttl_policy_.enabled();
+    const int64_t now = check_expiry ? now_us() : 0;
+    auto append_doc = [&](const std::string& key, const std::shared_ptr<Document>& doc) {
+        // Only include documents that are not tombstones and have not expired
+        if (!doc || (check_expiry && ttl_policy_.is_expired(*doc, now))) return;
+        if (doc->id == key) {
+            documents.push_back(doc);
+        } else {
+            auto doc_with_id = std::make_shared<Document>(*doc);
+            doc_with_id->id = key;
+            documents.push_back(std::move(doc_with_id));
         }
+    };
+
+    if (sstables_.empty()) {
+        documents.reserve(data.size());
+        for (const auto& pair : data) {
+            append_doc(pair.first, pair.second);
+        }
+        return documents;
+    }
+
+    // Newer sources overwrite older ones: SSTables oldest first, then memory.
+    std::map<std::string, std::shared_ptr<Document>> merged;
+    for (const auto& sstable : sstables_) {
+        for (auto& entry : sstable->scan_entries()) {
+            merged[entry.key] = std::move(entry.doc);
+        }
+    }
+    for (const auto& pair : data) {
+        merged[pair.first] = pair.second;
+    }
+    documents.reserve(merged.size());
+    for (const auto& pair : merged) {
+        append_doc(pair.first, pair.second);
     }
     return documents;
 }
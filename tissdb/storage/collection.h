@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
 #include <string>
 #include <map>
 #include <optional>
@@ -11,32 +12,44 @@
 #include "../common/schema.h"
 #include "indexer.h"
 #include "memtable.h"
+#include "sstable.h"
+#include "statistics.h"
+#include "ttl.h"
 
 namespace TissDB {
 namespace Storage {
 
 class LSMTree; // Forward declaration
 
-// A Collection is an in-memory sorted data structure that holds all documents for a single collection.
-// It is managed by the Database class.
+// A Collection holds all documents for a single collection. Recent writes live
+// in the inherited in-memory table; flush() moves them into an immutable
+// SSTable on disk. The set of live SSTables is recorded in a per-collection
+// manifest (sstables.json). It is managed by the LSMTree class.
 class Collection : public Memtable {
 public:
     Collection(LSMTree* parent_db, const std::string& path = "");
     Collection(const std::string& path, LSMTree* parent_db);
+    ~Collection();
 
     // Inserts or updates a document in the collection.
     void put(const std::string& key, const Document& doc);
 
-    // Marks a document as deleted by writing a "tombstone".
+    // Marks a document as deleted by writing a "tombstone" tagged with the
+    // database sequence number `seq` of the delete.
     // Returns true if the key existed, false otherwise.
-    bool del(const std::string& key);
+    bool del(const std::string& key, uint64_t seq = 0);
 
     // Retrieves a document from the collection.
     // Returns a pointer to the document if found.
-    // Returns `std::nullopt` if the key is not found.
+    // Returns `std::nullopt` if the key is not found or the document has expired.
     // Returns a `nullptr` inside the optional if the key was deleted (tombstone).
     std::optional<std::shared_ptr<Document>> get(const std::string& key);
 
+    // Retrieves many documents at once. The keys are sorted and resolved in a
+    // single pass over the in-memory table and each SSTable. Returns the live
+    // documents in the order of `keys`; missing, deleted and expired keys are skipped.
+    std::vector<Document> multi_get(const std::vector<std::string>& keys) const;
+
     // Returns all key-value pairs, sorted by key.
     // This is used when flushing the collection to an SSTable on disk.
     const std::map<std::string, std::shared_ptr<Document>>& get_all() const;
@@ -44,12 +57,53 @@ public:
     // Clears all data from the collection.
     void clear();
 
-    // Returns the approximate size of the collection in bytes.
-    size_t approximate_size() const;
-
-    // Scans all documents in the collection.
+    // Scans all documents in the collection, merging the in-memory writes over
+    // the on-disk SSTables.
     std::vector<Document> scan() const;
 
+    // The documents scan() returns, in key order, without copying them: they
+    // are shared with the collection, which replaces a stored document on
+    // write rather than modifying it. Each document's id is its key.
+    std::vector<std::shared_ptr<const Document>> scan_shared() const;
+
+    // Writes the in-memory writes to a new SSTable, records it in the manifest,
+    // and clears the in-memory table. Does nothing if there is nothing to flush.
+    void flush();
+
+    // File names (relative to the collection directory) of the live SSTables, oldest first.
+    std::vector<std::string> get_sstable_files() const;
+
+    // The live SSTables, oldest first.
+    std::vector<std::shared_ptr<SSTable>> get_sstables() const { return sstables_; }
+
+    // Reserves the file name for a new SSTable in this collection.
+    std::string allocate_sstable_path();
+
+    // Replaces the `count` oldest SSTables with `merged_path` (or with nothing
+    // if it is empty) and saves the manifest. Returns the paths of the replaced
+    // files, which the caller deletes once no reader can still use them.
+    std::vector<std::string> replace_oldest_sstables(size_t count, const std::string& merged_path);
+
+    const std::string& get_path() const { return path_; }
+    // The collection's name within its database; its SSTables are encrypted
+    // with this collection's DEK.
+    const std::string& get_name() const { return name_; }
+
+    // Sets and persists the expiry policy. Expired documents are hidden from
+    // get() and scan() right away and dropped by the next compaction.
+    void set_ttl_policy(const TtlPolicy& policy);
+    const TtlPolicy& get_ttl_policy() const { return ttl_policy_; }
+
+    // Removes the index entries of a document that compaction dropped as
+    // expired, unless the key has been written again since.
+    void forget_expired(const std::string& key, const Document& doc);
+
+    // Planner statistics. They are updated on every write, rebuilt in full by
+    // analyze(), and persisted (statistics.json) by save_statistics().
+    const CollectionStatistics& get_statistics() const { return statistics_; }
+    const CollectionStatistics& analyze();
+    void save_statistics() const;
+
     void set_schema(const TissDB::Schema& schema);
     void create_index(const std::vector<std::string>& field_names, bool is_unique = false);
 
@@ -62,11 +116,28 @@ public:
     std::vector<std::string> find_by_index(const std::vector<std::string>& field_names, const std::vector<std::string>& values) const;
 
 private:
+    void load_sstables();
+    void load_ttl();
+    void load_statistics();
+    // Reports changes in memtable and index size to the memory governor.
+    void account_memory();
+    void save_sstable_manifest() const;
+
+    // Looks a key up in the SSTables, newest first. Same return convention as get().
+    std::optional<std::shared_ptr<Document>> find_in_sstables(const std::string& key) const;
+
     std::string name_;
     TissDB::Schema schema_;
     LSMTree* parent_db_; // Pointer to the parent database
     std::unique_ptr<Indexer> indexer_;
     std::string path_;
+    std::vector<std::shared_ptr<SSTable>> sstables_; // Oldest first
+    std::map<std::string, uint64_t> tombstone_seqs_; // Sequence numbers of in-memory tombstones
+    TtlPolicy ttl_policy_;
+    CollectionStatistics statistics_;
+    size_t accounted_memtable_bytes_ = 0;
+    size_t accounted_index_bytes_ = 0;
+    uint64_t next_sstable_id_ = 1;
 };
 
 } // namespace Storage
@@ -0,0 +1,68 @@
+#include "compaction.h"
+
+#include <filesystem>
+#include <map>
+
+namespace TissDB {
+namespace Storage {
+
+CompactionOutcome compact_sstables(const std::vector<std::shared_ptr<SSTable>>& inputs,
+                                   const std::string& collection_name,
+                                   const std::string& output_path,
+                                   uint64_t purge_up_to,
+                                   const TtlPolicy& ttl,
+                                   int64_t now,
+                                   Common::RateLimiter& limiter) {
+    CompactionOutcome outcome;
+
+    // Later tables take precedence over earlier ones.
+    std::map<std::string, std::shared_ptr<Document>> merged;
+    std::map<std::string, uint64_t> tombstone_seqs;
+    for (const auto& sstable : inputs) {
+        const uint64_t size = std::filesystem::file_size(sstable->get_path());
+        limiter.acquire(size);
+        outcome.bytes_read += size;
+        for (auto& entry : sstable->scan_entries()) {
+            if (entry.doc) {
+                tombstone_seqs.erase(entry.key);
+            } else {
+                tombstone_seqs[entry.key] = entry.tombstone_seq;
+            }
+            merged[entry.key] = std::move(entry.doc);
+        }
+    }
+
+    for (auto it = merged.begin(); it != merged.end();) {
+        if (it->second) {
+            if (ttl.enabled() && ttl.is_expired(*it->second, now)) {
+                outcome.expired.emplace_back(it->first, std::move(it->second));
+                it = merged.erase(it);
+                continue;
+            }
+            ++outcome.live_entries;
+            ++it;
+            continue;
+        }
+        if (tombstone_seqs[it->first] <= purge_up_to) {
+            ++outcome.tombstones_purged;
+            tombstone_seqs.erase(it->first);
+            it = merged.erase(it);
+        } else {
+            ++outcome.tombstones_retained;
+            ++it;
+        }
+    }
+
+    if (merged.empty()) {
+        return outcome;
+    }
+
+    SSTable::write(output_path, collection_name, merged, &tombstone_seqs);
+    outcome.wrote_output = true;
+    outcome.bytes_written = std::filesystem::file_size(output_path);
+    limiter.acquire(outcome.bytes_written);
+    return outcome;
+}
+
+} // namespace Storage
+} // namespace TissDB
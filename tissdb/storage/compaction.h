@@ -0,0 +1,71 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "sstable.h"
+#include "ttl.h"
+#include "../common/rate_limiter.h"
+
+namespace TissDB {
+namespace Storage {
+
+struct CompactionOptions {
+    // Run compactions on a background thread owned by the database.
+    bool background = true;
+    // A collection is compacted once it has at least this many SSTables.
+    size_t min_sstables = 4;
+    // How often the background thread looks for work.
+    std::chrono::milliseconds interval{1000};
+    // Combined read and write budget for compaction I/O. 0 means unlimited.
+    uint64_t max_bytes_per_second = 16 * 1024 * 1024;
+    // Collections with a TTL policy are also compacted this often, whatever
+    // their SSTable count, so expired documents are reclaimed.
+    std::chrono::milliseconds expiry_interval{60000};
+};
+
+// Cumulative counters, reported through the `_stats` endpoint.
+struct CompactionStats {
+    uint64_t runs = 0;
+    uint64_t bytes_read = 0;
+    uint64_t bytes_written = 0;
+    uint64_t tombstones_purged = 0;
+    uint64_t tombstones_retained = 0;
+    uint64_t documents_expired = 0;
+    uint64_t sstables_removed = 0;
+    uint64_t last_duration_ms = 0;
+};
+
+// Result of merging one run of SSTables.
+struct CompactionOutcome {
+    bool wrote_output = false; // False if every entry was purged
+    uint64_t bytes_read = 0;
+    uint64_t bytes_written = 0;
+    uint64_t live_entries = 0;
+    uint64_t tombstones_purged = 0;
+    uint64_t tombstones_retained = 0;
+    // Documents dropped because they had expired, for index cleanup.
+    std::vector<std::pair<std::string, std::shared_ptr<Document>>> expired;
+};
+
+// Merges `inputs` (oldest first) into a single SSTable at `output_path`.
+// The inputs must include the oldest SSTable of the collection, so no older
+// version of a key can exist below them: a tombstone is then only needed by
+// consumers still reading history, and is dropped once its sequence number is
+// at or below `purge_up_to`. For the same reason, documents that `ttl` says
+// have expired at `now` are dropped without leaving a tombstone. I/O is paced
+// through `limiter`. The output is encrypted with the DEK of `collection_name`.
+CompactionOutcome compact_sstables(const std::vector<std::shared_ptr<SSTable>>& inputs,
+                                   const std::string& collection_name,
+                                   const std::string& output_path,
+                                   uint64_t purge_up_to,
+                                   const TtlPolicy& ttl,
+                                   int64_t now,
+                                   Common::RateLimiter& limiter);
+
+} // namespace Storage
+} // namespace TissDB
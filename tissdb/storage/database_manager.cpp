@@ -11,15 +11,16 @@ namespace Storage {
 namespace fs = std::filesystem;
 
 // Forward declaration for helper functions
-void load_manifest(const std::string& manifest_path, std::map<std::string, std::unique_ptr<LSMTree>>& databases, const std::string& base_data_path);
+void load_manifest(const std::string& manifest_path, std::map<std::string, std::unique_ptr<LSMTree>>& databases, const std::string& base_data_path, Common::ThreadPool& pool);
 void save_manifest(const std::string& manifest_path, const std::map<std::string, std::unique_ptr<LSMTree>>& databases);
 
-DatabaseManager::DatabaseManager(const std::string& base_path) : base_data_path_(base_path) {
+DatabaseManager::DatabaseManager(const std::string& base_path)
+    : base_data_path_(base_path), loader_pool_(std::make_unique<Common::ThreadPool>()) {
     if (!fs::exists(base_data_path_)) {
         fs::create_directories(base_data_path_);
     }
     // Load existing databases from the manifest file on startup
-    load_manifest((fs::path(base_data_path_) / "manifest.json").string(), databases_, base_data_path_);
+    load_manifest((fs::path(base_data_path_) / "manifest.json").string(), databases_, base_data_path_, *loader_pool_);
 }
 
 DatabaseManager::~DatabaseManager() = default;
@@ -34,7 +35,7 @@ void DatabaseManager::create_database(const std::string& db_name) {
         fs::create_directory(db_path);
     }
 
-    databases_[db_name] = std::make_unique<LSMTree>(db_path);
+    databases_[db_name] = std::make_unique<LSMTree>(db_path, loader_pool_.get());
 
     // Update the manifest on disk
     save_manifest((fs::path(base_data_path_) / "manifest.json").string(), databases_);
@@ -86,7 +87,7 @@ void DatabaseManager::shutdown() {
 
 // --- Helper Function Implementations ---
 
-void load_manifest(const std::string& manifest_path, std::map<std::string, std::unique_ptr<LSMTree>>& databases, const std::string& base_data_path) {
+void load_manifest(const std::string& manifest_path, std::map<std::string, std::unique_ptr<LSMTree>>& databases, const std::string& base_data_path, Common::ThreadPool& pool) {
     if (!fs::exists(manifest_path)) {
         return; // No manifest to load
     }
@@ -106,13 +107,20 @@ void load_manifest(const std::string& manifest_path, std::map<std::string, std::
     try {
         Json::JsonValue parsed = Json::JsonValue::parse(content);
         const auto& dbs_array = parsed.as_object().at("databases").as_array();
+        // Databases are independent, so recover them in parallel.
+        std::map<std::string, std::future<std::unique_ptr<LSMTree>>> pending;
         for (const auto& db_val : dbs_array) {
             std::string db_name = db_val.as_string();
-            if (databases.find(db_name) == databases.end()) {
+            if (databases.find(db_name) == databases.end() && pending.find(db_name) == pending.end()) {
                  std::string db_path = (fs::path(base_data_path) / db_name).string();
-                 databases[db_name] = std::make_unique<LSMTree>(db_path);
+                 pending[db_name] = pool.submit([db_path, &pool] {
+                     return std::make_unique<LSMTree>(db_path, &pool);
+                 });
             }
         }
+        for (auto& [db_name, future] : pending) {
+            databases[db_name] = future.get();
+        }
     } catch (const std::exception& e) {
         throw std::runtime_error("Failed to parse manifest file: " + std::string(e.what()));
     }
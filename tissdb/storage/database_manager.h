@@ -4,6 +4,7 @@
 #include <map>
 #include <memory>
 #include "lsm_tree.h"
+#include "../common/thread_pool.h"
 
 namespace TissDB {
 namespace Storage {
@@ -36,6 +37,9 @@ public:
 
 private:
     std::string base_data_path_;
+    // Opens databases in parallel at startup and loads collections in the
+    // background afterwards. Declared before databases_ so it outlives them.
+    std::unique_ptr<Common::ThreadPool> loader_pool_;
     std::map<std::string, std::unique_ptr<LSMTree>> databases_;
 };
 
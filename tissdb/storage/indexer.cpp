@@ -7,6 +7,37 @@
 namespace TissDB {
 namespace Storage {
 
+namespace {
+// Rough per-entry cost of a B+ tree slot beyond the key and value bytes.
+constexpr size_t INDEX_ENTRY_OVERHEAD = 2 * sizeof(std::string);
+
+// Key of a document in a timestamp index on `field_name`, if it has one.
+std::optional<int64_t> timestamp_key(const std::string& field_name, const Document& doc) {
+    for (const auto& elem : doc.elements) {
+        if (elem.key == field_name) {
+            if (const auto* ts = std::get_if<TissDB::Timestamp>(&elem.value)) {
+                return ts->microseconds_since_epoch_utc;
+            }
+            return std::nullopt;
+        }
+    }
+    return std::nullopt;
+}
+} // anonymous namespace
+
+void Indexer::account_entry(size_t key_size, const std::optional<std::string>& old_value, size_t new_value_size) {
+    if (old_value) {
+        memory_usage_ -= old_value->size();
+    } else {
+        memory_usage_ += key_size + INDEX_ENTRY_OVERHEAD;
+    }
+    memory_usage_ += new_value_size;
+}
+
+void Indexer::release_entry(size_t key_size, size_t value_size) {
+    memory_usage_ -= key_size + INDEX_ENTRY_OVERHEAD + value_size;
+}
+
 std::string Indexer::get_index_name(const std::vector<std::string>& field_names) const {
     std::stringstream ss;
     for (size_t i = 0; i < field_names.size(); ++i) {
@@ -84,6 +115,19 @@ std::string Indexer::get_composite_key(const std::vector<std::string>& field_nam
     return key_ss.str();
 }
 
+bool Indexer::same_index_keys(const Document& a, const Document& b) const {
+    for (const auto& [index_name, field_names] : index_fields_) {
+        if (timestamp_indexes_.count(index_name)) {
+            if (field_names.size() == 1 && timestamp_key(field_names[0], a) != timestamp_key(field_names[0], b)) {
+                return false;
+            }
+        } else if (get_composite_key(field_names, a) != get_composite_key(field_names, b)) {
+            return false;
+        }
+    }
+    return true;
+}
+
 void Indexer::update_indexes(const std::string& document_id, const Document& doc) {
     for (const auto& pair : index_fields_) {
         const std::string& index_name = pair.first;
@@ -133,7 +177,9 @@ void Indexer::update_indexes(const std::string& document_id, const Document& doc
                 }
 
                 doc_ids_array.push_back(Json::JsonValue(document_id));
-                btree->insert(key, Json::JsonValue(doc_ids_array).serialize());
+                std::string ids_json = Json::JsonValue(doc_ids_array).serialize();
+                account_entry(sizeof(int64_t), existing_json_str_opt, ids_json.size());
+                btree->insert(key, ids_json);
             }
         } else if (indexes_.count(index_name)) {
             // Handle string-based composite index
@@ -170,7 +216,9 @@ void Indexer::update_indexes(const std::string& document_id, const Document& doc
             }
 
             doc_ids_array.push_back(Json::JsonValue(document_id));
-            btree->insert(key, Json::JsonValue(doc_ids_array).serialize());
+            std::string ids_json = Json::JsonValue(doc_ids_array).serialize();
+            account_entry(key.size(), existing_json_str_opt, ids_json.size());
+            btree->insert(key, ids_json);
         }
     }
 }
@@ -214,9 +262,12 @@ void Indexer::remove_from_indexes(const std::string& document_id, const Document
 
                     if (found) {
                         if (new_doc_ids_array.empty()) {
+                            release_entry(sizeof(int64_t), existing_json_str_opt->size());
                             btree->erase(key);
                         } else {
-                            btree->insert(key, Json::JsonValue(new_doc_ids_array).serialize());
+                            std::string ids_json = Json::JsonValue(new_doc_ids_array).serialize();
+                            account_entry(sizeof(int64_t), existing_json_str_opt, ids_json.size());
+                            btree->insert(key, ids_json);
                         }
                     }
                 }
@@ -248,9 +299,12 @@ void Indexer::remove_from_indexes(const std::string& document_id, const Document
 
                 if (found) {
                     if (new_doc_ids_array.empty()) {
+                        release_entry(key.size(), existing_json_str_opt->size());
                         btree->erase(key);
                     } else {
-                        btree->insert(key, Json::JsonValue(new_doc_ids_array).serialize());
+                        std::string ids_json = Json::JsonValue(new_doc_ids_array).serialize();
+                        account_entry(key.size(), existing_json_str_opt, ids_json.size());
+                        btree->insert(key, ids_json);
                     }
                 }
             }
@@ -479,6 +533,7 @@ std::vector<std::vector<std::string>> Indexer::get_available_indexes() const {
 void Indexer::load_indexes(const std::string& data_dir) {
     indexes_.clear();
     index_fields_.clear();
+    memory_usage_ = 0;
 
     std::string meta_path = data_dir + "/indexes.meta";
     if (!std::filesystem::exists(meta_path)) {
@@ -522,6 +577,9 @@ void Indexer::load_indexes(const std::string& data_dir) {
                 auto btree = std::make_shared<BTree<std::string, std::string>>();
                 std::ifstream ifs(bpt_path, std::ios::binary);
                 btree->load(ifs);
+                btree->foreach([this](const std::string& key, const std::string& value) {
+                    memory_usage_ += key.size() + INDEX_ENTRY_OVERHEAD + value.size();
+                });
                 indexes_[index_name] = btree;
             } catch (...) {
                 // Handle B-Tree deserialization error, maybe log it
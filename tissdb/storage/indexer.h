@@ -5,6 +5,7 @@
 #include <vector>
 #include <map>
 #include <memory>
+#include <optional>
 
 #include "native_b_tree.h"
 
@@ -28,6 +29,9 @@ public:
     bool has_index(const std::vector<std::string>& field_names) const;
     void update_indexes(const std::string& document_id, const Document& doc);
     void remove_from_indexes(const std::string& document_id, const Document& doc);
+    // True if every index files `a` and `b` under the same key, so replacing
+    // one with the other leaves the indexes as they are.
+    bool same_index_keys(const Document& a, const Document& b) const;
     std::vector<std::string> find_by_index(const std::string& index_name, const Value& key) const;
     std::vector<std::string> find_by_index(const std::string& index_name, const std::string& value) const;
     std::vector<std::string> find_by_index(const std::string& index_name, int64_t value) const;
@@ -39,6 +43,9 @@ public:
     void load_indexes(const std::string& data_dir);
     std::vector<std::vector<std::string>> get_available_indexes() const;
 
+    // Approximate bytes held by all index trees.
+    size_t approximate_memory_usage() const { return memory_usage_; }
+
 private:
     using BTreeVariant = std::variant<
         std::shared_ptr<BTree<std::string, std::string>>,
@@ -47,6 +54,8 @@ private:
 
     std::string get_index_name(const std::vector<std::string>& field_names) const;
     std::string get_composite_key(const std::vector<std::string>& field_names, const Document& doc) const;
+    void account_entry(size_t key_size, const std::optional<std::string>& old_value, size_t new_value_size);
+    void release_entry(size_t key_size, size_t value_size);
 
     // Maps an index name (e.g., "lastname_firstname") to a B+ tree instance.
     // The B+ tree maps a composite key (e.g., "Smith\0John") to a string
@@ -62,6 +71,7 @@ private:
     std::map<std::string, IndexType> index_types_;
     // Maps an index name to whether it's a unique index.
     std::map<std::string, bool> index_uniqueness_;
+    size_t memory_usage_ = 0;
 };
 
 } // namespace Storage
@@ -2,9 +2,15 @@
 #include "../common/log.h"
 #include "../common/serialization.h"
 #include "../crypto/kms.h"
+#include "../json/json.h"
+#include <algorithm>
+#include <chrono>
 #include <stdexcept>
 #include <filesystem>
+#include <fstream>
 #include <set>
+#include <mutex>
+#include <tuple>
 #include "wal.h" // For LogEntry, LogEntryType
 #include "../query/executor_common.h" // For value_to_string
 
@@ -21,9 +27,63 @@ TissDB::Crypto::KeyManagementSystem& get_kms_instance() {
     static TissDB::Crypto::KeyManagementSystem instance(master_key);
     return instance;
 }
+
+const char* const SEQUENCE_FILE = "sequence.json";
+const char* const WAL_ARCHIVE_DIR = "wal_archive";
+const char* const SHARD_WAL_FILE = "wal.log";
+
+// Completes a sequence number in the change feed however the write that took
+// it ends, so readers are never held up behind it: published if its entry
+// reached the log, skipped otherwise.
+class SequenceCompletion {
+public:
+    SequenceCompletion(ChangeFeed& feed, uint64_t lsn) : feed_(feed), lsn_(lsn) {}
+    ~SequenceCompletion() {
+        if (logged_) {
+            feed_.publish(lsn_);
+        } else {
+            feed_.skip(lsn_);
+        }
+    }
+    SequenceCompletion(const SequenceCompletion&) = delete;
+    SequenceCompletion& operator=(const SequenceCompletion&) = delete;
+
+    void logged() { logged_ = true; }
+
+private:
+    ChangeFeed& feed_;
+    uint64_t lsn_;
+    bool logged_ = false;
+};
+
+template <typename T>
+std::vector<T> concatenate(std::vector<std::vector<T>>&& parts) {
+    std::vector<T> result;
+    for (auto& part : parts) {
+        if (result.empty()) {
+            result = std::move(part);
+        } else {
+            result.insert(result.end(), std::make_move_iterator(part.begin()), std::make_move_iterator(part.end()));
+        }
+    }
+    return result;
+}
 } // anonymous namespace
 
-LSMTree::LSMTree(const std::string& path) : path_(path), transaction_manager_(*this) {
+const char* to_string(CollectionLoadState state) {
+    switch (state) {
+        case CollectionLoadState::Unloaded: return "unloaded";
+        case CollectionLoadState::Loading: return "loading";
+        case CollectionLoadState::Ready: return "ready";
+        case CollectionLoadState::Failed: return "failed";
+    }
+    return "unknown";
+}
+
+LSMTree::LSMTree(const std::string& path, Common::ThreadPool* loader_pool, const CompactionOptions& compaction_options,
+                 const ChangeFeedOptions& change_feed_options)
+    : path_(path), transaction_manager_(*this), compaction_options_(compaction_options),
+      compaction_limiter_(compaction_options.max_bytes_per_second) {
     std::filesystem::path db_path(path_);
     if (!std::filesystem::exists(db_path)) {
         std::filesystem::create_directories(db_path);
@@ -31,13 +91,138 @@ LSMTree::LSMTree(const std::string& path) : path_(path), transaction_manager_(*t
 
     std::string wal_path = (db_path / "wal.log").string();
     wal_ = std::make_unique<WriteAheadLog>(wal_path);
+    change_feed_ = std::make_unique<ChangeFeed>((db_path / WAL_ARCHIVE_DIR).string(), wal_path, change_feed_options);
 
-    LOG_INFO("Database opened at: " + path_ + ". Starting recovery.");
+    // Register the collections on disk first; the WAL only holds writes made
+    // since the last checkpoint. Replay opens the collections it touches.
+    LOG_INFO("Database opened at: " + path_ + ". Discovering collections...");
+    load_sequence();
+    load_collections();
+    LOG_INFO("Starting recovery.");
     recover();
+    uint64_t active_first_lsn = wal_->first_lsn();
+    for (auto const& [name, shards] : sharded_) {
+        for (const auto& shard : shards) {
+            const uint64_t first = shard->wal->first_lsn();
+            if (first != 0 && (active_first_lsn == 0 || first < active_first_lsn)) {
+                active_first_lsn = first;
+            }
+        }
+    }
+    change_feed_->start(active_first_lsn, last_sequence_.load());
     LOG_INFO("Recovery complete.");
-    LOG_INFO("Loading collections and indexes...");
-    load_collections();
-    LOG_INFO("Collection loading complete.");
+
+    if (loader_pool) {
+        for (auto const& [name, slot] : collections_) {
+            if (slot->state.load() != CollectionLoadState::Unloaded) continue;
+            background_loads_.push_back(loader_pool->submit([this, slot = slot] {
+                try {
+                    ensure_open(*slot);
+                } catch (const std::exception&) {
+                    // Already logged; the collection stays Failed and is retried on access.
+                }
+            }));
+        }
+    }
+
+    if (compaction_options_.background) {
+        compaction_thread_ = std::thread([this] { compaction_loop(); });
+    }
+
+    // Under memory pressure the governor asks for a checkpoint, which empties the memtables.
+    Common::MemoryGovernor::Reclaimer reclaimer;
+    reclaimer.usage = [this] {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        return memtable_bytes_locked();
+    };
+    reclaimer.reclaim = [this] {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        size_t before = memtable_bytes_locked();
+        checkpoint_locked();
+        size_t after = memtable_bytes_locked();
+        return before > after ? before - after : 0;
+    };
+    memory_reclaimer_id_ = Common::MemoryGovernor::instance().register_reclaimer(std::move(reclaimer));
+}
+
+size_t LSMTree::memtable_bytes_locked() const {
+    size_t total = 0;
+    for (auto const& [name, slot] : collections_) {
+        if (is_shard_collection_name(name)) continue; // Counted below, under the shard's lock
+        if (const Collection* collection = opened_collection(*slot)) {
+            total += collection->approximate_size();
+        }
+    }
+    for (auto const& [name, shards] : sharded_) {
+        for (const auto& shard : shards) {
+            std::shared_lock<std::shared_mutex> shard_lock(shard->mutex);
+            if (const Collection* collection = opened_collection(*shard->slot)) {
+                total += collection->approximate_size();
+            }
+        }
+    }
+    return total;
+}
+
+bool LSMTree::collection_exists_locked(const std::string& name) const {
+    return collections_.count(name) > 0 || sharded_.count(name) > 0;
+}
+
+LSMTree::ShardSet* LSMTree::find_shards(const std::string& name) {
+    auto it = sharded_.find(name);
+    return it == sharded_.end() ? nullptr : &it->second;
+}
+
+const LSMTree::ShardSet* LSMTree::find_shards(const std::string& name) const {
+    auto it = sharded_.find(name);
+    return it == sharded_.end() ? nullptr : &it->second;
+}
+
+Collection& LSMTree::shard_collection(const Shard& shard) const {
+    // Opening a collection does not change the logical state of the database.
+    return const_cast<LSMTree*>(this)->ensure_open(*shard.slot);
+}
+
+template <typename F>
+auto LSMTree::read_shards(const ShardSet& shards, F read) const {
+    return for_each_shard(*shard_pool_, shards.size(), [&](size_t i) {
+        const Shard& shard = *shards[i];
+        std::shared_lock<std::shared_mutex> shard_lock(shard.mutex);
+        return read(i, shard_collection(shard));
+    });
+}
+
+Collection& LSMTree::ensure_open(CollectionSlot& slot) {
+    if (slot.state.load(std::memory_order_acquire) != CollectionLoadState::Ready) {
+        std::call_once(slot.open_once, [this, &slot] {
+            slot.state.store(CollectionLoadState::Loading);
+            try {
+                slot.collection = std::make_unique<Collection>(slot.path, this);
+            } catch (const std::exception& e) {
+                LOG_ERROR("Failed to open collection at " + slot.path + ": " + e.what());
+                slot.state.store(CollectionLoadState::Failed);
+                throw;
+            }
+            slot.state.store(CollectionLoadState::Ready, std::memory_order_release);
+        });
+    }
+    return *slot.collection;
+}
+
+Collection* LSMTree::opened_collection(const CollectionSlot& slot) const {
+    if (slot.state.load(std::memory_order_acquire) != CollectionLoadState::Ready) {
+        return nullptr;
+    }
+    return slot.collection.get();
+}
+
+std::map<std::string, CollectionLoadState> LSMTree::get_collection_states() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    std::map<std::string, CollectionLoadState> states;
+    for (auto const& [name, slot] : collections_) {
+        states[name] = slot->state.load();
+    }
+    return states;
 }
 
 void LSMTree::recover() {
@@ -51,6 +236,10 @@ void LSMTree::recover() {
     }
 
     for (const auto& entry : log_entries) {
+        if (entry.lsn != 0) {
+            // Replay the write under the sequence number it was logged with.
+            last_sequence_.store(entry.lsn - 1);
+        }
         switch (entry.type) {
             case LogEntryType::PUT:
                 put(entry.collection_name, entry.document_id, entry.doc, -1, true);
@@ -59,7 +248,7 @@ void LSMTree::recover() {
                 del(entry.collection_name, entry.document_id, -1, true);
                 break;
             case LogEntryType::CREATE_COLLECTION:
-                if (!collections_.count(entry.collection_name)) {
+                if (!collection_exists_locked(entry.collection_name)) {
                     create_collection(entry.collection_name, {}, true);
                 } else {
                     LOG_WARNING("Recovery: Attempted to re-create collection '" + entry.collection_name + "' which already exists. Skipping.");
@@ -80,25 +269,56 @@ void LSMTree::recover() {
                 break;
         }
     }
+    recover_shards();
 }
 
-LSMTree::~LSMTree() {}
+void LSMTree::recover_shards() {
+    // Each shard's log holds only that shard's writes, each under the
+    // sequence number it was given; replay order across shards is irrelevant.
+    uint64_t last_lsn = last_sequence_.load();
+    for (auto const& [name, shards] : sharded_) {
+        for (const auto& shard : shards) {
+            auto log_entries = shard->wal->recover();
+            if (log_entries.empty()) continue;
+            Collection& collection = ensure_open(*shard->slot);
+            for (const auto& entry : log_entries) {
+                if (entry.type == LogEntryType::PUT) {
+                    collection.put(entry.document_id, entry.doc);
+                } else if (entry.type == LogEntryType::DELETE) {
+                    collection.del(entry.document_id, entry.lsn);
+                }
+                last_lsn = std::max(last_lsn, entry.lsn);
+            }
+        }
+    }
+    last_sequence_.store(last_lsn);
+}
+
+LSMTree::~LSMTree() {
+    Common::MemoryGovernor::instance().unregister_reclaimer(memory_reclaimer_id_);
+    stop_compaction();
+    // Background loads reference this database; let them finish first.
+    for (auto& load : background_loads_) {
+        load.wait();
+    }
+}
 
 LSMTree::LSMTree() : LSMTree(".") {
     // Delegating constructor
 }
 
 std::vector<std::string> LSMTree::find_by_index(const std::string& collection_name, const std::string& field_name, const std::string& value) {
-    try {
-        const Collection& collection = get_collection(collection_name);
-        return collection.find_by_index({field_name}, {value});
-    } catch (const std::runtime_error& e) {
-        return {};
-    }
+    return find_by_index(collection_name, std::vector<std::string>{field_name}, std::vector<std::string>{value});
 }
 
 std::vector<std::string> LSMTree::find_by_index(const std::string& collection_name, const std::vector<std::string>& field_names, const std::vector<std::string>& values) {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
     try {
+        if (const ShardSet* shards = find_shards(collection_name)) {
+            return concatenate(read_shards(*shards, [&](size_t, Collection& collection) {
+                return collection.find_by_index(field_names, values);
+            }));
+        }
         const Collection& collection = get_collection(collection_name);
         return collection.find_by_index(field_names, values);
     } catch (const std::runtime_error& e) {
@@ -107,7 +327,9 @@ std::vector<std::string> LSMTree::find_by_index(const std::string& collection_na
 }
 
 void LSMTree::create_collection(const std::string& name, const TissDB::Schema& schema, bool is_recovery) {
-    if (collections_.count(name)) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    catalog_version_++;
+    if (collection_exists_locked(name)) {
         LOG_ERROR("Attempted to create collection that already exists: " + name);
         throw std::runtime_error("Collection already exists: " + name);
     }
@@ -125,13 +347,78 @@ void LSMTree::create_collection(const std::string& name, const TissDB::Schema& s
     if (!std::filesystem::exists(collection_path)) {
         std::filesystem::create_directories(collection_path);
     }
-    auto collection = std::make_unique<Collection>(this, collection_path);
-    collection->set_schema(schema);
-    collections_[name] = std::move(collection);
+    auto slot = std::make_shared<CollectionSlot>();
+    slot->path = collection_path;
+    std::call_once(slot->open_once, [&] {
+        slot->collection = std::make_unique<Collection>(this, collection_path);
+        slot->collection->set_schema(schema);
+    });
+    slot->state.store(CollectionLoadState::Ready, std::memory_order_release);
+    collections_[name] = std::move(slot);
+}
+
+void LSMTree::create_sharded_collection(const std::string& name, const TissDB::Schema& schema, size_t shard_count) {
+    if (shard_count < 1 || shard_count > MAX_SHARDS) {
+        throw std::runtime_error("Shard count must be between 1 and " + std::to_string(MAX_SHARDS) + ": " + name);
+    }
+    if (name.empty() || is_shard_collection_name(name)) {
+        throw std::runtime_error("Invalid collection name: " + name);
+    }
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    catalog_version_++;
+    if (collection_exists_locked(name)) {
+        LOG_ERROR("Attempted to create collection that already exists: " + name);
+        throw std::runtime_error("Collection already exists: " + name);
+    }
+
+    // The layout is on disk before the creation is logged, so replaying the
+    // entry finds the collection already registered.
+    LOG_INFO("Creating collection: " + name + " with " + std::to_string(shard_count) + " shards");
+    std::filesystem::path collection_path = std::filesystem::path(path_) / name;
+    for (size_t i = 0; i < shard_count; ++i) {
+        std::filesystem::create_directories(collection_path / ("shard_" + std::to_string(i)));
+    }
+    write_shard_count(collection_path.string(), shard_count);
+    register_shards(name, shard_count);
+    for (const auto& shard : sharded_.at(name)) {
+        ensure_open(*shard->slot).set_schema(schema);
+    }
+
+    LogEntry entry;
+    entry.type = LogEntryType::CREATE_COLLECTION;
+    entry.collection_name = name;
+    wal_->append(entry);
+}
+
+size_t LSMTree::shard_count(const std::string& name) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    const ShardSet* shards = find_shards(name);
+    return shards ? shards->size() : 1;
+}
+
+void LSMTree::register_shards(const std::string& name, size_t shard_count) {
+    const std::filesystem::path collection_path = std::filesystem::path(path_) / name;
+    ShardSet shards;
+    for (size_t i = 0; i < shard_count; ++i) {
+        auto shard = std::make_unique<Shard>();
+        shard->slot = std::make_shared<CollectionSlot>();
+        shard->slot->path = (collection_path / ("shard_" + std::to_string(i))).string();
+        std::filesystem::create_directories(shard->slot->path);
+        shard->wal = std::make_unique<WriteAheadLog>((std::filesystem::path(shard->slot->path) / SHARD_WAL_FILE).string());
+        change_feed_->add_stream(shard->wal->get_path());
+        collections_[shard_collection_name(name, i)] = shard->slot;
+        shards.push_back(std::move(shard));
+    }
+    sharded_[name] = std::move(shards);
+    if (!shard_pool_) {
+        shard_pool_ = std::make_unique<Common::ThreadPool>(std::max(2u, std::thread::hardware_concurrency()));
+    }
 }
 
 void LSMTree::delete_collection(const std::string& name) {
-    if (!collections_.count(name)) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    catalog_version_++;
+    if (!collection_exists_locked(name)) {
         LOG_ERROR("Attempted to delete collection that does not exist: " + name);
         throw std::runtime_error("Collection does not exist: " + name);
     }
@@ -146,6 +433,16 @@ void LSMTree::delete_collection(const std::string& name) {
 
     LOG_INFO("Deleting collection: " + name);
     collections_.erase(name);
+    if (ShardSet* shards = find_shards(name)) {
+        for (size_t i = 0; i < shards->size(); ++i) {
+            Shard& shard = *(*shards)[i];
+            // The shard's unsealed changes go with it.
+            change_feed_->remove_stream(shard.wal->get_path());
+            shard.wal->shutdown();
+            collections_.erase(shard_collection_name(name, i));
+        }
+        sharded_.erase(name);
+    }
 
     try {
         std::filesystem::path db_path(path_);
@@ -160,10 +457,17 @@ void LSMTree::delete_collection(const std::string& name) {
 }
 
 std::vector<std::string> LSMTree::list_collections() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
     std::vector<std::string> names;
     for (const auto& pair : collections_) {
+        if (!is_shard_collection_name(pair.first)) {
+            names.push_back(pair.first);
+        }
+    }
+    for (const auto& pair : sharded_) {
         names.push_back(pair.first);
     }
+    std::sort(names.begin(), names.end());
     return names;
 }
 
@@ -172,18 +476,83 @@ void LSMTree::put(const std::string& collection_name, const std::string& key, co
         transaction_manager_.add_put_operation(tid, collection_name, key, doc);
     } else {
         if (!is_recovery) {
+            Common::MemoryGovernor::instance().admit_write();
+        }
+        {
+            std::shared_lock<std::shared_mutex> lock(mutex_);
+            if (ShardSet* shards = find_shards(collection_name)) {
+                LogEntry entry;
+                entry.type = LogEntryType::PUT;
+                entry.collection_name = collection_name;
+                entry.document_id = key;
+                entry.doc = doc;
+                write_to_shard(lock, *shards, entry, is_recovery);
+                return;
+            }
+        }
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        Collection& collection = get_collection(collection_name);
+        const uint64_t lsn = last_sequence_.fetch_add(1) + 1;
+        if (!is_recovery) {
+            SequenceCompletion completion(*change_feed_, lsn);
             LogEntry entry;
             entry.type = LogEntryType::PUT;
             entry.collection_name = collection_name;
             entry.document_id = key;
             entry.doc = doc;
+            entry.lsn = lsn;
+            // Stamp the default expiry now, so replaying the WAL does not extend it.
+            collection.get_ttl_policy().apply_default(entry.doc, now_us());
             wal_->append(entry);
+            completion.logged();
+            collection.put(key, entry.doc);
+        } else {
+            collection.put(key, doc);
+        }
+        if (!is_recovery && collection.is_full()) {
+            checkpoint_locked();
         }
-        Collection& collection = get_collection(collection_name);
-        collection.put(key, doc);
     }
 }
 
+bool LSMTree::write_to_shard(std::shared_lock<std::shared_mutex>& lock, ShardSet& shards, LogEntry& entry, bool is_recovery) {
+    Shard& shard = *shards[shard_of(entry.document_id, shards.size())];
+    bool result = true;
+    bool full = false;
+    {
+        std::unique_lock<std::shared_mutex> shard_lock(shard.mutex);
+        Collection& collection = ensure_open(*shard.slot);
+        // Taken under the shard lock, so each shard's log is in sequence order.
+        entry.lsn = last_sequence_.fetch_add(1) + 1;
+        if (is_recovery) {
+            if (entry.type == LogEntryType::PUT) {
+                collection.put(entry.document_id, entry.doc);
+                return true;
+            }
+            return collection.del(entry.document_id, entry.lsn);
+        }
+
+        SequenceCompletion completion(*change_feed_, entry.lsn);
+        if (entry.type == LogEntryType::PUT) {
+            // Stamp the default expiry now, so replaying the WAL does not extend it.
+            collection.get_ttl_policy().apply_default(entry.doc, now_us());
+            shard.wal->append(entry);
+            completion.logged();
+            collection.put(entry.document_id, entry.doc);
+        } else {
+            shard.wal->append(entry);
+            completion.logged();
+            result = collection.del(entry.document_id, entry.lsn);
+        }
+        full = collection.is_full();
+    }
+    if (full) {
+        lock.unlock();
+        checkpoint();
+    }
+    return result;
+}
+
 std::optional<std::shared_ptr<Document>> LSMTree::get(const std::string& collection_name, const std::string& key, Transactions::TransactionID tid) {
     if (tid != -1) {
         const auto* transaction = transaction_manager_.get_transaction(tid);
@@ -202,7 +571,14 @@ std::optional<std::shared_ptr<Document>> LSMTree::get(const std::string& collect
         }
     }
 
+    // Taken after the transaction lookup: commit holds the transaction lock while it writes.
+    std::shared_lock<std::shared_mutex> lock(mutex_);
     try {
+        if (const ShardSet* shards = find_shards(collection_name)) {
+            const Shard& shard = *(*shards)[shard_of(key, shards->size())];
+            std::shared_lock<std::shared_mutex> shard_lock(shard.mutex);
+            return ensure_open(*shard.slot).get(key);
+        }
         Collection& collection = get_collection(collection_name);
         return collection.get(key);
     } catch (const std::runtime_error& e) {
@@ -211,15 +587,29 @@ std::optional<std::shared_ptr<Document>> LSMTree::get(const std::string& collect
 }
 
 std::vector<Document> LSMTree::get_many(const std::string& collection_name, const std::vector<std::string>& keys) {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
     std::vector<Document> result_docs;
     try {
-        Collection& collection = get_collection(collection_name);
-        for (const auto& key : keys) {
-            auto doc_opt = collection.get(key);
-            if (doc_opt && *doc_opt) {
-                result_docs.push_back(**doc_opt);
+        if (const ShardSet* shards = find_shards(collection_name)) {
+            std::vector<std::vector<std::string>> shard_keys(shards->size());
+            for (const auto& key : keys) {
+                shard_keys[shard_of(key, shards->size())].push_back(key);
+            }
+            auto parts = read_shards(*shards, [&](size_t i, Collection& collection) {
+                return shard_keys[i].empty() ? std::vector<Document>() : collection.multi_get(shard_keys[i]);
+            });
+            // Back in the order asked for; a document's id is its key.
+            std::map<std::string, const Document*> by_key;
+            for (const auto& part : parts) {
+                for (const auto& doc : part) by_key.emplace(doc.id, &doc);
+            }
+            for (const auto& key : keys) {
+                auto it = by_key.find(key);
+                if (it != by_key.end()) result_docs.push_back(*it->second);
             }
+            return result_docs;
         }
+        result_docs = get_collection(collection_name).multi_get(keys);
     } catch (const std::runtime_error& e) {
     }
     return result_docs;
@@ -231,23 +621,135 @@ bool LSMTree::del(const std::string& collection_name, const std::string& key, Tr
         return true;
     } else {
         if (!is_recovery) {
+            Common::MemoryGovernor::instance().admit_write();
+        }
+        {
+            std::shared_lock<std::shared_mutex> lock(mutex_);
+            if (ShardSet* shards = find_shards(collection_name)) {
+                LogEntry entry;
+                entry.type = LogEntryType::DELETE;
+                entry.collection_name = collection_name;
+                entry.document_id = key;
+                return write_to_shard(lock, *shards, entry, is_recovery);
+            }
+        }
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        Collection* collection = nullptr;
+        try {
+            collection = &get_collection(collection_name);
+        } catch (const std::runtime_error& e) {
+            return false;
+        }
+        const uint64_t lsn = last_sequence_.fetch_add(1) + 1;
+        if (!is_recovery) {
+            SequenceCompletion completion(*change_feed_, lsn);
             LogEntry entry;
             entry.type = LogEntryType::DELETE;
             entry.collection_name = collection_name;
             entry.document_id = key;
+            entry.lsn = lsn;
             wal_->append(entry);
+            completion.logged();
         }
-        try {
-            Collection& collection = get_collection(collection_name);
-            return collection.del(key);
-        } catch (const std::runtime_error& e) {
-            return false;
+        return collection->del(key, lsn);
+    }
+}
+
+void LSMTree::put_many(const std::string& collection_name, std::vector<Document> docs) {
+    std::vector<LogEntry> entries(docs.size());
+    for (size_t i = 0; i < docs.size(); ++i) {
+        entries[i].type = LogEntryType::PUT;
+        entries[i].collection_name = collection_name;
+        entries[i].document_id = docs[i].id;
+        entries[i].doc = std::move(docs[i]);
+    }
+    write_many(collection_name, std::move(entries));
+}
+
+size_t LSMTree::del_many(const std::string& collection_name, const std::vector<std::string>& keys) {
+    std::vector<LogEntry> entries(keys.size());
+    for (size_t i = 0; i < keys.size(); ++i) {
+        entries[i].type = LogEntryType::DELETE;
+        entries[i].collection_name = collection_name;
+        entries[i].document_id = keys[i];
+    }
+    return write_many(collection_name, std::move(entries));
+}
+
+size_t LSMTree::write_many(const std::string& collection_name, std::vector<LogEntry> entries) {
+    if (entries.empty()) return 0;
+    Common::MemoryGovernor::instance().admit_write();
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        if (ShardSet* shards = find_shards(collection_name)) {
+            std::vector<std::vector<LogEntry>> by_shard(shards->size());
+            for (auto& entry : entries) {
+                by_shard[shard_of(entry.document_id, shards->size())].push_back(std::move(entry));
+            }
+            size_t deleted = 0;
+            bool full = false;
+            for (size_t i = 0; i < shards->size(); ++i) {
+                if (by_shard[i].empty()) continue;
+                Shard& shard = *(*shards)[i];
+                std::unique_lock<std::shared_mutex> shard_lock(shard.mutex);
+                Collection& collection = ensure_open(*shard.slot);
+                deleted += log_and_apply(collection, *shard.wal, by_shard[i]);
+                full = full || collection.is_full();
+            }
+            if (full) {
+                lock.unlock();
+                checkpoint();
+            }
+            return deleted;
         }
     }
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    Collection& collection = get_collection(collection_name);
+    const size_t deleted = log_and_apply(collection, *wal_, entries);
+    if (collection.is_full()) {
+        checkpoint_locked();
+    }
+    return deleted;
+}
+
+size_t LSMTree::log_and_apply(Collection& collection, WriteAheadLog& wal, std::vector<LogEntry>& entries) {
+    // One block of sequence numbers, so the group is in order in its log.
+    const uint64_t first_lsn = last_sequence_.fetch_add(entries.size()) + 1;
+    const int64_t now = now_us();
+    for (size_t i = 0; i < entries.size(); ++i) {
+        entries[i].lsn = first_lsn + i;
+        if (entries[i].type == LogEntryType::PUT) {
+            // Stamp the default expiry now, so replaying the WAL does not extend it.
+            collection.get_ttl_policy().apply_default(entries[i].doc, now);
+        }
+    }
+    try {
+        wal.append_batch(entries);
+    } catch (...) {
+        for (const auto& entry : entries) change_feed_->skip(entry.lsn);
+        throw;
+    }
+    for (const auto& entry : entries) change_feed_->publish(entry.lsn);
+
+    size_t deleted = 0;
+    for (const auto& entry : entries) {
+        if (entry.type == LogEntryType::PUT) {
+            collection.put(entry.document_id, entry.doc);
+        } else if (collection.del(entry.document_id, entry.lsn)) {
+            deleted++;
+        }
+    }
+    return deleted;
 }
 
 std::vector<Document> LSMTree::scan(const std::string& collection_name) {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
     try {
+        if (const ShardSet* shards = find_shards(collection_name)) {
+            return concatenate(read_shards(*shards, [](size_t, Collection& collection) {
+                return collection.scan();
+            }));
+        }
         Collection& collection = get_collection(collection_name);
         return collection.scan();
     } catch (const std::runtime_error& e) {
@@ -255,12 +757,27 @@ std::vector<Document> LSMTree::scan(const std::string& collection_name) {
     }
 }
 
+std::vector<std::shared_ptr<const Document>> LSMTree::scan_shared(const std::string& collection_name) {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    try {
+        if (const ShardSet* shards = find_shards(collection_name)) {
+            return concatenate(read_shards(*shards, [](size_t, Collection& collection) {
+                return collection.scan_shared();
+            }));
+        }
+        Collection& collection = get_collection(collection_name);
+        return collection.scan_shared();
+    } catch (const std::runtime_error& e) {
+        return {};
+    }
+}
+
 Collection& LSMTree::get_collection(const std::string& name) {
     auto it = collections_.find(name);
     if (it == collections_.end()) {
         throw std::runtime_error("Collection not found: " + name);
     }
-    return *it->second;
+    return ensure_open(*it->second);
 }
 
 const std::string& LSMTree::get_path() const {
@@ -272,11 +789,22 @@ const Collection& LSMTree::get_collection(const std::string& name) const {
     if (it == collections_.end()) {
         throw std::runtime_error("Collection not found: " + name);
     }
-    return *it->second;
+    // Opening a collection does not change the logical state of the database.
+    return const_cast<LSMTree*>(this)->ensure_open(*it->second);
 }
 
 void LSMTree::create_index(const std::string& collection_name, const std::vector<std::string>& field_names, bool is_unique) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    catalog_version_++;
     try {
+        if (ShardSet* shards = find_shards(collection_name)) {
+            // Uniqueness is enforced per shard; a unique index is only global
+            // if it covers the key.
+            for (const auto& shard : *shards) {
+                ensure_open(*shard->slot).create_index(field_names, is_unique);
+            }
+            return;
+        }
         Collection& collection = get_collection(collection_name);
         collection.create_index(field_names, is_unique);
     } catch (const std::runtime_error& e) {
@@ -285,19 +813,67 @@ void LSMTree::create_index(const std::string& collection_name, const std::vector
     }
 }
 
-std::vector<std::string> LSMTree::find_by_index(const std::string& collection_name, const std::vector<std::string>& field_names, const std::vector<Value>& values) {
+void LSMTree::set_ttl_policy(const std::string& collection_name, const TtlPolicy& policy) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    if (ShardSet* shards = find_shards(collection_name)) {
+        for (const auto& shard : *shards) {
+            ensure_open(*shard->slot).set_ttl_policy(policy);
+        }
+        return;
+    }
+    get_collection(collection_name).set_ttl_policy(policy);
+}
+
+TtlPolicy LSMTree::get_ttl_policy(const std::string& collection_name) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    if (const ShardSet* shards = find_shards(collection_name)) {
+        // Every shard has the same policy.
+        std::shared_lock<std::shared_mutex> shard_lock(shards->front()->mutex);
+        return shard_collection(*shards->front()).get_ttl_policy();
+    }
+    return get_collection(collection_name).get_ttl_policy();
+}
+
+CollectionStatistics LSMTree::analyze(const std::string& collection_name) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    catalog_version_++;
+    if (const ShardSet* shards = find_shards(collection_name)) {
+        // No writer can reach the shards while the exclusive lock is held.
+        auto parts = for_each_shard(*shard_pool_, shards->size(), [&](size_t i) {
+            return ensure_open(*(*shards)[i]->slot).analyze();
+        });
+        CollectionStatistics merged = parts[0];
+        for (size_t i = 1; i < parts.size(); ++i) merged.merge(parts[i]);
+        return merged;
+    }
+    return get_collection(collection_name).analyze();
+}
+
+CollectionStatistics LSMTree::get_statistics(const std::string& collection_name) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
     try {
-        const Collection& collection = get_collection(collection_name);
-        std::vector<std::string> string_values;
-        for(const auto& v : values) {
-            string_values.push_back(TissDB::Query::value_to_string(v));
+        if (const ShardSet* shards = find_shards(collection_name)) {
+            auto parts = read_shards(*shards, [](size_t, Collection& collection) {
+                return collection.get_statistics();
+            });
+            CollectionStatistics merged = parts[0];
+            for (size_t i = 1; i < parts.size(); ++i) merged.merge(parts[i]);
+            return merged;
         }
-        return collection.find_by_index(field_names, string_values);
+        return get_collection(collection_name).get_statistics();
     } catch (const std::runtime_error& e) {
         return {};
     }
 }
 
+std::vector<std::string> LSMTree::find_by_index(const std::string& collection_name, const std::vector<std::string>& field_names, const std::vector<Value>& values) {
+    std::vector<std::string> string_values;
+    for(const auto& v : values) {
+        string_values.push_back(TissDB::Query::value_to_string(v));
+    }
+    return find_by_index(collection_name, field_names, string_values);
+}
+
 Transactions::TransactionID LSMTree::begin_transaction() {
     return transaction_manager_.begin_transaction();
 }
@@ -311,7 +887,13 @@ bool LSMTree::rollback_transaction(Transactions::TransactionID transaction_id) {
 }
 
 bool LSMTree::has_index(const std::string& collection_name, const std::vector<std::string>& field_names) {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
     try {
+        if (const ShardSet* shards = find_shards(collection_name)) {
+            // Every shard has the same indexes.
+            std::shared_lock<std::shared_mutex> shard_lock(shards->front()->mutex);
+            return shard_collection(*shards->front()).has_index(field_names);
+        }
         const Collection& collection = get_collection(collection_name);
         return collection.has_index(field_names);
     } catch (const std::runtime_error& e) {
@@ -320,7 +902,13 @@ bool LSMTree::has_index(const std::string& collection_name, const std::vector<st
 }
 
 std::vector<std::vector<std::string>> LSMTree::get_available_indexes(const std::string& collection_name) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
     try {
+        if (const ShardSet* shards = find_shards(collection_name)) {
+            // Every shard has the same indexes.
+            std::shared_lock<std::shared_mutex> shard_lock(shards->front()->mutex);
+            return shard_collection(*shards->front()).get_available_indexes();
+        }
         const Collection& collection = get_collection(collection_name);
         return collection.get_available_indexes();
     } catch (const std::runtime_error& e) {
@@ -330,36 +918,402 @@ std::vector<std::vector<std::string>> LSMTree::get_available_indexes(const std::
 
 void LSMTree::shutdown() {
     LOG_INFO("Shutting down database at: " + path_);
-    save_collections();
+    stop_compaction();
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    checkpoint_locked();
     if (wal_) {
         wal_->shutdown();
     }
+    for (auto const& [name, shards] : sharded_) {
+        for (const auto& shard : shards) shard->wal->shutdown();
+    }
     LOG_INFO("Database shutdown complete.");
 }
 
+void LSMTree::checkpoint() {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    checkpoint_locked();
+}
+
+void LSMTree::checkpoint_locked() {
+    LOG_INFO("Checkpointing database at: " + path_);
+    for (auto const& [name, slot] : collections_) {
+        // A collection that was never opened has nothing in memory.
+        if (Collection* collection = opened_collection(*slot)) {
+            collection->flush();
+        }
+    }
+    // Indexes are rebuilt from the WAL on recovery, so they must be on disk before it is truncated.
+    save_collections();
+    // Replaying the WAL re-derives the sequence numbers it covers; past it they must be stored.
+    save_sequence();
+    if (wal_) {
+        std::vector<WriteAheadLog*> wals{wal_.get()};
+        for (auto const& [name, shards] : sharded_) {
+            for (const auto& shard : shards) wals.push_back(shard->wal.get());
+        }
+        change_feed_->seal(wals);
+    }
+}
+
+BackupResult LSMTree::create_backup(const std::string& destination_root, bool flush_first) {
+    namespace fs = std::filesystem;
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    if (flush_first) {
+        checkpoint_locked();
+    } else {
+        save_collections();
+    }
+
+    BackupWriter writer(destination_root);
+    for (auto const& [name, slot] : collections_) {
+        Collection* collection = &ensure_open(*slot);
+        const fs::path collection_dir(collection->get_path());
+        std::set<std::string> sstable_files;
+        for (const auto& file : collection->get_sstable_files()) {
+            sstable_files.insert(file);
+            writer.add_immutable_file((collection_dir / file).string(), name + "/" + file);
+        }
+        // Manifest and index files. SSTables that are not in the manifest are
+        // leftovers from an interrupted flush and are skipped.
+        for (const auto& entry : fs::directory_iterator(collection_dir)) {
+            std::string file = entry.path().filename().string();
+            if (!entry.is_regular_file() || sstable_files.count(file) ||
+                file.rfind("sstable_", 0) == 0 || entry.path().extension() == ".tmp") {
+                continue;
+            }
+            writer.add_mutable_file(entry.path().string(), name + "/" + file);
+        }
+    }
+
+    for (auto const& [name, shards] : sharded_) {
+        writer.add_mutable_file((fs::path(path_) / name / SHARDS_FILE).string(), name + "/" + SHARDS_FILE);
+    }
+
+    fs::path wal_path = fs::path(path_) / "wal.log";
+    if (fs::exists(wal_path)) {
+        writer.add_mutable_file(wal_path.string(), "wal.log");
+    }
+
+    // Flushed writes are no longer in the WAL, so without the saved counter a
+    // restored database would hand out sequence numbers already seen by
+    // replicas and change feed cursors.
+    save_sequence();
+    writer.add_mutable_file((fs::path(path_) / SEQUENCE_FILE).string(), SEQUENCE_FILE);
+
+    BackupResult result = writer.finish();
+    LOG_INFO("Backup " + result.backup_id + " of " + path_ + " written to " + result.backup_path);
+    return result;
+}
+
+void LSMTree::load_sequence() {
+    std::filesystem::path sequence_path = std::filesystem::path(path_) / SEQUENCE_FILE;
+    if (!std::filesystem::exists(sequence_path)) return;
+    std::ifstream sequence_file(sequence_path);
+    std::string content((std::istreambuf_iterator<char>(sequence_file)), std::istreambuf_iterator<char>());
+    try {
+        Json::JsonValue parsed = Json::JsonValue::parse(content);
+        last_sequence_.store(static_cast<uint64_t>(parsed.as_object().at("last_sequence").as_number()));
+    } catch (const std::exception& e) {
+        LOG_ERROR("Failed to load sequence number for database at " + path_ + ": " + e.what());
+    }
+}
+
+void LSMTree::save_sequence() const {
+    Json::JsonObject sequence_obj;
+    sequence_obj["last_sequence"] = Json::JsonValue(static_cast<double>(last_sequence_.load()));
+
+    std::filesystem::path sequence_path = std::filesystem::path(path_) / SEQUENCE_FILE;
+    std::filesystem::path tmp_path = sequence_path.string() + ".tmp";
+    {
+        std::ofstream sequence_file(tmp_path, std::ios::trunc);
+        if (!sequence_file.is_open()) {
+            throw std::runtime_error("Could not open sequence file for writing: " + tmp_path.string());
+        }
+        sequence_file << Json::JsonValue(sequence_obj).serialize();
+    }
+    std::filesystem::rename(tmp_path, sequence_path);
+}
+
+uint64_t LSMTree::add_retention_hold(uint64_t sequence) {
+    std::lock_guard<std::mutex> lock(holds_mutex_);
+    uint64_t hold_id = next_hold_id_++;
+    retention_holds_[hold_id] = sequence;
+    return hold_id;
+}
+
+void LSMTree::release_retention_hold(uint64_t hold_id) {
+    std::lock_guard<std::mutex> lock(holds_mutex_);
+    retention_holds_.erase(hold_id);
+}
+
+uint64_t LSMTree::purge_horizon() const {
+    std::lock_guard<std::mutex> lock(holds_mutex_);
+    uint64_t horizon = last_sequence_.load();
+    for (const auto& [id, sequence] : retention_holds_) {
+        horizon = std::min(horizon, sequence);
+    }
+    return horizon;
+}
+
+ChangeBatch LSMTree::read_changes(uint64_t since, size_t limit, const std::string& collection_name) const {
+    return change_feed_->read(since, limit, collection_name);
+}
+
+bool LSMTree::wait_for_changes(uint64_t since, std::chrono::milliseconds timeout) const {
+    return change_feed_->wait_for(since, timeout);
+}
+
+uint64_t LSMTree::earliest_change() const {
+    return change_feed_->earliest_lsn();
+}
+
+void LSMTree::hold_changes(const std::string& consumer, uint64_t lsn) {
+    change_feed_->hold(consumer, lsn);
+}
+
+bool LSMTree::apply_change(const ChangeEvent& change) {
+    if (change.lsn <= last_sequence_.load()) {
+        return false;
+    }
+    bool known = false;
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        known = collection_exists_locked(change.collection_name);
+    }
+    if (!known) {
+        create_collection(change.collection_name, {});
+    }
+
+    Common::MemoryGovernor::instance().admit_write();
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    WriteAheadLog* wal = wal_.get();
+    Collection* target = nullptr;
+    if (ShardSet* shards = find_shards(change.collection_name)) {
+        Shard& shard = *(*shards)[shard_of(change.document_id, shards->size())];
+        wal = shard.wal.get();
+        target = &ensure_open(*shard.slot);
+    } else {
+        target = &get_collection(change.collection_name);
+    }
+    Collection& collection = *target;
+    LogEntry entry;
+    entry.type = change.type;
+    entry.collection_name = change.collection_name;
+    entry.document_id = change.document_id;
+    entry.doc = change.doc;
+    entry.lsn = change.lsn;
+    wal->append(entry);
+    if (change.type == LogEntryType::PUT) {
+        // Already stamped with its expiry by the database it came from.
+        collection.put(change.document_id, change.doc);
+    } else {
+        collection.del(change.document_id, change.lsn);
+    }
+    last_sequence_.store(change.lsn);
+    // The leader's numbering has gaps (writes that failed, other databases).
+    change_feed_->publish_through(change.lsn);
+    if (collection.is_full()) {
+        checkpoint_locked();
+    }
+    return true;
+}
+
+CompactionStats LSMTree::get_compaction_stats() const {
+    std::lock_guard<std::mutex> lock(compaction_stats_mutex_);
+    return compaction_stats_;
+}
+
+bool LSMTree::compact(const std::string& collection_name) {
+    std::shared_ptr<CollectionSlot> slot;
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        auto it = collections_.find(collection_name);
+        if (it == collections_.end()) {
+            throw std::runtime_error("Collection not found: " + collection_name);
+        }
+        ensure_open(*it->second);
+        slot = it->second;
+    }
+    return compact_slot(collection_name, slot, 1);
+}
+
+void LSMTree::compact_all() {
+    for (const auto& name : list_collections()) {
+        try {
+            compact(name);
+        } catch (const std::exception& e) {
+            LOG_ERROR("Compaction of collection " + name + " failed: " + e.what());
+        }
+    }
+}
+
+bool LSMTree::compact_slot(const std::string& name, const std::shared_ptr<CollectionSlot>& slot, size_t min_sstables) {
+    namespace fs = std::filesystem;
+    std::lock_guard<std::mutex> run_lock(compaction_run_mutex_);
+    const auto started = std::chrono::steady_clock::now();
+
+    // Flushes only append, so the inputs stay the oldest tables of the
+    // collection while the merge runs without the database lock.
+    Collection* collection = nullptr;
+    std::vector<std::shared_ptr<SSTable>> inputs;
+    std::string output_path;
+    std::string collection_name;
+    TtlPolicy ttl;
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        collection = opened_collection(*slot);
+        if (!collection) return false;
+        ttl = collection->get_ttl_policy();
+        inputs = collection->get_sstables();
+        if (inputs.empty() || inputs.size() < min_sstables) return false;
+        output_path = collection->allocate_sstable_path();
+        collection_name = collection->get_name();
+    }
+
+    CompactionOutcome outcome;
+    try {
+        outcome = compact_sstables(inputs, collection_name, output_path, purge_horizon(), ttl, now_us(), compaction_limiter_);
+    } catch (const std::exception& e) {
+        LOG_ERROR("Compaction of collection " + name + " failed: " + e.what());
+        std::error_code ec;
+        fs::remove(output_path, ec);
+        return false;
+    }
+
+    std::vector<std::string> replaced;
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        auto it = collections_.find(name);
+        if (it == collections_.end() || it->second != slot) {
+            // The collection was dropped (and its directory removed) meanwhile.
+            return false;
+        }
+        try {
+            replaced = collection->replace_oldest_sstables(inputs.size(), outcome.wrote_output ? output_path : "");
+        } catch (const std::exception& e) {
+            LOG_ERROR("Could not install compacted SSTable for collection " + name + ": " + e.what());
+            std::error_code ec;
+            fs::remove(output_path, ec);
+            return false;
+        }
+        for (const auto& [key, doc] : outcome.expired) {
+            collection->forget_expired(key, *doc);
+        }
+    }
+    // No reader can reach the old tables any more.
+    for (const auto& file : replaced) {
+        std::error_code ec;
+        fs::remove(file, ec);
+    }
+
+    const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started);
+    {
+        std::lock_guard<std::mutex> lock(compaction_stats_mutex_);
+        compaction_stats_.runs++;
+        compaction_stats_.bytes_read += outcome.bytes_read;
+        compaction_stats_.bytes_written += outcome.bytes_written;
+        compaction_stats_.tombstones_purged += outcome.tombstones_purged;
+        compaction_stats_.tombstones_retained += outcome.tombstones_retained;
+        compaction_stats_.documents_expired += outcome.expired.size();
+        compaction_stats_.sstables_removed += replaced.size();
+        compaction_stats_.last_duration_ms = static_cast<uint64_t>(elapsed.count());
+    }
+    LOG_INFO("Compacted " + std::to_string(replaced.size()) + " SSTables of collection " + name +
+             ": " + std::to_string(outcome.live_entries) + " live entries, " +
+             std::to_string(outcome.tombstones_purged) + " tombstones purged, " +
+             std::to_string(outcome.tombstones_retained) + " retained, " +
+             std::to_string(outcome.expired.size()) + " documents expired");
+    return true;
+}
+
+void LSMTree::compaction_loop() {
+    using Clock = std::chrono::steady_clock;
+    std::map<std::string, Clock::time_point> last_expiry_run;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(compaction_wake_mutex_);
+            compaction_wake_.wait_for(lock, compaction_options_.interval, [this] { return stop_compaction_; });
+            if (stop_compaction_) return;
+        }
+
+        // Collection, and the SSTable count that makes it worth compacting.
+        std::vector<std::tuple<std::string, std::shared_ptr<CollectionSlot>, size_t>> candidates;
+        const auto now = Clock::now();
+        {
+            std::shared_lock<std::shared_mutex> lock(mutex_);
+            for (auto const& [name, slot] : collections_) {
+                // Collections nobody has opened yet are left alone.
+                Collection* collection = opened_collection(*slot);
+                if (!collection) continue;
+                const size_t sstable_count = collection->get_sstables().size();
+                if (sstable_count >= compaction_options_.min_sstables) {
+                    candidates.emplace_back(name, slot, compaction_options_.min_sstables);
+                } else if (sstable_count > 0 && collection->get_ttl_policy().enabled()) {
+                    auto last = last_expiry_run.find(name);
+                    if (last == last_expiry_run.end()) {
+                        last_expiry_run[name] = now; // Start the clock when first seen
+                    } else if (now - last->second >= compaction_options_.expiry_interval) {
+                        last->second = now;
+                        candidates.emplace_back(name, slot, 1);
+                    }
+                }
+            }
+        }
+        for (const auto& [name, slot, min_sstables] : candidates) {
+            {
+                std::lock_guard<std::mutex> lock(compaction_wake_mutex_);
+                if (stop_compaction_) return;
+            }
+            compact_slot(name, slot, min_sstables);
+        }
+    }
+}
+
+void LSMTree::stop_compaction() {
+    {
+        std::lock_guard<std::mutex> lock(compaction_wake_mutex_);
+        stop_compaction_ = true;
+    }
+    compaction_wake_.notify_all();
+    if (compaction_thread_.joinable()) {
+        compaction_thread_.join();
+    }
+}
+
 void LSMTree::load_collections() {
     namespace fs = std::filesystem;
     if (!fs::exists(path_) || !fs::is_directory(path_)) {
         return;
     }
     for (const auto& entry : fs::directory_iterator(path_)) {
-        if (entry.is_directory()) {
+        if (entry.is_directory() && entry.path().filename() != WAL_ARCHIVE_DIR) {
             std::string collection_name = entry.path().filename().string();
+            if (sharded_.count(collection_name)) continue;
+            if (auto shard_count = read_shard_count(entry.path().string())) {
+                LOG_DEBUG("Discovered collection: " + collection_name + " (" + std::to_string(*shard_count) + " shards)");
+                register_shards(collection_name, *shard_count);
+                continue;
+            }
             if (collections_.find(collection_name) == collections_.end()) {
-                LOG_INFO("Discovered and loading collection: " + collection_name);
-                std::string collection_path = entry.path().string();
-                collections_[collection_name] = std::make_unique<Collection>(collection_path, this);
+                LOG_DEBUG("Discovered collection: " + collection_name);
+                auto slot = std::make_shared<CollectionSlot>();
+                slot->path = entry.path().string();
+                collections_[collection_name] = std::move(slot);
             }
         }
     }
 }
 
 void LSMTree::save_collections() {
-    LOG_INFO("Saving all collection indexes...");
-    for (auto const& [name, collection] : collections_) {
-        collection->save_indexes();
+    LOG_INFO("Saving all collection indexes and statistics...");
+    for (auto const& [name, slot] : collections_) {
+        if (Collection* collection = opened_collection(*slot)) {
+            collection->save_indexes();
+            collection->save_statistics();
+        }
     }
-    LOG_INFO("Finished saving all collection indexes.");
+    LOG_INFO("Finished saving all collection indexes and statistics.");
 }
 
 } // namespace Storage
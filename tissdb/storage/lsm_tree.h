@@ -5,38 +5,102 @@
 #include <map>
 #include <optional>
 #include <vector>
+#include <shared_mutex>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <future>
+#include <mutex>
+#include <thread>
 
+#include "backup.h"
+#include "change_feed.h"
 #include "collection.h"
+#include "compaction.h"
+#include "sharding.h"
 #include "transaction_manager.h"
+#include "../common/memory_governor.h"
 #include "../common/schema.h"
+#include "../common/thread_pool.h"
 
 namespace TissDB {
 namespace Storage {
 
 class WriteAheadLog; // Forward declaration
 
+// Load state of a collection. Collections found on disk start Unloaded and are
+// opened on first access or by a background task on the loader pool.
+enum class CollectionLoadState {
+    Unloaded,
+    Loading,
+    Ready,
+    Failed
+};
+
+const char* to_string(CollectionLoadState state);
+
 // LSMTree acts as the main database interface, managing all collections.
-// In this simplified, in-memory version, it holds collections in a map.
+// Writes go to the WAL and the collection's in-memory table; a checkpoint
+// flushes every collection to SSTables and seals the WAL into the archive the
+// change feed reads from.
+//
+// Every write is assigned the next database sequence number. Deletes leave
+// tombstones tagged with theirs; compaction merges a collection's SSTables and
+// drops the tombstones that no retention hold (a snapshot or replication
+// consumer that has not yet seen them) still needs.
+//
+// A sharded collection spreads its documents over several shards by key
+// hash. Each shard is a collection of its own with its own WAL and lock, so
+// writes to different shards proceed in parallel; scans, index lookups and
+// statistics run on every shard at once and are merged.
 class LSMTree {
 public:
     LSMTree(); // Simplified constructor
-    LSMTree(const std::string& path);
+    // If `loader_pool` is given, collections found on disk are opened (and
+    // their indexes loaded) in the background on that pool. Either way, a
+    // collection is opened synchronously on first access if it is not ready yet.
+    LSMTree(const std::string& path, Common::ThreadPool* loader_pool = nullptr,
+            const CompactionOptions& compaction_options = CompactionOptions(),
+            const ChangeFeedOptions& change_feed_options = ChangeFeedOptions());
     ~LSMTree();
 
 
     // Collection management
     virtual void create_collection(const std::string& name, const TissDB::Schema& schema, bool is_recovery = false);
+    // Creates a collection hash-partitioned over `shard_count` shards (1..MAX_SHARDS).
+    void create_sharded_collection(const std::string& name, const TissDB::Schema& schema, size_t shard_count);
+    // Number of shards of a collection; 1 if it is not sharded.
+    size_t shard_count(const std::string& name) const;
     virtual void delete_collection(const std::string& name);
     virtual std::vector<std::string> list_collections() const;
 
     // Document operations (delegated to specific collection)
     virtual void put(const std::string& collection_name, const std::string& key, const Document& doc, Transactions::TransactionID tid = -1, bool is_recovery = false);
     virtual std::optional<std::shared_ptr<Document>> get(const std::string& collection_name, const std::string& key, Transactions::TransactionID tid = -1);
+    // Batched lookup: live documents for `keys`, in their order; see Collection::multi_get.
     virtual std::vector<Document> get_many(const std::string& collection_name, const std::vector<std::string>& keys);
     virtual bool del(const std::string& collection_name, const std::string& key, Transactions::TransactionID tid = -1, bool is_recovery = false);
+    // Batched writes of many documents of one collection, keyed by their ids,
+    // as UPDATE and DELETE make them. The WAL records go out in one write and
+    // flush per collection or shard, under one lock acquisition. A delete
+    // returns how many keys existed.
+    virtual void put_many(const std::string& collection_name, std::vector<Document> docs);
+    virtual size_t del_many(const std::string& collection_name, const std::vector<std::string>& keys);
     virtual std::vector<Document> scan(const std::string& collection_name);
+    // The same documents, shared with the collection rather than copied; see
+    // Collection::scan_shared.
+    virtual std::vector<std::shared_ptr<const Document>> scan_shared(const std::string& collection_name);
     virtual void create_index(const std::string& collection_name, const std::vector<std::string>& field_names, bool is_unique = false);
 
+    // Expiry policy of a collection; see TtlPolicy.
+    void set_ttl_policy(const std::string& collection_name, const TtlPolicy& policy);
+    TtlPolicy get_ttl_policy(const std::string& collection_name) const;
+
+    // Rebuilds the planner statistics of a collection from its documents.
+    CollectionStatistics analyze(const std::string& collection_name);
+    // Current planner statistics of a collection (a copy); empty if it does not exist.
+    CollectionStatistics get_statistics(const std::string& collection_name) const;
+
     virtual std::vector<std::string> find_by_index(const std::string& collection_name, const std::string& field_name, const std::string& value);
     virtual std::vector<std::string> find_by_index(const std::string& collection_name, const std::vector<std::string>& field_names, const std::vector<std::string>& values);
     virtual std::vector<std::string> find_by_index(const std::string& collection_name, const std::vector<std::string>& field_names, const std::vector<Value>& values);
@@ -46,24 +110,154 @@ public:
     bool commit_transaction(Transactions::TransactionID transaction_id);
     bool rollback_transaction(Transactions::TransactionID transaction_id);
 
-    // Helper to get a collection, throws if not found
+    // Helper to get a collection, throws if not found. Sharded collections
+    // are only reachable through the document operations above.
     Collection& get_collection(const std::string& name);
     const Collection& get_collection(const std::string& name) const;
     const std::string& get_path() const;
 
+    // Load state of every known collection, for readiness reporting.
+    std::map<std::string, CollectionLoadState> get_collection_states() const;
+
     bool has_index(const std::string& collection_name, const std::vector<std::string>& field_names);
     std::vector<std::vector<std::string>> get_available_indexes(const std::string& collection_name) const;
     void shutdown();
 
+    // Flushes every collection to SSTables, saves indexes and seals the WAL.
+    // Also triggered automatically when a collection's in-memory table fills up.
+    void checkpoint();
+
+    // Takes an online backup into a new directory under `destination_root`.
+    // Writes are blocked while the live SSTables are hard-linked and the WAL
+    // (everything since the last checkpoint) is copied. With `flush_first`, a
+    // checkpoint is taken first so the copied WAL tail is empty.
+    BackupResult create_backup(const std::string& destination_root, bool flush_first = false);
+
+    // Sequence number of the most recent write.
+    uint64_t last_sequence() const { return last_sequence_.load(); }
+
+    // Changes whenever a collection or index is created or dropped, or
+    // statistics are rebuilt: plans made under an older version are stale.
+    uint64_t catalog_version() const { return catalog_version_.load(); }
+
+    // Compacts one collection now, regardless of its SSTable count. Returns
+    // false if there was nothing to compact.
+    bool compact(const std::string& collection_name);
+    void compact_all();
+
+    // Keeps tombstones with a sequence number above `sequence` until the hold
+    // is released. Returns the hold's id.
+    uint64_t add_retention_hold(uint64_t sequence);
+    void release_retention_hold(uint64_t hold_id);
+
+    CompactionStats get_compaction_stats() const;
+
+    // Change data capture: committed puts and deletes after sequence number
+    // `since`, in order. Reading does not take the database lock.
+    ChangeBatch read_changes(uint64_t since, size_t limit, const std::string& collection_name = "") const;
+    // Blocks until a write after `since` is committed or `timeout` elapses.
+    bool wait_for_changes(uint64_t since, std::chrono::milliseconds timeout) const;
+    // Oldest sequence number the change feed can still return.
+    uint64_t earliest_change() const;
+    // Keeps the changes after `lsn` for a named consumer; see ChangeFeed::hold.
+    void hold_changes(const std::string& consumer, uint64_t lsn);
+
+    // Applies a change read from another database's feed under its original
+    // sequence number, creating the collection if needed. Changes at or below
+    // last_sequence() were applied before and are skipped; returns false then.
+    bool apply_change(const ChangeEvent& change);
+
 private:
+    // A collection known to the database, opened at most once.
+    struct CollectionSlot {
+        std::string path;
+        std::once_flag open_once;
+        std::unique_ptr<Collection> collection;
+        std::atomic<CollectionLoadState> state{CollectionLoadState::Unloaded};
+    };
+
+    // One partition of a sharded collection. Its collection is also in
+    // collections_, as "<name>/shard_<i>", so checkpoints, compaction and
+    // backups cover it. Writes take `mutex` exclusively and mutex_ shared.
+    struct Shard {
+        std::shared_ptr<CollectionSlot> slot;
+        std::unique_ptr<WriteAheadLog> wal;
+        mutable std::shared_mutex mutex;
+    };
+    using ShardSet = std::vector<std::unique_ptr<Shard>>;
+
+    Collection& ensure_open(CollectionSlot& slot);
+    // Returns the collection only if it has already been opened.
+    Collection* opened_collection(const CollectionSlot& slot) const;
+
+    // Caller holds mutex_.
+    bool collection_exists_locked(const std::string& name) const;
+    ShardSet* find_shards(const std::string& name);
+    const ShardSet* find_shards(const std::string& name) const;
+    // Registers the shards of a sharded collection whose directory exists.
+    // Caller holds mutex_ exclusively (or is the constructor).
+    void register_shards(const std::string& name, size_t shard_count);
+    void recover_shards();
+    // Opens a shard's collection if needed. Caller holds the shard's lock.
+    Collection& shard_collection(const Shard& shard) const;
+    // Runs `read(shard_index, collection)` on every shard in parallel, each
+    // under its shard's shared lock. Caller holds mutex_ shared.
+    template <typename F>
+    auto read_shards(const ShardSet& shards, F read) const;
+    // Logs and applies a put or delete to the shard holding the entry's key,
+    // under a new sequence number. `lock` holds mutex_ shared; it is released
+    // before a checkpoint if the shard's memtable filled up.
+    bool write_to_shard(std::shared_lock<std::shared_mutex>& lock, ShardSet& shards, LogEntry& entry, bool is_recovery);
+    // Logs `entries` (puts and deletes of one collection) as one group and
+    // applies them; returns the deletes that found their key.
+    size_t write_many(const std::string& collection_name, std::vector<LogEntry> entries);
+    // Numbers, logs and applies a group of entries of one collection. Caller
+    // holds the lock writes to `collection` take.
+    size_t log_and_apply(Collection& collection, WriteAheadLog& wal, std::vector<LogEntry>& entries);
+
+    void checkpoint_locked();
+    // Bytes held in the memtables of opened collections. Caller holds mutex_.
+    size_t memtable_bytes_locked() const;
+    void load_sequence();
+    void save_sequence() const;
+    bool compact_slot(const std::string& name, const std::shared_ptr<CollectionSlot>& slot, size_t min_sstables);
+    uint64_t purge_horizon() const;
+    void compaction_loop();
+    void stop_compaction();
     void load_collections();
     void save_collections();
     void recover();
 
-    std::map<std::string, std::unique_ptr<Collection>> collections_;
+    std::map<std::string, std::shared_ptr<CollectionSlot>> collections_;
+    std::map<std::string, ShardSet> sharded_;
+    // Runs the per-shard work of reads on sharded collections; created with the first one.
+    std::unique_ptr<Common::ThreadPool> shard_pool_;
+    std::vector<std::future<void>> background_loads_;
     std::string path_;
     Transactions::TransactionManager transaction_manager_;
     std::unique_ptr<WriteAheadLog> wal_;
+    std::unique_ptr<ChangeFeed> change_feed_;
+    // Writers (and checkpoints) take this exclusively, readers shared.
+    mutable std::shared_mutex mutex_;
+    // Last sequence number handed out. Taken under the exclusive lock, or by
+    // shard writers under the shared lock and their shard's.
+    std::atomic<uint64_t> last_sequence_{0};
+    std::atomic<uint64_t> catalog_version_{0};
+
+    CompactionOptions compaction_options_;
+    Common::RateLimiter compaction_limiter_;
+    std::mutex compaction_run_mutex_; // One compaction at a time
+    mutable std::mutex compaction_stats_mutex_;
+    CompactionStats compaction_stats_;
+    mutable std::mutex holds_mutex_;
+    std::map<uint64_t, uint64_t> retention_holds_; // Hold id -> sequence
+    uint64_t next_hold_id_ = 1;
+    std::thread compaction_thread_;
+    std::mutex compaction_wake_mutex_;
+    std::condition_variable compaction_wake_;
+    bool stop_compaction_ = false;
+
+    uint64_t memory_reclaimer_id_ = 0;
 };
 
 } // namespace Storage
@@ -37,12 +37,22 @@ void BTree<Key, Value, Order>::insert_non_full(BTreeNode* node, const Key& key,
     auto it = std::lower_bound(node->keys.begin(), node->keys.end(), key);
     int i = std::distance(node->keys.begin(), it);
 
+    // Keys are unique: inserting an existing key replaces its value.
+    if (it != node->keys.end() && *it == key) {
+        node->values[i] = value;
+        return;
+    }
+
     if (node->is_leaf) {
         node->keys.insert(it, key);
         node->values.insert(node->values.begin() + i, value);
     } else {
         if (node->children[i]->keys.size() == 2 * Order - 1) {
             split_child(node, i);
+            if (node->keys[i] == key) {
+                node->values[i] = value;
+                return;
+            }
             if (key > node->keys[i]) {
                 i++;
             }
@@ -56,26 +66,20 @@ void BTree<Key, Value, Order>::split_child(BTreeNode* parent, int index) {
     BTreeNode* child = parent->children[index].get();
     auto new_child = std::make_unique<BTreeNode>(child->is_leaf);
 
+    // Every node stores a value per key, so the median's value moves up with it.
     parent->keys.insert(parent->keys.begin() + index, child->keys[Order - 1]);
-    // For non-leaf nodes, there is no value, just keys for routing
-    if (child->is_leaf) {
-        parent->values.insert(parent->values.begin() + index, child->values[Order - 1]);
-    }
+    parent->values.insert(parent->values.begin() + index, child->values[Order - 1]);
 
     new_child->keys.assign(
         std::make_move_iterator(child->keys.begin() + Order),
         std::make_move_iterator(child->keys.end())
     );
-    if (child->is_leaf) {
-        new_child->values.assign(
-            std::make_move_iterator(child->values.begin() + Order),
-            std::make_move_iterator(child->values.end())
-        );
-    }
+    new_child->values.assign(
+        std::make_move_iterator(child->values.begin() + Order),
+        std::make_move_iterator(child->values.end())
+    );
     child->keys.resize(Order - 1);
-    if (child->is_leaf) {
-        child->values.resize(Order - 1);
-    }
+    child->values.resize(Order - 1);
 
     if (!child->is_leaf) {
         new_child->children.assign(
@@ -104,12 +108,7 @@ std::optional<Value> BTree<Key, Value, Order>::find_recursive(BTreeNode* node, c
         if (node->is_leaf) {
             return node->values[i];
         }
-        // In a B-Tree, the value is in the leaf. In a B+ tree, it could be here.
-        // This implementation stores values only in leaves.
-        // To find the actual value, we need to traverse to the leaf.
-        // For simplicity here, we assume if key is in internal node, we traverse left.
-        // A more correct B-Tree would only store values in leaves.
-        // Let's adjust the logic to be a proper B-Tree where keys can exist in internal nodes.
+        // Internal nodes hold values too (the key was promoted by a split).
         return node->values[i];
     }
 
@@ -177,14 +176,13 @@ void BTree<Key, Value, Order>::remove_from_non_leaf(BTreeNode* node, int index)
 
     if (node->children[index]->keys.size() >= Order) {
         Key pred_key = get_predecessor(node, index);
+        node->values[index] = *find_recursive(node->children[index].get(), pred_key);
         node->keys[index] = pred_key;
-        // The value should also be updated if we store values in internal nodes
-        // node->values[index] = pred_value;
         erase_recursive(node->children[index].get(), pred_key);
     } else if (node->children[index + 1]->keys.size() >= Order) {
         Key succ_key = get_successor(node, index);
+        node->values[index] = *find_recursive(node->children[index + 1].get(), succ_key);
         node->keys[index] = succ_key;
-        // node->values[index] = succ_value;
         erase_recursive(node->children[index + 1].get(), succ_key);
     } else {
         merge(node, index);
@@ -231,17 +229,11 @@ void BTree<Key, Value, Order>::borrow_from_prev(BTreeNode* node, int index) {
     BTreeNode* sibling = node->children[index - 1].get();
 
     child->keys.insert(child->keys.begin(), node->keys[index - 1]);
-    if (child->is_leaf) {
-        child->values.insert(child->values.begin(), node->values[index - 1]);
-    }
+    child->values.insert(child->values.begin(), node->values[index - 1]);
     node->keys[index - 1] = sibling->keys.back();
-    if (child->is_leaf) {
-        node->values[index - 1] = sibling->values.back();
-    }
+    node->values[index - 1] = sibling->values.back();
     sibling->keys.pop_back();
-    if (child->is_leaf) {
-        sibling->values.pop_back();
-    }
+    sibling->values.pop_back();
 
     if (!child->is_leaf) {
         child->children.insert(child->children.begin(), std::move(sibling->children.back()));
@@ -255,18 +247,12 @@ void BTree<Key, Value, Order>::borrow_from_next(BTreeNode* node, int index) {
     BTreeNode* sibling = node->children[index + 1].get();
 
     child->keys.push_back(node->keys[index]);
-    if (child->is_leaf) {
-        child->values.push_back(node->values[index]);
-    }
+    child->values.push_back(node->values[index]);
     node->keys[index] = sibling->keys.front();
-    if (child->is_leaf) {
-        node->values[index] = sibling->values.front();
-    }
+    node->values[index] = sibling->values.front();
 
     sibling->keys.erase(sibling->keys.begin());
-    if (child->is_leaf) {
-        sibling->values.erase(sibling->values.begin());
-    }
+    sibling->values.erase(sibling->values.begin());
 
     if (!child->is_leaf) {
         child->children.push_back(std::move(sibling->children.front()));
@@ -279,16 +265,13 @@ void BTree<Key, Value, Order>::merge(BTreeNode* node, int index) {
     BTreeNode* child = node->children[index].get();
     BTreeNode* sibling = node->children[index + 1].get();
 
+    // The separating key moves down from the parent, together with its value.
     child->keys.push_back(node->keys[index]);
-    // In a B-Tree, the median key from the parent moves down.
-    // If we store values in internal nodes, we'd move the value too.
-    // child->values.push_back(node->values[index]);
+    child->values.push_back(node->values[index]);
 
     for (size_t i = 0; i < sibling->keys.size(); ++i) {
         child->keys.push_back(sibling->keys[i]);
-        if (child->is_leaf) {
-             child->values.push_back(sibling->values[i]);
-        }
+        child->values.push_back(sibling->values[i]);
     }
 
     if (!child->is_leaf) {
@@ -298,9 +281,7 @@ void BTree<Key, Value, Order>::merge(BTreeNode* node, int index) {
     }
 
     node->keys.erase(node->keys.begin() + index);
-    if (child->is_leaf) {
-        node->values.erase(node->values.begin() + index);
-    }
+    node->values.erase(node->values.begin() + index);
     node->children.erase(node->children.begin() + index + 1);
 }
 
@@ -81,6 +81,9 @@ private:
         } else {
             for (size_t i = 0; i < node->children.size(); ++i) {
                 foreach_recursive(node->children[i].get(), func);
+                if (i < node->keys.size()) {
+                    func(node->keys[i], node->values[i]);
+                }
             }
         }
     }
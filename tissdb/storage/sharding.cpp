@@ -0,0 +1,60 @@
+#include "sharding.h"
+#include "../json/json.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+namespace TissDB {
+namespace Storage {
+
+size_t shard_of(const std::string& key, size_t shard_count) {
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : key) {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    return shard_count > 0 ? static_cast<size_t>(hash % shard_count) : 0;
+}
+
+std::string shard_collection_name(const std::string& collection_name, size_t index) {
+    return collection_name + "/shard_" + std::to_string(index);
+}
+
+bool is_shard_collection_name(const std::string& name) {
+    return name.find('/') != std::string::npos;
+}
+
+std::optional<size_t> read_shard_count(const std::string& collection_dir) {
+    std::filesystem::path shards_path = std::filesystem::path(collection_dir) / SHARDS_FILE;
+    if (!std::filesystem::exists(shards_path)) return std::nullopt;
+    std::ifstream shards_file(shards_path);
+    std::string content((std::istreambuf_iterator<char>(shards_file)), std::istreambuf_iterator<char>());
+    Json::JsonValue parsed = Json::JsonValue::parse(content);
+    double count = parsed.as_object().at("shards").as_number();
+    if (count < 1 || count > MAX_SHARDS) {
+        throw std::runtime_error("Invalid shard count in " + shards_path.string());
+    }
+    return static_cast<size_t>(count);
+}
+
+void write_shard_count(const std::string& collection_dir, size_t shard_count) {
+    Json::JsonObject shards_obj;
+    shards_obj["shards"] = Json::JsonValue(static_cast<double>(shard_count));
+
+    std::filesystem::path shards_path = std::filesystem::path(collection_dir) / SHARDS_FILE;
+    std::filesystem::path tmp_path = shards_path.string() + ".tmp";
+    {
+        std::ofstream shards_file(tmp_path, std::ios::trunc);
+        if (!shards_file.is_open()) {
+            throw std::runtime_error("Could not open shard file for writing: " + tmp_path.string());
+        }
+        shards_file << Json::JsonValue(shards_obj).serialize();
+    }
+    std::filesystem::rename(tmp_path, shards_path);
+}
+
+} // namespace Storage
+} // namespace TissDB
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <exception>
+#include <future>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "../common/thread_pool.h"
+
+namespace TissDB {
+namespace Storage {
+
+// A sharded collection `<name>` is hash-partitioned by key. On disk it is
+// `<db>/<name>/shards.json`, recording the shard count, and one directory per
+// shard, `<db>/<name>/shard_<i>`, each an ordinary collection directory plus
+// the shard's own WAL.
+constexpr const char* SHARDS_FILE = "shards.json";
+constexpr size_t MAX_SHARDS = 256;
+
+// Shard holding `key`. The hash (FNV-1a) is fixed, so keys stay on their
+// shard across restarts and builds.
+size_t shard_of(const std::string& key, size_t shard_count);
+
+// Name a shard's collection is registered under in the database,
+// "<collection_name>/shard_<index>". Collection names cannot contain '/'.
+std::string shard_collection_name(const std::string& collection_name, size_t index);
+bool is_shard_collection_name(const std::string& name);
+
+// Shard count recorded in `collection_dir`; nullopt if it is not sharded.
+std::optional<size_t> read_shard_count(const std::string& collection_dir);
+void write_shard_count(const std::string& collection_dir, size_t shard_count);
+
+// Runs `task(i)` for every shard, the first in the calling thread and the rest
+// on `pool`, and returns the results in shard order. The first exception
+// thrown by a task is rethrown once all of them have finished.
+template <typename F>
+auto for_each_shard(Common::ThreadPool& pool, size_t shard_count, F task)
+    -> std::vector<std::invoke_result_t<F&, size_t>> {
+    using Result = std::invoke_result_t<F&, size_t>;
+    std::vector<std::future<Result>> pending;
+    pending.reserve(shard_count > 0 ? shard_count - 1 : 0);
+    for (size_t i = 1; i < shard_count; ++i) {
+        pending.push_back(pool.submit([&task, i] { return task(i); }));
+    }
+
+    std::vector<Result> results;
+    results.reserve(shard_count);
+    std::exception_ptr error;
+    if (shard_count > 0) {
+        try {
+            results.push_back(task(0));
+        } catch (...) {
+            error = std::current_exception();
+        }
+    }
+    for (auto& result : pending) {
+        try {
+            results.push_back(result.get());
+        } catch (...) {
+            if (!error) error = std::current_exception();
+        }
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    return results;
+}
+
+} // namespace Storage
+} // namespace TissDB
@@ -2,7 +2,11 @@
 #include "../common/serialization.h"
 #include "../common/binary_stream_buffer.h"
 #include "../common/checksum.h"
+#include "../common/memory_governor.h"
+#include "../common/metrics.h"
+#include "../common/log.h"
 #include "../crypto/kms.h"
+#include <algorithm>
 #include <iostream>
 #include <chrono>
 #include <map>
@@ -27,22 +31,91 @@ TissDB::Crypto::KeyManagementSystem& get_kms_instance() {
 } // anonymous namespace
 
 const int SSTABLE_INDEX_INTERVAL = 16; // Sample every 16th key for the sparse index
+// find_many() reads blocks this close together in one read rather than seeking.
+constexpr uint64_t SSTABLE_COALESCE_GAP_BYTES = 16 * 1024;
+
+// Footer layouts:
+//   legacy: [crc32(data+index) u32][index_offset u64]
+//   v2+:    [crc32c(data+index) u32][index_offset u64][version u32][magic u32]
+// Since v3 a tombstone record is followed by the sequence number of the delete.
+// Since v4 values are encrypted with the DEK of the owning collection; older
+// tables all used the one under LEGACY_DEK_NAME.
+constexpr uint32_t SSTABLE_MAGIC = 0x54535354; // "TSST"
+constexpr uint32_t SSTABLE_FORMAT_VERSION = 4;
+constexpr uint32_t SSTABLE_MIN_FORMAT_VERSION = 2;
+constexpr std::streamoff LEGACY_FOOTER_SIZE = sizeof(uint32_t) + sizeof(uint64_t);
+constexpr std::streamoff FOOTER_SIZE = LEGACY_FOOTER_SIZE + 2 * sizeof(uint32_t);
+const char* const LEGACY_DEK_NAME = "default_collection";
+
+namespace {
+// Writes the data and index blocks followed by the current-format footer.
+void write_sstable_file(const std::string& file_path, const std::string& body, uint64_t index_start_offset) {
+    uint32_t checksum = Common::crc32c(body.data(), body.size());
+
+    std::ofstream sst_file(file_path, std::ios::binary | std::ios::trunc);
+    if (!sst_file.is_open()) {
+        throw std::runtime_error("Failed to create SSTable file: " + file_path);
+    }
+
+    sst_file.write(body.data(), body.size());
+    BinaryStreamBuffer file_bsb(sst_file);
+    file_bsb.write(checksum);
+    file_bsb.write(index_start_offset);
+    file_bsb.write(SSTABLE_FORMAT_VERSION);
+    file_bsb.write(SSTABLE_MAGIC);
+    sst_file.close();
+}
+struct ProbeMetrics {
+    Common::Histogram& latency;
+    Common::Counter& hits;   // The key was in the table, as a value or a tombstone
+    Common::Counter& misses;
+};
+
+ProbeMetrics& probe_metrics() {
+    static const char* const PROBES_HELP = "Per-SSTable key lookups by whether the table held the key.";
+    static ProbeMetrics metrics{
+        Common::Metrics::instance().histogram("tissdb_sstable_probe_seconds", "Time to look up one key in one SSTable."),
+        Common::Metrics::instance().counter("tissdb_sstable_probes_total", PROBES_HELP, "result=\"hit\""),
+        Common::Metrics::instance().counter("tissdb_sstable_probes_total", PROBES_HELP, "result=\"miss\""),
+    };
+    return metrics;
+}
+} // anonymous namespace
 
 // --- SSTable Public Methods ---
 
-SSTable::SSTable(const std::string& path) : file_path_(path) {
+SSTable::SSTable(const std::string& path, const std::string& collection_name)
+    : file_path_(path),
+      dek_(get_kms_instance().get_dek_handle(collection_name)) {
     file_stream_.open(file_path_, std::ios::binary);
     if (file_stream_.is_open()) {
         try {
             load_index();
         } catch (const std::runtime_error& e) {
-            std::cerr << "Failed to load SSTable " << path << ": " << e.what() << std::endl;
+            LOG_ERROR("Failed to load SSTable " << path << ": " << e.what());
             file_stream_.close(); // Invalidate the SSTable
         }
     }
+    for (const auto& entry : sparse_index_) {
+        index_memory_bytes_ += entry.first.size() + sizeof(uint64_t) + sizeof(std::string);
+    }
+    Common::MemoryGovernor::instance().adjust(Common::MemorySubsystem::SSTable, static_cast<int64_t>(index_memory_bytes_));
+}
+
+SSTable::~SSTable() {
+    Common::MemoryGovernor::instance().adjust(Common::MemorySubsystem::SSTable, -static_cast<int64_t>(index_memory_bytes_));
 }
 
 std::optional<std::vector<uint8_t>> SSTable::find(const std::string& key) {
+    ProbeMetrics& metrics = probe_metrics();
+    Common::ScopedTimer timer(metrics.latency);
+    auto found = probe(key);
+    (found ? metrics.hits : metrics.misses).add();
+    return found;
+}
+
+std::optional<std::vector<uint8_t>> SSTable::probe(const std::string& key) {
+    std::lock_guard<std::mutex> lock(stream_mutex_);
     if (!file_stream_.is_open() || sparse_index_.empty()) {
         return std::nullopt;
     }
@@ -58,7 +131,7 @@ std::optional<std::vector<uint8_t>> SSTable::find(const std::string& key) {
     file_stream_.seekg(start_offset);
     BinaryStreamBuffer bsb(file_stream_);
 
-    while (file_stream_.peek() != EOF) {
+    while (static_cast<uint64_t>(file_stream_.tellg()) < data_end_offset_) {
         try {
             // Check if we've scanned past the next indexed key. If so, the key is not in this block.
             if (it != sparse_index_.end() && static_cast<uint64_t>(file_stream_.tellg()) >= it->second) {
@@ -74,14 +147,9 @@ std::optional<std::vector<uint8_t>> SSTable::find(const std::string& key) {
                 if (val_len_marker == static_cast<size_t>(-1)) { // Tombstone marker
                     return std::vector<uint8_t>();
                 }
-                auto encrypted_bytes = bsb.read_bytes_with_length(val_len_marker);
-                // TODO: The collection name should be passed in, not hardcoded.
-                auto dek = get_kms_instance().get_dek("default_collection");
-                auto decrypted_bytes = get_kms_instance().decrypt(encrypted_bytes, dek);
-                if (decrypted_bytes.empty() && !encrypted_bytes.empty()) {
-                    throw std::runtime_error("Decryption failed (tampering suspected).");
-                }
-                return decrypted_bytes;
+                auto value_bytes = bsb.read_bytes_with_length(val_len_marker);
+                Crypto::KeyManagementSystem::apply_keystream(value_bytes.data(), value_bytes.size(), *dek_);
+                return value_bytes;
             } else if (current_key > key) {
                 // We've scanned past where the key should be, so it doesn't exist.
                 return std::nullopt;
@@ -90,6 +158,8 @@ std::optional<std::vector<uint8_t>> SSTable::find(const std::string& key) {
             // Key doesn't match, skip value bytes to get to the next entry.
             if (val_len_marker != static_cast<size_t>(-1)) {
                 file_stream_.seekg(val_len_marker, std::ios_base::cur);
+            } else if (has_tombstone_seq_) {
+                file_stream_.seekg(sizeof(uint64_t), std::ios_base::cur);
             }
         } catch (const std::ios_base::failure& e) {
             // This can happen if we read past the end of the file, which is a normal way to end the search.
@@ -99,59 +169,187 @@ std::optional<std::vector<uint8_t>> SSTable::find(const std::string& key) {
     return std::nullopt; // Key not found
 }
 
-std::vector<Document> SSTable::scan() {
-    std::vector<Document> documents;
+std::vector<std::optional<std::vector<uint8_t>>> SSTable::find_many(const std::vector<std::string>& keys) {
+    std::vector<std::optional<std::vector<uint8_t>>> results(keys.size());
+    std::lock_guard<std::mutex> lock(stream_mutex_);
+    if (!file_stream_.is_open() || sparse_index_.empty() || keys.empty()) {
+        return results;
+    }
+
+    // Group the keys by the block (span between sparse index entries) that
+    // can hold them, and merge nearby blocks into one byte range.
+    struct ReadRange {
+        uint64_t begin;
+        uint64_t end;
+        size_t first_key; // keys[first_key, last_key) fall in this range
+        size_t last_key;
+    };
+    std::vector<ReadRange> ranges;
+    size_t k = 0;
+    while (k < keys.size()) {
+        auto next_block = sparse_index_.upper_bound(keys[k]);
+        if (next_block == sparse_index_.begin()) {
+            ++k; // Sorts before the first key in the table
+            continue;
+        }
+        const uint64_t begin = std::prev(next_block)->second;
+        const uint64_t end = next_block == sparse_index_.end() ? data_end_offset_ : next_block->second;
+        const size_t first = k;
+        while (k < keys.size() && (next_block == sparse_index_.end() || keys[k] < next_block->first)) {
+            ++k;
+        }
+        if (!ranges.empty() && begin - ranges.back().end <= SSTABLE_COALESCE_GAP_BYTES) {
+            ranges.back().end = end;
+            ranges.back().last_key = k;
+        } else {
+            ranges.push_back({begin, end, first, k});
+        }
+    }
+
+    std::vector<Crypto::Buffer> values;
+    std::vector<size_t> value_slots;
+    for (const auto& range : ranges) {
+        std::string block(range.end - range.begin, '\0');
+        file_stream_.clear();
+        file_stream_.seekg(range.begin);
+        if (!file_stream_.read(&block[0], block.size())) {
+            LOG_EVERY_N_SEC(LogLevel::ERROR, 10, "Short read from SSTable " << file_path_);
+            break;
+        }
+
+        std::istringstream block_stream(std::move(block));
+        BinaryStreamBuffer bsb(block_stream);
+        const auto block_size = static_cast<std::streamoff>(range.end - range.begin);
+        size_t next = range.first_key;
+        try {
+            while (next < range.last_key && block_stream.tellg() < block_size) {
+                std::string current_key = bsb.read_string();
+                size_t val_len_marker;
+                bsb.read(val_len_marker);
+                while (next < range.last_key && keys[next] < current_key) {
+                    ++next; // Not in the table
+                }
+                const bool wanted = next < range.last_key && keys[next] == current_key;
+
+                if (val_len_marker == static_cast<size_t>(-1)) { // Tombstone
+                    if (wanted) results[next++] = std::vector<uint8_t>();
+                    if (has_tombstone_seq_) block_stream.seekg(sizeof(uint64_t), std::ios_base::cur);
+                } else if (wanted) {
+                    values.push_back(bsb.read_bytes_with_length(val_len_marker));
+                    value_slots.push_back(next++);
+                } else {
+                    block_stream.seekg(val_len_marker, std::ios_base::cur);
+                }
+            }
+        } catch (const std::exception& e) {
+            LOG_EVERY_N_SEC(LogLevel::ERROR, 10, "Error during SSTable multi-get: " << e.what());
+        }
+    }
+
+    Crypto::KeyManagementSystem::decrypt_batch(values, *dek_);
+    for (size_t i = 0; i < values.size(); ++i) {
+        results[value_slots[i]] = std::move(values[i]);
+    }
+    const size_t found = static_cast<size_t>(std::count_if(results.begin(), results.end(),
+                                                            [](const auto& result) { return result.has_value(); }));
+    probe_metrics().hits.add(found);
+    probe_metrics().misses.add(results.size() - found);
+    return results;
+}
+
+std::vector<SSTable::Entry> SSTable::scan_entries() {
+    std::vector<Entry> entries;
+    if (!file_stream_.is_open()) {
+        return entries; // Failed to load or checksum mismatch
+    }
     std::ifstream sst_file(file_path_, std::ios::binary);
     if (!sst_file.is_open()) {
-        return documents;
+        return entries;
     }
 
     BinaryStreamBuffer bsb(sst_file);
 
-    while (sst_file.peek() != EOF) {
+    // Read every record first and decrypt the values in a single batch pass.
+    std::vector<Entry> raw;
+    std::vector<Crypto::Buffer> values;
+
+    while (static_cast<uint64_t>(sst_file.tellg()) < data_end_offset_) {
         try {
-            std::string current_key = bsb.read_string();
+            Entry entry;
+            entry.key = bsb.read_string();
             
             size_t val_len_marker;
             bsb.read(val_len_marker);
 
             if (val_len_marker != static_cast<size_t>(-1)) { // Not a tombstone
-                auto encrypted_bytes = bsb.read_bytes_with_length(val_len_marker);
-                // TODO: The collection name should be passed in, not hardcoded.
-                auto dek = get_kms_instance().get_dek("default_collection");
-                auto decrypted_bytes = get_kms_instance().decrypt(encrypted_bytes, dek);
-                if (decrypted_bytes.empty() && !encrypted_bytes.empty()) {
-                     // Data is corrupt or key is wrong, skip this record.
-                     std::cerr << "Could not decrypt record with key: " << current_key << ". Skipping." << std::endl;
-                     continue;
-                }
-                documents.push_back(deserialize(decrypted_bytes));
-            } else {
-                // Tombstone
-                Document tombstone;
-                tombstone.id = current_key;
-                documents.push_back(tombstone);
+                values.push_back(bsb.read_bytes_with_length(val_len_marker));
+                entry.doc = std::make_shared<Document>(); // Filled in after decryption
+            } else if (has_tombstone_seq_) {
+                bsb.read(entry.tombstone_seq);
             }
+            raw.push_back(std::move(entry));
         } catch (const std::exception& e) {
-            std::cerr << "Error during SSTable scan: " << e.what() << std::endl;
+            LOG_EVERY_N_SEC(LogLevel::ERROR, 10, "Error during SSTable scan: " << e.what());
             break; // Stop scan on error
         }
     }
+
+    Crypto::KeyManagementSystem::decrypt_batch(values, *dek_);
+
+    entries.reserve(raw.size());
+    size_t value_idx = 0;
+    for (auto& entry : raw) {
+        if (entry.doc) {
+            try {
+                *entry.doc = deserialize(values[value_idx++]);
+            } catch (const std::exception& e) {
+                // Data is corrupt or key is wrong, skip this record.
+                LOG_EVERY_N_SEC(LogLevel::WARNING, 10, "Could not decode record with key: " << entry.key << ". Skipping.");
+                continue;
+            }
+        }
+        entries.push_back(std::move(entry));
+    }
+    return entries;
+}
+
+std::vector<Document> SSTable::scan() {
+    std::vector<Document> documents;
+    auto entries = scan_entries();
+    documents.reserve(entries.size());
+    for (auto& entry : entries) {
+        if (entry.doc) {
+            documents.push_back(std::move(*entry.doc));
+        } else {
+            // Tombstone
+            Document tombstone;
+            tombstone.id = entry.key;
+            documents.push_back(tombstone);
+        }
+    }
     return documents;
 }
 
-std::string SSTable::write_from_memtable(const std::string& data_dir, const Memtable& memtable) {
+std::string SSTable::write_from_memtable(const std::string& data_dir, const std::string& collection_name,
+                                         const Memtable& memtable) {
     long long timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
         std::chrono::system_clock::now().time_since_epoch()
     ).count();
     std::string file_path = data_dir + "/sstable_" + std::to_string(timestamp) + ".db";
+    write(file_path, collection_name, memtable.get_all());
+    return file_path;
+}
 
+void SSTable::write(const std::string& file_path, const std::string& collection_name,
+                    const std::map<std::string, std::shared_ptr<Document>>& data,
+                    const std::map<std::string, uint64_t>* tombstone_seqs) {
     std::stringstream buffer_stream;
     BinaryStreamBuffer bsb(static_cast<std::ostream&>(buffer_stream));
     std::map<std::string, uint64_t> sparse_index;
     int key_count = 0;
 
-    const auto& data = memtable.get_all();
+    Crypto::DekHandlePtr dek = get_kms_instance().get_dek_handle(collection_name);
+
     for (const auto& pair : data) {
         if (key_count % SSTABLE_INDEX_INTERVAL == 0) {
             sparse_index[pair.first] = buffer_stream.tellp();
@@ -161,14 +359,26 @@ std::string SSTable::write_from_memtable(const std::string& data_dir, const Memt
         bsb.write_string(pair.first);
 
         if (pair.second) {
-            std::vector<uint8_t> value_bytes = TissDB::serialize(*(pair.second));
-            // TODO: The collection name should be passed in, not hardcoded.
-            auto dek = get_kms_instance().get_dek("default_collection");
-            auto encrypted_bytes = get_kms_instance().encrypt(value_bytes, dek);
-            bsb.write_bytes(encrypted_bytes);
+            std::vector<uint8_t> value_bytes;
+            if (pair.second->id == pair.first) {
+                value_bytes = TissDB::serialize(*(pair.second));
+            } else {
+                // Documents are keyed by their map key; make sure the stored id agrees.
+                Document keyed_doc = *(pair.second);
+                keyed_doc.id = pair.first;
+                value_bytes = TissDB::serialize(keyed_doc);
+            }
+            Crypto::KeyManagementSystem::apply_keystream(value_bytes.data(), value_bytes.size(), *dek);
+            bsb.write_bytes(value_bytes);
         } else {
             size_t tombstone_marker = static_cast<size_t>(-1);
             bsb.write(tombstone_marker);
+            uint64_t seq = 0;
+            if (tombstone_seqs) {
+                auto seq_it = tombstone_seqs->find(pair.first);
+                if (seq_it != tombstone_seqs->end()) seq = seq_it->second;
+            }
+            bsb.write(seq);
         }
     }
 
@@ -179,100 +389,63 @@ std::string SSTable::write_from_memtable(const std::string& data_dir, const Memt
         bsb.write(pair.second);
     }
 
-    std::string buffer_str = buffer_stream.str();
-    uint32_t checksum = Common::crc32(buffer_str.data(), buffer_str.size());
-
-    std::ofstream sst_file(file_path, std::ios::binary | std::ios::trunc);
-    if (!sst_file.is_open()) {
-        throw std::runtime_error("Failed to create SSTable file: " + file_path);
-    }
-
-    sst_file.write(buffer_str.data(), buffer_str.size());
-    BinaryStreamBuffer file_bsb(sst_file);
-    file_bsb.write(checksum);
-    file_bsb.write(index_start_offset);
-
-    sst_file.close();
-    return file_path;
+    write_sstable_file(file_path, buffer_stream.str(), index_start_offset);
 }
 
-std::string SSTable::merge(const std::string& data_dir, const std::vector<SSTable*>& sstables) {
+std::string SSTable::merge(const std::string& data_dir, const std::string& collection_name,
+                           const std::vector<SSTable*>& sstables) {
     long long timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
         std::chrono::system_clock::now().time_since_epoch()
     ).count();
     std::string file_path = data_dir + "/sstable_merged_" + std::to_string(timestamp) + ".db";
 
-    std::map<std::string, std::optional<std::vector<uint8_t>>> merged_data;
-
+    // Later tables take precedence over earlier ones.
+    std::map<std::string, std::shared_ptr<Document>> merged_data;
+    std::map<std::string, uint64_t> tombstone_seqs;
     for (SSTable* sstable : sstables) {
-        if (!sstable->file_stream_.is_open()) continue;
-        std::vector<Document> documents = sstable->scan();
-        for (const auto& doc : documents) {
-            if (doc.elements.empty() && !doc.id.empty()) { // Tombstone
-                merged_data[doc.id] = std::nullopt;
-            } else {
-                merged_data[doc.id] = TissDB::serialize(doc);
-            }
-        }
-    }
-
-    std::stringstream buffer_stream;
-    BinaryStreamBuffer bsb(static_cast<std::ostream&>(buffer_stream));
-    std::map<std::string, uint64_t> sparse_index;
-    int key_count = 0;
-
-    for (const auto& pair : merged_data) {
-        if (key_count % SSTABLE_INDEX_INTERVAL == 0) {
-            sparse_index[pair.first] = buffer_stream.tellp();
-        }
-        key_count++;
-
-        bsb.write_string(pair.first);
-
-        if (pair.second.has_value()) {
-            // TODO: The collection name should be passed in, not hardcoded.
-            auto dek = get_kms_instance().get_dek("default_collection");
-            auto encrypted_bytes = get_kms_instance().encrypt(pair.second.value(), dek);
-            bsb.write_bytes(encrypted_bytes);
-        } else {
-            size_t tombstone_marker = static_cast<size_t>(-1);
-            bsb.write(tombstone_marker);
+        for (auto& entry : sstable->scan_entries()) {
+            if (!entry.doc) tombstone_seqs[entry.key] = entry.tombstone_seq;
+            merged_data[entry.key] = std::move(entry.doc);
         }
     }
 
-    uint64_t index_start_offset = buffer_stream.tellp();
-    bsb.write(static_cast<size_t>(sparse_index.size()));
-    for (const auto& pair : sparse_index) {
-        bsb.write_string(pair.first);
-        bsb.write(pair.second);
-    }
-
-    std::string buffer_str = buffer_stream.str();
-    uint32_t checksum = Common::crc32(buffer_str.data(), buffer_str.size());
-
-    std::ofstream sst_file(file_path, std::ios::binary | std::ios::trunc);
-    if (!sst_file.is_open()) {
-        throw std::runtime_error("Failed to create merged SSTable file: " + file_path);
-    }
-
-    sst_file.write(buffer_str.data(), buffer_str.size());
-    BinaryStreamBuffer file_bsb(sst_file);
-    file_bsb.write(checksum);
-    file_bsb.write(index_start_offset);
-
-    sst_file.close();
+    write(file_path, collection_name, merged_data, &tombstone_seqs);
     return file_path;
 }
 
 void SSTable::load_index() {
     file_stream_.seekg(0, std::ios::end);
-    std::streampos file_size = file_stream_.tellg();
-    if (file_size < static_cast<std::streamoff>(sizeof(uint64_t) + sizeof(uint32_t))) {
+    std::streamoff file_size = file_stream_.tellg();
+    if (file_size < LEGACY_FOOTER_SIZE) {
         throw std::runtime_error("SSTable file is too small to be valid.");
     }
 
-    // Read footer: index offset and checksum
-    file_stream_.seekg(-static_cast<std::streamoff>(sizeof(uint64_t) + sizeof(uint32_t)), std::ios::end);
+    // Detect the footer format from the trailing magic number.
+    Common::ChecksumType checksum_type = Common::ChecksumType::CRC32;
+    std::streamoff footer_size = LEGACY_FOOTER_SIZE;
+    bool collection_keyed = false;
+    if (file_size >= FOOTER_SIZE) {
+        file_stream_.seekg(-static_cast<std::streamoff>(2 * sizeof(uint32_t)), std::ios::end);
+        BinaryStreamBuffer version_bsb(file_stream_);
+        uint32_t version, magic;
+        version_bsb.read(version);
+        version_bsb.read(magic);
+        if (magic == SSTABLE_MAGIC) {
+            if (version < SSTABLE_MIN_FORMAT_VERSION || version > SSTABLE_FORMAT_VERSION) {
+                throw std::runtime_error("Unsupported SSTable format version: " + std::to_string(version));
+            }
+            checksum_type = Common::ChecksumType::CRC32C;
+            has_tombstone_seq_ = version >= 3;
+            collection_keyed = version >= 4;
+            footer_size = FOOTER_SIZE;
+        }
+    }
+    if (!collection_keyed) {
+        dek_ = get_kms_instance().get_dek_handle(LEGACY_DEK_NAME);
+    }
+
+    // Read footer: checksum and index offset
+    file_stream_.seekg(file_size - footer_size);
     BinaryStreamBuffer footer_bsb(file_stream_);
     uint32_t stored_checksum;
     uint64_t index_start_offset;
@@ -280,15 +453,21 @@ void SSTable::load_index() {
     footer_bsb.read(index_start_offset);
 
     // Verify checksum of the data and index blocks
-    std::vector<char> buffer(index_start_offset);
+    const uint64_t body_size = static_cast<uint64_t>(file_size - footer_size);
+    if (index_start_offset > body_size) {
+        throw std::runtime_error("SSTable index offset is out of range.");
+    }
+    std::vector<char> buffer(body_size);
     file_stream_.seekg(0);
-    file_stream_.read(buffer.data(), index_start_offset);
+    file_stream_.read(buffer.data(), body_size);
 
-    uint32_t calculated_checksum = Common::crc32(buffer.data(), index_start_offset);
+    uint32_t calculated_checksum = Common::checksum(checksum_type, buffer.data(), body_size);
     if (stored_checksum != calculated_checksum) {
         throw std::runtime_error("SSTable checksum mismatch. Data corruption detected.");
     }
 
+    data_end_offset_ = index_start_offset;
+
     // Seek to the beginning of the index block.
     file_stream_.seekg(index_start_offset);
 
@@ -7,9 +7,13 @@
 #include <map>
 #include <fstream>
 #include <optional>
+#include <memory>
+#include <mutex>
+#include <utility>
 
 #include "memtable.h"
 #include "../common/document.h"
+#include "../crypto/kms.h"
 
 namespace TissDB {
 namespace Storage {
@@ -17,8 +21,10 @@ namespace Storage {
 // Represents a single, immutable, sorted on-disk table.
 class SSTable {
 public:
-    // Opens an existing SSTable file and loads its index into memory.
-    SSTable(const std::string& path);
+    // Opens an existing SSTable file and loads its index into memory. Values
+    // are decrypted with the DEK of `collection_name`.
+    SSTable(const std::string& path, const std::string& collection_name);
+    ~SSTable();
 
     // Searches for a key within this SSTable file.
     // Returns the serialized document data if found.
@@ -26,27 +32,63 @@ public:
     // Returns an empty vector to represent a tombstone.
     std::optional<std::vector<uint8_t>> find(const std::string& key);
 
+    // Looks up many keys in one pass. `keys` must be sorted and unique. The
+    // blocks holding them are read in order, nearby blocks with a single read.
+    // Returns one result per key, with the same convention as find().
+    std::vector<std::optional<std::vector<uint8_t>>> find_many(const std::vector<std::string>& keys);
+
     // Scans all documents in the SSTable.
     std::vector<Document> scan();
 
+    // One record of the table. `doc` is nullptr for a tombstone, in which case
+    // `tombstone_seq` is the sequence number of the delete (0 if unknown).
+    struct Entry {
+        std::string key;
+        std::shared_ptr<Document> doc;
+        uint64_t tombstone_seq = 0;
+    };
+
+    // Scans all entries in key order.
+    std::vector<Entry> scan_entries();
+
+    // Returns false if the file could not be opened or failed verification.
+    bool is_valid() const { return file_stream_.is_open(); }
+
     // Static method to create a new SSTable file from a Memtable.
     // Returns the path to the newly created SSTable file.
-    static std::string write_from_memtable(const std::string& data_dir, const Memtable& memtable);
+    static std::string write_from_memtable(const std::string& data_dir, const std::string& collection_name,
+                                           const Memtable& memtable);
+
+    // Writes a sorted key/document map (nullptr = tombstone) to a new SSTable at
+    // `file_path`, encrypting values with the DEK of `collection_name`.
+    // Tombstones are tagged with their sequence number from `tombstone_seqs`.
+    static void write(const std::string& file_path, const std::string& collection_name,
+                      const std::map<std::string, std::shared_ptr<Document>>& data,
+                      const std::map<std::string, uint64_t>* tombstone_seqs = nullptr);
 
     // Static method to merge multiple SSTables into a new one.
     // Returns the path to the newly created SSTable file.
-    static std::string merge(const std::string& data_dir, const std::vector<SSTable*>& sstables);
+    static std::string merge(const std::string& data_dir, const std::string& collection_name,
+                             const std::vector<SSTable*>& sstables);
 
     const std::string& get_path() const { return file_path_; }
 
 private:
     void load_index();
+    // find() without the bookkeeping.
+    std::optional<std::vector<uint8_t>> probe(const std::string& key);
 
     std::string file_path_;
     std::ifstream file_stream_;
+    std::mutex stream_mutex_; // find() seeks on the shared stream
+    uint64_t data_end_offset_ = 0; // Start of the index block
+    bool has_tombstone_seq_ = false; // Format v3+
     // The sparse index maps a key to its offset in the file.
     // This allows for efficient lookups without reading the whole file.
     std::map<std::string, uint64_t> sparse_index_;
+    size_t index_memory_bytes_ = 0; // Reported to the memory governor
+    // Resolved once when the table is opened and reused for every record.
+    Crypto::DekHandlePtr dek_;
 };
 
 } // namespace Storage
@@ -0,0 +1,359 @@
+#include "statistics.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+namespace TissDB {
+namespace Storage {
+
+namespace {
+// FNV-1a followed by a 64-bit finalizer, so sketches built by different
+// processes (and persisted) agree on every value's hash.
+uint64_t hash_bytes(char tag, const void* data, size_t size) {
+    uint64_t hash = 14695981039346656037ULL;
+    auto mix = [&hash](uint8_t byte) {
+        hash ^= byte;
+        hash *= 1099511628211ULL;
+    };
+    mix(static_cast<uint8_t>(tag));
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        mix(bytes[i]);
+    }
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+template <typename T>
+uint64_t hash_scalar(char tag, T value) {
+    return hash_bytes(tag, &value, sizeof(value));
+}
+
+// Numeric view of a value for min/max and histograms.
+std::optional<double> numeric_value(const Value& value) {
+    if (const auto* number = std::get_if<Number>(&value)) return *number;
+    if (const auto* ts = std::get_if<Timestamp>(&value)) return static_cast<double>(ts->microseconds_since_epoch_utc);
+    return std::nullopt;
+}
+
+Json::JsonValue optional_number(const std::optional<double>& value) {
+    return value ? Json::JsonValue(*value) : Json::JsonValue();
+}
+
+Json::JsonValue optional_string(const std::optional<std::string>& value) {
+    return value ? Json::JsonValue(*value) : Json::JsonValue();
+}
+
+int64_t now_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+} // anonymous namespace
+
+// --- HyperLogLog ---
+
+void HyperLogLog::add(uint64_t hash) {
+    const size_t index = static_cast<size_t>(hash >> (64 - PRECISION));
+    const uint64_t rest = hash << PRECISION;
+    const uint8_t rank = rest == 0 ? static_cast<uint8_t>(64 - PRECISION + 1)
+                                   : static_cast<uint8_t>(__builtin_clzll(rest) + 1);
+    registers_[index] = std::max(registers_[index], rank);
+}
+
+double HyperLogLog::estimate() const {
+    const double m = static_cast<double>(REGISTER_COUNT);
+    double sum = 0.0;
+    size_t zeros = 0;
+    for (uint8_t reg : registers_) {
+        sum += std::ldexp(1.0, -static_cast<int>(reg));
+        if (reg == 0) ++zeros;
+    }
+    const double alpha = 0.7213 / (1.0 + 1.079 / m);
+    const double raw = alpha * m * m / sum;
+    if (raw <= 2.5 * m && zeros > 0) {
+        return m * std::log(m / static_cast<double>(zeros)); // Linear counting for small sets
+    }
+    return raw;
+}
+
+void HyperLogLog::merge(const HyperLogLog& other) {
+    for (size_t i = 0; i < REGISTER_COUNT; ++i) {
+        registers_[i] = std::max(registers_[i], other.registers_[i]);
+    }
+}
+
+std::string HyperLogLog::to_hex() const {
+    static const char* digits = "0123456789abcdef";
+    std::string hex;
+    hex.reserve(REGISTER_COUNT * 2);
+    for (uint8_t reg : registers_) {
+        hex.push_back(digits[reg >> 4]);
+        hex.push_back(digits[reg & 0xF]);
+    }
+    return hex;
+}
+
+HyperLogLog HyperLogLog::from_hex(const std::string& hex) {
+    if (hex.size() != REGISTER_COUNT * 2) {
+        throw std::runtime_error("Invalid HyperLogLog sketch size: " + std::to_string(hex.size()));
+    }
+    HyperLogLog sketch;
+    for (size_t i = 0; i < REGISTER_COUNT; ++i) {
+        sketch.registers_[i] = static_cast<uint8_t>(std::stoi(hex.substr(i * 2, 2), nullptr, 16));
+    }
+    return sketch;
+}
+
+// --- EquiDepthHistogram ---
+
+EquiDepthHistogram EquiDepthHistogram::build(std::vector<double> values, size_t buckets) {
+    EquiDepthHistogram histogram;
+    if (values.empty() || buckets == 0) return histogram;
+    std::sort(values.begin(), values.end());
+    const size_t n = values.size();
+    buckets = std::min(buckets, n);
+    histogram.bounds_.push_back(values.front());
+    for (size_t i = 0; i < buckets; ++i) {
+        const size_t start = i * n / buckets;
+        const size_t end = (i + 1) * n / buckets;
+        histogram.bounds_.push_back(values[end - 1]);
+        histogram.counts_.push_back(end - start);
+    }
+    histogram.total_ = n;
+    return histogram;
+}
+
+double EquiDepthHistogram::fraction_below(double value) const {
+    if (counts_.empty() || value <= bounds_.front()) return 0.0;
+    if (value > bounds_.back()) return 1.0;
+    double below = 0.0;
+    for (size_t i = 0; i < counts_.size(); ++i) {
+        const double lo = bounds_[i];
+        const double hi = bounds_[i + 1];
+        if (value > hi) {
+            below += static_cast<double>(counts_[i]);
+            continue;
+        }
+        if (value > lo && hi > lo) {
+            below += static_cast<double>(counts_[i]) * (value - lo) / (hi - lo);
+        }
+        break;
+    }
+    return below / static_cast<double>(total_);
+}
+
+Json::JsonValue EquiDepthHistogram::to_json() const {
+    Json::JsonArray bounds;
+    for (double bound : bounds_) bounds.push_back(Json::JsonValue(bound));
+    Json::JsonArray counts;
+    for (uint64_t count : counts_) counts.push_back(Json::JsonValue(static_cast<double>(count)));
+    Json::JsonObject obj;
+    obj["bounds"] = Json::JsonValue(bounds);
+    obj["counts"] = Json::JsonValue(counts);
+    return Json::JsonValue(obj);
+}
+
+EquiDepthHistogram EquiDepthHistogram::from_json(const Json::JsonValue& json) {
+    EquiDepthHistogram histogram;
+    const auto& obj = json.as_object();
+    for (const auto& bound : obj.at("bounds").as_array()) {
+        histogram.bounds_.push_back(bound.as_number());
+    }
+    for (const auto& count : obj.at("counts").as_array()) {
+        histogram.counts_.push_back(static_cast<uint64_t>(count.as_number()));
+        histogram.total_ += histogram.counts_.back();
+    }
+    if (!histogram.counts_.empty() && histogram.bounds_.size() != histogram.counts_.size() + 1) {
+        throw std::runtime_error("Histogram bounds do not match its buckets.");
+    }
+    return histogram;
+}
+
+// --- FieldStatistics ---
+
+void FieldStatistics::add(const Value& value) {
+    if (std::holds_alternative<std::nullptr_t>(value)) return;
+    ++non_null;
+    if (const auto* str = std::get_if<std::string>(&value)) {
+        distinct.add(hash_bytes('s', str->data(), str->size()));
+        if (!min_string || *str < *min_string) min_string = *str;
+        if (!max_string || *str > *max_string) max_string = *str;
+        return;
+    }
+    if (auto number = numeric_value(value)) {
+        double normalized = *number == 0.0 ? 0.0 : *number; // -0.0 and 0.0 are one value
+        distinct.add(hash_scalar('n', normalized));
+        if (!min_number || *number < *min_number) min_number = *number;
+        if (!max_number || *number > *max_number) max_number = *number;
+        return;
+    }
+    if (const auto* boolean = std::get_if<Boolean>(&value)) {
+        distinct.add(hash_scalar('b', static_cast<uint8_t>(*boolean)));
+    } else if (const auto* date = std::get_if<Date>(&value)) {
+        distinct.add(hash_scalar('d', (uint32_t{date->year} << 16) | (uint32_t{date->month} << 8) | date->day));
+    } else if (const auto* time = std::get_if<Time>(&value)) {
+        distinct.add(hash_scalar('h', (uint32_t{time->hour} << 16) | (uint32_t{time->minute} << 8) | time->second));
+    } else if (const auto* datetime = std::get_if<DateTime>(&value)) {
+        distinct.add(hash_scalar('D', static_cast<int64_t>(datetime->time_since_epoch().count())));
+    } else if (const auto* binary = std::get_if<BinaryData>(&value)) {
+        distinct.add(hash_bytes('x', binary->data(), binary->size()));
+    }
+    // Nested values only count towards non_null.
+}
+
+void FieldStatistics::merge(const FieldStatistics& other) {
+    // Partitions are hash-distributed samples of the rows, so the histogram
+    // built from more of them stands in for the whole.
+    if (histogram.empty() || (!other.histogram.empty() && other.non_null > non_null)) {
+        histogram = other.histogram;
+    }
+    non_null += other.non_null;
+    distinct.merge(other.distinct);
+    if (other.min_number && (!min_number || *other.min_number < *min_number)) min_number = other.min_number;
+    if (other.max_number && (!max_number || *other.max_number > *max_number)) max_number = other.max_number;
+    if (other.min_string && (!min_string || *other.min_string < *min_string)) min_string = other.min_string;
+    if (other.max_string && (!max_string || *other.max_string > *max_string)) max_string = other.max_string;
+}
+
+double FieldStatistics::distinct_estimate() const {
+    double estimate = distinct.estimate();
+    if (non_null > 0) {
+        estimate = std::min(estimate, static_cast<double>(non_null));
+    }
+    return std::max(1.0, estimate);
+}
+
+// --- CollectionStatistics ---
+
+const FieldStatistics* CollectionStatistics::field(const std::string& name) const {
+    auto it = fields_.find(name);
+    return it == fields_.end() ? nullptr : &it->second;
+}
+
+void CollectionStatistics::add_fields(const Document& doc) {
+    for (const auto& element : doc.elements) {
+        fields_[element.key].add(element.value);
+    }
+}
+
+void CollectionStatistics::record_insert(const Document& doc) {
+    ++row_count_;
+    ++modifications_;
+    add_fields(doc);
+}
+
+void CollectionStatistics::record_update(const Document& doc) {
+    ++modifications_;
+    add_fields(doc);
+}
+
+void CollectionStatistics::record_delete() {
+    if (row_count_ > 0) --row_count_;
+    ++modifications_;
+}
+
+double CollectionStatistics::equality_selectivity(const std::string& name) const {
+    const FieldStatistics* stats = field(name);
+    if (!stats || row_count_ == 0) return DEFAULT_EQUALITY_SELECTIVITY;
+    const double present = std::min(1.0, static_cast<double>(stats->non_null) / static_cast<double>(row_count_));
+    return present / stats->distinct_estimate();
+}
+
+double CollectionStatistics::range_selectivity(const std::string& name, double value, bool less) const {
+    const FieldStatistics* stats = field(name);
+    if (!stats || row_count_ == 0) return DEFAULT_RANGE_SELECTIVITY;
+    const double present = std::min(1.0, static_cast<double>(stats->non_null) / static_cast<double>(row_count_));
+    double below;
+    if (!stats->histogram.empty()) {
+        below = stats->histogram.fraction_below(value);
+    } else if (stats->min_number && stats->max_number) {
+        const double lo = *stats->min_number;
+        const double hi = *stats->max_number;
+        if (value <= lo) below = 0.0;
+        else if (value > hi) below = 1.0;
+        else below = hi > lo ? (value - lo) / (hi - lo) : 0.5;
+    } else {
+        return DEFAULT_RANGE_SELECTIVITY;
+    }
+    return present * (less ? below : 1.0 - below);
+}
+
+CollectionStatistics CollectionStatistics::analyze(const std::vector<Document>& docs) {
+    CollectionStatistics stats;
+    std::map<std::string, std::vector<double>> numeric_values;
+    for (const auto& doc : docs) {
+        ++stats.row_count_;
+        for (const auto& element : doc.elements) {
+            stats.fields_[element.key].add(element.value);
+            if (auto number = numeric_value(element.value)) {
+                numeric_values[element.key].push_back(*number);
+            }
+        }
+    }
+    for (auto& [name, values] : numeric_values) {
+        stats.fields_[name].histogram = EquiDepthHistogram::build(std::move(values));
+    }
+    stats.analyzed_at_ms_ = now_ms();
+    return stats;
+}
+
+void CollectionStatistics::merge(const CollectionStatistics& other) {
+    // The oldest analysis, or never if one partition was not analyzed.
+    analyzed_at_ms_ = std::min(analyzed_at_ms_, other.analyzed_at_ms_);
+    row_count_ += other.row_count_;
+    modifications_ += other.modifications_;
+    for (const auto& [name, stats] : other.fields_) {
+        fields_[name].merge(stats);
+    }
+}
+
+Json::JsonValue CollectionStatistics::to_json() const {
+    Json::JsonObject fields;
+    for (const auto& [name, stats] : fields_) {
+        Json::JsonObject field;
+        field["non_null"] = Json::JsonValue(static_cast<double>(stats.non_null));
+        field["distinct"] = Json::JsonValue(stats.distinct.to_hex());
+        field["min_number"] = optional_number(stats.min_number);
+        field["max_number"] = optional_number(stats.max_number);
+        field["min_string"] = optional_string(stats.min_string);
+        field["max_string"] = optional_string(stats.max_string);
+        field["histogram"] = stats.histogram.to_json();
+        fields[name] = Json::JsonValue(field);
+    }
+    Json::JsonObject obj;
+    obj["row_count"] = Json::JsonValue(static_cast<double>(row_count_));
+    obj["analyzed_at_ms"] = Json::JsonValue(static_cast<double>(analyzed_at_ms_));
+    obj["modifications"] = Json::JsonValue(static_cast<double>(modifications_));
+    obj["fields"] = Json::JsonValue(fields);
+    return Json::JsonValue(obj);
+}
+
+CollectionStatistics CollectionStatistics::from_json(const Json::JsonValue& json) {
+    CollectionStatistics stats;
+    const auto& obj = json.as_object();
+    stats.row_count_ = static_cast<uint64_t>(obj.at("row_count").as_number());
+    stats.analyzed_at_ms_ = static_cast<int64_t>(obj.at("analyzed_at_ms").as_number());
+    stats.modifications_ = static_cast<uint64_t>(obj.at("modifications").as_number());
+    for (const auto& [name, field_json] : obj.at("fields").as_object()) {
+        const auto& field = field_json.as_object();
+        FieldStatistics& fs = stats.fields_[name];
+        fs.non_null = static_cast<uint64_t>(field.at("non_null").as_number());
+        fs.distinct = HyperLogLog::from_hex(field.at("distinct").as_string());
+        if (field.at("min_number").is_number()) fs.min_number = field.at("min_number").as_number();
+        if (field.at("max_number").is_number()) fs.max_number = field.at("max_number").as_number();
+        if (field.at("min_string").is_string()) fs.min_string = field.at("min_string").as_string();
+        if (field.at("max_string").is_string()) fs.max_string = field.at("max_string").as_string();
+        fs.histogram = EquiDepthHistogram::from_json(field.at("histogram"));
+    }
+    return stats;
+}
+
+} // namespace Storage
+} // namespace TissDB
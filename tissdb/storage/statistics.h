@@ -0,0 +1,118 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "../common/document.h"
+#include "../json/json.h"
+
+namespace TissDB {
+namespace Storage {
+
+// HyperLogLog sketch estimating the number of distinct values added to it.
+// 2^10 registers give a standard error of about 3%.
+class HyperLogLog {
+public:
+    static constexpr int PRECISION = 10;
+    static constexpr size_t REGISTER_COUNT = size_t{1} << PRECISION;
+
+    void add(uint64_t hash);
+    double estimate() const;
+    void merge(const HyperLogLog& other);
+
+    std::string to_hex() const;
+    static HyperLogLog from_hex(const std::string& hex);
+
+private:
+    std::array<uint8_t, REGISTER_COUNT> registers_{};
+};
+
+// Equi-depth histogram over numeric values: every bucket holds about the same
+// number of rows, so bucket widths follow the data distribution.
+class EquiDepthHistogram {
+public:
+    static constexpr size_t DEFAULT_BUCKETS = 16;
+
+    // `values` need not be sorted.
+    static EquiDepthHistogram build(std::vector<double> values, size_t buckets = DEFAULT_BUCKETS);
+
+    bool empty() const { return counts_.empty(); }
+    // Estimated fraction of rows with a value below `value` (0..1).
+    double fraction_below(double value) const;
+
+    Json::JsonValue to_json() const;
+    static EquiDepthHistogram from_json(const Json::JsonValue& json);
+
+private:
+    std::vector<double> bounds_;   // Bucket i covers [bounds_[i], bounds_[i + 1]]
+    std::vector<uint64_t> counts_;
+    uint64_t total_ = 0;
+};
+
+// Statistics of one top-level field.
+struct FieldStatistics {
+    uint64_t non_null = 0;
+    HyperLogLog distinct;
+    std::optional<double> min_number;
+    std::optional<double> max_number;
+    std::optional<std::string> min_string;
+    std::optional<std::string> max_string;
+    EquiDepthHistogram histogram; // Only rebuilt by ANALYZE
+
+    void add(const Value& value);
+    // Combines the statistics of another partition of the same field.
+    void merge(const FieldStatistics& other);
+    double distinct_estimate() const;
+};
+
+// Per-collection statistics for the query planner. Row counts, sketches and
+// min/max are maintained on every write; histograms are rebuilt by ANALYZE.
+// Sketches cannot forget values, so deletes and updates leave the distinct
+// counts somewhat high until the next ANALYZE.
+class CollectionStatistics {
+public:
+    uint64_t row_count() const { return row_count_; }
+    bool empty() const { return row_count_ == 0 && fields_.empty(); }
+    int64_t analyzed_at_ms() const { return analyzed_at_ms_; }
+    uint64_t modifications_since_analyze() const { return modifications_; }
+    const std::map<std::string, FieldStatistics>& fields() const { return fields_; }
+    const FieldStatistics* field(const std::string& name) const;
+
+    void record_insert(const Document& doc);
+    void record_update(const Document& doc);
+    void record_delete();
+
+    // Fraction of rows expected to match `field = <constant>`.
+    double equality_selectivity(const std::string& field) const;
+    // Fraction of rows expected to match `field < value` (or `>` if !less).
+    double range_selectivity(const std::string& field, double value, bool less) const;
+
+    // Full statistics, including histograms, from every live document.
+    static CollectionStatistics analyze(const std::vector<Document>& docs);
+
+    // Adds the statistics of another partition of the collection (a shard).
+    void merge(const CollectionStatistics& other);
+
+    Json::JsonValue to_json() const;
+    static CollectionStatistics from_json(const Json::JsonValue& json);
+
+private:
+    void add_fields(const Document& doc);
+
+    uint64_t row_count_ = 0;
+    std::map<std::string, FieldStatistics> fields_;
+    int64_t analyzed_at_ms_ = 0; // 0: never analyzed
+    uint64_t modifications_ = 0;
+};
+
+// Used when a field has no statistics.
+constexpr double DEFAULT_EQUALITY_SELECTIVITY = 0.1;
+constexpr double DEFAULT_RANGE_SELECTIVITY = 1.0 / 3.0;
+
+} // namespace Storage
+} // namespace TissDB
@@ -0,0 +1,100 @@
+#include "ttl.h"
+#include "../json/json.h"
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+namespace TissDB {
+namespace Storage {
+
+const char* const DEFAULT_EXPIRY_FIELD = "_expires_at";
+
+namespace {
+const char* const TTL_POLICY_FILE = "ttl.json";
+} // anonymous namespace
+
+const std::string& TtlPolicy::field() const {
+    static const std::string default_field = DEFAULT_EXPIRY_FIELD;
+    return expiry_field.empty() ? default_field : expiry_field;
+}
+
+std::optional<int64_t> TtlPolicy::expires_at_us(const Document& doc) const {
+    const std::string& name = field();
+    for (const auto& element : doc.elements) {
+        if (element.key != name) continue;
+        if (const auto* ts = std::get_if<Timestamp>(&element.value)) {
+            return ts->microseconds_since_epoch_utc;
+        }
+        if (const auto* dt = std::get_if<DateTime>(&element.value)) {
+            return std::chrono::duration_cast<std::chrono::microseconds>(dt->time_since_epoch()).count();
+        }
+        if (const auto* seconds = std::get_if<Number>(&element.value)) {
+            return static_cast<int64_t>(*seconds * 1000000.0);
+        }
+        return std::nullopt; // Any other type never expires
+    }
+    return std::nullopt;
+}
+
+bool TtlPolicy::is_expired(const Document& doc, int64_t now) const {
+    auto expires_at = expires_at_us(doc);
+    return expires_at && *expires_at <= now;
+}
+
+void TtlPolicy::apply_default(Document& doc, int64_t now) const {
+    if (default_ttl_seconds == 0) return;
+    const std::string& name = field();
+    for (const auto& element : doc.elements) {
+        if (element.key == name) return;
+    }
+    Element element;
+    element.key = name;
+    element.value = Timestamp{now + static_cast<int64_t>(default_ttl_seconds) * 1000000};
+    doc.elements.push_back(std::move(element));
+}
+
+int64_t now_us() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+TtlPolicy load_ttl_policy(const std::string& collection_path) {
+    TtlPolicy policy;
+    std::filesystem::path policy_path = std::filesystem::path(collection_path) / TTL_POLICY_FILE;
+    if (!std::filesystem::exists(policy_path)) return policy;
+
+    std::ifstream policy_file(policy_path);
+    std::string content((std::istreambuf_iterator<char>(policy_file)), std::istreambuf_iterator<char>());
+    Json::JsonValue parsed = Json::JsonValue::parse(content);
+    const auto& obj = parsed.as_object();
+    policy.default_ttl_seconds = static_cast<uint64_t>(obj.at("ttl_seconds").as_number());
+    policy.expiry_field = obj.at("expiry_field").as_string();
+    return policy;
+}
+
+void save_ttl_policy(const std::string& collection_path, const TtlPolicy& policy) {
+    std::filesystem::path policy_path = std::filesystem::path(collection_path) / TTL_POLICY_FILE;
+    if (!policy.enabled()) {
+        std::filesystem::remove(policy_path);
+        return;
+    }
+
+    Json::JsonObject policy_obj;
+    policy_obj["ttl_seconds"] = Json::JsonValue(static_cast<double>(policy.default_ttl_seconds));
+    policy_obj["expiry_field"] = Json::JsonValue(policy.expiry_field);
+
+    std::filesystem::path tmp_path = policy_path.string() + ".tmp";
+    {
+        std::ofstream policy_file(tmp_path, std::ios::trunc);
+        if (!policy_file.is_open()) {
+            throw std::runtime_error("Could not open TTL policy for writing: " + tmp_path.string());
+        }
+        policy_file << Json::JsonValue(policy_obj).serialize();
+    }
+    std::filesystem::rename(tmp_path, policy_path);
+}
+
+} // namespace Storage
+} // namespace TissDB
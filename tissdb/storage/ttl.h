@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+
+#include "../common/document.h"
+
+namespace TissDB {
+namespace Storage {
+
+// Field holding a document's expiry when the policy does not name one.
+extern const char* const DEFAULT_EXPIRY_FIELD;
+
+// Expiry settings of a collection, stored in its `ttl.json`.
+//
+// A document expires at the time held in the expiry field: a Timestamp, a
+// DateTime, or a Number of seconds since the Unix epoch. With a default TTL,
+// documents written without that field get it set to write time + TTL.
+// Expired documents are hidden from reads and dropped by compaction.
+struct TtlPolicy {
+    uint64_t default_ttl_seconds = 0; // 0: documents only expire if they carry the field
+    std::string expiry_field;         // Empty: DEFAULT_EXPIRY_FIELD
+
+    bool enabled() const { return default_ttl_seconds > 0 || !expiry_field.empty(); }
+    const std::string& field() const;
+
+    // Microseconds since the epoch at which `doc` expires, if it does.
+    std::optional<int64_t> expires_at_us(const Document& doc) const;
+    bool is_expired(const Document& doc, int64_t now_us) const;
+
+    // Adds the expiry field to `doc` if a default TTL applies and it has none.
+    void apply_default(Document& doc, int64_t now_us) const;
+};
+
+int64_t now_us();
+
+// Reads the policy from `<collection_path>/ttl.json`; a missing file means no TTL.
+TtlPolicy load_ttl_policy(const std::string& collection_path);
+void save_ttl_policy(const std::string& collection_path, const TtlPolicy& policy);
+
+} // namespace Storage
+} // namespace TissDB
@@ -1,8 +1,10 @@
 #include "wal.h"
 #include "../common/log.h"
+#include "../common/metrics.h"
 #include "../common/serialization.h"
 #include "../common/binary_stream_buffer.h"
 #include "../crypto/kms.h"
+#include <filesystem>
 #include <iostream>
 #include <vector>
 #include <sstream>
@@ -24,10 +26,69 @@ TissDB::Crypto::KeyManagementSystem& get_kms_instance() {
 } // anonymous namespace
 
 WriteAheadLog::WriteAheadLog(const std::string& path) : log_path(path) {
-    log_file.open(log_path, std::ios::app | std::ios::binary);
+    dek_ = get_kms_instance().get_dek_handle("wal_key"); // Use a dedicated key for the WAL
+    open_log(std::ios::app);
+}
+
+namespace {
+// Reads the header of an existing log and returns its format version (1 for a
+// log without a header); leaves the stream positioned after the header.
+uint32_t read_wal_header(std::istream& in) {
+    uint32_t magic = 0;
+    uint32_t version = 0;
+    in.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+    in.read(reinterpret_cast<char*>(&version), sizeof(version));
+    if (!in || magic != WAL_MAGIC) {
+        in.clear();
+        in.seekg(0);
+        return 1;
+    }
+    if (version < 2 || version > WAL_FORMAT_VERSION) {
+        throw std::runtime_error("Unsupported WAL format version: " + std::to_string(version));
+    }
+    return version;
+}
+
+Common::ChecksumType checksum_type_for(uint32_t version) {
+    return version >= 2 ? Common::ChecksumType::CRC32C : Common::ChecksumType::CRC32;
+}
+} // anonymous namespace
+
+void WriteAheadLog::open_log(std::ios::openmode mode) {
+    log_file.open(log_path, mode | std::ios::out | std::ios::binary);
     if (!log_file.is_open()) {
         throw std::runtime_error("Failed to open WAL file: " + log_path);
     }
+    init_format();
+}
+
+void WriteAheadLog::init_format() {
+    first_lsn_ = 0;
+    last_lsn_ = 0;
+    std::ifstream existing(log_path, std::ios::binary | std::ios::ate);
+    if (existing.is_open() && existing.tellg() > 0) {
+        // Keep appending in whatever format the file already uses; an older
+        // log is upgraded the next time it is cleared.
+        existing.seekg(0);
+        version_ = read_wal_header(existing);
+        checksum_type_ = checksum_type_for(version_);
+        existing.seekg(0);
+        read_entries(existing, [this](LogEntry& entry) {
+            if (entry.lsn != 0) {
+                if (first_lsn_ == 0) first_lsn_ = entry.lsn;
+                last_lsn_ = entry.lsn;
+            }
+            return true;
+        });
+        return;
+    }
+
+    version_ = WAL_FORMAT_VERSION;
+    checksum_type_ = checksum_type_for(version_);
+    BinaryStreamBuffer file_bsb(log_file);
+    file_bsb.write(WAL_MAGIC);
+    file_bsb.write(version_);
+    log_file.flush();
 }
 
 WriteAheadLog::~WriteAheadLog() {
@@ -36,11 +97,7 @@ WriteAheadLog::~WriteAheadLog() {
     }
 }
 
-void WriteAheadLog::append(const LogEntry& entry) {
-    if (!log_file.is_open()) {
-        throw std::runtime_error("WAL file is not open.");
-    }
-
+size_t WriteAheadLog::encode(const LogEntry& entry, std::ostream& out) const {
     std::stringstream buffer_stream;
     BinaryStreamBuffer bsb(static_cast<std::ostream&>(buffer_stream));
 
@@ -57,23 +114,75 @@ void WriteAheadLog::append(const LogEntry& entry) {
         size_t zero_len = 0;
         bsb.write(zero_len);
     }
+    if (version_ >= 3) {
+        bsb.write(entry.lsn);
+    }
 
     std::string buffer_str = buffer_stream.str();
 
-    // Encrypt the entire log entry
-    auto dek = get_kms_instance().get_dek("wal_key"); // Use a dedicated key for the WAL
-    Crypto::Buffer plaintext_buffer(buffer_str.begin(), buffer_str.end());
-    Crypto::Buffer encrypted_buffer = get_kms_instance().encrypt(plaintext_buffer, dek);
+    // Encrypt the entire log entry in place
+    Crypto::KeyManagementSystem::apply_keystream(
+        reinterpret_cast<Crypto::byte*>(&buffer_str[0]), buffer_str.size(), *dek_);
 
-    uint32_t checksum = Common::crc32(encrypted_buffer.data(), encrypted_buffer.size());
-    uint32_t entry_size = encrypted_buffer.size();
+    uint32_t checksum = Common::checksum(checksum_type_, buffer_str.data(), buffer_str.size());
+    uint32_t entry_size = buffer_str.size();
 
-    BinaryStreamBuffer file_bsb(log_file);
-    file_bsb.write(entry_size);
-    log_file.write(reinterpret_cast<const char*>(encrypted_buffer.data()), entry_size);
-    file_bsb.write(checksum);
+    BinaryStreamBuffer out_bsb(out);
+    out_bsb.write(entry_size);
+    out.write(buffer_str.data(), entry_size);
+    out_bsb.write(checksum);
+    return sizeof(entry_size) + entry_size + sizeof(checksum);
+}
+
+void WriteAheadLog::note_lsn(const LogEntry& entry) {
+    if (entry.lsn != 0 && version_ >= 3) {
+        if (first_lsn_ == 0) first_lsn_ = entry.lsn;
+        last_lsn_ = entry.lsn;
+    }
+}
 
+void WriteAheadLog::append(const LogEntry& entry) {
+    static Common::Histogram& append_latency = Common::Metrics::instance().histogram(
+        "tissdb_wal_append_seconds", "Time to encode and append one WAL record, flush included.");
+    static Common::Histogram& flush_latency = Common::Metrics::instance().histogram(
+        "tissdb_wal_flush_seconds", "Time to hand one appended WAL record to the operating system.");
+    static Common::Counter& bytes_appended = Common::Metrics::instance().counter(
+        "tissdb_wal_bytes_total", "Bytes appended to write-ahead logs.");
+    Common::ScopedTimer timer(append_latency);
+    if (!log_file.is_open()) {
+        throw std::runtime_error("WAL file is not open.");
+    }
+
+    const size_t bytes = encode(entry, log_file);
+    {
+        Common::ScopedTimer flush_timer(flush_latency);
+        log_file.flush();
+    }
+    bytes_appended.add(bytes);
+    note_lsn(entry);
+}
+
+void WriteAheadLog::append_batch(const std::vector<LogEntry>& entries) {
+    static Common::Histogram& batch_latency = Common::Metrics::instance().histogram(
+        "tissdb_wal_batch_append_seconds", "Time to encode and append one group of WAL records, flush included.");
+    static Common::Counter& bytes_appended = Common::Metrics::instance().counter(
+        "tissdb_wal_bytes_total", "Bytes appended to write-ahead logs.");
+    Common::ScopedTimer timer(batch_latency);
+    if (!log_file.is_open()) {
+        throw std::runtime_error("WAL file is not open.");
+    }
+
+    std::stringstream group;
+    for (const auto& entry : entries) {
+        encode(entry, group);
+    }
+    const std::string bytes = group.str();
+    log_file.write(bytes.data(), bytes.size());
     log_file.flush();
+    bytes_appended.add(bytes.size());
+    for (const auto& entry : entries) {
+        note_lsn(entry);
+    }
 }
 
 std::vector<LogEntry> WriteAheadLog::recover() {
@@ -82,10 +191,21 @@ std::vector<LogEntry> WriteAheadLog::recover() {
     if (!input_log_file.is_open()) {
         return recovered_entries;
     }
+    read_entries(input_log_file, [&recovered_entries](LogEntry& entry) {
+        recovered_entries.push_back(std::move(entry));
+        return true;
+    });
+    return recovered_entries;
+}
 
-    BinaryStreamBuffer bsb(input_log_file);
+void WriteAheadLog::read_entries(std::istream& in, const std::function<bool(LogEntry&)>& visit) {
+    const uint32_t version = read_wal_header(in);
+    const Common::ChecksumType checksum_type = checksum_type_for(version);
+    Crypto::DekHandlePtr dek = get_kms_instance().get_dek_handle("wal_key");
 
-    while (input_log_file.peek() != EOF) {
+    BinaryStreamBuffer bsb(in);
+
+    while (in.peek() != EOF) {
         uint32_t entry_size;
         uint32_t stored_checksum;
         std::vector<uint8_t> entry_data;
@@ -93,30 +213,25 @@ std::vector<LogEntry> WriteAheadLog::recover() {
         try {
             bsb.read(entry_size);
             entry_data.resize(entry_size);
-            input_log_file.read(reinterpret_cast<char*>(entry_data.data()), entry_size);
-            if (static_cast<uint32_t>(input_log_file.gcount()) != entry_size) {
+            in.read(reinterpret_cast<char*>(entry_data.data()), entry_size);
+            if (static_cast<uint32_t>(in.gcount()) != entry_size) {
                 break;
             }
 
             bsb.read(stored_checksum);
-            if (input_log_file.fail()) {
+            if (in.fail()) {
                 break;
             }
 
-            if (stored_checksum != Common::crc32(entry_data.data(), entry_data.size())) {
+            if (stored_checksum != Common::checksum(checksum_type, entry_data.data(), entry_data.size())) {
                 break;
             }
 
-            // Decrypt the entry data
-            auto dek = get_kms_instance().get_dek("wal_key");
-            auto decrypted_buffer = get_kms_instance().decrypt(entry_data, dek);
-            if (decrypted_buffer.empty() && !entry_data.empty()) {
-                std::cerr << "WAL entry decryption failed. Recovery may be incomplete." << std::endl;
-                break;
-            }
+            // Decrypt the entry data in place
+            Crypto::KeyManagementSystem::apply_keystream(entry_data.data(), entry_data.size(), *dek);
 
             LogEntry entry;
-            std::string entry_data_str(decrypted_buffer.begin(), decrypted_buffer.end());
+            std::string entry_data_str(entry_data.begin(), entry_data.end());
             std::istringstream entry_stream(entry_data_str);
             BinaryStreamBuffer entry_bsb(entry_stream);
             entry_bsb.read(entry.type);
@@ -130,24 +245,32 @@ std::vector<LogEntry> WriteAheadLog::recover() {
                 entry_bsb.read_bytes(); // Consume the empty bytes
                 entry.doc = Document{};
             }
-            recovered_entries.push_back(entry);
+            if (version >= 3) {
+                entry_bsb.read(entry.lsn);
+            }
+            if (!visit(entry)) {
+                break;
+            }
 
         } catch (const std::exception& e) {
             break;
         }
     }
-    input_log_file.close();
-    return recovered_entries;
 }
 
 void WriteAheadLog::clear() {
     if (log_file.is_open()) {
         log_file.close();
     }
-    log_file.open(log_path, std::ios::out | std::ios::binary | std::ios::trunc);
-    if (!log_file.is_open()) {
-        throw std::runtime_error("Failed to clear WAL file: " + log_path);
+    open_log(std::ios::trunc);
+}
+
+void WriteAheadLog::archive_to(const std::string& archive_path) {
+    if (log_file.is_open()) {
+        log_file.close();
     }
+    std::filesystem::rename(log_path, archive_path);
+    open_log(std::ios::trunc);
 }
 
 void WriteAheadLog::shutdown() {
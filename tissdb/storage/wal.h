@@ -4,11 +4,15 @@
 #include <cstdint>
 #include <string>
 #include <fstream>
+#include <functional>
+#include <istream>
+#include <ostream>
 #include <vector>
 #include <optional>
 
 #include "../common/document.h"
 #include "../common/checksum.h"
+#include "../crypto/kms.h"
 #include "transaction_manager.h"
 
 namespace TissDB {
@@ -35,8 +39,16 @@ struct LogEntry {
     Document doc;
     std::vector<TissDB::Transactions::Operation> operations;
     std::optional<std::vector<uint8_t>> schema_data;
+    // Sequence number of a PUT or DELETE (format v3+, stored after the
+    // document); 0 for other entries.
+    uint64_t lsn = 0;
 };
 
+// On-disk format marker. Logs written before the header existed start
+// directly with the first entry and are checksummed with CRC32.
+constexpr uint32_t WAL_MAGIC = 0x4C415754; // "TWAL"
+constexpr uint32_t WAL_FORMAT_VERSION = 3; // v2: CRC32C entry checksums, v3: sequence numbers
+
 // Manages the Write-Ahead Log for ensuring durability of writes.
 class WriteAheadLog {
 public:
@@ -48,19 +60,57 @@ public:
     // This must be called before the change is applied to the memtable.
     void append(const LogEntry& entry);
 
+    // Appends several entries with a single write and flush. Each keeps its
+    // own record framing, so recovery reads them like separate appends; a
+    // crash part-way through keeps the records before the torn one.
+    void append_batch(const std::vector<LogEntry>& entries);
+
     // Reads the log from disk to reconstruct the state after a crash.
     // Returns a vector of log entries that need to be replayed.
     std::vector<LogEntry> recover();
 
+    // Reads a log (active or archived) from `in`, calling `visit` for each
+    // intact entry until it returns false. Stops quietly at a torn or corrupt
+    // tail, so a log that is still being appended to can be read.
+    static void read_entries(std::istream& in, const std::function<bool(LogEntry&)>& visit);
+
     // Clears the log file, typically after a successful flush of a memtable to disk.
     void clear();
 
+    // Moves the log to `archive_path` and starts a new, empty one in its place.
+    void archive_to(const std::string& archive_path);
+
+    const std::string& get_path() const { return log_path; }
+
+    // Sequence numbers of the first and last entries in the current file that
+    // carry one; 0 if there are none.
+    uint64_t first_lsn() const { return first_lsn_; }
+    uint64_t last_lsn() const { return last_lsn_; }
+
     // Ensures the log file is properly flushed and closed.
     void shutdown();
 
 private:
+    // Writes the format header if the file is empty, otherwise detects the
+    // format of the existing file.
+    void init_format();
+
+    // Writes the framed, encrypted record of `entry` to `out`; returns its size.
+    size_t encode(const LogEntry& entry, std::ostream& out) const;
+    // Tracks the sequence numbers of an entry that reached the file.
+    void note_lsn(const LogEntry& entry);
+
+    // Opens the file for appending and sets up its header.
+    void open_log(std::ios::openmode mode);
+
     std::string log_path;
     std::ofstream log_file;
+    Common::ChecksumType checksum_type_ = Common::ChecksumType::CRC32C;
+    uint32_t version_ = WAL_FORMAT_VERSION; // Of the current file; appends keep it
+    uint64_t first_lsn_ = 0;
+    uint64_t last_lsn_ = 0;
+    // Handle to the dedicated WAL key, resolved once in the constructor.
+    Crypto::DekHandlePtr dek_;
 };
 
 } // namespace Storage
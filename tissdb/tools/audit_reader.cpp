@@ -0,0 +1,57 @@
+#include <chrono>
+#include <iostream>
+#include <string>
+
+#include "../audit/audit_logger.h"
+#include "../json/json.h"
+
+// Prints the events of a TissDB audit log directory as JSON, one per line.
+//
+// Example compilation command (from the tissdb directory), or `make audit_reader`:
+// g++ -std=c++17 -I. -o audit_reader tools/audit_reader.cpp audit/audit_logger.cpp common/checksum.cpp common/log.cpp json/json.cpp -lpthread
+//
+// A running server serves the same data at GET /_admin/audit_log?from=<ms>&to=<ms>.
+
+namespace {
+void print_usage() {
+    std::cout << "TissDB Audit Log Reader" << std::endl;
+    std::cout << "-----------------------" << std::endl;
+    std::cout << "Usage: audit_reader <audit_directory> [from_ms] [to_ms]" << std::endl;
+    std::cout << "  Prints the events between from_ms and to_ms (Unix milliseconds," << std::endl;
+    std::cout << "  default: everything), oldest first." << std::endl;
+}
+
+std::chrono::system_clock::time_point from_ms(const std::string& text) {
+    return std::chrono::system_clock::time_point(std::chrono::milliseconds(std::stoll(text)));
+}
+} // anonymous namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 2 || argc > 4) {
+        print_usage();
+        return 1;
+    }
+    try {
+        auto start = std::chrono::system_clock::time_point::min();
+        auto end = std::chrono::system_clock::time_point::max();
+        if (argc > 2) start = from_ms(argv[2]);
+        if (argc > 3) end = from_ms(argv[3]);
+
+        for (const auto& entry : TissDB::Audit::read_audit_log(argv[1], start, end)) {
+            TissDB::Json::JsonObject obj;
+            obj["timestamp_ms"] = TissDB::Json::JsonValue(static_cast<double>(
+                std::chrono::duration_cast<std::chrono::milliseconds>(entry.timestamp.time_since_epoch()).count()));
+            obj["user"] = TissDB::Json::JsonValue(entry.user_token_id);
+            obj["source_ip"] = TissDB::Json::JsonValue(entry.source_ip);
+            obj["event_type"] = TissDB::Json::JsonValue(TissDB::Audit::event_type_to_string(entry.event_type));
+            obj["resource"] = TissDB::Json::JsonValue(entry.resource_accessed);
+            obj["success"] = TissDB::Json::JsonValue(entry.success);
+            obj["description"] = TissDB::Json::JsonValue(entry.description);
+            std::cout << TissDB::Json::JsonValue(obj).serialize() << std::endl;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
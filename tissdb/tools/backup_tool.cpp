@@ -4,12 +4,18 @@
 #include <filesystem>
 #include <stdexcept>
 
+#include "../storage/backup.h"
+
 // NOTE FOR USER:
 // This tool is designed to be compiled as a separate utility.
 // It requires C++17 for the <filesystem> library.
 //
-// Example compilation command:
-// g++ -std=c++17 -o backup_tool backup_tool.cpp
+// Example compilation command (from the tissdb directory):
+// g++ -std=c++17 -I. -o backup_tool tools/backup_tool.cpp storage/backup.cpp json/json.cpp
+//
+// For a running server prefer the online API, which takes a consistent
+// checkpoint: POST /<db>/_backup {"destination": "<backup_root>"}.
+// The `backup` command below is for a stopped server only.
 //
 // The master key for the Key Management System (KMS) is not handled here.
 // In a real system, the backup process must also include a secure way to
@@ -23,55 +29,49 @@ void print_usage() {
     std::cout << "----------------------------" << std::endl;
     std::cout << "Usage: backup_tool <command> <args...>" << std::endl;
     std::cout << "\nCommands:" << std::endl;
-    std::cout << "  backup <data_directory> <backup_directory>" << std::endl;
-    std::cout << "    - Creates a backup of .db and .log files." << std::endl;
-    std::cout << "  restore <backup_directory> <data_directory>" << std::endl;
-    std::cout << "    - Restores files from a backup. Warning: Overwrites destination files." << std::endl;
+    std::cout << "  backup <database_directory> <backup_root>" << std::endl;
+    std::cout << "    - Creates an offline backup of a stopped database under <backup_root>." << std::endl;
+    std::cout << "      SSTables are hard-linked; later backups reuse files from the previous one." << std::endl;
+    std::cout << "  restore <backup_directory> <database_directory>" << std::endl;
+    std::cout << "    - Restores a backup by swapping it into place. The old directory is kept" << std::endl;
+    std::cout << "      as <database_directory>.pre_restore_<timestamp>." << std::endl;
 }
 
-void backup(const fs::path& data_dir, const fs::path& backup_dir) {
+void backup(const fs::path& data_dir, const fs::path& backup_root) {
     if (!fs::is_directory(data_dir)) {
         throw std::runtime_error("Source data directory does not exist or is not a directory: " + data_dir.string());
     }
-    if (!fs::exists(backup_dir)) {
-        std::cout << "Backup directory does not exist. Creating it: " << backup_dir.string() << std::endl;
-        fs::create_directories(backup_dir);
-    }
 
     std::cout << "Starting backup..." << std::endl;
-    int files_copied = 0;
-    for (const auto& entry : fs::directory_iterator(data_dir)) {
+    TissDB::Storage::BackupWriter writer(backup_root.string());
+    for (const auto& entry : fs::recursive_directory_iterator(data_dir)) {
+        if (!entry.is_regular_file()) continue;
         const auto& path = entry.path();
-        if (entry.is_regular_file() && (path.extension() == ".db" || path.extension() == ".log")) {
-            fs::copy(path, backup_dir / path.filename(), fs::copy_options::overwrite_existing);
-            std::cout << "  - Copied " << path.filename().string() << std::endl;
-            files_copied++;
+        std::string relative = fs::relative(path, data_dir).generic_string();
+        if (path.filename().string().rfind("sstable_", 0) == 0 && path.extension() == ".db") {
+            writer.add_immutable_file(path.string(), relative);
+        } else {
+            writer.add_mutable_file(path.string(), relative);
         }
     }
-    std::cout << "Backup complete. " << files_copied << " files copied." << std::endl;
+    TissDB::Storage::BackupResult result = writer.finish();
+
+    std::cout << "Backup complete: " << result.backup_path << std::endl;
+    if (!result.parent_backup_id.empty()) {
+        std::cout << "  Incremental on top of " << result.parent_backup_id << std::endl;
+    }
+    std::cout << "  " << result.files_linked << " linked, " << result.files_reused << " reused, "
+              << result.files_copied << " copied (" << result.bytes_copied << " bytes)." << std::endl;
 }
 
 void restore(const fs::path& backup_dir, const fs::path& data_dir) {
     if (!fs::is_directory(backup_dir)) {
         throw std::runtime_error("Source backup directory does not exist or is not a directory: " + backup_dir.string());
     }
-    if (!fs::exists(data_dir)) {
-        std::cout << "Data directory does not exist. Creating it: " << data_dir.string() << std::endl;
-        fs::create_directories(data_dir);
-    }
 
     std::cout << "Starting restore..." << std::endl;
-    std::cout << "WARNING: This will overwrite existing files in " << data_dir.string() << std::endl;
-    int files_restored = 0;
-    for (const auto& entry : fs::directory_iterator(backup_dir)) {
-        const auto& path = entry.path();
-        if (entry.is_regular_file()) {
-            fs::copy(path, data_dir / path.filename(), fs::copy_options::overwrite_existing);
-            std::cout << "  - Restored " << path.filename().string() << std::endl;
-            files_restored++;
-        }
-    }
-    std::cout << "Restore complete. " << files_restored << " files restored." << std::endl;
+    TissDB::Storage::restore_backup(backup_dir.string(), data_dir.string());
+    std::cout << "Restore complete. " << data_dir.string() << " now contains " << backup_dir.filename().string() << std::endl;
 }
 
 int main(int argc, char* argv[]) {
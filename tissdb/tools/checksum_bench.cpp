@@ -0,0 +1,90 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../common/checksum.h"
+
+// Microbenchmark for the checksum implementations used by the WAL and SSTables.
+//
+// Build and run with:
+//   make bench
+// or
+//   g++ -std=c++17 -O2 -march=native -I. tools/checksum_bench.cpp common/checksum.cpp -o checksum_bench
+
+namespace {
+
+using ChecksumFn = uint32_t (*)(const void*, size_t);
+
+uint32_t legacy_crc32(const void* data, size_t size) {
+    return TissDB::Common::crc32(data, size);
+}
+
+uint32_t crc32c_portable(const void* data, size_t size) {
+    return TissDB::Common::Crc32cImpl::extend_portable(0, data, size);
+}
+
+uint32_t crc32c_hardware(const void* data, size_t size) {
+    return TissDB::Common::Crc32cImpl::extend_hardware(0, data, size);
+}
+
+double measure_gbps(ChecksumFn fn, const std::vector<uint8_t>& buffer, size_t block_size, size_t total_bytes) {
+    const size_t iterations = total_bytes / block_size;
+    volatile uint32_t sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        sink = sink ^ fn(buffer.data() + (i * 64) % (buffer.size() - block_size + 1), block_size);
+    }
+    auto end = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(end - start).count();
+    return (static_cast<double>(iterations * block_size) / seconds) / 1e9;
+}
+
+} // anonymous namespace
+
+int main(int argc, char* argv[]) {
+    size_t total_mb = 512;
+    if (argc > 1) {
+        total_mb = std::strtoul(argv[1], nullptr, 10);
+    }
+    const size_t total_bytes = total_mb * 1024 * 1024;
+
+    std::vector<uint8_t> buffer(4 * 1024 * 1024);
+    uint32_t seed = 12345;
+    for (auto& b : buffer) {
+        seed = seed * 1103515245 + 12345;
+        b = static_cast<uint8_t>(seed >> 16);
+    }
+
+    std::cout << "TissDB checksum benchmark (" << total_mb << " MiB per run)" << std::endl;
+    std::cout << "Active CRC32C implementation: "
+              << TissDB::Common::Crc32cImpl::active_implementation() << std::endl;
+
+    struct Candidate { const char* name; ChecksumFn fn; bool enabled; };
+    const Candidate candidates[] = {
+        {"crc32 (legacy, bytewise)", legacy_crc32, true},
+        {"crc32c slicing-by-8", crc32c_portable, true},
+        {"crc32c sse4.2", crc32c_hardware, TissDB::Common::Crc32cImpl::hardware_available()},
+    };
+    const size_t block_sizes[] = {64, 512, 4096, 65536, 1024 * 1024};
+
+    std::cout << std::left << std::setw(28) << "implementation";
+    for (size_t bs : block_sizes) {
+        std::cout << std::right << std::setw(12) << (std::to_string(bs) + "B");
+    }
+    std::cout << "   (GB/s)" << std::endl;
+
+    for (const auto& c : candidates) {
+        if (!c.enabled) continue;
+        std::cout << std::left << std::setw(28) << c.name;
+        for (size_t bs : block_sizes) {
+            std::cout << std::right << std::setw(12) << std::fixed << std::setprecision(2)
+                      << measure_gbps(c.fn, buffer, bs, total_bytes);
+        }
+        std::cout << std::endl;
+    }
+    return 0;
+}